@@ -8,6 +8,8 @@
 #ifndef snake_h
 #define snake_h
 
+#include "snake_env.h"
+
 #define MIN_SNAKE_LEN 3
 #define MAX_MOVES_PER_APPLE 150
 
@@ -16,6 +18,17 @@
 #define LEFT 3
 #define RIGHT 4
 
+#define DEATH_NONE 0
+#define DEATH_WALL 1
+#define DEATH_SELF 2
+#define DEATH_TIMEOUT 3
+#define DEATH_REVERSE 4
+#define NUM_DEATHS 5
+
+#define VENV_MIN_DIM 5
+#define VENV_MAX_DIM 255
+#define VENV_PLACE_TRIES 64     // random apple draws per board cell before scanning for a free cell
+
 typedef struct snake_node snake_node;
 typedef struct apple apple;
 typedef struct env env;
@@ -23,6 +36,7 @@ typedef struct apple_data apple_data;
 typedef struct move_data move_data;
 typedef struct dist_data dist_data;
 typedef struct env_set env_set;
+typedef struct venv_game venv_game;
 
 struct snake_node {
     int x;
@@ -58,6 +72,7 @@ struct env {
     int len;
     int env_dim;
     int alive;
+    int death;              // DEATH_* cause of a finished game
     apple_data *a_data;
     move_data *m_data;
 };
@@ -75,6 +90,41 @@ struct env_set {
     dist_data *dist_d;
 };
 
+// a vectorized env game: the snake is a ring of packed (x | y << 8) cells from the head to the tail
+struct venv_game {
+    unsigned long long rng;     // the game's own random numbers (the trainer's generator, seeded the same way)
+    int head;                   // ring index of the head
+    int len;
+    int hx;
+    int hy;
+    int ax;
+    int ay;
+    int m;
+    int m_n;
+    int n;
+    int alive;
+};
+
+struct gs_venv {
+    int num_games;
+    int dim;
+    int cells;
+    int auto_reset;
+    const int *actions;
+    double *obs;
+    unsigned char *grid;
+    float *rewards;
+    unsigned char *dones;
+    gs_venv_episode *episodes;
+    venv_game *games;
+    unsigned short *rings;      // num_games rings of dim * dim cells
+    unsigned char *own_grid;    // the grid when the caller does not take one
+    long long steps;
+    long long num_episodes;
+    long long apples;
+    double run_t;
+};
+
 // env functions
 void init_apple(int, env *);
 void init_snake(int, int, env *);
@@ -87,7 +137,10 @@ int run_env_action(int a, env *src);
 
 // env controller functions
 void free_env_set(env_set *);
+void release_env_set(env_set *);
 void update_dist_data(env_set *, int);
+void alloc_env_set(env_set *, int);
+void init_env_range(env_set *, int, int, int);
 void init_env_set(env_set *, int, int);
 void reset_env_set(env_set *);
 void run_env_set(env_set *, int *);
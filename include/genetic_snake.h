@@ -0,0 +1,80 @@
+//
+//  genetic_snake.h
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#ifndef genetic_snake_h
+#define genetic_snake_h
+
+#include <stddef.h>
+
+// result codes of every engine call (and of parameter checks)
+#define GS_OK 0
+#define GS_ERR_ARG -1           // NULL engine or buffer, or a bad argument
+#define GS_ERR_PARAMS -2        // the configuration failed its checks (the reason is in the error message)
+#define GS_ERR_NOMEM -3         // an allocation failed (a run that fails can only be destroyed)
+#define GS_ERR_THREAD -4        // the engine's threads could not be started
+#define GS_ERR_STATE -5         // no generation has run yet
+#define GS_ERR_FINISHED -6      // every generation has already run
+#define GS_ERR_SIZE -7          // the buffer is too small (the needed size is returned)
+#define GS_ERR_IO -8
+
+#define GS_MAX_LAYERS 6
+#define GS_SCHEDULE_INDEX 0
+#define GS_SCHEDULE_LONGEST 1
+
+// weight formats of an exported champion
+#define GS_CHAMP_DOUBLE 0
+#define GS_CHAMP_FLOAT 1
+#define GS_CHAMP_INT16 2        // per-layer scale
+#define GS_CHAMP_INT8 3
+
+typedef struct gs_engine gs_engine;
+typedef struct gs_config gs_config;
+typedef struct gs_engine_stats gs_engine_stats;
+
+struct gs_config {
+    int pop_size;
+    int gen_count;
+    float mutate;
+    float survive;
+    int num_layers;
+    int shape[2 * GS_MAX_LAYERS];   // inputs and outputs of every layer (24 in, 4 out)
+    int num_threads;
+    long long seed;                 // negative seeds from the clock
+    int chunk;
+    int schedule;                   // GS_SCHEDULE_LONGEST or GS_SCHEDULE_INDEX
+    int barrier_spin;
+    int verbose;                    // print every generation like the command line model
+};
+
+struct gs_engine_stats {
+    int gens;                       // generations run so far
+    int gen_count;
+    int finished;
+    int highscore;
+    long games;                     // games of the last generation
+    double fitness_min;
+    double fitness_mean;
+    double fitness_max;
+    double moves_mean;
+    double apples_mean;
+    int apples_max;
+    double seconds;                 // time spent running generations
+};
+
+// engine library functions (an engine is not thread safe, but engines share nothing)
+void gs_config_init(gs_config *);
+int gs_engine_create(const gs_config *, gs_engine **, char *, size_t);
+int gs_engine_create_from_checkpoint(const gs_config *, const char *, gs_engine **, char *, size_t);
+int gs_engine_run(gs_engine *, int);
+int gs_engine_get_stats(gs_engine *, gs_engine_stats *);
+int gs_engine_best_genome(gs_engine *, double *, int, int *);
+int gs_engine_checkpoint(gs_engine *, const char *);
+int gs_engine_export_champion(gs_engine *, const char *, int, double);
+void gs_engine_destroy(gs_engine *);
+const char * gs_strerror(int);
+
+#endif /* genetic_snake_h */
@@ -14,8 +14,11 @@
 #include <time.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include "nndefs.h"
 #include "envdefs.h"
+#include "genetic_snake.h"
 
 #define MAX_LINE_SIZE 512
 #define MAX_STR_SIZE 32
@@ -29,7 +32,53 @@
 #define MAX_MUTATE 1.0
 #define MAX_SURVIVE 1.0
 
-#define MAX_NUM_THREADS 100
+#define MAX_NUM_THREADS 256
+
+#define CACHE_LINE 64
+#define BARRIER_FANIN 4
+#define BARRIER_SPIN 4000
+
+#define MODE_GENERATIONAL 0
+#define MODE_STEADY 1
+#define MODE_ISLAND 2
+
+#define TOPOLOGY_RING 0
+#define TOPOLOGY_RANDOM 1
+#define MIGRATE_EVERY 10
+#define MIGRATE_K 2
+#define MIN_ISLAND_SIZE 20
+
+#define MODE_FARM 3
+#define FARM_ADDR "unix:/tmp/genetic-snake.sock"
+#define FARM_BATCH 16
+#define FARM_TIMEOUT 30
+#define FARM_INFLIGHT 2
+#define FARM_MAGIC 0x4B4E5347
+#define FARM_HELLO 1
+#define FARM_GAMES 2
+#define FARM_RESULT 3
+#define FARM_BYE 4
+#define FARM_MIN_WIDTH 5           // board widths and layer widths a worker accepts from a coordinator
+#define FARM_MAX_WIDTH 255
+#define FARM_MAX_NEURONS 1024
+#define BATCH_PENDING 0
+#define BATCH_SENT 1
+#define BATCH_DONE 2
+
+#define AFFINITY_NONE 0
+#define AFFINITY_COMPACT 1
+#define AFFINITY_SCATTER 2
+
+#define CLAIM_RUN 0
+#define CLAIM_SPAWN 1
+#define NUM_CLAIMS 2
+#define CLAIM_GUIDED_DIV 2
+#define RUN_MIN_CHUNK 1
+#define SPAWN_MIN_CHUNK 2
+
+#define SCHEDULE_INDEX 0
+#define SCHEDULE_LONGEST 1
+#define LPT_BUCKETS 32
 
 #define PRINT_BATCH 10
 #define REPLAY_TIME_5 30000
@@ -37,12 +86,145 @@
 #define REPLAY_TIME_3 25000
 #define REPLAY_TIME_2 22500
 #define REPLAY_TIME_1 20000
+#define PROF_RUN 0
+#define PROF_RESET 1
+#define PROF_INFER 2
+#define PROF_ENV 3
+#define PROF_FITNESS 4
+#define PROF_SPAWN 5
+#define PROF_BARRIER 6
+#define PROF_MUTEX 7
+#define PROF_SELECT 8
+#define PROF_STATS 9
+#define PROF_SCHED 10
+#define NUM_PROF 11
+#define PROF_SAMPLE 16
+#define PROF_MAX_EVENTS (1 << 20)
+
+#define PERF_CYCLES 0
+#define PERF_INSTR 1
+#define PERF_LLC_MISS 2
+#define PERF_BRANCH_MISS 3
+#define NUM_PERF 4
+#define PERF_PHASE_RUN 0
+#define PERF_PHASE_SPAWN 1
+#define NUM_PERF_PHASES 2
+
+#define MEM_GENOMES 0
+#define MEM_ACTIVATIONS 1
+#define MEM_ENV 2
+#define MEM_TRAJECTORY 3
+#define MEM_THREADS 4
+#define MEM_BUFFERS 5
+#define NUM_MEM 6
+#define MEM_EST_APPLES 10
+#define BUDGET_REFUSE 0
+#define BUDGET_DOWNSCALE 1
+
+#define TUNE_OFF 0
+#define TUNE_CALIBRATED 1
+#define TUNE_CACHED 2
+#define TUNE_GENS 5
+#define TUNE_REPEATS 2
+#define TUNE_FILE "tune.cache"
+
+#define METRICS_OFF 0
+#define METRICS_CSV 1
+#define METRICS_JSONL 2
+#define METRICS_BIN 3
+#define METRICS_RING 1024
+#define METRICS_MAGIC 0x544D5347
+#define METRICS_VERSION 1
+
+#define CHAMP_GAMES 100
+#define CHAMP_SEED 1
+#define CHAMP_DECISIONS (1 << 20)
+
+#define CKPT_MAGIC 0x4B434753
+#define CKPT_VERSION 1
+#define CKPT_EVERY 50
+#define CKPT_OFF 0
+#define CKPT_RESUME 1
+#define CKPT_INIT_POP 2
+
+#define LINEAGE_MAGIC 0x4E4C5347
+#define LINEAGE_VERSION 1
+#define LINEAGE_KEYFRAME 20
+#define LINEAGE_KEY 0
+#define LINEAGE_DELTA 1
+#define LINEAGE_RING 4
+
+#define MAX_SCALE 16
+#define SCALE_SEED 1
+#define SCALE_OUT "scale"
+
+#define MAX_SWEEP 16
+#define MAX_SWEEP_RUNS 256
+#define SWEEP_OUT "sweep"
+#define SWEEP_GRID 0
+#define SWEEP_LIST 1
+#define SWEEP_RUN 0
+#define SWEEP_SPAWN 1
+#define SWEEP_DONE 2
+#define SWEEP_WAIT 3
+
+#define MAX_RUNGS 16
+#define ASHA_ETA 3
+#define ASHA_FITNESS 0
+#define ASHA_HIGHSCORE 1
+
+#define REPLAY_QUEUE 4
+#define REPLAY_NICE 10
+#define SNAPSHOT_EMPTY 0
+#define SNAPSHOT_PENDING 1
+#define SNAPSHOT_PLAYING 2
 
 #define NOT_FOUND -1
 #define NOT_SET -5
 
 typedef struct gs_params gs_params;
 typedef struct thread_data thread_data;
+typedef struct phase_claim phase_claim;
+typedef struct barrier_node barrier_node;
+typedef struct gs_barrier gs_barrier;
+typedef struct thread_ctx thread_ctx;
+typedef struct thread_state thread_state;
+typedef struct ranked_pool ranked_pool;
+typedef struct eval_stats eval_stats;
+typedef struct gen_stats gen_stats;
+typedef struct replay_snapshot replay_snapshot;
+typedef struct replay_viewer replay_viewer;
+typedef struct renderer renderer;
+typedef struct prof_event prof_event;
+typedef struct prof_thread prof_thread;
+typedef struct profiler profiler;
+typedef struct prof_totals prof_totals;
+typedef struct scale_cell scale_cell;
+typedef struct sweep_run sweep_run;
+typedef struct sweep_worker sweep_worker;
+typedef struct sweep sweep;
+typedef struct engine_worker engine_worker;
+typedef struct champ_layer champ_layer;
+typedef struct ckpt_header ckpt_header;
+typedef struct checkpoint checkpoint;
+typedef struct lineage_header lineage_header;
+typedef struct lineage_record lineage_record;
+typedef struct lineage_child lineage_child;
+typedef struct lineage_buf lineage_buf;
+typedef struct lineage_block lineage_block;
+typedef struct lineage lineage;
+typedef struct metrics_rec metrics_rec;
+typedef struct metrics_ring metrics_ring;
+typedef struct metrics metrics;
+typedef struct perf_thread perf_thread;
+typedef struct perf_counters perf_counters;
+typedef struct mailbox_cell mailbox_cell;
+typedef struct mailbox mailbox;
+typedef struct island_set island_set;
+typedef struct farm_worker farm_worker;
+typedef struct farm farm;
+typedef struct mem_account mem_account;
+typedef void (*serial_funct) (void *);
 
 struct gs_params {
     int pop_size;
@@ -51,57 +233,766 @@ struct gs_params {
     int num_layers;
     int num_threads;
     int print_replay;
+    char replay_file[MAX_LINE_SIZE];
+    int profile;
+    char trace_file[MAX_LINE_SIZE];
+    int perf_counters;
+    long memory_budget;     // MB (0 is unlimited)
+    int mem_stats;          // count live heap bytes without a budget
+    int budget_policy;
+    long long seed;         // NOT_SET seeds from the clock
+    int chunk;              // smallest run claim chunk (spawn claims round it up to pairs)
+    int autotune;           // TUNE_OFF, or how the tuned threads, schedule and chunk were found
+    char tune_file[MAX_LINE_SIZE];
+    double tune_rate;       // calibration gens/sec of the tuned configuration
+    char ckpt_file[MAX_LINE_SIZE];
+    int ckpt_every;         // generations between checkpoints (0 is off)
+    char resume_file[MAX_LINE_SIZE];
+    int resume;             // CKPT_OFF, CKPT_RESUME or CKPT_INIT_POP
+    char lineage_file[MAX_LINE_SIZE];
+    int lineage_every;      // generations between lineage keyframes (0 is off)
+    char metrics_file[MAX_LINE_SIZE];
+    int metrics_format;     // METRICS_OFF, METRICS_CSV, METRICS_JSONL or METRICS_BIN
+    char champ_file[MAX_LINE_SIZE];
+    int champ_format;       // GS_CHAMP_DOUBLE, GS_CHAMP_FLOAT, GS_CHAMP_INT16 or GS_CHAMP_INT8
+    double champ_prune;     // weights below it are pruned from an exported champion (0 is off)
+    int scale_threads[MAX_SCALE];
+    int num_scale_threads;
+    int scale_pop[MAX_SCALE];
+    int num_scale_pop;
+    char scale_out[MAX_LINE_SIZE];
+    int sweep_pop[MAX_SWEEP];
+    int num_sweep_pop;
+    float sweep_mutate[MAX_SWEEP];
+    int num_sweep_mutate;
+    float sweep_survive[MAX_SWEEP];
+    int num_sweep_survive;
+    int sweep_shape[MAX_SWEEP][2 * MAX_NUM_LAYERS];
+    int sweep_layers[MAX_SWEEP];
+    int num_sweep_shape;
+    int sweep_mode;         // SWEEP_GRID (every combination) or SWEEP_LIST (the i-th value of every list)
+    char sweep_out[MAX_LINE_SIZE];
+    int asha_gens;          // generations of the first early-stopping rung (0 is off)
+    int asha_eta;           // reduction factor: a rung keeps its top 1/eta and the next rung is eta times longer
+    int asha_metric;        // ASHA_FITNESS (mean fitness of the rung's generation) or ASHA_HIGHSCORE
+    int quiet;              // no per-generation output (library engines)
+    prof_totals *totals;    // profile totals of the run (scaling harness only)
+    int barrier_spin;
+    int schedule;
+    int affinity;
+    int mode;
+    int report_evals;
+    int num_islands;
+    int migrate_every;
+    int migrate_k;
+    int topology;
+    char farm_addr[MAX_LINE_SIZE];
+    int farm_workers;
+    int farm_batch;
+    int farm_timeout;
+    int quantize;
     float mutate;
     float survive;
     int shape[(2 * MAX_NUM_LAYERS)];
     funct activation [MAX_NUM_LAYERS];
 };
 
+struct phase_claim {
+    atomic_int next;        // first target that has not been claimed yet
+    int id;                 // claim counter index (CLAIM_RUN, CLAIM_SPAWN)
+    int limit;              // number of targets in the phase
+    int step;               // chunks are rounded to a multiple of step
+    int min_chunk;          // smallest chunk handed out near the end of a phase
+} __attribute__((aligned(CACHE_LINE)));
+
+struct barrier_node {
+    atomic_int count;       // arrivals still expected at this node in the current episode
+    int expected;           // arrivals per episode (threads at a leaf, child nodes above)
+    int parent;             // parent node index (NOT_FOUND at the root)
+} __attribute__((aligned(CACHE_LINE)));
+
+struct gs_barrier {
+    int num_threads;
+    int num_nodes;
+    int spin;               // sense polls before a waiting thread parks
+    barrier_node *nodes;
+    atomic_int sense __attribute__((aligned(CACHE_LINE)));          // global release sense (also the futex word)
+    atomic_int num_sleeping __attribute__((aligned(CACHE_LINE)));
+#ifndef __linux__
+    pthread_mutex_t lock;   // guards parking where there is no futex
+    pthread_cond_t wake;    // signals a reversed sense where there is no futex
+#endif
+};
+
+struct gen_stats {
+    long ct;                // finished games
+    double sum_fitness;
+    double min_fitness;
+    double max_fitness;
+    long sum_moves;
+    int min_moves;
+    int max_moves;
+    long sum_apples;
+    int min_apples;
+    int max_apples;
+    int best_idx;           // most apples (lowest index on ties)
+    double sum_sq_fitness;
+    long deaths[NUM_DEATHS];
+};
+
+struct mem_account {
+    atomic_long live[NUM_MEM + 1];  // live bytes of every subsystem, with the total at [NUM_MEM]
+    atomic_long peak[NUM_MEM + 1];  // peak bytes of every subsystem, with the total at [NUM_MEM]
+};
+
+struct thread_state {
+    // run queue shared with thieves: packed [head, tail) of this thread's slice of the run order (tail in the high 32 bits)
+    atomic_llong bounds __attribute__((aligned(CACHE_LINE)));
+
+    // written only by the owning thread
+    long steals __attribute__((aligned(CACHE_LINE)));   // targets this thread stole from other queues
+    double finish_t;                                    // time this thread ran out of run targets
+    long claims[NUM_CLAIMS];                            // chunks claimed per phase
+    long targets[NUM_CLAIMS];                           // targets claimed per phase
+    long contention[NUM_CLAIMS];                        // claims that raced with another thread's claim
+    gen_stats stats;                                    // games this thread finished in the current run phase
+    long mem[NUM_MEM];                                  // heap bytes this thread counted since select merged them
+};
+
+struct ranked_pool {
+    pthread_mutex_t lock;
+    int capacity;           // number of survivors kept
+    int size;
+    int *slot;              // population slot of each pool position
+    double *fitness;        // fitness of each pool position
+    double *tree;           // fenwick tree of pool position fitness (roulette sampling)
+    int *heap;              // min-heap of pool positions by fitness (culling)
+    double sum_fitness;
+    int tree_updates;
+    int *pins;              // per slot: spawns currently reading the slot as a parent
+    char *culled;           // per slot: culled while pinned, freed by the last unpin
+    int *free_slots;        // slots available for new children
+    int num_free;
+    atomic_long evals;      // evaluations claimed
+    long done;              // evaluations ranked
+    long win_ct;            // report window accumulators
+    double win_fitness;
+    double win_moves;
+    double win_apples;
+    double win_start_t;
+};
+
+struct eval_stats {
+    long evals;
+    long ct;
+    double fitness;
+    double moves;
+    double apples;
+    double elapsed_t;
+    double min_surv_fitness;
+};
+
+struct mailbox_cell {
+    atomic_long seq;        // cell sequence number (bounded MPSC queue)
+    double fitness;
+    int moves;
+    double *genome;         // migrant weights followed by biases
+};
+
+struct mailbox {
+    int capacity;           // power of two
+    int genome_len;
+    mailbox_cell *cells;
+    atomic_long head __attribute__((aligned(CACHE_LINE)));     // next cell to enqueue (any producer island)
+    long tail __attribute__((aligned(CACHE_LINE)));            // next cell to dequeue (owner island only)
+};
+
+struct island_set {
+    int num_islands;
+    gs_params params;       // per island parameters (island population and threads)
+    thread_data *islands;
+    mailbox *boxes;         // one inbox per island
+    atomic_long sent;
+    atomic_long received;
+    atomic_long dropped;
+};
+
+struct replay_snapshot {
+    int state;              // SNAPSHOT_EMPTY, SNAPSHOT_PENDING or SNAPSHOT_PLAYING
+    int gen;
+    int island;
+    int env_dim;
+    int apples;
+    ann net;                // copy of the highscoring genome
+    int num_apples;         // apple positions in the order they appeared
+    int *apple_xy;
+    int num_moves;          // actions in the order they were played
+    int *actions;
+};
+
+struct prof_event {
+    double start_t;
+    double end_t;
+    int phase;
+    int gen;
+    long ct;                // games run or children spawned by the phase
+};
+
+struct prof_thread {
+    double t[NUM_PROF] __attribute__((aligned(CACHE_LINE)));   // seconds per phase (infer and env are sampled estimates)
+    long ct[NUM_PROF];      // phase entries
+    long games;
+    long moves;
+    long sampled_moves;     // moves of the games whose inference and env steps were timed
+    double loop_t;          // move loops of every game (split into infer and env by the sampled ratio)
+    double infer_t;         // timed inference of the sampled games
+    double env_t;           // timed env steps of the sampled games
+    prof_event *events;     // trace events (NULL without a trace file)
+    int num_events;
+    long dropped_events;
+};
+
+struct profiler {
+    int num_threads;
+    int island;
+    const char *trace_file; // Chrome trace JSON path (NULL without a trace file)
+    double start_t;
+    double last_serial_t;   // duration of the last serial step (taken out of its thread's barrier wait)
+    prof_thread *threads;   // one per thread plus the serial steps at [num_threads]
+};
+
+struct prof_totals {
+    double t[NUM_PROF];     // seconds per phase summed over threads (inference and env steps split by the sampled ratio)
+    long games;
+    long moves;
+};
+
+struct scale_cell {
+    int threads;
+    int pop_size;
+    double wall_t;
+    double gens;            // generations (games / POP_WIDTH for the steady-state engine)
+    prof_totals totals;
+    double speedup;         // strong scaling against the fewest threads at this POP_WIDTH (NOT_SET without one)
+    double efficiency;
+    double weak_efficiency; // against the fewest threads at the same POP_WIDTH per thread (NOT_SET without one)
+};
+
+// a champion layer while it is pruned (weights output by output, like an ann)
+struct champ_layer {
+    int in;
+    int out;
+    double *w;
+    double *b;
+};
+
+struct ckpt_header {
+    uint32_t magic;         // CKPT_MAGIC
+    uint32_t version;       // CKPT_VERSION
+    int32_t pop_size;
+    int32_t gen;            // next generation to run
+    int32_t gen_ct;
+    int32_t env_width;
+    int32_t num_layers;
+    int32_t shape[2 * MAX_NUM_LAYERS];
+    int32_t num_w;          // weights per snake
+    int32_t num_n;          // biases per snake
+    int32_t highscore;
+    float mutate;
+    float survive;
+    int64_t params_seed;    // SEED of the run (NOT_SET without one)
+    uint64_t seed;          // run seed that every thread's stream (and every SEED target's seed) derives from
+    uint64_t weights_off;   // [pop_size][num_w] doubles
+    uint64_t biases_off;    // [pop_size][num_n] doubles
+    uint64_t fitness_off;   // [pop_size] doubles (last evaluated fitness, NOT_SET for unevaluated children)
+    uint64_t moves_off;     // [pop_size] ints (last game length, the longest-first prediction)
+    uint64_t file_size;
+};
+
+struct checkpoint {
+    char file[MAX_LINE_SIZE];
+    char tmp_file[MAX_LINE_SIZE + 8];
+    int every;
+    pid_t writer;           // writer process of the checkpoint in flight (0 when none)
+    int writer_gen;
+    ckpt_header hdr;        // header of the checkpoint in flight
+    double *fitness;        // per snake fitness of the checkpoint in flight
+    long written;
+    long skipped;           // checkpoints skipped while the last one was still being written
+    long failed;
+    int resume;             // CKPT_RESUME or CKPT_INIT_POP when a file is mapped
+    const ckpt_header *map;
+    size_t map_size;
+};
+
+struct metrics_rec {
+    int32_t gen;
+    int32_t island;         // producer ring: island or sweep run (NOT_FOUND without either)
+    double elapsed_s;       // since the metrics stream started
+    int64_t games;
+    double fitness[7];      // min, p25, median, p75, p90, max, mean
+    double fitness_std;
+    double moves[3];        // min, mean, max
+    double apples[3];       // min, mean, max
+    int32_t highscore;
+    int32_t pad;
+    int64_t deaths[NUM_DEATHS];
+    double run_ms;
+    double select_ms;
+    double spawn_ms;
+    double gen_ms;          // run start to the next generation's run start
+    double idle_pct;        // straggler idle of the run phase
+    int64_t steals;
+    double games_per_s;
+    double steps_per_s;
+};
+
+struct metrics_ring {
+    atomic_long head __attribute__((aligned(CACHE_LINE)));  // written by the producing serial step
+    atomic_long tail __attribute__((aligned(CACHE_LINE)));  // written by the writer thread
+    metrics_rec *recs;      // METRICS_RING records
+    double *sorted;         // producer scratch for fitness quantiles
+    long dropped;           // records dropped while the ring was full (producer only)
+};
+
+struct metrics {
+    FILE *file;
+    char file_name[MAX_LINE_SIZE];
+    int format;
+    const char *group_key;  // name of the producer column ("island" or "run")
+    int num_rings;
+    int pop_size;           // size of every ring's quantile scratch
+    metrics_ring *rings;    // one per island or sweep run (one producer each)
+    pthread_t thread;
+    atomic_int seq __attribute__((aligned(CACHE_LINE)));    // pushes (the writer sleeps on it)
+    atomic_int stop;
+    double start_t;
+    long written;
+};
+
+struct lineage_header {
+    uint32_t magic;         // LINEAGE_MAGIC
+    uint32_t version;       // LINEAGE_VERSION
+    int32_t pop_size;
+    int32_t num_layers;
+    int32_t shape[2 * MAX_NUM_LAYERS];
+    int32_t num_w;          // weights per snake (genes [0, num_w))
+    int32_t num_n;          // biases per snake (genes [num_w, num_w + num_n))
+    int32_t keyframe_every;
+    int32_t mask_bytes;     // crossover mask bytes per child
+    int64_t params_seed;
+};
+
+struct lineage_record {
+    uint32_t type;          // LINEAGE_KEY (every snake's genes) or LINEAGE_DELTA (an int32 child count, then the children)
+    int32_t gen;            // generation the population plays after this record
+    uint64_t size;          // payload bytes after this header
+};
+
+struct lineage_child {
+    int32_t child;
+    int32_t parent_a;
+    int32_t parent_b;
+    int32_t num_mut;        // followed by the crossover mask (bit set: gene of parent b) and num_mut (uint32 gene, double value) pairs
+};
+
+struct lineage_buf {
+    unsigned char *data __attribute__((aligned(CACHE_LINE)));
+    size_t len;
+    size_t cap;
+    int ct;                 // children encoded this generation
+};
+
+struct lineage_block {
+    unsigned char *data;    // a record header and its payload
+    size_t len;
+    size_t cap;
+};
+
+struct lineage {
+    FILE *file;
+    char file_name[MAX_LINE_SIZE];
+    int keyframe_every;
+    int num_genes;
+    int mask_bytes;
+    int num_bufs;
+    lineage_buf *bufs;      // per thread encoded children of the current spawn phase
+    lineage_block *ring;    // LINEAGE_RING records handed to the writer thread
+    atomic_long head __attribute__((aligned(CACHE_LINE)));  // written by the serial step
+    atomic_long tail __attribute__((aligned(CACHE_LINE)));  // written by the writer thread
+    atomic_int seq __attribute__((aligned(CACHE_LINE)));    // pushes and writes (both sides sleep on it)
+    atomic_int stop;
+    pthread_t thread;
+    long keyframes;
+    long deltas;
+    double key_bytes;
+    double delta_bytes;
+    int started;
+};
+
+struct perf_thread {
+    int fd[NUM_PERF] __attribute__((aligned(CACHE_LINE)));    // counter fds of this thread (-1 when unavailable)
+    double start[NUM_PERF];                 // counter values at the start of the current phase
+    double gen[NUM_PERF_PHASES][NUM_PERF];  // counts of this generation's phases
+};
+
+struct perf_counters {
+    int num_threads;
+    int island;
+    atomic_int missing[NUM_PERF];           // threads that could not open each counter
+    atomic_int open_errno;                  // first open error (reported once)
+    double gen[NUM_PERF_PHASES][NUM_PERF];  // counts of the last generation summed over threads
+    double total[NUM_PERF_PHASES][NUM_PERF];
+    double gen_units[NUM_PERF_PHASES];      // snake steps run / children spawned in the last generation
+    double total_units[NUM_PERF_PHASES];
+    perf_thread *threads;
+};
+
+struct renderer {
+    int fd;                 // stdout or the REPLAY_FILE
+    int headless;           // whole plain text frames instead of terminal cell updates
+    int dim;
+    int scroll_top;         // first terminal row below the board
+    unsigned char *prev;    // cells on screen
+    unsigned char *cur;     // cells of the frame being rendered
+    char *buf;              // frame bytes, sent in one write
+    size_t buf_size;
+    size_t len;
+    long frames;
+};
+
+struct replay_viewer {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    int min_apples;         // REPLAY threshold
+    int stop;
+    replay_snapshot slots[REPLAY_QUEUE];
+    renderer render;
+    int profile;            // print replay times when the viewer stops
+    double submit_t;        // training time spent snapshotting replays
+    double play_t;          // viewer time spent playing replays
+    long played;
+    long dropped;
+};
+
+struct farm_worker {
+    int fd;
+    int inflight;                   // batches sent and not answered yet
+    int batch[FARM_INFLIGHT];       // answered in the order they were sent
+    double progress_t;              // time of the last send/answer while batches are in flight
+    long games;
+};
+
+struct farm {
+    gs_params *params;
+    ann_set *ann_s;
+    env_set *eval_s;                // single env for local evaluation and replays
+    int listen_fd;
+    farm_worker *workers;
+    int num_workers;
+    int max_workers;
+    int num_batches;
+    int *batch_state;
+    unsigned long long *seed;       // game seed of every snake this generation
+    int *moves;
+    int *apples;
+    gen_stats stats;                // games answered this generation
+    replay_viewer *viewer;
+    unsigned char *buf;
+    size_t buf_size;
+    int highscore;
+    long bytes_sent;
+    long bytes_recv;
+    long requeued;
+    long lost;
+    long local_games;
+    long joined;
+};
+
 struct thread_data {
     ann_set *ann_s;
     env_set *env_s;
-    int *action_set;
     gs_params *params;
     int *surv_idx;
     double *fitness_prob;
+    phase_claim run_claim;
+    phase_claim spawn_claim;
+    int *pred_moves;
+    int *run_order;
+    int *run_sorted;
+    thread_state *threads;
+    int *cpu_order;
+    int num_cpus;
+    unsigned long long seed;
+    double run_start_t;
+    double run_t;
+    double idle_t;
+    double idle_pct;
+    double total_idle_pct;
+    long gen_steals;
+    long total_steals;
+    ranked_pool *pool;
+    island_set *isl;
+    replay_viewer *viewer;
+    profiler *prof;
+    perf_counters *perf;
+    checkpoint *ckpt;
+    lineage *lin;
+    metrics *metrics;
+    metrics_rec gen_metrics;    // metrics of the current generation until it is pushed
+    double spawn_start_t;
+    int island;
+    int cpu_base;
+    long mem_bytes;         // accounted thread data bytes
+    mem_account *acct;      // account the run counts heap bytes into (the one bound on the thread that made it, NULL counts nothing)
+    gs_barrier barrier;
+    int highscore;
+    int finished;
+    int started;            // every shard is initialized (a paused run resumes without them)
+    int stop_gen;           // generation a run pauses before (NOT_SET runs to GEN_COUNT)
+    atomic_int fail;        // first GS_ERR_* code a snake controller thread hit (a failed run stops at its next barrier)
+    gen_stats last_stats;   // merged stats of the last generation run
+};
+
+struct thread_ctx {
+    thread_data *t_data;
+    int tid;
+    int sense;
+};
+
+struct sweep_run {
+    gs_params params;
+    thread_data t_data;
+    int phase;              // SWEEP_RUN, SWEEP_SPAWN, SWEEP_DONE or SWEEP_WAIT (held at an early-stopping rung)
+    atomic_int done;        // targets finished in the current phase
+    int limit;              // targets of the current phase
+    atomic_long busy_ns;    // pool thread time spent on this run (the fair share key)
+    double start_t;
+    double end_t;
+    double best_fitness;    // best single game of the run
+    double final_fitness;   // mean fitness of the last generation
+    double final_apples;    // mean apples of the last generation
+    int gens;               // generations run (fewer than GEN_COUNT when stopped early)
+    int stopped;            // rung the run was stopped at (NOT_FOUND if it ran every generation)
+};
+
+struct engine_worker {
+    gs_engine *engine;
+    int tid;
 };
 
-// multi-threading variables
-int finished_flag;
-int model_flag;
-int curr_target;
-int spawn_setup_flag;
-int wait_run_flag;
-int wait_compute_flag;
-int wait_spawn_flag;
-int wait_reset_flag;
-int run_flag;
-int compute_flag;
-int spawn_flag;
-int reset_flag;
+struct gs_engine {
+    gs_params params;
+    thread_data t_data;
+    thread_ctx ctx[MAX_NUM_THREADS];        // persists every thread's barrier sense between runs
+    engine_worker workers[MAX_NUM_THREADS];
+    pthread_t tid[MAX_NUM_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t go;                      // signalled when a run starts or the engine is destroyed
+    pthread_cond_t idle;                    // signalled when the last worker has finished a run
+    int round;                              // runs started (workers wait for the next one)
+    int num_idle;
+    int quit;
+    unsigned long long rand_state;          // thread 0's random numbers (thread 0 is whichever thread calls gs_engine_run)
+    double run_t;
+};
+
+struct sweep_worker {
+    sweep *sw;
+    int tid;
+};
+
+struct sweep {
+    gs_params *params;      // base parameters (pool size, seed, output)
+    sweep_run *runs;
+    int num_runs;
+    int num_threads;
+    int active;             // runs not done yet
+    pthread_mutex_t lock;   // guards every run's phase, claims and done counter resets
+    pthread_cond_t cond;    // signalled when a phase is armed or the last run is done
+    unsigned long long seed;
+    double start_t;
+    double wall_t;
+    metrics *metrics;
+    int num_rungs;
+    int rung_gens[MAX_RUNGS];   // generation milestone of every rung
+    double *rung_vals[MAX_RUNGS];   // metric of every run that reached the rung, in arrival order (guarded by lock)
+    int *rung_runs[MAX_RUNGS];      // run of every metric of the rung (guarded by lock)
+    int rung_ct[MAX_RUNGS];
+};
 
 //gs driver functions
+void run_genetic_snake(gs_params *, replay_viewer *);
 void genetic_snake(const char *);
 
+// gs scaling harness functions
+double run_quiet(gs_params *);
+void scale_genetic_snake(const char *);
+
+// gs sweep functions
+void sweep_shape_str(gs_params *, char *, size_t);
+void sweep_genetic_snake(const char *);
+
+// gs champion functions
+int champion_index(thread_data *, double *);
+int export_champion(ann *, int, double, int, int, double, const char *);
+void save_champion(thread_data *, int);
+void play_champion(const char *);
+
+// gs checkpoint functions
+int open_checkpoint(thread_data *, char *, size_t);
+checkpoint * init_checkpoint(thread_data *);
+void restore_shard(thread_data *, int, int);
+void checkpoint_gen(thread_data *);
+void finish_checkpoint(thread_data *);
+int save_population(gs_params *, ann_set *, int, const char *);
+
+// gs metrics functions
+int create_metrics(gs_params *, int, const char *, metrics **, char *, size_t);
+metrics * start_metrics(gs_params *, int, const char *);
+void collect_gen_metrics(thread_data *, gen_stats *);
+void push_gen_metrics(thread_data *);
+void stop_metrics(metrics *);
+
+// gs lineage functions
+int create_lineage(thread_data *, char *, size_t);
+lineage * init_lineage(thread_data *);
+void log_child(thread_data *, int, int, int, int);
+void log_lineage(thread_data *);
+void finish_lineage(thread_data *);
+void rebuild_lineage(const char *, int, const char *);
+
+// gs auto-tuner functions
+void autotune(gs_params *);
+
 // gs utils functions
 int rand_int(int, int);
 double rand_double(int, int);
 double rand_norm(void);
 int rand_roulette(int, double *);
 void compute_set_fitness(ann_set *, env_set *);
+void reset_gen_stats(gen_stats *);
+void add_game_stats(gen_stats *, int, double, int, int, int);
+void merge_gen_stats(gen_stats *, gen_stats *);
 void compute_ann_fitness(ann_set *, env_set *, int);
+int create_thread_data_struct(thread_data *, gs_params *);
 void init_thread_data_struct(thread_data *t_data, gs_params *params);
-void init_thread_variables();
+void free_thread_data_struct(thread_data *);
+void init_phase_claim(phase_claim *, int, int, int, int);
+void seed_rand(unsigned long long);
+unsigned long long get_rand_state(void);
+void set_rand_state(unsigned long long);
+double game_fitness(int, int);
+double rand_unit(void);
+unsigned long long rand_u64(void);
+gs_params * init_parameters_struct(void);
+int check_parameters(gs_params *, char *, size_t);
 gs_params * read_parameters_from_file(const char *);
+gs_params * read_parameters_override(const char *, int, int);
+
+// gs scheduler functions
+double get_time();
+int moves_bucket(int);
+void build_run_order(thread_data *);
+int pop_run_target(thread_data *, int);
+int shard_start(int, int, int);
+void build_cpu_order(thread_data *);
+int pin_thread(thread_data *, int);
+void compute_straggler_idle(thread_data *);
 
 // gs print functions
 void print_model_parameters(gs_params *);
 void print_start_prompt();
-void print_pop_stats(ann_set *, env_set *);
-void print_gen_stats(int, int *, ann_set *, env_set *, int);
+void print_pop_stats(gen_stats *);
+void print_gen_stats(int, int, int *, gen_stats *, ann_set *, env_set *, replay_viewer *);
+void print_claim_stats(thread_data *);
+void print_sched_stats(int, thread_data *);
+void print_ann_run_replay(replay_snapshot *, renderer *);
+void print_eval_stats(eval_stats *);
+void print_island_stats(island_set *);
+void print_profile(profiler *);
+void print_perf_stats(int, perf_counters *);
+void print_perf_summary(perf_counters *);
+void print_mem_stats(mem_account *);
+void print_mem_summary(gs_params *, mem_account *);
+void print_scale_results(scale_cell *, int);
+void print_sweep_results(sweep *, int *);
+void print_farm_stats(int, farm *);
+void print_farm_summary(farm *);
+
+// gs barrier functions
+int create_barrier(gs_barrier *, int, int);
+void init_barrier(gs_barrier *, int, int);
+void free_barrier(gs_barrier *);
+int barrier_wait(gs_barrier *, int, int *, serial_funct, void *);
 
 // gs thread functions
+int claim_targets(phase_claim *, int, thread_state *, int *, int *);
+void run_target(thread_data *, int, int);
+void spawn_targets(thread_data *, int, int, int);
+int init_shard_thread(thread_data *, int);
 void * snake_controller_thread(void *);
-void * model_controller_thread(void *);
+
+// gs steady-state functions
+void init_ranked_pool(ranked_pool *, int, int);
+void free_ranked_pool(ranked_pool *);
+void * steady_controller_thread(void *);
+
+// gs island functions
+void init_island_set(island_set *, gs_params *);
+void free_island_set(island_set *);
+void emigrate(thread_data *);
+void immigrate(thread_data *);
+
+// gs profiler functions
+profiler * init_profiler(gs_params *, int, int);
+void free_profiler(profiler *);
+void prof_add(profiler *, int, int, double, double, int, long);
+void prof_lock(profiler *, int, pthread_mutex_t *);
+void sum_profile(profiler *, prof_totals *);
+void finish_profile(profiler **, int, prof_totals *);
+
+// gs memory accounting functions
+extern __thread mem_account *mem_acct;
+long mem_chunk(long);
+void init_mem_account(mem_account *);
+void mem_add(int, long);
+void mem_bind(mem_account *, long *);
+mem_account * mem_bound(void);
+void mem_merge(mem_account *, long *);
+long mem_live(mem_account *, int);
+long mem_peak(mem_account *, int);
+long env_body_bytes(env *);
+long env_log_bytes(env *);
+long estimate_footprint(gs_params *, long *);
+int apply_memory_budget(gs_params *, char *, size_t);
+
+// gs hardware counter functions
+int create_perf_counters(gs_params *, int, int, perf_counters **);
+perf_counters * init_perf_counters(gs_params *, int, int);
+void free_perf_counters(perf_counters *);
+void perf_open_thread(perf_counters *, int);
+void perf_begin(perf_counters *, int);
+void perf_end(perf_counters *, int, int);
+void perf_merge_gen(perf_counters *, double, double);
+void perf_report_missing(perf_counters *);
+
+// gs render functions
+int create_renderer(renderer *, int, const char *, char *, size_t);
+void free_renderer(renderer *);
+void render_begin(renderer *, const char *);
+void render_frame(renderer *, env *, const char *);
+void render_end(renderer *);
+void render_text(renderer *, const char *);
+
+// gs replay functions
+replay_viewer * start_replay_viewer(gs_params *);
+void stop_replay_viewer(replay_viewer *);
+void submit_replay(replay_viewer *, int, int, ann *, env *);
+
+// gs farm functions
+void farm_genetic_snake(gs_params *, replay_viewer *);
+void farm_worker_main(const char *);
 
 #endif /* gsdefs_h */
@@ -10,15 +10,19 @@
 
 #include <math.h>
 #include "envdefs.h"
+#include "snake_champion.h"
 
 // macro to return index of 2D array in a 1D representation
 #define RIDX(i,j,d) (j + i * d)
 
 #define SHAPE_DIM 2
 
+#define CHAMP_CLOCK_READS 1024  // back to back clock reads that calibrate a latency measurement
+
 typedef struct ann ann;
 typedef struct ann_set ann_set;
 typedef double (*funct) (double);
+typedef void (*dense_funct) (const double *, const double *, const double *, int, int, double *);
 
 struct ann {
     int num_l;
@@ -39,9 +43,24 @@ struct ann_set {
     ann *data;
 };
 
+// a loaded champion: every layer's input-major weights, biases and activations live in one allocation
+struct gs_champion {
+    gs_champion_info info;
+    int num_l;
+    int in[GS_MAX_LAYERS];
+    int out[GS_MAX_LAYERS];
+    const double *w[GS_MAX_LAYERS];
+    const double *b[GS_MAX_LAYERS];
+    dense_funct kernel[GS_MAX_LAYERS];  // specialized to the layer's width when there is one
+    double *a;                          // activations of even layers
+    double *a_next;                     // activations of odd layers
+    double *mem;
+};
+
 // nn functs
 double sigmoid(double);
 void destroy_ann(ann *);
+int create_ann(ann *, int, int *, funct *);
 void init_ann(ann *, int, int *, funct *);
 double * forward(ann *, int, int, double *);
 void set_parameters(ann *, double *, double *);
@@ -49,6 +68,9 @@ void copy_parameters(ann *, ann *);
 
 // nn controller functions
 void free_ann_set(ann_set *);
+void release_ann_set(ann_set *);
+void alloc_ann_set(ann_set *, int);
+int create_ann_range(ann_set *, int, int, int, int *, funct *);
 void init_ann_set(ann_set *, int, int, int *, funct *);
 void spawn_ann(double, ann *, ann *, ann *);
 void determine_most_fit_parents(int, double, int *, double *, ann_set *);
@@ -0,0 +1,77 @@
+//
+//  snake_champion.h
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#ifndef snake_champion_h
+#define snake_champion_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "genetic_snake.h"
+
+#define GS_CHAMP_MAGIC 0x48434753       // "GSCH"
+#define GS_CHAMP_VERSION 1
+#define GS_CHAMP_SIGMOID 0
+
+typedef struct gs_champion_header gs_champion_header;
+typedef struct gs_champion gs_champion;
+typedef struct gs_champion_info gs_champion_info;
+typedef struct gs_champion_latency gs_champion_latency;
+
+// frozen champion file: this header, then every layer's weights input by input (the runtime's kernel order), then the biases as doubles
+struct gs_champion_header {
+    uint32_t magic;                     // GS_CHAMP_MAGIC
+    uint32_t version;                   // GS_CHAMP_VERSION
+    int32_t format;                     // GS_CHAMP_DOUBLE, GS_CHAMP_FLOAT, GS_CHAMP_INT16 or GS_CHAMP_INT8
+    int32_t num_layers;
+    int32_t shape[2 * GS_MAX_LAYERS];   // inputs and outputs of every layer (after pruning)
+    int32_t activation[GS_MAX_LAYERS];  // GS_CHAMP_SIGMOID
+    int32_t num_w;
+    int32_t num_n;
+    int32_t pruned_w;                   // weights pruned to zero
+    int32_t pruned_n;                   // hidden neurons removed (or folded into the next layer's biases)
+    int32_t gen;                        // generation the champion played in
+    int32_t apples;                     // apples of that game
+    double fitness;
+    float scale[GS_MAX_LAYERS];         // integer weight of a layer times its scale is the weight
+    uint64_t weights_off;
+    uint64_t biases_off;
+    uint64_t file_size;
+};
+
+struct gs_champion_info {
+    int num_layers;
+    int shape[2 * GS_MAX_LAYERS];
+    int format;
+    int num_w;
+    int num_n;
+    int pruned_w;
+    int pruned_n;
+    int gen;
+    int apples;
+    double fitness;
+    size_t file_size;
+    size_t bytes;                       // everything a loaded champion holds
+};
+
+struct gs_champion_latency {
+    long decisions;
+    double mean_ns;                     // per decision, every decision timed on its own
+    double p50_ns;
+    double p99_ns;
+    double min_ns;
+    double clock_ns;                    // median clock read cost, taken off every decision's time
+};
+
+// inference runtime functions (a champion is not thread safe, load one per thread)
+int gs_champion_load(const char *, gs_champion **, char *, size_t);
+int gs_champion_decide(gs_champion *, const double *);
+int gs_champion_decide_batch(gs_champion *, const double *, int, int *);
+int gs_champion_get_info(gs_champion *, gs_champion_info *);
+int gs_champion_measure(gs_champion *, const double *, int, int, gs_champion_latency *);
+void gs_champion_free(gs_champion *);
+
+#endif /* snake_champion_h */
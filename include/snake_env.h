@@ -0,0 +1,79 @@
+//
+//  snake_env.h
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#ifndef snake_env_h
+#define snake_env_h
+
+#include <stddef.h>
+#include "genetic_snake.h"
+
+// actions (the same moves the trainer's snakes make)
+#define GS_ENV_UP 1
+#define GS_ENV_DOWN 2
+#define GS_ENV_LEFT 3
+#define GS_ENV_RIGHT 4
+
+// features of a game's observation: distances to the wall, body and apple along 8 rays
+#define GS_ENV_NUM_FEATURES 24
+#define GS_ENV_NOT_FOUND -1             // a body or apple ray that hits nothing
+#define GS_ENV_DIM 20
+
+// cells of the board grid observation
+#define GS_ENV_EMPTY 0
+#define GS_ENV_BODY 1
+#define GS_ENV_HEAD 2
+#define GS_ENV_APPLE 3
+
+// how an episode ended
+#define GS_ENV_DEATH_NONE 0             // the board has no room left for an apple
+#define GS_ENV_DEATH_WALL 1
+#define GS_ENV_DEATH_SELF 2
+#define GS_ENV_DEATH_TIMEOUT 3          // no apple in 150 moves
+#define GS_ENV_DEATH_REVERSE 4
+
+typedef struct gs_venv gs_venv;
+typedef struct gs_venv_config gs_venv_config;
+typedef struct gs_venv_episode gs_venv_episode;
+typedef struct gs_venv_stats gs_venv_stats;
+
+struct gs_venv_episode {
+    int apples;
+    int moves;
+    int death;
+};
+
+// every buffer belongs to the caller and is bound once (reset and step write into them in place)
+struct gs_venv_config {
+    int num_games;
+    int dim;                            // board width (at most 255)
+    unsigned long long seed;            // game i starts from seed + i
+    int auto_reset;                     // a finished game starts its next episode in the same step
+    const int *actions;                 // num_games actions read by every step
+    double *obs;                        // num_games * GS_ENV_NUM_FEATURES features (or NULL)
+    unsigned char *grid;                // num_games * dim * dim cells, row by row (or NULL)
+    float *rewards;                     // 1 for an apple, -1 for a death, 0 otherwise (or NULL)
+    unsigned char *dones;               // 1 when the step ended the game's episode, until a reset without auto_reset (or NULL)
+    gs_venv_episode *episodes;          // a game's last finished episode (or NULL)
+};
+
+struct gs_venv_stats {
+    long long steps;                    // game steps (every game of a batch step is one)
+    long long episodes;                 // finished episodes
+    long long apples;
+    double seconds;                     // time spent in gs_venv_step
+    double steps_per_sec;
+};
+
+// vectorized env library functions (an env is not thread safe, but envs share nothing)
+void gs_venv_config_init(gs_venv_config *);
+int gs_venv_create(const gs_venv_config *, gs_venv **, char *, size_t);
+int gs_venv_reset(gs_venv *, const unsigned long long *);
+int gs_venv_step(gs_venv *);
+int gs_venv_get_stats(gs_venv *, gs_venv_stats *);
+void gs_venv_destroy(gs_venv *);
+
+#endif /* snake_env_h */
@@ -0,0 +1,473 @@
+//
+//  gsbench.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "gsdefs.h"
+
+#define BENCH_SEED 20210417ULL
+#define BENCH_SAMPLES 10
+#define BENCH_SAMPLE_T 0.02
+#define BENCH_THRESHOLD 10.0
+#define BENCH_POP 500
+#define BENCH_DIM 20
+#define BENCH_MAX_MOVES 4096
+#define BENCH_MAX_RESULTS 16
+#define BENCH_VEC_BATCHES 64
+
+typedef struct bench_ctx bench_ctx;
+typedef struct bench_result bench_result;
+typedef double (*bench_funct) (bench_ctx *, long);
+
+// fixed inputs shared by every kernel (rebuilt from the same seed for every run)
+struct bench_ctx {
+    ann net;
+    ann parent_a;
+    ann parent_b;
+    ann child;
+    env_set *env_s;
+    ann_set *ann_s;
+    int *surv_idx;
+    double *fitness_prob;
+    int *actions;
+    int num_actions;
+    int num_apples;
+    gs_venv *venv;
+    int *vec_actions;       // BENCH_VEC_BATCHES batches of random actions for BENCH_POP games
+    double *vec_obs;
+    gs_champion *champ;     // the bench net exported as a double champion
+    volatile double sink;   // kernel outputs land here so the optimizer keeps the kernels
+};
+
+struct bench_result {
+    char name[MAX_STR_SIZE];
+    double mean;
+    double stddev;
+    double min;
+    long ops;
+};
+
+static int shape[] = { 24, 12, 12, 8, 8, 4 };
+static funct activation[] = { sigmoid, sigmoid, sigmoid };
+
+
+/*
+ * greedy_action - Returns the move towards the apple that does not hit a wall or the body if there is one (records a long game to replay)
+ */
+static int greedy_action(env *e)
+{
+    int horiz = (e->a->x < e->h->x)? LEFT: RIGHT;
+    int vert = (e->a->y < e->h->y)? UP: DOWN;
+    int order[4], dx, dy, x, y, safe;
+    snake_node *curr;
+
+    // towards the apple first (along the axis it is off on), then away from it
+    order[0] = (e->a->x != e->h->x)? horiz: vert;
+    order[1] = (e->a->x != e->h->x)? vert: horiz;
+    order[2] = (order[1] == LEFT)? RIGHT: (order[1] == RIGHT)? LEFT: (order[1] == UP)? DOWN: UP;
+    order[3] = (order[0] == LEFT)? RIGHT: (order[0] == RIGHT)? LEFT: (order[0] == UP)? DOWN: UP;
+
+    for (int i = 0; i < 4; i++) {
+        dx = (order[i] == LEFT)? -1: (order[i] == RIGHT)? 1: 0;
+        dy = (order[i] == UP)? -1: (order[i] == DOWN)? 1: 0;
+        x = e->h->x + dx;
+        y = e->h->y + dy;
+        safe = (x >= 1) && (x <= e->env_dim) && (y >= 1) && (y <= e->env_dim);
+        for (curr = e->h->c; (curr != NULL) && safe; curr = curr->c) { if ((curr->x == x) && (curr->y == y)) { safe = 0; } }
+        if (safe) { return order[i]; }
+    }
+    return order[0];
+}
+
+
+/*
+ * restart_game - Resets the bench env to the start of the recorded game (reseeding makes every apple land where it did when it was recorded)
+ */
+static void restart_game(bench_ctx *ctx)
+{
+    seed_rand(BENCH_SEED);
+    reset_env(&ctx->env_s->data[0]);
+    update_dist_data(ctx->env_s, 0);
+    return;
+}
+
+
+/*
+ * init_bench_ctx - Builds the networks, env, population and recorded game every kernel runs on
+ */
+static void init_bench_ctx(bench_ctx *ctx)
+{
+    gs_venv_config vec_config;
+    char champ_file[] = "/tmp/gsbench_champ_XXXXXX";
+    int fd;
+    env *e;
+
+    seed_rand(BENCH_SEED);
+    init_ann(&ctx->net, 3, shape, activation);
+    init_ann(&ctx->parent_a, 3, shape, activation);
+    init_ann(&ctx->parent_b, 3, shape, activation);
+    init_ann(&ctx->child, 3, shape, activation);
+    for (int k = 0; k < ctx->net.num_w; k++) { ctx->net.w[k] = rand_norm(); ctx->parent_a.w[k] = rand_norm(); ctx->parent_b.w[k] = rand_norm(); }
+    for (int k = 0; k < ctx->net.num_n; k++) { ctx->net.b[k] = rand_norm(); ctx->parent_a.b[k] = rand_norm(); ctx->parent_b.b[k] = rand_norm(); }
+
+    // a population for parent selection
+    ctx->ann_s = (ann_set *) malloc(sizeof(ann_set));
+    init_ann_set(ctx->ann_s, BENCH_POP, 3, shape, activation);
+    ctx->surv_idx = (int *) malloc(BENCH_POP * sizeof(int));
+    ctx->fitness_prob = (double *) malloc(BENCH_POP * sizeof(double));
+
+    // record a greedy game to replay move by move
+    ctx->env_s = (env_set *) malloc(sizeof(env_set));
+    seed_rand(BENCH_SEED);
+    init_env_set(ctx->env_s, 1, BENCH_DIM);
+    e = &ctx->env_s->data[0];
+    ctx->actions = (int *) malloc(BENCH_MAX_MOVES * sizeof(int));
+    ctx->num_actions = 0;
+    while ((e->alive) && (ctx->num_actions < BENCH_MAX_MOVES)) {
+        ctx->actions[ctx->num_actions] = greedy_action(e);
+        run_env_action(ctx->actions[ctx->num_actions++], e);
+    }
+    ctx->num_apples = e->n;
+    restart_game(ctx);
+
+    // a vectorized env of a population's games on random actions (reverses and walls end games early, like an untrained population)
+    ctx->vec_actions = (int *) malloc(BENCH_VEC_BATCHES * BENCH_POP * sizeof(int));
+    ctx->vec_obs = (double *) malloc(BENCH_POP * GS_ENV_NUM_FEATURES * sizeof(double));
+    for (int k = 0; k < BENCH_VEC_BATCHES * BENCH_POP; k++) { ctx->vec_actions[k] = rand_int(UP, RIGHT + 1); }
+    gs_venv_config_init(&vec_config);
+    vec_config.num_games = BENCH_POP;
+    vec_config.dim = BENCH_DIM;
+    vec_config.seed = BENCH_SEED;
+    vec_config.actions = ctx->vec_actions;
+    vec_config.obs = ctx->vec_obs;
+    if (gs_venv_create(&vec_config, &ctx->venv, NULL, 0) != GS_OK) {
+        printf("\n\nERR: could not create the bench vectorized env\n\n\n");
+        exit(127);
+    }
+
+    // the bench net as a frozen champion (the file is only needed until it is loaded)
+    fd = mkstemp(champ_file);
+    if ((fd < 0) || (export_champion(&ctx->net, GS_CHAMP_DOUBLE, 0, 0, 0, 0, champ_file) != 0) || (gs_champion_load(champ_file, &ctx->champ, NULL, 0) != GS_OK)) {
+        printf("\n\nERR: could not export the bench champion\n\n\n");
+        exit(127);
+    }
+    close(fd);
+    unlink(champ_file);
+    ctx->sink = 0;
+    return;
+}
+
+
+/*
+ * free_bench_ctx - Frees every kernel input
+ */
+static void free_bench_ctx(bench_ctx *ctx)
+{
+    destroy_ann(&ctx->net);
+    destroy_ann(&ctx->parent_a);
+    destroy_ann(&ctx->parent_b);
+    destroy_ann(&ctx->child);
+    free_ann_set(ctx->ann_s);
+    free_env_set(ctx->env_s);
+    free(ctx->surv_idx);
+    free(ctx->fitness_prob);
+    free(ctx->actions);
+    gs_venv_destroy(ctx->venv);
+    free(ctx->vec_actions);
+    free(ctx->vec_obs);
+    gs_champion_free(ctx->champ);
+    return;
+}
+
+
+/*
+ * bench_run_ann - Times run_ann on the start of the recorded game
+ */
+static double bench_run_ann(bench_ctx *ctx, long n)
+{
+    double start_t;
+
+    restart_game(ctx);
+    start_t = get_time();
+    for (long i = 0; i < n; i++) { ctx->sink += run_ann(&ctx->net, &ctx->env_s->dist_d[0]); }
+    return get_time() - start_t;
+}
+
+
+/*
+ * bench_forward - Times forward on the start of the recorded game (including freeing its output)
+ */
+static double bench_forward(bench_ctx *ctx, long n)
+{
+    double *y;
+    double start_t;
+
+    restart_game(ctx);
+    start_t = get_time();
+    for (long i = 0; i < n; i++) {
+        y = forward(&ctx->net, 1, 24, (double *) &ctx->env_s->dist_d[0]);
+        ctx->sink += y[0];
+        free(y);
+    }
+    return get_time() - start_t;
+}
+
+
+/*
+ * bench_run_env_action - Times run_env_action over the recorded game (restarting it between replays is not timed)
+ */
+static double bench_run_env_action(bench_ctx *ctx, long n)
+{
+    env *e = &ctx->env_s->data[0];
+    double elapsed = 0, start_t;
+    long i = 0;
+    int m;
+
+    restart_game(ctx);
+    while (i < n) {
+        start_t = get_time();
+        for (m = 0; (m < ctx->num_actions) && (i < n); m++, i++) { run_env_action(ctx->actions[m], e); }
+        elapsed += get_time() - start_t;
+        restart_game(ctx);
+    }
+    return elapsed;
+}
+
+
+/*
+ * bench_update_dist_data - Times update_dist_data halfway into the recorded game (a longer snake than at the start)
+ */
+static double bench_update_dist_data(bench_ctx *ctx, long n)
+{
+    double start_t;
+
+    restart_game(ctx);
+    for (int m = 0; m < ctx->num_actions / 2; m++) { run_env_action(ctx->actions[m], &ctx->env_s->data[0]); }
+    start_t = get_time();
+    for (long i = 0; i < n; i++) { update_dist_data(ctx->env_s, 0); }
+    return get_time() - start_t;
+}
+
+
+/*
+ * bench_spawn_ann - Times spawn_ann from two fixed parents
+ */
+static double bench_spawn_ann(bench_ctx *ctx, long n)
+{
+    double start_t = get_time();
+    for (long i = 0; i < n; i++) { spawn_ann(0.01, &ctx->parent_a, &ctx->parent_b, &ctx->child); }
+    ctx->sink += ctx->child.w[0];
+    return get_time() - start_t;
+}
+
+
+/*
+ * bench_determine_most_fit_parents - Times parent selection over a population of shuffled fitness (refilling it is not timed)
+ */
+static double bench_determine_most_fit_parents(bench_ctx *ctx, long n)
+{
+    double elapsed = 0, start_t;
+
+    for (long i = 0; i < n; i++) {
+        for (int k = 0; k < BENCH_POP; k++) { ctx->ann_s->fitness[k] = rand_double(0, 1000); }
+        start_t = get_time();
+        determine_most_fit_parents(BENCH_POP, 0.05, ctx->surv_idx, ctx->fitness_prob, ctx->ann_s);
+        elapsed += get_time() - start_t;
+    }
+    ctx->sink += ctx->fitness_prob[0];
+    return elapsed;
+}
+
+
+/*
+ * bench_rand_norm - Times rand_norm
+ */
+static double bench_rand_norm(bench_ctx *ctx, long n)
+{
+    double start_t = get_time();
+    for (long i = 0; i < n; i++) { ctx->sink += rand_norm(); }
+    return get_time() - start_t;
+}
+
+
+/*
+ * bench_reset_env - Times reset_env on the finished recorded game (replaying it is not timed)
+ */
+static double bench_reset_env(bench_ctx *ctx, long n)
+{
+    env *e = &ctx->env_s->data[0];
+    double elapsed = 0, start_t;
+
+    restart_game(ctx);
+    for (long i = 0; i < n; i++) {
+        for (int m = 0; m < ctx->num_actions; m++) { run_env_action(ctx->actions[m], e); }
+        seed_rand(BENCH_SEED);
+        start_t = get_time();
+        reset_env(e);
+        elapsed += get_time() - start_t;
+    }
+    update_dist_data(ctx->env_s, 0);
+    return elapsed;
+}
+
+
+/*
+ * bench_vec_env_step - Times gs_venv_step per game step (every batch steps BENCH_POP games, auto-resetting the finished ones)
+ */
+static double bench_vec_env_step(bench_ctx *ctx, long n)
+{
+    double start_t;
+    long steps = 0;
+    int batch = 0;
+
+    start_t = get_time();
+    while (steps < n) {
+        ctx->venv->actions = ctx->vec_actions + batch * BENCH_POP;
+        gs_venv_step(ctx->venv);
+        batch = (batch + 1) % BENCH_VEC_BATCHES;
+        steps += BENCH_POP;
+    }
+    ctx->sink += ctx->vec_obs[0];
+    return (get_time() - start_t) * n / steps;
+}
+
+
+/*
+ * bench_champion_decide - Times gs_champion_decide of the bench net on the start of the recorded game (compare to run_ann)
+ */
+static double bench_champion_decide(bench_ctx *ctx, long n)
+{
+    double start_t;
+
+    restart_game(ctx);
+    start_t = get_time();
+    for (long i = 0; i < n; i++) { ctx->sink += gs_champion_decide(ctx->champ, (double *) &ctx->env_s->dist_d[0]); }
+    return get_time() - start_t;
+}
+
+
+/*
+ * run_bench - Calibrates a kernel to the sample time and returns the mean, deviation and minimum ns/op over a number of samples
+ */
+static void run_bench(bench_ctx *ctx, const char *name, bench_funct kernel, int samples, bench_result *res)
+{
+    double elapsed, ns, sum = 0, sum_sq = 0;
+    long n = 1;
+
+    // warm up and double the ops until a sample takes long enough to time
+    while (((elapsed = kernel(ctx, n)) < BENCH_SAMPLE_T) && (n < (1L << 40))) { n *= 2; }
+
+    snprintf(res->name, sizeof(res->name), "%s", name);
+    res->min = -1;
+    res->ops = n;
+    for (int s = 0; s < samples; s++) {
+        ns = 1e9 * kernel(ctx, n) / n;
+        sum += ns;
+        sum_sq += ns * ns;
+        if ((res->min < 0) || (ns < res->min)) { res->min = ns; }
+    }
+    res->mean = sum / samples;
+    res->stddev = (samples > 1)? sqrt(fmax(0, (sum_sq - samples * res->mean * res->mean) / (samples - 1))): 0;
+    fprintf(stderr, "  %-28s %12.1f ns/op  (+- %0.1f)\n", name, res->mean, res->stddev);
+    return;
+}
+
+
+/*
+ * read_baseline - Reads a benchmark's mean and deviation from a previous run's JSON output and returns 0 if it is not there
+ */
+static int read_baseline(const char *file_name, const char *name, double *mean, double *stddev)
+{
+    FILE *file = fopen(file_name, "r");
+    char line[MAX_LINE_SIZE], key[MAX_LINE_SIZE];
+    int found = 0;
+
+    if (file == NULL) {
+        perror(file_name);
+        exit(127);
+    }
+
+    // every result is a single line of the JSON output
+    snprintf(key, sizeof(key), "\"name\": \"%.*s\"", MAX_STR_SIZE, name);
+    while ((!found) && (fgets(line, sizeof(line), file) != NULL)) {
+        if (strstr(line, key) == NULL) continue;
+        found = (sscanf(strstr(line, "\"ns_per_op\""), "\"ns_per_op\": %lf", mean) == 1) &&
+            (sscanf(strstr(line, "\"stddev\""), "\"stddev\": %lf", stddev) == 1);
+    }
+    fclose(file);
+    return found;
+}
+
+
+/*
+ * main - Runs every kernel benchmark and prints JSON results, comparing them to a baseline with -compare <file>
+ */
+int main(int argc, const char *argv[])
+{
+    const char *names[] = { "run_ann", "forward", "run_env_action", "update_dist_data", "spawn_ann", "determine_most_fit_parents", "rand_norm", "reset_env", "vec_env_step", "champion_decide" };
+    bench_funct kernels[] = { bench_run_ann, bench_forward, bench_run_env_action, bench_update_dist_data, bench_spawn_ann, bench_determine_most_fit_parents, bench_rand_norm, bench_reset_env, bench_vec_env_step, bench_champion_decide };
+    int num_bench = sizeof(kernels) / sizeof(bench_funct);
+    const char *baseline = NULL;
+    const char *filter = NULL;
+    double threshold = BENCH_THRESHOLD;
+    int samples = BENCH_SAMPLES;
+    bench_result res[BENCH_MAX_RESULTS];
+    double base_mean, base_sd, change;
+    int num_res = 0, regressions = 0, regressed;
+    bench_ctx ctx;
+
+    // options
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-compare") == 0) && (i + 1 < argc)) { baseline = argv[++i]; }
+        else if ((strcmp(argv[i], "-threshold") == 0) && (i + 1 < argc)) { threshold = atof(argv[++i]); }
+        else if ((strcmp(argv[i], "-samples") == 0) && (i + 1 < argc)) { samples = atoi(argv[++i]); }
+        else if ((strcmp(argv[i], "-filter") == 0) && (i + 1 < argc)) { filter = argv[++i]; }
+        else {
+            printf("\n\nERR: usage: bench [-compare <baseline.json>] [-threshold <pct>] [-samples <n>] [-filter <name>]\n\n\n");
+            exit(127);
+        }
+    }
+    if (samples < 2) {
+        printf("\n\nERR: bench needs at least 2 samples per kernel for a deviation\n\n\n");
+        exit(127);
+    }
+
+    // every kernel runs on the same seeded inputs
+    init_bench_ctx(&ctx);
+    fprintf(stderr, "\n+++++++  BENCHMARKS  +++++++\n\n  recorded game - %d moves, %d apples\n\n", ctx.num_actions, ctx.num_apples);
+    restart_game(&ctx);
+    for (int b = 0; b < num_bench; b++) {
+        if ((filter != NULL) && (strstr(names[b], filter) == NULL)) continue;
+        run_bench(&ctx, names[b], kernels[b], samples, &res[num_res++]);
+        if (kernels[b] == bench_vec_env_step) { fprintf(stderr, "  %-28s %12.2f M steps/s\n", "", 1e3 / res[num_res - 1].mean); }
+    }
+
+    // results as JSON on stdout, one result per line
+    printf("{\"seed\": %llu, \"samples\": %d, \"results\": [\n", BENCH_SEED, samples);
+    for (int r = 0; r < num_res; r++) {
+        printf("  {\"name\": \"%s\", \"ns_per_op\": %0.3f, \"stddev\": %0.3f, \"min\": %0.3f, \"ops\": %ld", res[r].name, res[r].mean, res[r].stddev, res[r].min, res[r].ops);
+
+        // a regression has to be over the threshold and outside the noise of both runs
+        if ((baseline != NULL) && (read_baseline(baseline, res[r].name, &base_mean, &base_sd))) {
+            change = 100.0 * (res[r].mean - base_mean) / base_mean;
+            regressed = (change > threshold) && (res[r].mean - base_mean > 2 * sqrt(res[r].stddev * res[r].stddev + base_sd * base_sd));
+            printf(", \"baseline\": %0.3f, \"change_pct\": %0.2f, \"regression\": %s", base_mean, change, (regressed)? "true": "false");
+            if (regressed) {
+                fprintf(stderr, "\nWARN: %s regressed %0.2f%% (%0.1f -> %0.1f ns/op)\n", res[r].name, change, base_mean, res[r].mean);
+                regressions++;
+            }
+        }
+        printf("}%s\n", (r + 1 < num_res)? ",": "");
+    }
+    printf("], \"regressions\": %d}\n", regressions);
+
+    free_bench_ctx(&ctx);
+    return (regressions > 0)? 1: 0;
+}
@@ -0,0 +1,123 @@
+#!/bin/sh
+#
+#  check.sh
+#  genetic-snake
+#
+#  Created by Alexander Gonsalves
+#  04/17/2021
+#
+#  Command line regression checks of bin/main and bin/bench, run by make check after bin/check.
+#  The model checks train small seeded populations in a temporary directory.
+
+MAIN=bin/main
+BENCH=bin/bench
+DIR=$(mktemp -d) || exit 1
+FAILED=0
+RUN=0
+trap 'rm -rf "$DIR"' EXIT
+
+
+# write_params - Writes a small seeded parameters file with a given thread count and generation count, followed by any extra lines
+write_params() {
+    file=$1; threads=$2; gens=$3; shift 3
+    printf 'POP_WIDTH 100\nGEN_COUNT %s\nMUTATE 0.05\nSURVIVE 0.1\nLAYER 24 8 sigmoid\nLAYER 8 4 sigmoid\nTHREADS %s\nREPLAY 0\nSEED 11\n' "$gens" "$threads" > "$file"
+    for line in "$@"; do printf '%s\n' "$line" >> "$file"; done
+}
+
+
+# gen_lines - Prints the generation reports of a run without its timings (from an optional first generation on)
+gen_lines() {
+    grep -A1 ":: GEN" "$1" | grep -v -- "^--" | awk -v from="${2:-0}" '/:: GEN/ { keep = ($3 >= from) } keep'
+}
+
+
+# result - Prints the outcome of a check (a failed check prints why)
+result() {
+    RUN=$((RUN + 1))
+    if [ "$2" = ok ]; then printf '  ok    %s\n' "$1"
+    else printf '  FAIL  %s: %s\n' "$1" "$2"; FAILED=$((FAILED + 1)); fi
+}
+
+
+# check_threads - Checks that a seeded run plays the same generations on 1 and 3 threads
+check_threads() {
+    write_params "$DIR/t1" 1 100
+    write_params "$DIR/t3" 3 100
+    $MAIN "$DIR/t1" > "$DIR/t1.out" < /dev/null && $MAIN "$DIR/t3" > "$DIR/t3.out" < /dev/null || { result threads "a run failed"; return; }
+    gen_lines "$DIR/t1.out" > "$DIR/t1.gen"
+    gen_lines "$DIR/t3.out" > "$DIR/t3.gen"
+    if [ ! -s "$DIR/t1.gen" ]; then result threads "no generations reported"
+    elif cmp -s "$DIR/t1.gen" "$DIR/t3.gen"; then result threads ok
+    else result threads "1 and 3 threads report different generations"; fi
+}
+
+
+# check_resume - Checks that a run resumed from its checkpoint reports the same generations as a run that was never stopped
+check_resume() {
+    write_params "$DIR/half" 3 100 "CHECKPOINT $DIR/half.ckpt 50"
+    write_params "$DIR/rest" 3 150 "RESUME $DIR/half.ckpt"
+    write_params "$DIR/full" 3 150
+    $MAIN "$DIR/half" > /dev/null < /dev/null && $MAIN "$DIR/rest" > "$DIR/rest.out" < /dev/null && $MAIN "$DIR/full" > "$DIR/full.out" < /dev/null || { result resume "a run failed"; return; }
+    gen_lines "$DIR/rest.out" 101 > "$DIR/rest.gen"
+    gen_lines "$DIR/full.out" 101 > "$DIR/full.gen"
+    if [ ! -s "$DIR/rest.gen" ]; then result resume "the resumed run reported no generations after the checkpoint"
+    elif cmp -s "$DIR/rest.gen" "$DIR/full.gen"; then result resume ok
+    else result resume "the resumed run reports different generations"; fi
+}
+
+
+# header_u64 - Prints the unsigned 64-bit checkpoint header field at a given offset
+header_u64() {
+    od -An -t u8 -j "$2" -N 8 "$1" | tr -d ' '
+}
+
+
+# check_lineage - Checks that a population rebuilt from the lineage log has the weights and biases of the checkpoint written at the same generation
+check_lineage() {
+    write_params "$DIR/lin" 3 100 "CHECKPOINT $DIR/lin.ckpt 50" "LINEAGE $DIR/lin.log 20"
+    $MAIN "$DIR/lin" > /dev/null < /dev/null && $MAIN -lineage "$DIR/lin" 100 "$DIR/reb.ckpt" > /dev/null < /dev/null || { result lineage "a run failed"; return; }
+
+    # the nets run from the weights offset to the fitness offset (highscores, seeds and fitness differ)
+    w_off=$(header_u64 "$DIR/lin.ckpt" 112)
+    f_off=$(header_u64 "$DIR/lin.ckpt" 128)
+    if [ "$w_off" != "$(header_u64 "$DIR/reb.ckpt" 112)" ] || [ "$f_off" != "$(header_u64 "$DIR/reb.ckpt" 128)" ]; then result lineage "the rebuilt checkpoint has another layout"
+    elif [ -z "$w_off" ] || [ "$f_off" -le "$w_off" ]; then result lineage "the checkpoint has no nets"
+    elif cmp -s -i "$w_off" -n $((f_off - w_off)) "$DIR/lin.ckpt" "$DIR/reb.ckpt"; then result lineage ok
+    else result lineage "the rebuilt nets differ from the checkpoint"; fi
+}
+
+
+# write_baseline - Writes a bench baseline of rand_norm with a given mean and deviation
+write_baseline() {
+    printf '{"seed": 20210417, "samples": 3, "results": [\n  {"name": "rand_norm", "ns_per_op": %s, "stddev": %s, "min": %s, "ops": 1}\n], "regressions": 0}\n' "$2" "$3" "$2" > "$1"
+}
+
+
+# compare_exit - Prints the exit code of a quick rand_norm bench run against a baseline, with any extra bench options
+compare_exit() {
+    base=$1; shift
+    $BENCH -filter rand_norm -samples 3 -compare "$base" "$@" > /dev/null 2>&1
+    echo $?
+}
+
+
+# check_bench_compare - Checks that bench -compare fails only on a regression over the threshold and outside the deviations
+check_bench_compare() {
+    write_baseline "$DIR/fast.json" 0.001 0
+    write_baseline "$DIR/slow.json" 1000000000 0
+    write_baseline "$DIR/noisy.json" 0.001 1000000000
+    if [ "$(compare_exit "$DIR/fast.json")" != 1 ]; then result bench_compare "a slower kernel is not a regression"
+    elif [ "$(compare_exit "$DIR/slow.json")" != 0 ]; then result bench_compare "a faster kernel is a regression"
+    elif [ "$(compare_exit "$DIR/noisy.json")" != 0 ]; then result bench_compare "a kernel within the baseline deviation is a regression"
+    elif [ "$(compare_exit "$DIR/fast.json" -threshold 1000000000000)" != 0 ]; then result bench_compare "a kernel under the threshold is a regression"
+    else result bench_compare ok; fi
+}
+
+
+printf '\n+++++++  COMMAND LINE CHECKS  +++++++\n\n'
+check_threads
+check_resume
+check_lineage
+check_bench_compare
+printf '\n  %d of %d checks failed\n\n' "$FAILED" "$RUN"
+[ "$FAILED" -eq 0 ]
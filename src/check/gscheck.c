@@ -0,0 +1,431 @@
+//
+//  gscheck.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <limits.h>
+#include "gsdefs.h"
+
+#define CHECK_EPISODES 2000
+#define CHECK_SPIN 64
+#define CHECK_TIMEOUT 120
+#define CHECK_MSG_SIZE 128
+#define CHECK_POP 100
+#define CHECK_SEED 20210417ULL
+#define CHECK_GENS 100
+#define CHECK_GENOME 1024
+
+typedef struct check_waiter check_waiter;
+typedef int (*check_funct) (const char *);
+
+// one thread of the barrier wait check
+struct check_waiter {
+    gs_barrier *bar;
+    int tid;
+    int *episode;           // bumped once per episode by the serial function
+    int serials;            // episodes this thread ran the serial function in
+    int misses;             // episodes this thread left before the serial function ran
+};
+
+static int barrier_threads[] = { 1, 2, 3, 5, 6, 7, 9, 13 };
+static int sched_threads[] = { 1, 2, 3, 4, 7, 16, 33 };
+static int engine_whole[] = { CHECK_GENS };
+static int engine_split[] = { 1, 29, 70 };
+static char timeout_msg[CHECK_MSG_SIZE];  // printed when a check never returns (a broken barrier never releases)
+
+
+/*
+ * fail - Prints why a check failed and returns 1 (checks add these up)
+ */
+static int fail(const char *name, const char *fmt, ...)
+{
+    va_list args;
+
+    printf("  FAIL  %s: ", name);
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    printf("\n");
+    return 1;
+}
+
+
+/*
+ * timed_out - Fails the check that is still running after CHECK_TIMEOUT seconds and stops
+ */
+static void timed_out(int sig)
+{
+    ssize_t written = write(STDOUT_FILENO, timeout_msg, strlen(timeout_msg));
+
+    (void) sig;
+    (void) written;
+    _exit(1);
+}
+
+
+/*
+ * count_nodes - Returns the number of nodes a combining tree barrier needs for a number of threads
+ */
+static int count_nodes(int num_threads)
+{
+    int num_nodes = 0;
+
+    for (int ct = (num_threads + BARRIER_FANIN - 1) / BARRIER_FANIN; ; ct = (ct + BARRIER_FANIN - 1) / BARRIER_FANIN) {
+        num_nodes += ct;
+        if (ct == 1) break;
+    }
+    return num_nodes;
+}
+
+
+/*
+ * check_barrier_tree - Checks the barrier tree of every thread count (leaves expect every thread once, every other node its children, one root)
+ */
+static int check_barrier_tree(const char *name)
+{
+    int children[MAX_NUM_THREADS];
+    int failed = 0, num_leaves, leaf_sum, roots;
+    gs_barrier bar;
+
+    for (int n = 1; n <= MAX_NUM_THREADS; n++) {
+        if (create_barrier(&bar, n, 0) != GS_OK) { failed += fail(name, "could not create a barrier for %d threads", n); continue; }
+        if (bar.num_nodes != count_nodes(n)) { failed += fail(name, "%d threads have %d nodes (expected %d)", n, bar.num_nodes, count_nodes(n)); free_barrier(&bar); continue; }
+
+        // leaves take the threads in order
+        num_leaves = (n + BARRIER_FANIN - 1) / BARRIER_FANIN;
+        leaf_sum = 0;
+        for (int i = 0; i < num_leaves; i++) {
+            if ((bar.nodes[i].expected < 1) || (bar.nodes[i].expected > BARRIER_FANIN)) { failed += fail(name, "%d threads, leaf %d expects %d", n, i, bar.nodes[i].expected); }
+            leaf_sum += bar.nodes[i].expected;
+        }
+        if (leaf_sum != n) { failed += fail(name, "%d threads, leaves expect %d arrivals", n, leaf_sum); }
+
+        // every node above the leaves expects exactly the nodes that point at it
+        memset(children, 0, sizeof(children));
+        roots = 0;
+        for (int i = 0; i < bar.num_nodes; i++) {
+            if (bar.nodes[i].parent == NOT_FOUND) { roots++; continue; }
+            if ((bar.nodes[i].parent <= i) || (bar.nodes[i].parent >= bar.num_nodes)) { failed += fail(name, "%d threads, node %d has parent %d", n, i, bar.nodes[i].parent); continue; }
+            children[bar.nodes[i].parent]++;
+        }
+        if ((roots != 1) || (bar.nodes[bar.num_nodes - 1].parent != NOT_FOUND)) { failed += fail(name, "%d threads, %d roots", n, roots); }
+        for (int i = num_leaves; i < bar.num_nodes; i++) {
+            if (children[i] != bar.nodes[i].expected) { failed += fail(name, "%d threads, node %d expects %d of its %d children", n, i, bar.nodes[i].expected, children[i]); }
+        }
+        free_barrier(&bar);
+    }
+    return failed;
+}
+
+
+/*
+ * bump_episode - Serial function of the barrier wait check
+ */
+static void bump_episode(void *arg)
+{
+    (*(int *) arg)++;
+    return;
+}
+
+
+/*
+ * barrier_waiter - Waits on the check barrier for every episode and counts the episodes it saw out of order
+ */
+static void *barrier_waiter(void *arg)
+{
+    check_waiter *w = (check_waiter *) arg;
+    int sense = 0;
+
+    for (int i = 0; i < CHECK_EPISODES; i++) {
+        w->serials += barrier_wait(w->bar, w->tid, &sense, bump_episode, w->episode);
+        if (*w->episode != i + 1) { w->misses++; }
+    }
+    return NULL;
+}
+
+
+/*
+ * check_barrier_wait - Checks that a barrier holds every thread until the serial function ran, spinning and parking
+ */
+static int check_barrier_wait(const char *name)
+{
+    int num_counts = sizeof(barrier_threads) / sizeof(int);
+    pthread_t threads[MAX_NUM_THREADS];
+    check_waiter waiters[MAX_NUM_THREADS];
+    int failed = 0, episode, serials, misses, n;
+    gs_barrier bar;
+
+    for (int spin = 0; spin <= CHECK_SPIN; spin += CHECK_SPIN) {
+        for (int c = 0; c < num_counts; c++) {
+            n = barrier_threads[c];
+            episode = 0;
+            if (create_barrier(&bar, n, spin) != GS_OK) { failed += fail(name, "could not create a barrier for %d threads", n); continue; }
+            for (int t = 0; t < n; t++) {
+                waiters[t] = (check_waiter) { .bar = &bar, .tid = t, .episode = &episode, .serials = 0, .misses = 0 };
+                pthread_create(&threads[t], NULL, barrier_waiter, &waiters[t]);
+            }
+            serials = misses = 0;
+            for (int t = 0; t < n; t++) {
+                pthread_join(threads[t], NULL);
+                serials += waiters[t].serials;
+                misses += waiters[t].misses;
+            }
+            if ((episode != CHECK_EPISODES) || (serials != CHECK_EPISODES)) { failed += fail(name, "%d threads (spin %d) ran %d serial functions in %d episodes", n, spin, serials, episode); }
+            if (misses > 0) { failed += fail(name, "%d threads (spin %d) left %d episodes early", n, spin, misses); }
+            free_barrier(&bar);
+        }
+    }
+    return failed;
+}
+
+
+/*
+ * check_moves_bucket - Checks that longer predicted games never land in a later bucket and that every power of two starts its own bucket
+ */
+static int check_moves_bucket(const char *name)
+{
+    int failed = 0, last = LPT_BUCKETS - 1, b;
+
+    if ((moves_bucket(0) != LPT_BUCKETS - 1) || (moves_bucket(1) != LPT_BUCKETS - 1)) { failed += fail(name, "0 and 1 moves land in buckets %d and %d", moves_bucket(0), moves_bucket(1)); }
+    for (int k = 0; k < 31; k++) {
+        if (moves_bucket(1 << k) != (LPT_BUCKETS - 1) - k) { failed += fail(name, "%d moves land in bucket %d (expected %d)", 1 << k, moves_bucket(1 << k), (LPT_BUCKETS - 1) - k); }
+        if (moves_bucket((1 << k) + ((1 << k) - 1)) != (LPT_BUCKETS - 1) - k) { failed += fail(name, "%d moves land in bucket %d (expected %d)", (1 << k) + ((1 << k) - 1), moves_bucket((1 << k) + ((1 << k) - 1)), (LPT_BUCKETS - 1) - k); }
+    }
+    for (int m = 0; m < 1 << 16; m++) {
+        b = moves_bucket(m);
+        if ((b > last) || (b < 0)) { failed += fail(name, "%d moves land in bucket %d after bucket %d", m, b, last); break; }
+        last = b;
+    }
+    if ((moves_bucket(INT_MAX) < 0) || (moves_bucket(INT_MAX) >= LPT_BUCKETS)) { failed += fail(name, "INT_MAX moves land in bucket %d", moves_bucket(INT_MAX)); }
+    return failed;
+}
+
+
+/*
+ * check_run_order - Checks that build_run_order sorts the snakes longest bucket first and deals them boustrophedon into slices that drain every snake once
+ */
+static int check_run_order(const char *name)
+{
+    int num_counts = sizeof(sched_threads) / sizeof(int);
+    int seen[CHECK_POP];
+    int failed = 0, n, num_seen, target, head, tail, expected_head, k;
+    gs_params *params;
+    thread_data t_data;
+    long long b;
+
+    for (int c = 0; c < num_counts; c++) {
+        n = sched_threads[c];
+        params = init_parameters_struct();
+        if (params == NULL) { failed += fail(name, "could not allocate parameters"); continue; }
+        params->pop_size = CHECK_POP;
+        params->survive = 0.5;
+        params->num_threads = n;
+        if (create_thread_data_struct(&t_data, params) != GS_OK) { failed += fail(name, "could not create thread data for %d threads", n); free(params); continue; }
+
+        // predicted lengths over every bucket a game reaches (with ties, so the counting sort has to keep snake order)
+        seed_rand(CHECK_SEED + n);
+        for (int i = 0; i < CHECK_POP; i++) { t_data.pred_moves[i] = (i % 10 == 0)? 0: rand_int(1, 1 << rand_int(1, 14)); }
+        build_run_order(&t_data);
+
+        // longest bucket first, snake order within a bucket
+        memset(seen, 0, sizeof(seen));
+        for (k = 0; k < CHECK_POP; k++) {
+            target = t_data.run_sorted[k];
+            if ((target < 0) || (target >= CHECK_POP) || (seen[target]++ > 0)) { failed += fail(name, "%d threads, sorted position %d holds snake %d twice or out of range", n, k, target); break; }
+            if ((k > 0) && ((moves_bucket(t_data.pred_moves[target]) < moves_bucket(t_data.pred_moves[t_data.run_sorted[k - 1]])) ||
+                ((moves_bucket(t_data.pred_moves[target]) == moves_bucket(t_data.pred_moves[t_data.run_sorted[k - 1]])) && (target < t_data.run_sorted[k - 1])))) {
+                failed += fail(name, "%d threads, sorted position %d (snake %d) is out of order", n, k, target);
+                break;
+            }
+        }
+
+        // every slice follows the last one and holds the targets dealt to it in sorted order
+        expected_head = 0;
+        for (int t = 0; t < n; t++) {
+            b = atomic_load(&t_data.threads[t].bounds);
+            head = (int) (b & 0xffffffffLL);
+            tail = (int) (b >> 32);
+            if (head != expected_head) { failed += fail(name, "%d threads, slice %d starts at %d (expected %d)", n, t, head, expected_head); break; }
+            for (int j = 0; head + j < tail; j++) {
+                k = j * n + (((j % 2) == 0)? t: (n - 1) - t);
+                if ((k >= CHECK_POP) || (t_data.run_order[head + j] != t_data.run_sorted[k])) { failed += fail(name, "%d threads, slice %d position %d is not sorted position %d", n, t, j, k); break; }
+            }
+            expected_head = tail;
+        }
+        if (expected_head != CHECK_POP) { failed += fail(name, "%d threads, slices end at %d", n, expected_head); }
+
+        // draining the queues (and stealing from them) hands out every snake exactly once
+        memset(seen, 0, sizeof(seen));
+        num_seen = 0;
+        for (int t = 0; num_seen < CHECK_POP + n; t = (t + 1) % n) {
+            target = pop_run_target(&t_data, t);
+            num_seen++;
+            if (target == NOT_FOUND) continue;
+            if (seen[target]++ > 0) { failed += fail(name, "%d threads, snake %d ran twice", n, target); break; }
+        }
+        for (int i = 0; i < CHECK_POP; i++) {
+            if (seen[i] == 0) { failed += fail(name, "%d threads, snake %d never ran", n, i); break; }
+        }
+
+        free_thread_data_struct(&t_data);
+        free(params);
+    }
+    return failed;
+}
+
+
+/*
+ * check_config - Sets up the small seeded engine config of the engine checks
+ */
+static void check_config(gs_config *config, int num_threads)
+{
+    gs_config_init(config);
+    config->pop_size = CHECK_POP;
+    config->gen_count = CHECK_GENS;
+    config->mutate = 0.05;
+    config->survive = 0.1;
+    config->num_layers = 2;
+    config->shape[0] = 24; config->shape[1] = 8; config->shape[2] = 8; config->shape[3] = 4;
+    config->num_threads = num_threads;
+    config->seed = CHECK_SEED;
+    return;
+}
+
+
+/*
+ * run_engine - Runs a seeded engine on a number of threads in steps of generations and keeps its last stats and best genome, returns the failed conditions
+ */
+static int run_engine(const char *name, int num_threads, int *steps, int num_steps, gs_engine_stats *stats, double *genome, int *genome_size)
+{
+    gs_config config;
+    gs_engine *engine;
+    char err[MAX_LINE_SIZE];
+    int failed = 0, code;
+
+    check_config(&config, num_threads);
+    if ((code = gs_engine_create(&config, &engine, err, sizeof(err))) != GS_OK) { return fail(name, "could not create an engine (%s)", err); }
+    for (int i = 0; i < num_steps; i++) {
+        if ((code = gs_engine_run(engine, steps[i])) != GS_OK) { failed += fail(name, "run of %d generations returned %s", steps[i], gs_strerror(code)); break; }
+    }
+    if ((code = gs_engine_run(engine, 1)) != GS_ERR_FINISHED) { failed += fail(name, "a finished engine returned %s", gs_strerror(code)); }
+    if ((code = gs_engine_get_stats(engine, stats)) != GS_OK) { failed += fail(name, "stats returned %s", gs_strerror(code)); }
+    if ((code = gs_engine_best_genome(engine, genome, CHECK_GENOME, genome_size)) != GS_OK) { failed += fail(name, "best genome returned %s", gs_strerror(code)); }
+    gs_engine_destroy(engine);
+    return failed;
+}
+
+
+/*
+ * check_engine_runs - Checks that a seeded engine ends with the same stats and best genome when its run is split over calls and threads
+ */
+static int check_engine_runs(const char *name)
+{
+    gs_engine_stats whole, other;
+    double whole_genome[CHECK_GENOME], other_genome[CHECK_GENOME];
+    int whole_size = 0, other_size = 0, failed;
+    const char *labels[] = { "a split run", "a run on 3 threads" };
+    int threads[] = { 1, 3 };
+
+    if ((failed = run_engine(name, 1, engine_whole, sizeof(engine_whole) / sizeof(int), &whole, whole_genome, &whole_size)) > 0) { return failed; }
+    if ((whole.gens != CHECK_GENS) || (!whole.finished)) { failed += fail(name, "a run of %d generations stopped at %d", CHECK_GENS, whole.gens); }
+    for (int r = 0; r < 2; r++) {
+        if (run_engine(name, threads[r], engine_split, sizeof(engine_split) / sizeof(int), &other, other_genome, &other_size) > 0) { failed++; continue; }
+        if ((other.gens != whole.gens) || (other.highscore != whole.highscore) || (other.games != whole.games) || (other.fitness_min != whole.fitness_min) ||
+            (other.fitness_mean != whole.fitness_mean) || (other.fitness_max != whole.fitness_max) || (other.moves_mean != whole.moves_mean) ||
+            (other.apples_mean != whole.apples_mean) || (other.apples_max != whole.apples_max)) {
+            failed += fail(name, "%s ends at mean fitness %f (expected %f)", labels[r], other.fitness_mean, whole.fitness_mean);
+        }
+        if ((other_size != whole_size) || (memcmp(other_genome, whole_genome, whole_size * sizeof(double)) != 0)) { failed += fail(name, "%s has another best genome", labels[r]); }
+    }
+    return failed;
+}
+
+
+/*
+ * check_engine_checkpoint - Checks that an engine loads its own checkpoint and refuses a missing one or one of another shape
+ */
+static int check_engine_checkpoint(const char *name)
+{
+    char file[] = "/tmp/gscheck_ckpt_XXXXXX";
+    char err[MAX_LINE_SIZE];
+    gs_config config;
+    gs_engine *engine, *loaded;
+    int failed = 0, fd, code;
+
+    check_config(&config, 1);
+    fd = mkstemp(file);
+    if (fd < 0) { return fail(name, "could not create a temporary file"); }
+    close(fd);
+    if (gs_engine_create(&config, &engine, err, sizeof(err)) != GS_OK) { unlink(file); return fail(name, "could not create an engine (%s)", err); }
+    code = gs_engine_run(engine, 1);
+    if (code == GS_OK) { code = gs_engine_checkpoint(engine, file); }
+    gs_engine_destroy(engine);
+    if (code != GS_OK) { unlink(file); return fail(name, "could not write a checkpoint (%s)", gs_strerror(code)); }
+
+    // the same shape loads
+    if ((code = gs_engine_create_from_checkpoint(&config, file, &loaded, err, sizeof(err))) != GS_OK) { failed += fail(name, "loading the checkpoint returned %s (%s)", gs_strerror(code), err); }
+    else { gs_engine_destroy(loaded); }
+
+    // another hidden layer width is refused
+    config.shape[1] = 12; config.shape[2] = 12;
+    if ((code = gs_engine_create_from_checkpoint(&config, file, &loaded, err, sizeof(err))) != GS_ERR_PARAMS) {
+        failed += fail(name, "another shape returned %s (expected %s)", gs_strerror(code), gs_strerror(GS_ERR_PARAMS));
+        if (code == GS_OK) { gs_engine_destroy(loaded); }
+    }
+
+    // a missing checkpoint is refused
+    unlink(file);
+    config.shape[1] = 8; config.shape[2] = 8;
+    if ((code = gs_engine_create_from_checkpoint(&config, file, &loaded, err, sizeof(err))) != GS_ERR_IO) {
+        failed += fail(name, "a missing checkpoint returned %s (expected %s)", gs_strerror(code), gs_strerror(GS_ERR_IO));
+        if (code == GS_OK) { gs_engine_destroy(loaded); }
+    }
+    return failed;
+}
+
+
+/*
+ * main - Runs every check (or the ones matching -filter <name>) and returns 1 if any of them failed
+ */
+int main(int argc, const char *argv[])
+{
+    const char *names[] = { "barrier_tree", "barrier_wait", "moves_bucket", "run_order", "engine_runs", "engine_checkpoint" };
+    check_funct checks[] = { check_barrier_tree, check_barrier_wait, check_moves_bucket, check_run_order, check_engine_runs, check_engine_checkpoint };
+    int num_checks = sizeof(checks) / sizeof(check_funct);
+    const char *filter = NULL;
+    int num_run = 0, num_failed = 0;
+
+    // options
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-filter") == 0) && (i + 1 < argc)) { filter = argv[++i]; }
+        else {
+            printf("\n\nERR: usage: check [-filter <name>]\n\n\n");
+            exit(127);
+        }
+    }
+
+    // a check that hangs fails the run instead of stalling it
+    signal(SIGALRM, timed_out);
+    setvbuf(stdout, NULL, _IONBF, 0);
+    printf("\n+++++++  CHECKS  +++++++\n\n");
+    for (int c = 0; c < num_checks; c++) {
+        if ((filter != NULL) && (strstr(names[c], filter) == NULL)) continue;
+        num_run++;
+        snprintf(timeout_msg, sizeof(timeout_msg), "  FAIL  %s: timed out after %d s\n", names[c], CHECK_TIMEOUT);
+        alarm(CHECK_TIMEOUT);
+        if (checks[c](names[c]) > 0) { num_failed++; }
+        else { printf("  ok    %s\n", names[c]); }
+        alarm(0);
+    }
+    printf("\n  %d of %d checks failed\n\n", num_failed, num_run);
+    return (num_failed > 0)? 1: 0;
+}
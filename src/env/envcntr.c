@@ -17,8 +17,20 @@
 void free_env_set(env_set *src)
 {
     for (int i = 0; i < (src->num_env);i++) { destroy_env(&(src->data[i])); }
+    release_env_set(src);
+    return;
+}
+
+
+/*
+ * release_env_set - Frees an env_set struct and its arrays without touching envs that were never initialized
+ */
+void release_env_set(env_set *src)
+{
     free(src->data);
     free(src->dist_d);
+    mem_add(MEM_ENV, -mem_chunk(src->num_env * sizeof(env)));
+    mem_add(MEM_ACTIVATIONS, -mem_chunk(src->num_env * sizeof(dist_data)));
     free(src);
     return;
 }
@@ -197,18 +209,28 @@ void update_dist_data(env_set * src, int i)
 
 
 /*
- * init_env_set - Initializes an env set of a specified env dimesion and env count
+ * alloc_env_set - Allocates an env set of a specified env count without initializing its members
  */
-void init_env_set(env_set *src, int ct, int dim)
+void alloc_env_set(env_set *src, int ct)
 {
     src->data = (env *) malloc(ct * sizeof(env));
     src->dist_d = (dist_data *) malloc(ct * sizeof(dist_data));
+    mem_add(MEM_ENV, mem_chunk(ct * sizeof(env)));
+    mem_add(MEM_ACTIVATIONS, mem_chunk(ct * sizeof(dist_data)));
     src->num_env = ct;
     src->is_active = 1;
-    
-    // build specified number of environments
-    for (int i = 0; i< ct; i++) {
+    return;
+}
+
+
+/*
+ * init_env_range - Initializes the env set members in [start, end) with a specified env dimension
+ */
+void init_env_range(env_set *src, int dim, int start, int end)
+{
+    for (int i = start; i < end; i++) {
         src->data[i].a = (apple *) malloc(sizeof(apple));
+        mem_add(MEM_ENV, mem_chunk(sizeof(apple)));
         init_env(dim, &src->data[i]);
         update_dist_data(src, i);
     }
@@ -216,6 +238,17 @@ void init_env_set(env_set *src, int ct, int dim)
 }
 
 
+/*
+ * init_env_set - Initializes an env set of a specified env dimesion and env count
+ */
+void init_env_set(env_set *src, int ct, int dim)
+{
+    alloc_env_set(src, ct);
+    init_env_range(src, dim, 0, ct);
+    return;
+}
+
+
 /*
  * reset_env_set - Resets given env set struct
  */
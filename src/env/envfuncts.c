@@ -77,6 +77,33 @@ static void add_snake_node(snake_node *curr, int x, int y)
 }
 
 
+/*
+ * account_chains - Adds (or subtracts) an env's snake body and game record bytes to the memory accounting, either as a finished game or as a fresh one
+ */
+static void account_chains(env *src, int finished, int sign)
+{
+    long body, log;
+    if (mem_acct == NULL) { return; }
+
+    body = (finished)? env_body_bytes(src): MIN_SNAKE_LEN * mem_chunk(sizeof(snake_node));
+    log = (finished)? env_log_bytes(src): mem_chunk(sizeof(apple_data));
+    mem_add(MEM_ENV, sign * body);
+    mem_add(MEM_TRAJECTORY, sign * log);
+    return;
+}
+
+
+/*
+ * account_death - Moves a snake's memory accounting from a fresh game to its finished game (chains only grow during a game, so they are counted once when it ends)
+ */
+static void account_death(env *src)
+{
+    account_chains(src, 0, -1);
+    account_chains(src, 1, 1);
+    return;
+}
+
+
 /*
  * init_apple - Sets up a given apple struct and records its position
  */
@@ -175,6 +202,8 @@ static void free_move_data_chain(move_data *src)
  */
 void destroy_env(env *src)
 {
+    account_chains(src, !src->alive, -1);
+    mem_add(MEM_ENV, -mem_chunk(sizeof(apple)));
     free_apple_data_chain(src->a_data);
     free_move_data_chain(src->m_data);
     free_snake_chain(src->h);
@@ -188,6 +217,7 @@ void destroy_env(env *src)
  */
 void reset_env(env *src)
 {
+    account_chains(src, !src->alive, -1);
     free_apple_data_chain(src->a_data);
     free_move_data_chain(src->m_data);
     free_snake_chain(src->h);
@@ -215,7 +245,9 @@ void init_env(int dim, env *src)
     src->len = MIN_SNAKE_LEN;
     src->env_dim = dim;
     src->alive = 1;
+    src->death = DEATH_NONE;
     src->m_data = NULL;
+    account_chains(src, 0, 1);
     return;
 }
 
@@ -302,6 +334,8 @@ int run_env_action(int a, env *src)
     // kill snake if it is out of moves for this apple
     if (src->m_n > MAX_MOVES_PER_APPLE) {
         src->alive = 0;
+        src->death = DEATH_TIMEOUT;
+        account_death(src);
         return (src->alive);
     }
     
@@ -314,12 +348,15 @@ int run_env_action(int a, env *src)
         curr->y = curr->y + dy;
     } else { // snake went backwards (invalid move)
         src->alive = 0;
+        src->death = DEATH_REVERSE;
+        account_death(src);
         return (src->alive);
     }
     
     // check if snake went off the board
     if ((head->x < 1) || (head->x > src->env_dim) || (head->y < 1) || (head->y > src->env_dim)){
         src->alive = 0;
+        src->death = DEATH_WALL;
     }
     
     // move linked snake nodes
@@ -335,6 +372,7 @@ int run_env_action(int a, env *src)
         // check if snake ate itself
         if ((head->x == curr->x) && (head->y == curr->y)){
             src->alive = 0;
+            src->death = DEATH_SELF;
         }
     } while (curr->c != NULL);
     
@@ -347,5 +385,6 @@ int run_env_action(int a, env *src)
         record_move_data(src, a, 0);
     }
     
+    if (!src->alive) { account_death(src); }
     return (src->alive);
 }
\ No newline at end of file
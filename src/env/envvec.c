@@ -0,0 +1,431 @@
+//
+//  envvec.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "envdefs.h"
+
+_Static_assert((GS_ENV_UP == UP) && (GS_ENV_DOWN == DOWN) && (GS_ENV_LEFT == LEFT) && (GS_ENV_RIGHT == RIGHT), "snake_env.h and envdefs.h disagree on the actions");
+_Static_assert((GS_ENV_DEATH_WALL == DEATH_WALL) && (GS_ENV_DEATH_SELF == DEATH_SELF) && (GS_ENV_DEATH_TIMEOUT == DEATH_TIMEOUT) && (GS_ENV_DEATH_REVERSE == DEATH_REVERSE), "snake_env.h and envdefs.h disagree on the deaths");
+
+#define CELL_X(c) ((c) & 0xFF)
+#define CELL_Y(c) ((c) >> 8)
+#define NO_RAY -1
+
+
+/*
+ * venv_time - Returns a monotonic time in seconds (the env library does not link the trainer's clock)
+ */
+static double venv_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*
+ * venv_seed - Seeds a game's random numbers the way seed_rand seeds a thread's (the same seed plays the same game as the trainer's env)
+ */
+static void venv_seed(venv_game *game, unsigned long long seed)
+{
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    game->rng = (z ^ (z >> 31)) | 1;
+    return;
+}
+
+
+/*
+ * venv_rand_int - Same as rand_int on a game's own random numbers
+ */
+static int venv_rand_int(venv_game *game, int low, int high)
+{
+    game->rng ^= game->rng >> 12;
+    game->rng ^= game->rng << 25;
+    game->rng ^= game->rng >> 27;
+    return ((int) (((game->rng * 0x2545F4914F6CDD1DULL) >> 33) % (high - low))) + low;
+}
+
+
+/*
+ * place_apple - Places a new apple where the snake is not (like eat_apple), scanning for a free cell when random draws keep missing, and returns 0 if there is none
+ */
+static int place_apple(gs_venv *venv, venv_game *game, unsigned char *grid)
+{
+    int dim = venv->dim;
+    int x, y;
+
+    for (int t = 0; t < VENV_PLACE_TRIES * venv->cells; t++) {
+        x = venv_rand_int(game, 1, dim);
+        y = venv_rand_int(game, 1, dim);
+        if (grid[(y - 1) * dim + (x - 1)] == GS_ENV_EMPTY) {
+            game->ax = x;
+            game->ay = y;
+            grid[(y - 1) * dim + (x - 1)] = GS_ENV_APPLE;
+            return 1;
+        }
+    }
+
+    // apples only land in the first dim - 1 rows and columns
+    for (y = 1; y < dim; y++) {
+        for (x = 1; x < dim; x++) {
+            if (grid[(y - 1) * dim + (x - 1)] != GS_ENV_EMPTY) continue;
+            game->ax = x;
+            game->ay = y;
+            grid[(y - 1) * dim + (x - 1)] = GS_ENV_APPLE;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ * start_game - Starts a game's next episode like init_env: a 3 cell snake up from the middle of the board and an apple off of it
+ */
+static void start_game(gs_venv *venv, int g)
+{
+    venv_game *game = &venv->games[g];
+    unsigned short *ring = venv->rings + (size_t) g * venv->cells;
+    unsigned char *grid = venv->grid + (size_t) g * venv->cells;
+    int dim = venv->dim;
+    int mid = dim / 2;
+
+    memset(grid, GS_ENV_EMPTY, venv->cells);
+    game->head = 0;
+    game->len = MIN_SNAKE_LEN;
+    for (int k = 0; k < MIN_SNAKE_LEN; k++) {
+        ring[k] = (unsigned short) (mid | ((mid + k) << 8));
+        grid[(mid + k - 1) * dim + (mid - 1)] = (k == 0)? GS_ENV_HEAD: GS_ENV_BODY;
+    }
+    game->hx = mid;
+    game->hy = mid;
+
+    // the first apple only avoids the spawn cells (init_apple)
+    do {
+        game->ax = venv_rand_int(game, 1, dim);
+        game->ay = venv_rand_int(game, 1, dim);
+    } while ((game->ax == mid) && ((game->ay == mid) || (game->ay == mid + 1) || (game->ay == mid + 2)));
+    grid[(game->ay - 1) * dim + (game->ax - 1)] = GS_ENV_APPLE;
+    game->m = 0;
+    game->m_n = 0;
+    game->n = 0;
+    game->alive = 1;
+    return;
+}
+
+
+/*
+ * write_features - Writes a game's wall, body and apple distances along 8 rays exactly as update_dist_data computes them (a network trained on the trainer's env plays the same moves)
+ */
+static void write_features(gs_venv *venv, int g)
+{
+    venv_game *game = &venv->games[g];
+    unsigned short *ring = venv->rings + (size_t) g * venv->cells;
+    double *wall = venv->obs + (size_t) g * GS_ENV_NUM_FEATURES;
+    double *body = wall + 8;
+    double *apple = wall + 16;
+    double d1 = (double) game->hy - 1;
+    double d2 = (double) venv->dim - game->hx;
+    double d3 = (double) venv->dim - game->hy;
+    double d4 = (double) game->hx - 1;
+    int pos = game->head;
+    int dx, dy, r;
+    double d;
+
+    for (int j = 0; j < 8; j++) {
+        body[j] = GS_ENV_NOT_FOUND;
+        apple[j] = GS_ENV_NOT_FOUND;
+    }
+
+    // walls (calc_dist_to_wall)
+    wall[0] = d1;
+    wall[1] = d2;
+    wall[2] = d3;
+    wall[3] = d4;
+    wall[4] = (d1 >= d2)? sqrt((d2 * d2) + (d2 * d2)): sqrt((d1 * d1) + (d1 * d1));
+    wall[5] = (d2 >= d3)? sqrt((d3 * d3) + (d3 * d2)): sqrt((d2 * d2) + (d2 * d2));
+    wall[6] = (d3 >= d4)? sqrt((d4 * d4) + (d4 * d4)): sqrt((d3 * d3) + (d3 * d3));
+    wall[7] = (d4 >= d1)? sqrt((d1 * d1) + (d1 * d1)): sqrt((d4 * d4) + (d4 * d4));
+
+    // body nodes from the head to the tail (calc_dist_to_body keeps the first of two nodes a cell apart on a ray)
+    for (int k = 1; k < game->len; k++) {
+        if (++pos == venv->cells) { pos = 0; }
+        dx = game->hx - CELL_X(ring[pos]);
+        dy = game->hy - CELL_Y(ring[pos]);
+        if (abs(dx) == abs(dy)) {
+            r = ((dx > 0) && (dy > 0))? 4: ((dx > 0) && (dy < 0))? 5: ((dx < 0) && (dy < 0))? 6: ((dx < 0) && (dy > 0))? 7: NO_RAY;
+            if (r == NO_RAY) continue;
+            dx = abs(dx) - 1;
+            dy = abs(dy) - 1;
+            d = sqrt((double) ((dx * dx) + (dy * dy)));
+            if ((body[r] == GS_ENV_NOT_FOUND) || (d < body[r])) { body[r] = d; }
+        } else if ((dx == 0) || (dy == 0)) {
+            r = (dx == 0)? ((dy > 0)? 0: 1): ((dx > 0)? 2: 3);
+            d = (dx == 0)? abs(dy): abs(dx);
+            if ((body[r] == GS_ENV_NOT_FOUND) || (d < body[r])) { body[r] = d - 1; }
+        }
+    }
+
+    // apple (calc_dist_to_apple)
+    dx = game->ax - game->hx;
+    dy = game->ay - game->hy;
+    if (abs(dx) == abs(dy)) {
+        r = ((dx > 0) && (dy > 0))? 4: ((dx > 0) && (dy < 0))? 5: ((dx < 0) && (dy < 0))? 6: ((dx < 0) && (dy > 0))? 7: NO_RAY;
+        if (r != NO_RAY) {
+            dx = abs(dx) - 1;
+            dy = abs(dy) - 1;
+            apple[r] = sqrt((double) ((dx * dx) + (dy * dy)));
+        }
+    } else if (dx == 0) {
+        apple[(dy > 0)? 0: 1] = abs(dy) - 1;
+    } else if (dy == 0) {
+        apple[(dx > 0)? 2: 3] = abs(dx) - 1;
+    }
+    return;
+}
+
+
+/*
+ * end_game - Records a game's finished episode and starts the next one when the env resets games on its own
+ */
+static void end_game(gs_venv *venv, int g, int death)
+{
+    venv_game *game = &venv->games[g];
+
+    game->alive = 0;
+    venv->num_episodes++;
+    if (venv->episodes != NULL) {
+        venv->episodes[g].apples = game->n;
+        venv->episodes[g].moves = game->m;
+        venv->episodes[g].death = death;
+    }
+    if (venv->dones != NULL) { venv->dones[g] = 1; }
+    if (venv->auto_reset) {
+        start_game(venv, g);
+        if (venv->obs != NULL) { write_features(venv, g); }
+    }
+    return;
+}
+
+
+/*
+ * step_game - Runs one action of a live game like run_env_action (the move counters, then a reverse, then the walls and body) and returns its reward
+ */
+static float step_game(gs_venv *venv, int g, int action)
+{
+    venv_game *game = &venv->games[g];
+    unsigned short *ring = venv->rings + (size_t) g * venv->cells;
+    unsigned char *grid = venv->grid + (size_t) g * venv->cells;
+    int dim = venv->dim;
+    int neck = game->head + 1, tail = game->head + game->len - 1;
+    int x, y, cell, tail_cell, ate;
+
+    // out of moves for this apple
+    game->m++;
+    game->m_n++;
+    if (game->m_n > MAX_MOVES_PER_APPLE) {
+        end_game(venv, g, DEATH_TIMEOUT);
+        return -1;
+    }
+
+    x = game->hx + ((action == LEFT)? -1: (action == RIGHT)? 1: 0);
+    y = game->hy + ((action == UP)? -1: (action == DOWN)? 1: 0);
+    if (neck >= venv->cells) { neck -= venv->cells; }
+    if (tail >= venv->cells) { tail -= venv->cells; }
+    if ((x == CELL_X(ring[neck])) && (y == CELL_Y(ring[neck]))) {
+        end_game(venv, g, DEATH_REVERSE);
+        return -1;
+    }
+    if ((x < 1) || (x > dim) || (y < 1) || (y > dim)) {
+        end_game(venv, g, DEATH_WALL);
+        return -1;
+    }
+
+    // the tail moves out of the way in the same step, so only the rest of the body kills
+    cell = (y - 1) * dim + (x - 1);
+    tail_cell = (CELL_Y(ring[tail]) - 1) * dim + (CELL_X(ring[tail]) - 1);
+    if ((grid[cell] == GS_ENV_BODY) && (cell != tail_cell)) {
+        end_game(venv, g, DEATH_SELF);
+        return -1;
+    }
+
+    // move the head (the tail stays where it was when the snake grows)
+    ate = (x == game->ax) && (y == game->ay);
+    grid[(game->hy - 1) * dim + (game->hx - 1)] = GS_ENV_BODY;
+    if (ate) {
+        game->len++;
+    } else {
+        grid[tail_cell] = GS_ENV_EMPTY;
+    }
+    game->head = (game->head == 0)? venv->cells - 1: game->head - 1;
+    ring[game->head] = (unsigned short) (x | (y << 8));
+    grid[cell] = GS_ENV_HEAD;
+    game->hx = x;
+    game->hy = y;
+    if (!ate) { return 0; }
+
+    game->n++;
+    game->m_n = 0;
+    venv->apples++;
+    if (!place_apple(venv, game, grid)) {
+        end_game(venv, g, DEATH_NONE);
+        return 1;
+    }
+    return 1;
+}
+
+
+/*
+ * gs_venv_config_init - Fills a vectorized env config with the defaults (the games, actions and observation buffers still have to be set)
+ */
+void gs_venv_config_init(gs_venv_config *config)
+{
+    memset(config, 0, sizeof(gs_venv_config));
+    config->dim = GS_ENV_DIM;
+    config->auto_reset = 1;
+    return;
+}
+
+
+/*
+ * gs_venv_create - Checks a config and builds a vectorized env on its buffers, writing the reason of a failure to err, then resets every game
+ */
+int gs_venv_create(const gs_venv_config *config, gs_venv **out, char *err, size_t size)
+{
+    gs_venv *venv;
+    int cells;
+
+    if ((config == NULL) || (out == NULL)) { return GS_ERR_ARG; }
+    *out = NULL;
+    if (err == NULL) { size = 0; }
+    if (config->num_games < 1) {
+        if (size > 0) { snprintf(err, size, "Invalid number of games (needs to be >= 1)"); }
+        return GS_ERR_PARAMS;
+    }
+    if ((config->dim < VENV_MIN_DIM) || (config->dim > VENV_MAX_DIM)) {
+        if (size > 0) { snprintf(err, size, "Invalid board width (needs to be %d to %d)", VENV_MIN_DIM, VENV_MAX_DIM); }
+        return GS_ERR_PARAMS;
+    }
+    if (config->actions == NULL) {
+        if (size > 0) { snprintf(err, size, "Did not set the actions buffer"); }
+        return GS_ERR_PARAMS;
+    }
+
+    venv = (gs_venv *) calloc(1, sizeof(gs_venv));
+    if (venv == NULL) { return GS_ERR_NOMEM; }
+    cells = config->dim * config->dim;
+    venv->num_games = config->num_games;
+    venv->dim = config->dim;
+    venv->cells = cells;
+    venv->auto_reset = config->auto_reset;
+    venv->actions = config->actions;
+    venv->obs = config->obs;
+    venv->rewards = config->rewards;
+    venv->dones = config->dones;
+    venv->episodes = config->episodes;
+
+    // a game's state is one cache line, its ring and grid are its own
+    if ((posix_memalign((void **) &venv->games, 64, config->num_games * sizeof(venv_game)) != 0) ||
+        ((venv->rings = (unsigned short *) malloc((size_t) config->num_games * cells * sizeof(unsigned short))) == NULL) ||
+        ((config->grid == NULL) && ((venv->own_grid = (unsigned char *) malloc((size_t) config->num_games * cells)) == NULL))) {
+        gs_venv_destroy(venv);
+        return GS_ERR_NOMEM;
+    }
+    venv->grid = (config->grid != NULL)? config->grid: venv->own_grid;
+    for (int g = 0; g < venv->num_games; g++) { venv_seed(&venv->games[g], config->seed + g); }
+
+    gs_venv_reset(venv, NULL);
+    venv->num_episodes = 0;
+    *out = venv;
+    return GS_OK;
+}
+
+
+/*
+ * gs_venv_reset - Starts a new episode of every game, from the given seeds (one per game) or from where every game's random numbers are
+ */
+int gs_venv_reset(gs_venv *venv, const unsigned long long *seeds)
+{
+    if (venv == NULL) { return GS_ERR_ARG; }
+    for (int g = 0; g < venv->num_games; g++) {
+        if (seeds != NULL) { venv_seed(&venv->games[g], seeds[g]); }
+        start_game(venv, g);
+        if (venv->obs != NULL) { write_features(venv, g); }
+        if (venv->rewards != NULL) { venv->rewards[g] = 0; }
+        if (venv->dones != NULL) { venv->dones[g] = 0; }
+    }
+    return GS_OK;
+}
+
+
+/*
+ * gs_venv_step - Runs every game's action, writing its reward, done flag and next observation in place (finished games wait for a reset unless the env resets them)
+ */
+int gs_venv_step(gs_venv *venv)
+{
+    const int *actions;
+    double start_t;
+    float reward;
+
+    if (venv == NULL) { return GS_ERR_ARG; }
+    actions = venv->actions;
+
+    // a bad action fails the whole step before any game moves
+    for (int g = 0; g < venv->num_games; g++) {
+        if ((venv->games[g].alive) && ((actions[g] < UP) || (actions[g] > RIGHT))) { return GS_ERR_ARG; }
+    }
+
+    start_t = venv_time();
+    for (int g = 0; g < venv->num_games; g++) {
+        if (!venv->games[g].alive) {
+            if (venv->rewards != NULL) { venv->rewards[g] = 0; }
+            continue;
+        }
+        if (venv->dones != NULL) { venv->dones[g] = 0; }
+        reward = step_game(venv, g, actions[g]);
+        if (venv->rewards != NULL) { venv->rewards[g] = reward; }
+        if ((venv->obs != NULL) && (venv->games[g].alive) && (reward >= 0)) { write_features(venv, g); }
+    }
+    venv->steps += venv->num_games;
+    venv->run_t += venv_time() - start_t;
+    return GS_OK;
+}
+
+
+/*
+ * gs_venv_get_stats - Copies the steps, episodes and apples so far and the steps per second of gs_venv_step
+ */
+int gs_venv_get_stats(gs_venv *venv, gs_venv_stats *stats)
+{
+    if ((venv == NULL) || (stats == NULL)) { return GS_ERR_ARG; }
+    stats->steps = venv->steps;
+    stats->episodes = venv->num_episodes;
+    stats->apples = venv->apples;
+    stats->seconds = venv->run_t;
+    stats->steps_per_sec = (venv->run_t > 0)? venv->steps / venv->run_t: 0;
+    return GS_OK;
+}
+
+
+/*
+ * gs_venv_destroy - Frees a vectorized env (the caller's buffers stay theirs)
+ */
+void gs_venv_destroy(gs_venv *venv)
+{
+    if (venv == NULL) { return; }
+    free(venv->games);
+    free(venv->rings);
+    free(venv->own_grid);
+    free(venv);
+    return;
+}
@@ -0,0 +1,184 @@
+//
+//  gsbarrier.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "gsdefs.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+
+/*
+ * cpu_relax - Hints to the processor that the calling thread is spinning
+ */
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+    return;
+}
+
+
+/*
+ * sleep_on_sense - Parks the calling thread until the barrier sense is no longer the given value
+ *
+ * Without a futex the sense is checked under the barrier lock, so a release that lands after the check still takes the lock and wakes this thread
+ */
+static void sleep_on_sense(gs_barrier *bar, int old_sense)
+{
+#ifdef __linux__
+    syscall(SYS_futex, &bar->sense, FUTEX_WAIT_PRIVATE, old_sense, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&bar->lock);
+    while (atomic_load_explicit(&bar->sense, memory_order_seq_cst) == old_sense) { pthread_cond_wait(&bar->wake, &bar->lock); }
+    pthread_mutex_unlock(&bar->lock);
+#endif
+    return;
+}
+
+
+/*
+ * wake_all - Wakes every thread parked on the barrier sense
+ */
+static void wake_all(gs_barrier *bar)
+{
+#ifdef __linux__
+    syscall(SYS_futex, &bar->sense, FUTEX_WAKE_PRIVATE, bar->num_threads, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&bar->lock);
+    pthread_cond_broadcast(&bar->wake);
+    pthread_mutex_unlock(&bar->lock);
+#endif
+    return;
+}
+
+
+/*
+ * create_barrier - Builds a combining tree barrier for a given number of threads and spin budget, returns GS_OK or GS_ERR_NOMEM
+ */
+int create_barrier(gs_barrier *bar, int num_threads, int spin)
+{
+    int level_start = 0;
+    int level_ct = (num_threads + BARRIER_FANIN - 1) / BARRIER_FANIN;
+    int num_nodes = 0;
+
+    // count the tree nodes (leaves take BARRIER_FANIN threads, inner nodes take BARRIER_FANIN children)
+    for (int ct = level_ct; ; ct = (ct + BARRIER_FANIN - 1) / BARRIER_FANIN) {
+        num_nodes += ct;
+        if (ct == 1) break;
+    }
+
+    bar->num_threads = num_threads;
+    bar->num_nodes = num_nodes;
+    bar->spin = spin;
+    atomic_init(&bar->sense, 0);
+    atomic_init(&bar->num_sleeping, 0);
+    if (posix_memalign((void **) &bar->nodes, CACHE_LINE, num_nodes * sizeof(barrier_node)) != 0) {
+        bar->nodes = NULL;
+        return GS_ERR_NOMEM;
+    }
+#ifndef __linux__
+    pthread_mutex_init(&bar->lock, NULL);
+    pthread_cond_init(&bar->wake, NULL);
+#endif
+
+    // leaf level expects one arrival per thread
+    for (int i = 0; i < level_ct; i++) {
+        bar->nodes[i].expected = (num_threads - i * BARRIER_FANIN < BARRIER_FANIN)? num_threads - i * BARRIER_FANIN: BARRIER_FANIN;
+    }
+
+    // inner levels expect one arrival per child node
+    while (level_ct > 1) {
+        int next_start = level_start + level_ct;
+        int next_ct = (level_ct + BARRIER_FANIN - 1) / BARRIER_FANIN;
+        for (int i = 0; i < level_ct; i++) { bar->nodes[level_start + i].parent = next_start + i / BARRIER_FANIN; }
+        for (int i = 0; i < next_ct; i++) {
+            bar->nodes[next_start + i].expected = (level_ct - i * BARRIER_FANIN < BARRIER_FANIN)? level_ct - i * BARRIER_FANIN: BARRIER_FANIN;
+        }
+        level_start = next_start;
+        level_ct = next_ct;
+    }
+    bar->nodes[level_start].parent = NOT_FOUND;
+
+    // arm every node for the first episode
+    for (int i = 0; i < num_nodes; i++) { atomic_init(&bar->nodes[i].count, bar->nodes[i].expected); }
+    return GS_OK;
+}
+
+
+/*
+ * init_barrier - Initializes a barrier for a number of threads, stopping the run if its nodes cannot be allocated
+ */
+void init_barrier(gs_barrier *bar, int num_threads, int spin)
+{
+    if (create_barrier(bar, num_threads, spin) != GS_OK) {
+        printf("\n\nERR: could not allocate barrier nodes\n");
+        exit(127);
+    }
+    return;
+}
+
+
+/*
+ * free_barrier - Frees the tree nodes of a barrier
+ */
+void free_barrier(gs_barrier *bar)
+{
+#ifndef __linux__
+    // a thread data struct that never ran threads has no barrier to tear down
+    if (bar->nodes != NULL) {
+        pthread_mutex_destroy(&bar->lock);
+        pthread_cond_destroy(&bar->wake);
+    }
+#endif
+    free(bar->nodes);
+    return;
+}
+
+
+/*
+ * barrier_wait - Waits until every barrier thread arrives, using the thread's id and local sense, and runs an optional serial function in the last arriving thread before the release (returns 1 in that thread)
+ */
+int barrier_wait(gs_barrier *bar, int tid, int *local_sense, serial_funct serial, void *arg)
+{
+    barrier_node *node = &bar->nodes[tid / BARRIER_FANIN];
+    int sense = !(*local_sense);
+    *local_sense = sense;
+
+    // climb the tree while this thread is the last arrival at its node
+    while (atomic_fetch_sub_explicit(&node->count, 1, memory_order_acq_rel) == 1) {
+        // re-arm the node (no thread can arrive here again before the release)
+        atomic_store_explicit(&node->count, node->expected, memory_order_relaxed);
+
+        // the last arrival at the root runs the serial function and releases every thread by reversing the sense
+        if (node->parent == NOT_FOUND) {
+            if (serial != NULL) { serial(arg); }
+            atomic_store_explicit(&bar->sense, sense, memory_order_seq_cst);
+            if (atomic_load_explicit(&bar->num_sleeping, memory_order_seq_cst) > 0) { wake_all(bar); }
+            return 1;
+        }
+        node = &bar->nodes[node->parent];
+    }
+
+    // spin on the sense for the spin budget
+    for (int i = 0; i < bar->spin; i++) {
+        if (atomic_load_explicit(&bar->sense, memory_order_acquire) == sense) { return 0; }
+        cpu_relax();
+    }
+
+    // park until the sense is reversed
+    atomic_fetch_add_explicit(&bar->num_sleeping, 1, memory_order_seq_cst);
+    while (atomic_load_explicit(&bar->sense, memory_order_seq_cst) != sense) { sleep_on_sense(bar, !sense); }
+    atomic_fetch_sub_explicit(&bar->num_sleeping, 1, memory_order_relaxed);
+    return 0;
+}
@@ -0,0 +1,323 @@
+//
+//  gschamp.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "gsdefs.h"
+
+static const char *champ_format_names[] = {"double", "float", "int16", "int8"};
+
+
+/*
+ * champion_index - Returns the index of a run's most fit snake of the last generation and writes its fitness (the generation it played is ann_s->gen plus finished)
+ */
+int champion_index(thread_data *t_data, double *fitness)
+{
+    int ct = t_data->params->pop_size;
+    int best_i = 0;
+
+    // a finished run never selected its last generation, a paused one ranked its parents already
+    if (t_data->finished) {
+        for (int i = 1; i < ct; i++) {
+            if (t_data->ann_s->fitness[i] > t_data->ann_s->fitness[best_i]) { best_i = i; }
+        }
+        if (fitness != NULL) { *fitness = t_data->ann_s->fitness[best_i]; }
+    } else {
+        best_i = t_data->surv_idx[ct - 1];
+        if (fitness != NULL) { *fitness = t_data->ann_s->fitness[ct - 1]; }
+    }
+    return best_i;
+}
+
+
+/*
+ * remove_neuron - Removes a hidden neuron from a champion's layer and its weights from the next layer
+ */
+static void remove_neuron(champ_layer *layers, int l, int j)
+{
+    champ_layer *curr = &layers[l];
+    champ_layer *next = &layers[l + 1];
+    int idx = 0;
+
+    // drop the neuron's weights and bias
+    memmove(curr->w + j * curr->in, curr->w + (j + 1) * curr->in, (curr->out - j - 1) * curr->in * sizeof(double));
+    memmove(curr->b + j, curr->b + j + 1, (curr->out - j - 1) * sizeof(double));
+    curr->out--;
+
+    // drop its input from every next layer neuron (in place, the copies only move down)
+    for (int i = 0; i < next->out; i++) {
+        for (int k = 0; k < next->in; k++) {
+            if (k != j) { next->w[idx++] = next->w[RIDX(i, k, next->in)]; }
+        }
+    }
+    next->in--;
+    return;
+}
+
+
+/*
+ * prune_layers - Zeroes the weights below a threshold, then removes hidden neurons nothing reads and folds the ones nothing feeds into the next layer's biases, returns the zeroed weights
+ */
+static int prune_layers(champ_layer *layers, int num_l, double prune, int *pruned_n)
+{
+    int pruned_w = 0;
+    int changed = 1;
+    int dead;
+
+    for (int l = 0; l < num_l; l++) {
+        for (int k = 0; k < layers[l].in * layers[l].out; k++) {
+            if (fabs(layers[l].w[k]) < prune) {
+                layers[l].w[k] = 0;
+                pruned_w++;
+            }
+        }
+    }
+
+    // removing a neuron can leave the neurons feeding it unread, so repeat until nothing changes (every layer keeps a neuron)
+    while (changed) {
+        changed = 0;
+        for (int l = 0; l < num_l - 1; l++) {
+            for (int j = layers[l].out - 1; (j >= 0) && (layers[l].out > 1); j--) {
+                // a neuron no next layer weight reads does not change the output
+                dead = 1;
+                for (int i = 0; (i < layers[l + 1].out) && (dead); i++) { dead = (layers[l + 1].w[RIDX(i, j, layers[l + 1].in)] == 0); }
+                if (!dead) {
+                    // a neuron without weights always outputs the sigmoid of its bias
+                    dead = 1;
+                    for (int k = 0; (k < layers[l].in) && (dead); k++) { dead = (layers[l].w[RIDX(j, k, layers[l].in)] == 0); }
+                    if (!dead) { continue; }
+                    for (int i = 0; i < layers[l + 1].out; i++) {
+                        layers[l + 1].b[i] += layers[l + 1].w[RIDX(i, j, layers[l + 1].in)] * sigmoid(layers[l].b[j]);
+                    }
+                }
+                remove_neuron(layers, l, j);
+                (*pruned_n)++;
+                changed = 1;
+            }
+        }
+    }
+    return pruned_w;
+}
+
+
+/*
+ * write_champion - Writes a champion's header, its weights input by input in a given format and its biases, returns 0 on success
+ */
+static int write_champion(FILE *file, gs_champion_header *hdr, champ_layer *layers, size_t elem)
+{
+    static const char pad[8] = {0};
+    size_t pad_len;
+    double max, w;
+    float f;
+    int16_t q16;
+    int8_t q8;
+    int err = 0;
+
+    err |= (fwrite(hdr, sizeof(gs_champion_header), 1, file) != 1);
+    for (int l = 0; (l < hdr->num_layers) && (!err); l++) {
+        for (int k = 0; k < layers[l].in; k++) {
+            for (int j = 0; j < layers[l].out; j++) {
+                w = layers[l].w[RIDX(j, k, layers[l].in)];
+                if (hdr->format == GS_CHAMP_DOUBLE) { err |= (fwrite(&w, sizeof(double), 1, file) != 1); }
+                else if (hdr->format == GS_CHAMP_FLOAT) { f = (float) w; err |= (fwrite(&f, sizeof(float), 1, file) != 1); }
+                else {
+                    // round to the nearest step of the layer's scale (max keeps the largest weight in range)
+                    max = (hdr->format == GS_CHAMP_INT16)? 32767: 127;
+                    w = round(w / hdr->scale[l]);
+                    w = (w > max)? max: (w < -max)? -max: w;
+                    if (hdr->format == GS_CHAMP_INT16) { q16 = (int16_t) w; err |= (fwrite(&q16, sizeof(int16_t), 1, file) != 1); }
+                    else { q8 = (int8_t) w; err |= (fwrite(&q8, sizeof(int8_t), 1, file) != 1); }
+                }
+            }
+        }
+    }
+
+    // biases stay doubles, they are few and sigmoid is steep around them
+    if (!err) {
+        pad_len = hdr->biases_off - hdr->weights_off - hdr->num_w * elem;
+        err |= (fwrite(pad, 1, pad_len, file) != pad_len);
+    }
+    for (int l = 0; (l < hdr->num_layers) && (!err); l++) { err |= (fwrite(layers[l].b, sizeof(double), layers[l].out, file) != (size_t) layers[l].out); }
+    return (err)? -1: 0;
+}
+
+
+/*
+ * export_champion - Prunes a copy of a net and writes it as a frozen champion file in a given weight format, returns 0 on success
+ */
+int export_champion(ann *net, int format, double prune, int gen, int apples, double fitness, const char *file_name)
+{
+    static const size_t elem[] = {sizeof(double), sizeof(float), sizeof(int16_t), sizeof(int8_t)};
+    champ_layer layers[MAX_NUM_LAYERS];
+    gs_champion_header hdr;
+    char tmp_file[MAX_LINE_SIZE + 8];
+    int idx_w = 0, idx_n = 0, pruned_n = 0, err;
+    double max;
+    FILE *file;
+
+    if ((net->num_l < 1) || (net->num_l > MAX_NUM_LAYERS) || (format < GS_CHAMP_DOUBLE) || (format > GS_CHAMP_INT8) || (prune < 0)) { return -1; }
+
+    // copy every layer so pruning leaves the population alone
+    for (int l = 0; l < net->num_l; l++) {
+        layers[l].in = net->shape[RIDX(l, 0, SHAPE_DIM)];
+        layers[l].out = net->shape[RIDX(l, 1, SHAPE_DIM)];
+        layers[l].w = (double *) malloc(layers[l].in * layers[l].out * sizeof(double));
+        layers[l].b = (double *) malloc(layers[l].out * sizeof(double));
+        memcpy(layers[l].w, net->w + idx_w, layers[l].in * layers[l].out * sizeof(double));
+        memcpy(layers[l].b, net->b + idx_n, layers[l].out * sizeof(double));
+        idx_w += layers[l].in * layers[l].out;
+        idx_n += layers[l].out;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = GS_CHAMP_MAGIC;
+    hdr.version = GS_CHAMP_VERSION;
+    hdr.format = format;
+    hdr.num_layers = net->num_l;
+    hdr.pruned_w = (prune > 0)? prune_layers(layers, net->num_l, prune, &pruned_n): 0;
+    hdr.pruned_n = pruned_n;
+    hdr.gen = gen;
+    hdr.apples = apples;
+    hdr.fitness = fitness;
+    for (int l = 0; l < net->num_l; l++) {
+        hdr.shape[RIDX(l, 0, 2)] = layers[l].in;
+        hdr.shape[RIDX(l, 1, 2)] = layers[l].out;
+        hdr.activation[l] = GS_CHAMP_SIGMOID;
+        hdr.num_w += layers[l].in * layers[l].out;
+        hdr.num_n += layers[l].out;
+
+        // an integer layer's scale maps its largest weight to the largest integer
+        max = 0;
+        for (int k = 0; k < layers[l].in * layers[l].out; k++) { max = (fabs(layers[l].w[k]) > max)? fabs(layers[l].w[k]): max; }
+        hdr.scale[l] = (max == 0)? 1: (format == GS_CHAMP_INT16)? (float) (max / 32767): (format == GS_CHAMP_INT8)? (float) (max / 127): 1;
+    }
+    hdr.weights_off = sizeof(gs_champion_header);
+    hdr.biases_off = (hdr.weights_off + hdr.num_w * elem[format] + 7) & ~((uint64_t) 7);
+    hdr.file_size = hdr.biases_off + hdr.num_n * sizeof(double);
+
+    // the old champion is only replaced once the new one is written
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", file_name);
+    file = fopen(tmp_file, "wb");
+    err = (file == NULL)? -1: write_champion(file, &hdr, layers, elem[format]);
+    if ((file != NULL) && (fclose(file) != 0)) { err = -1; }
+    if ((!err) && (rename(tmp_file, file_name) != 0)) { err = -1; }
+    if ((err) && (file != NULL)) { remove(tmp_file); }
+
+    for (int l = 0; l < net->num_l; l++) {
+        free(layers[l].w);
+        free(layers[l].b);
+    }
+    return err;
+}
+
+
+/*
+ * save_champion - Exports the most fit snake of the last generation across a run's islands to the CHAMPION file
+ */
+void save_champion(thread_data *islands, int num_islands)
+{
+    gs_params *params = islands[0].params;
+    int best_isl = 0, best_i, idx, gen;
+    double best_fitness, fitness;
+
+    if (params->champ_file[0] == '\0') { return; }
+    best_i = champion_index(&islands[0], &best_fitness);
+    for (int i = 1; i < num_islands; i++) {
+        idx = champion_index(&islands[i], &fitness);
+        if (fitness > best_fitness) {
+            best_isl = i;
+            best_i = idx;
+            best_fitness = fitness;
+        }
+    }
+
+    gen = islands[best_isl].ann_s->gen + islands[best_isl].finished;
+    if (export_champion(&islands[best_isl].ann_s->data[best_i], params->champ_format, params->champ_prune, gen,
+                        islands[best_isl].env_s->data[best_i].n, best_fitness, params->champ_file) != 0) {
+        printf("\nWARN: could not write the champion to %s\n", params->champ_file);
+        return;
+    }
+    printf("\n--  champion (GEN %d, fitness %g, %d apples) saved to %s  --\n", gen, best_fitness, islands[best_isl].env_s->data[best_i].n, params->champ_file);
+    return;
+}
+
+
+/*
+ * play_champion - Loads a champion file, plays seeded games with it on the vectorized env and measures its decision latency
+ */
+void play_champion(const char *file_name)
+{
+    static double obs[CHAMP_GAMES * GS_ENV_NUM_FEATURES];
+    static int actions[CHAMP_GAMES];
+    static unsigned char dones[CHAMP_GAMES];
+    static gs_venv_episode episodes[CHAMP_GAMES];
+    gs_champion *champ;
+    gs_champion_info info;
+    gs_champion_latency lat;
+    gs_venv_config config;
+    gs_venv *venv;
+    char err[MAX_LINE_SIZE];
+    int num_done = 0, best_apples = 0, best_moves = 0;
+    double sum_apples = 0, sum_moves = 0;
+
+    if (gs_champion_load(file_name, &champ, err, sizeof(err)) != GS_OK) {
+        printf("\n\nERR: %s\n\n\n", err);
+        exit(127);
+    }
+    gs_champion_get_info(champ, &info);
+    if ((info.shape[0] != GS_ENV_NUM_FEATURES) || (info.shape[RIDX((info.num_layers - 1), 1, 2)] != RIGHT)) {
+        printf("\n\nERR: champion %s does not take %d features to %d moves\n\n\n", file_name, GS_ENV_NUM_FEATURES, RIGHT);
+        exit(127);
+    }
+
+    // every game of a seed plays the same board, so a champion's score is reproducible
+    gs_venv_config_init(&config);
+    config.num_games = CHAMP_GAMES;
+    config.seed = CHAMP_SEED;
+    config.auto_reset = 0;
+    config.actions = actions;
+    config.obs = obs;
+    config.dones = dones;
+    config.episodes = episodes;
+    if (gs_venv_create(&config, &venv, err, sizeof(err)) != GS_OK) {
+        printf("\n\nERR: %s\n\n\n", err);
+        exit(127);
+    }
+    while (num_done < CHAMP_GAMES) {
+        gs_champion_decide_batch(champ, obs, CHAMP_GAMES, actions);
+        gs_venv_step(venv);
+        num_done = 0;
+        for (int g = 0; g < CHAMP_GAMES; g++) { num_done += dones[g]; }
+    }
+    for (int g = 0; g < CHAMP_GAMES; g++) {
+        sum_apples += episodes[g].apples;
+        sum_moves += episodes[g].moves;
+        best_apples = (episodes[g].apples > best_apples)? episodes[g].apples: best_apples;
+        best_moves = (episodes[g].moves > best_moves)? episodes[g].moves: best_moves;
+    }
+
+    // the latency of a decision over the starting boards (a warm cache, like a game loop)
+    gs_venv_reset(venv, NULL);
+    gs_champion_measure(champ, obs, CHAMP_GAMES, CHAMP_DECISIONS, &lat);
+    gs_venv_destroy(venv);
+
+    printf("+++++++  CHAMPION  +++++++\n\n");
+    printf("FILE: %s\n", file_name);
+    printf("EXPORTED: GEN %d, fitness %g, %d apples\n", info.gen, info.fitness, info.apples);
+    printf("SHAPE: ");
+    for (int l = 0; l < info.num_layers; l++) { printf("[%d, %d] ", info.shape[RIDX(l, 0, 2)], info.shape[RIDX(l, 1, 2)]); }
+    printf("\nWEIGHTS: %d %s, %d pruned to zero, %d neurons removed\n", info.num_w, champ_format_names[info.format], info.pruned_w, info.pruned_n);
+    printf("SIZE: %zu bytes on disk, %zu bytes loaded\n", info.file_size, info.bytes);
+    printf("GAMES: %d (seed %d), %.2f mean / %d best apples, %.1f mean / %d best moves\n", CHAMP_GAMES, CHAMP_SEED, sum_apples / CHAMP_GAMES, best_apples,
+           sum_moves / CHAMP_GAMES, best_moves);
+    printf("LATENCY: %.1f ns mean, %.1f ns p50, %.1f ns p99, %.1f ns best over %ld decisions (%.1f ns clock read taken off each)\n", lat.mean_ns, lat.p50_ns,
+           lat.p99_ns, lat.min_ns, lat.decisions, lat.clock_ns);
+    gs_champion_free(champ);
+    return;
+}
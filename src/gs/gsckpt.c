@@ -0,0 +1,389 @@
+//
+//  gsckpt.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "gsdefs.h"
+
+#define CKPT_ALIGN 64
+
+static const char ckpt_pad[CKPT_ALIGN];
+
+
+/*
+ * ckpt_align - Rounds a file offset up to the next CKPT_ALIGN bytes
+ */
+static uint64_t ckpt_align(uint64_t off)
+{
+    return (off + CKPT_ALIGN - 1) / CKPT_ALIGN * CKPT_ALIGN;
+}
+
+
+/*
+ * write_all - Writes a whole buffer to a file descriptor (only async-signal-safe calls, so a forked writer can use it) and returns 0 on success
+ */
+static int write_all(int fd, const void *buf, size_t size)
+{
+    const char *curr = (const char *) buf;
+    ssize_t ct;
+
+    while (size > 0) {
+        ct = write(fd, curr, size);
+        if ((ct < 0) && (errno == EINTR)) continue;
+        if (ct <= 0) { return -1; }
+        curr += ct;
+        size -= ct;
+    }
+    return 0;
+}
+
+
+/*
+ * build_header - Fills a checkpoint header with the run's topology, parameters, seeds and section offsets for a population resuming at a generation
+ */
+static void build_header(gs_params *params, ann_set *ann_s, int gen, int highscore, uint64_t seed, ckpt_header *hdr)
+{
+    ann *a = &ann_s->data[0];
+    uint64_t ct = params->pop_size;
+
+    memset(hdr, 0, sizeof(ckpt_header));
+    hdr->magic = CKPT_MAGIC;
+    hdr->version = CKPT_VERSION;
+    hdr->pop_size = params->pop_size;
+    hdr->gen = gen;
+    hdr->gen_ct = params->gen_ct;
+    hdr->env_width = params->env_width;
+    hdr->num_layers = params->num_layers;
+    for (int l = 0; l < 2 * params->num_layers; l++) { hdr->shape[l] = params->shape[l]; }
+    hdr->num_w = a->num_w;
+    hdr->num_n = a->num_n;
+    hdr->highscore = highscore;
+    hdr->mutate = params->mutate;
+    hdr->survive = params->survive;
+    hdr->params_seed = params->seed;
+    hdr->seed = seed;
+
+    // every section starts on its own cache line so a mapped file can be read in place
+    hdr->weights_off = ckpt_align(sizeof(ckpt_header));
+    hdr->biases_off = hdr->weights_off + ct * hdr->num_w * sizeof(double);
+    hdr->fitness_off = hdr->biases_off + ct * hdr->num_n * sizeof(double);
+    hdr->moves_off = hdr->fitness_off + ct * sizeof(double);
+    hdr->file_size = hdr->moves_off + ct * sizeof(int32_t);
+    return;
+}
+
+
+/*
+ * write_checkpoint - Writes a population to a temporary file and renames it over the checkpoint file (a forked writer runs it, so it only uses async-signal-safe calls) and returns 0 on success
+ */
+static int write_checkpoint(const char *tmp_file, const char *file, const ckpt_header *hdr, ann_set *ann_s, const double *fitness, const int *moves)
+{
+    int ct = hdr->pop_size;
+    int fd = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int err = 0;
+
+    if (fd < 0) { return -1; }
+    err |= write_all(fd, hdr, sizeof(ckpt_header));
+    err |= write_all(fd, ckpt_pad, hdr->weights_off - sizeof(ckpt_header));
+    for (int i = 0; (i < ct) && (!err); i++) { err |= write_all(fd, ann_s->data[i].w, hdr->num_w * sizeof(double)); }
+    for (int i = 0; (i < ct) && (!err); i++) { err |= write_all(fd, ann_s->data[i].b, hdr->num_n * sizeof(double)); }
+    if (!err) { err |= write_all(fd, fitness, ct * sizeof(double)); }
+    if (!err) { err |= write_all(fd, moves, ct * sizeof(int32_t)); }
+
+    // the old checkpoint is only replaced once the new one is on disk
+    if ((!err) && (fsync(fd) != 0)) { err = -1; }
+    if (close(fd) != 0) { err = -1; }
+    if ((!err) && (rename(tmp_file, file) != 0)) { err = -1; }
+    return err;
+}
+
+
+/*
+ * save_population - Writes a population outside of a run (no seeds, highscore or game lengths) as a checkpoint that INIT_POP can seed a run from, returns 0 on success
+ */
+int save_population(gs_params *params, ann_set *ann_s, int gen, const char *file)
+{
+    char tmp_file[MAX_LINE_SIZE + 8];
+    int *moves = (int *) calloc(params->pop_size, sizeof(int));
+    ckpt_header hdr;
+    int err;
+
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", file);
+    build_header(params, ann_s, gen, 0, 0, &hdr);
+    hdr.params_seed = NOT_SET;
+    err = write_checkpoint(tmp_file, file, &hdr, ann_s, ann_s->fitness, moves);
+    free(moves);
+    return err;
+}
+
+
+/*
+ * reap_writer - Collects the forked writer of the checkpoint in flight (waiting for it if asked to) and returns 0 if it is still writing
+ */
+static int reap_writer(checkpoint *ckpt, int wait)
+{
+    int status;
+    pid_t pid;
+
+    if (ckpt->writer == 0) { return 1; }
+    do { pid = waitpid(ckpt->writer, &status, (wait)? 0: WNOHANG); } while ((pid < 0) && (errno == EINTR));
+    if (pid == 0) { return 0; }
+
+    if ((pid == ckpt->writer) && (WIFEXITED(status)) && (WEXITSTATUS(status) == 0)) {
+        ckpt->written++;
+    } else {
+        ckpt->failed++;
+        printf("\nWARN: could not write the GEN %d checkpoint to %s\n", ckpt->writer_gen, ckpt->file);
+    }
+    ckpt->writer = 0;
+    return 1;
+}
+
+
+/*
+ * snapshot_population - Forks a writer that saves the population as it is now (copy-on-write) while training goes on, unless the last writer is still busy
+ */
+static void snapshot_population(thread_data *t_data, int gen, int sorted)
+{
+    checkpoint *ckpt = t_data->ckpt;
+    ann_set *ann_s = t_data->ann_s;
+    int ct = t_data->params->pop_size;
+    int ct_die = ct - (int) (ct * t_data->params->survive);
+    pid_t pid;
+
+    // a slow disk skips checkpoints instead of stalling training or piling up writers
+    if (!reap_writer(ckpt, 0)) {
+        ckpt->skipped++;
+        return;
+    }
+
+    // after selection the fitness array is sorted along with surv_idx, and children have not played yet
+    if (sorted) {
+        for (int i = 0; i < ct_die; i++) { ckpt->fitness[t_data->surv_idx[i]] = NOT_SET; }
+        for (int i = ct_die; i < ct; i++) { ckpt->fitness[t_data->surv_idx[i]] = ann_s->fitness[i]; }
+    } else {
+        memcpy(ckpt->fitness, ann_s->fitness, ct * sizeof(double));
+    }
+    build_header(t_data->params, ann_s, gen, t_data->highscore, t_data->seed, &ckpt->hdr);
+
+    // every other thread is parked on the barrier, so the child gets a consistent copy of the population
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) { _exit((write_checkpoint(ckpt->tmp_file, ckpt->file, &ckpt->hdr, ann_s, ckpt->fitness, t_data->pred_moves) == 0)? 0: 1); }
+    if (pid < 0) {
+        perror("fork");
+        ckpt->failed++;
+        return;
+    }
+    ckpt->writer = pid;
+    ckpt->writer_gen = gen;
+    return;
+}
+
+
+/*
+ * map_checkpoint - Maps a checkpoint file read-only and checks its header against the run's parameters, returns GS_OK or the reason it could not in err
+ */
+static int map_checkpoint(checkpoint *ckpt, gs_params *params, char *err, size_t size)
+{
+    const ckpt_header *hdr;
+    struct stat st;
+    int fd = open(params->resume_file, O_RDONLY);
+    int same_shape, code = GS_ERR_PARAMS;
+
+    if ((fd < 0) || (fstat(fd, &st) != 0)) {
+        if (fd >= 0) { close(fd); }
+        snprintf(err, size, "could not open checkpoint %s", params->resume_file);
+        return GS_ERR_IO;
+    }
+    if ((size_t) st.st_size < sizeof(ckpt_header)) {
+        close(fd);
+        snprintf(err, size, "%s is not a checkpoint (too small)", params->resume_file);
+        return GS_ERR_PARAMS;
+    }
+
+    // pages are only read in as snakes are restored, so a warm start costs about as much as a cold one
+    ckpt->map_size = st.st_size;
+    ckpt->map = (const ckpt_header *) mmap(NULL, ckpt->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ckpt->map == MAP_FAILED) {
+        ckpt->map = NULL;
+        snprintf(err, size, "could not map checkpoint %s (%s)", params->resume_file, strerror(errno));
+        return GS_ERR_IO;
+    }
+    hdr = ckpt->map;
+
+    same_shape = (hdr->num_layers == params->num_layers);
+    for (int l = 0; (l < 2 * params->num_layers) && (same_shape); l++) { same_shape = (hdr->shape[l] == params->shape[l]); }
+    if ((hdr->magic != CKPT_MAGIC) || (hdr->version != CKPT_VERSION)) {
+        snprintf(err, size, "%s is not a version %d checkpoint", params->resume_file, (int) CKPT_VERSION);
+    } else if ((hdr->file_size != ckpt->map_size) || (hdr->pop_size < 1) || (hdr->weights_off < sizeof(ckpt_header)) ||
+        (hdr->biases_off != hdr->weights_off + (uint64_t) hdr->pop_size * hdr->num_w * sizeof(double)) ||
+        (hdr->fitness_off != hdr->biases_off + (uint64_t) hdr->pop_size * hdr->num_n * sizeof(double)) ||
+        (hdr->moves_off != hdr->fitness_off + (uint64_t) hdr->pop_size * sizeof(double)) ||
+        (hdr->file_size != hdr->moves_off + (uint64_t) hdr->pop_size * sizeof(int32_t))) {
+        snprintf(err, size, "checkpoint %s is truncated or corrupt", params->resume_file);
+    } else if (!same_shape) {
+        snprintf(err, size, "the LAYER shape of checkpoint %s does not match the run", params->resume_file);
+    } else if ((params->resume == CKPT_RESUME) && (hdr->pop_size != params->pop_size)) {
+        snprintf(err, size, "RESUME needs the POP_WIDTH of checkpoint %s (%d, use INIT_POP to seed another size)", params->resume_file, hdr->pop_size);
+    } else if ((params->resume == CKPT_RESUME) && (hdr->gen >= params->gen_ct)) {
+        snprintf(err, size, "checkpoint %s resumes at GEN %d, past GEN_COUNT %d", params->resume_file, hdr->gen + 1, params->gen_ct);
+    } else {
+        code = GS_OK;
+    }
+    if (code != GS_OK) {
+        munmap((void *) ckpt->map, ckpt->map_size);
+        ckpt->map = NULL;
+    }
+    return code;
+}
+
+
+/*
+ * open_checkpoint - Sets up the checkpoints of a generational run and maps the checkpoint it resumes from (or seeds its population from) as t_data->ckpt (NULL if it does neither), returns GS_OK or the reason it could not in err
+ */
+int open_checkpoint(thread_data *t_data, char *err, size_t size)
+{
+    gs_params *params = t_data->params;
+    const ckpt_header *hdr;
+    const int32_t *moves;
+    checkpoint *ckpt;
+    int code;
+
+    t_data->ckpt = NULL;
+    if ((params->ckpt_every == 0) && (params->resume == CKPT_OFF)) { return GS_OK; }
+    ckpt = (checkpoint *) calloc(1, sizeof(checkpoint));
+    if (ckpt == NULL) {
+        snprintf(err, size, "could not allocate checkpoint");
+        return GS_ERR_NOMEM;
+    }
+    if (params->resume != CKPT_OFF) {
+        code = map_checkpoint(ckpt, params, err, size);
+        if (code != GS_OK) {
+            free(ckpt);
+            return code;
+        }
+        ckpt->resume = params->resume;
+    }
+    ckpt->every = params->ckpt_every;
+    if (ckpt->every) {
+        strcpy(ckpt->file, params->ckpt_file);
+        snprintf(ckpt->tmp_file, sizeof(ckpt->tmp_file), "%s.tmp", params->ckpt_file);
+        ckpt->fitness = (double *) malloc(params->pop_size * sizeof(double));
+        mem_add(MEM_BUFFERS, mem_chunk(params->pop_size * sizeof(double)));
+    }
+    t_data->ckpt = ckpt;
+    if (params->resume == CKPT_OFF) { return GS_OK; }
+    hdr = ckpt->map;
+    moves = (const int32_t *) ((const char *) hdr + hdr->moves_off);
+
+    // a resumed run continues the saved run's generation, seeds and highscore (a seeded run starts over at GEN 1)
+    if (ckpt->resume == CKPT_RESUME) {
+        t_data->ann_s->gen = hdr->gen;
+        t_data->highscore = hdr->highscore;
+        t_data->seed = hdr->seed;
+        if ((params->seed == NOT_SET) && (hdr->params_seed != NOT_SET)) { params->seed = hdr->params_seed; }
+        if (!params->quiet) { printf("--  resuming %s at GEN %d  --\n", params->resume_file, hdr->gen + 1); }
+    } else if (!params->quiet) {
+        printf("--  seeding %d snakes from the %d of %s  --\n", params->pop_size, hdr->pop_size, params->resume_file);
+    }
+
+    // saved game lengths predict the first schedule
+    for (int i = 0; i < params->pop_size; i++) { t_data->pred_moves[i] = moves[i % hdr->pop_size]; }
+    build_run_order(t_data);
+    return GS_OK;
+}
+
+
+/*
+ * init_checkpoint - Opens the checkpoints of a command line run, stopping it if the checkpoint it resumes from cannot be used, returns NULL if it keeps none
+ */
+checkpoint * init_checkpoint(thread_data *t_data)
+{
+    char err[2 * MAX_LINE_SIZE];
+
+    if (open_checkpoint(t_data, err, sizeof(err)) != GS_OK) {
+        printf("\n\nERR: %s\n\n\n", err);
+        exit(127);
+    }
+    return t_data->ckpt;
+}
+
+
+/*
+ * restore_shard - Copies the saved genomes of the snakes in [start, end) from the mapped checkpoint (snake i from saved snake i modulo the saved population)
+ */
+void restore_shard(thread_data *t_data, int start, int end)
+{
+    checkpoint *ckpt = t_data->ckpt;
+    const ckpt_header *hdr;
+    const double *w, *b;
+    ann *a;
+    int src;
+
+    if ((ckpt == NULL) || (ckpt->map == NULL)) { return; }
+    hdr = ckpt->map;
+    w = (const double *) ((const char *) hdr + hdr->weights_off);
+    b = (const double *) ((const char *) hdr + hdr->biases_off);
+
+    for (int i = start; i < end; i++) {
+        a = &t_data->ann_s->data[i];
+        src = i % hdr->pop_size;
+        memcpy(a->w, w + (size_t) src * hdr->num_w, hdr->num_w * sizeof(double));
+        memcpy(a->b, b + (size_t) src * hdr->num_n, hdr->num_n * sizeof(double));
+
+        // a resumed snake plays its first game from a fresh reset, as it would have without the interruption
+        if (ckpt->resume == CKPT_RESUME) { t_data->env_s->data[i].alive = 0; }
+    }
+    return;
+}
+
+
+/*
+ * checkpoint_gen - Serial step hook after the next generation has spawned: snapshots the population every CHECKPOINT generations
+ */
+void checkpoint_gen(thread_data *t_data)
+{
+    checkpoint *ckpt = t_data->ckpt;
+    int gen = t_data->ann_s->gen;
+
+    if ((ckpt == NULL) || (ckpt->every == 0) || (gen % ckpt->every != 0)) { return; }
+    snapshot_population(t_data, gen, 1);
+    return;
+}
+
+
+/*
+ * finish_checkpoint - Saves the last evaluated population (resuming from it replays the last generation), waits for the writer and frees the checkpoint
+ */
+void finish_checkpoint(thread_data *t_data)
+{
+    checkpoint *ckpt = t_data->ckpt;
+    if (ckpt == NULL) { return; }
+
+    // the last generation was run but never selected, so the saved run picks up by running it again from the same seeds
+    if (ckpt->every) {
+        reap_writer(ckpt, 1);
+        snapshot_population(t_data, t_data->ann_s->gen, 0);
+        reap_writer(ckpt, 1);
+        printf("\n  CHECKPOINT  %s (%ld written, %ld skipped while writing, %ld failed)\n", ckpt->file, ckpt->written, ckpt->skipped, ckpt->failed);
+        mem_add(MEM_BUFFERS, -mem_chunk(t_data->params->pop_size * sizeof(double)));
+    }
+    if (ckpt->map != NULL) { munmap((void *) ckpt->map, ckpt->map_size); }
+    free(ckpt->fitness);
+    free(ckpt);
+    t_data->ckpt = NULL;
+    return;
+}
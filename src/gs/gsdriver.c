@@ -10,53 +10,87 @@
 
 
 /*
- * threaded_genetic_snake - Starts the specified number of threads to run the genetic algorithm model with given parameters
+ * run_contexts - Runs a thread function on every given thread context (the calling thread runs the first) and waits for them to finish
  */
-static void threaded_genetic_snake(gs_params *params)
+static void run_contexts(thread_ctx *ctx, int num_ctx, void *(*thread_funct) (void *))
 {
-    pthread_t tid[MAX_NUM_THREADS + 1];
-    thread_data t_data;
-    model_flag = params->num_threads;
-
-    // setup thread data struct
-    init_thread_data_struct(&t_data, params);
-
-    // setup thread variables
-    init_thread_variables();
-    
-    // init ann and env set with given params
-    init_env_set(t_data.env_s, params->pop_size, params->env_width);
-    init_ann_set(t_data.ann_s, params->pop_size, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
-
-    // create model controller thread
-    if (pthread_create(&(tid[0]), NULL, model_controller_thread, &t_data) != 0) {
-        printf ("\n\nERR: pthread_create error for model controller thread\n"); 
-        exit (1); 
-    }
+    pthread_t tid[MAX_NUM_THREADS];
 
     // create snake controller threads
-    for (int i = 0; i < params->num_threads; i++) {
-        if (pthread_create(&(tid[i + 1]), NULL, snake_controller_thread, &t_data) != 0) {
+    for (int i = 1; i < num_ctx; i++) {
+        if (pthread_create(&(tid[i]), NULL, thread_funct, &ctx[i]) != 0) {
             printf ("\n\nERR: pthread_create error for snake controller thread (%d)\n", i); 
             exit (1); 
         }
     }
+    thread_funct(&ctx[0]);
 
     // wait for all threads to finish execution
-    for (int i = 0; i < (params->num_threads + 1); i++) {
+    for (int i = 1; i < num_ctx; i++) {
         if (pthread_join (tid[i], NULL) != 0) {
-            if (i == 0) { printf ( "\n\nERR: pthread_join error for model controller thread\n"); } 
-            else { printf ( "\n\nERR: pthread_join error for snake controller thread (%d)\n", i); }
+            printf ( "\n\nERR: pthread_join error for snake controller thread (%d)\n", i);
             exit(127); 
         }
     }
+    return;
+}
+
+
+/*
+ * launch_threads - Runs a thread function on the specified number of threads (the calling thread is thread 0) and waits for them to finish
+ */
+static void launch_threads(thread_data *t_data, void *(*thread_funct) (void *))
+{
+    thread_ctx ctx[MAX_NUM_THREADS];
+    int num_threads = t_data->params->num_threads;
+
+    // setup the barrier shared by every thread
+    init_barrier(&t_data->barrier, num_threads, (num_threads > 1)? t_data->params->barrier_spin: 0);
+    for (int i = 0; i < num_threads; i++) {
+        ctx[i].t_data = t_data;
+        ctx[i].tid = i;
+        ctx[i].sense = 0;
+    }
+
+    run_contexts(ctx, num_threads, thread_funct);
+    if (atomic_load(&t_data->fail) != GS_OK) {
+        printf("\n\nERR: snake controller threads stopped the run (%s)\n\n\n", gs_strerror(atomic_load(&t_data->fail)));
+        exit(127);
+    }
+    return;
+}
+
+
+/*
+ * threaded_genetic_snake - Starts the specified number of threads to run the genetic algorithm model with given parameters
+ */
+static void threaded_genetic_snake(gs_params *params, replay_viewer *viewer)
+{
+    thread_data t_data;
+
+    // setup thread data struct and run every generation on all snake controller threads
+    init_thread_data_struct(&t_data, params);
+    t_data.viewer = viewer;
+    t_data.prof = init_profiler(params, params->num_threads, NOT_FOUND);
+    t_data.perf = init_perf_counters(params, params->num_threads, NOT_FOUND);
+    t_data.ckpt = init_checkpoint(&t_data);
+    t_data.lin = init_lineage(&t_data);
+    t_data.metrics = start_metrics(params, 1, "island");
+    launch_threads(&t_data, snake_controller_thread);
+    finish_checkpoint(&t_data);
+    finish_lineage(&t_data);
+    stop_metrics(t_data.metrics);
+    save_champion(&t_data, 1);
+
+    // print target claim counters of every phase, the phase profile and hardware counters
+    print_claim_stats(&t_data);
+    finish_profile(&t_data.prof, 1, params->totals);
+    print_perf_summary(t_data.perf);
 
     // final cleanup
-    free(t_data.action_set);
-    free_env_set(t_data.env_s);
-    free_ann_set(t_data.ann_s);
-    free(t_data.surv_idx);
-    free(t_data.fitness_prob);
+    free_perf_counters(t_data.perf);
+    free_profiler(t_data.prof);
+    free_thread_data_struct(&t_data);
     return;
 }
 
@@ -64,48 +98,129 @@ static void threaded_genetic_snake(gs_params *params)
 /*
  * sequential_genetic_snake - Runs the specified genetic algorithm model on a single thread with given parameters
  */
-static void sequential_genetic_snake(gs_params *params)
+static void sequential_genetic_snake(gs_params *params, replay_viewer *viewer)
 {
-    int highscore = 0;
-    int *action_set = (int *) malloc(params->pop_size * sizeof(int));
-    env_set *env_s = (env_set *) malloc(sizeof(env_set));
-    ann_set *ann_s = (ann_set *) malloc(sizeof(ann_set));
-
-    // init ann and env set with given parameters
-    init_env_set(env_s, params->pop_size, params->env_width);
-    init_ann_set(ann_s, params->pop_size, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
-    
-    // run specififed number of generations
-    for (int gen_i = 0; gen_i < params->gen_ct; gen_i++) {
-        // runs coupled ann/env sets until there are no active snakes left
-        do {
-            run_ann_set(ann_s, action_set, env_s->dist_d);
-            run_env_set(env_s, action_set);
-        } while (env_s->is_active);
-
-        // prints gen stats and any highscoring run data
-        print_gen_stats(gen_i, &highscore, ann_s, env_s, params->print_replay);
-        
-        // skips spawning last gen
-        if ((gen_i + 1) == params->gen_ct) break;
-        
-        // compute fitness of current generation
-        compute_set_fitness(ann_s, env_s);
-
-        // spawn next generation
-        spawn_ann_gen(ann_s, params->survive, params->mutate, params->pop_size, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
-
-        // reset environment for next generation
-        reset_env_set(env_s);
-
-        // increment ann set generation number
-        ann_s->gen += 1;
+    thread_data t_data;
+
+    // run every generation on the calling thread through the snake controller pipeline
+    init_thread_data_struct(&t_data, params);
+    t_data.viewer = viewer;
+    t_data.prof = init_profiler(params, params->num_threads, NOT_FOUND);
+    t_data.perf = init_perf_counters(params, params->num_threads, NOT_FOUND);
+    t_data.ckpt = init_checkpoint(&t_data);
+    t_data.lin = init_lineage(&t_data);
+    t_data.metrics = start_metrics(params, 1, "island");
+    launch_threads(&t_data, snake_controller_thread);
+    finish_checkpoint(&t_data);
+    finish_lineage(&t_data);
+    stop_metrics(t_data.metrics);
+    save_champion(&t_data, 1);
+    finish_profile(&t_data.prof, 1, params->totals);
+    print_perf_summary(t_data.perf);
+
+    // final cleanup
+    free_perf_counters(t_data.perf);
+    free_profiler(t_data.prof);
+    free_thread_data_struct(&t_data);
+    return;
+}
+
+
+/*
+ * steady_genetic_snake - Runs the steady-state genetic algorithm model on the specified number of threads with given parameters
+ */
+static void steady_genetic_snake(gs_params *params, replay_viewer *viewer)
+{
+    thread_data t_data;
+    ranked_pool pool;
+
+    // setup thread data struct with a ranked pool of survivors
+    init_thread_data_struct(&t_data, params);
+    init_ranked_pool(&pool, (int) (params->pop_size * params->survive), params->pop_size);
+    t_data.pool = &pool;
+    t_data.viewer = viewer;
+    t_data.prof = init_profiler(params, params->num_threads, NOT_FOUND);
+
+    // evaluate, rank and spawn on all threads until the evaluation budget is spent
+    launch_threads(&t_data, steady_controller_thread);
+    finish_profile(&t_data.prof, 1, params->totals);
+
+    // final cleanup
+    free_profiler(t_data.prof);
+    free_ranked_pool(&pool);
+    free_thread_data_struct(&t_data);
+    return;
+}
+
+
+/*
+ * island_genetic_snake - Runs the generational model on independent islands of threads that exchange their most fit snakes
+ */
+static void island_genetic_snake(gs_params *params, replay_viewer *viewer)
+{
+    thread_ctx ctx[MAX_NUM_THREADS];
+    profiler *profs[MAX_NUM_THREADS];
+    island_set isl;
+    metrics *m = start_metrics(params, params->num_islands, "island");
+    int island_threads = params->num_threads / params->num_islands;
+
+    // setup every island with its own population shard, barrier and inbox
+    init_island_set(&isl, params);
+    for (int i = 0; i < isl.num_islands; i++) {
+        init_barrier(&isl.islands[i].barrier, island_threads, (island_threads > 1)? params->barrier_spin: 0);
+        isl.islands[i].viewer = viewer;
+        isl.islands[i].prof = profs[i] = init_profiler(&isl.params, island_threads, i);
+        isl.islands[i].perf = init_perf_counters(&isl.params, island_threads, i);
+        isl.islands[i].metrics = m;
     }
-    
+
+    // consecutive threads share an island (and neighbouring cpus when pinned)
+    for (int i = 0; i < params->num_threads; i++) {
+        ctx[i].t_data = &isl.islands[i / island_threads];
+        ctx[i].tid = i % island_threads;
+        ctx[i].sense = 0;
+    }
+    run_contexts(ctx, params->num_threads, snake_controller_thread);
+    for (int i = 0; i < isl.num_islands; i++) {
+        if (atomic_load(&isl.islands[i].fail) != GS_OK) {
+            printf("\n\nERR: snake controller threads stopped island %d (%s)\n\n\n", i, gs_strerror(atomic_load(&isl.islands[i].fail)));
+            exit(127);
+        }
+    }
+    stop_metrics(m);
+    save_champion(isl.islands, isl.num_islands);
+
+    // print island totals and migration counters
+    print_island_stats(&isl);
+    finish_profile(profs, isl.num_islands, params->totals);
+    for (int i = 0; i < isl.num_islands; i++) { print_perf_summary(isl.islands[i].perf); }
+
     // final cleanup
-    free(action_set);
-    free_env_set(env_s);
-    free_ann_set(ann_s);
+    for (int i = 0; i < isl.num_islands; i++) {
+        free_profiler(profs[i]);
+        free_perf_counters(isl.islands[i].perf);
+    }
+    free_island_set(&isl);
+    return;
+}
+
+
+/*
+ * run_genetic_snake - Starts the appropriate model for the engine and number of threads specified
+ */
+void run_genetic_snake(gs_params *params, replay_viewer *viewer)
+{
+    if (params->mode == MODE_STEADY) {
+        steady_genetic_snake(params, viewer);
+    } else if (params->mode == MODE_ISLAND) {
+        island_genetic_snake(params, viewer);
+    } else if (params->mode == MODE_FARM) {
+        farm_genetic_snake(params, viewer);
+    } else if (params->num_threads == 1) {
+        sequential_genetic_snake(params, viewer);
+    } else {
+        threaded_genetic_snake(params, viewer);
+    }
     return;
 }
 
@@ -115,8 +230,10 @@ static void sequential_genetic_snake(gs_params *params)
  */ 
 void genetic_snake(const char *file_name)
 {
-    // read parameters from input file
+    // read parameters from input file (a SEED replaces the clock seed) and tune them if asked to
     gs_params *params = read_parameters_from_file(file_name);
+    if (params->seed != NOT_SET) { seed_rand(params->seed); }
+    autotune(params);
 
     // print model parameters
     print_model_parameters(params);
@@ -124,14 +241,22 @@ void genetic_snake(const char *file_name)
     // ask user to start the model
     print_start_prompt();
 
-    // start model by number of threads specified
-    if (params->num_threads == 1) {
-        sequential_genetic_snake(params);
-    } else {
-        threaded_genetic_snake(params);
+    // count live heap bytes of this run only when a budget or the stats ask for them (autotune trials above count nothing)
+    mem_account acct;
+    int counted = ((params->memory_budget > 0) || (params->mem_stats));
+    if (counted) {
+        init_mem_account(&acct);
+        mem_bind(&acct, NULL);
     }
+
+    // highscore replays play on their own thread while the model trains
+    replay_viewer *viewer = start_replay_viewer(params);
+    run_genetic_snake(params, viewer);
     
-    // cleanup
+    // cleanup (after the last pending replay) and peak memory of every subsystem
+    stop_replay_viewer(viewer);
+    print_mem_summary(params, (counted)? &acct: NULL);
+    mem_bind(NULL, NULL);
     free(params);
     return;
 }
\ No newline at end of file
@@ -0,0 +1,387 @@
+//
+//  gsengine.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "gsdefs.h"
+
+_Static_assert(GS_MAX_LAYERS == MAX_NUM_LAYERS, "genetic_snake.h and gsdefs.h disagree on the number of layers");
+_Static_assert((GS_SCHEDULE_INDEX == SCHEDULE_INDEX) && (GS_SCHEDULE_LONGEST == SCHEDULE_LONGEST), "genetic_snake.h and gsdefs.h disagree on the schedules");
+
+
+/*
+ * gs_config_init - Fills an engine config with the defaults of a parameters file (only the population, generations, rates and shape have to be set)
+ */
+void gs_config_init(gs_config *config)
+{
+    memset(config, 0, sizeof(gs_config));
+    config->pop_size = NOT_SET;
+    config->gen_count = NOT_SET;
+    config->mutate = NOT_SET;
+    config->survive = NOT_SET;
+    config->num_threads = 1;
+    config->seed = -1;
+    config->chunk = RUN_MIN_CHUNK;
+    config->schedule = SCHEDULE_LONGEST;
+    config->barrier_spin = BARRIER_SPIN;
+    config->verbose = 0;
+    return;
+}
+
+
+/*
+ * engine_worker_thread - Parks a worker thread between runs and runs every generation of a run as its snake controller thread
+ */
+static void * engine_worker_thread(void *void_worker)
+{
+    engine_worker *worker = (engine_worker *) void_worker;
+    gs_engine *engine = worker->engine;
+    int round = 0;
+
+    while (1) {
+        // wait for the next run (or for the engine to be destroyed)
+        pthread_mutex_lock(&engine->lock);
+        while ((engine->round == round) && (!engine->quit)) { pthread_cond_wait(&engine->go, &engine->lock); }
+        if (engine->quit) {
+            pthread_mutex_unlock(&engine->lock);
+            break;
+        }
+        round = engine->round;
+        pthread_mutex_unlock(&engine->lock);
+
+        snake_controller_thread(&engine->ctx[worker->tid]);
+
+        // the last worker to finish wakes the calling thread
+        pthread_mutex_lock(&engine->lock);
+        if (++engine->num_idle == engine->params.num_threads - 1) { pthread_cond_signal(&engine->idle); }
+        pthread_mutex_unlock(&engine->lock);
+    }
+    return NULL;
+}
+
+
+/*
+ * stop_workers - Wakes every started worker thread to exit and joins them
+ */
+static void stop_workers(gs_engine *engine, int num_workers)
+{
+    pthread_mutex_lock(&engine->lock);
+    engine->quit = 1;
+    pthread_cond_broadcast(&engine->go);
+    pthread_mutex_unlock(&engine->lock);
+    for (int i = 1; i <= num_workers; i++) { pthread_join(engine->tid[i], NULL); }
+    return;
+}
+
+
+/*
+ * create_engine - Checks a config and builds an engine (population, barrier and parked worker threads) from it, seeding its first population from a checkpoint file unless it is NULL, and writes the reason of a failure to err
+ */
+static int create_engine(const gs_config *config, const char *file, gs_engine **out, char *err, size_t size)
+{
+    unsigned long long rand_state;
+    gs_params *defaults;
+    gs_engine *engine;
+    int num_threads, code;
+
+    if ((config == NULL) || (out == NULL) || ((file != NULL) && (strlen(file) >= MAX_LINE_SIZE))) { return GS_ERR_ARG; }
+    *out = NULL;
+    if (err == NULL) { size = 0; }
+    if (posix_memalign((void **) &engine, CACHE_LINE, sizeof(gs_engine)) != 0) { return GS_ERR_NOMEM; }
+
+    // every parameter a config does not cover keeps its parameters file default
+    defaults = init_parameters_struct();
+    if (defaults == NULL) {
+        free(engine);
+        return GS_ERR_NOMEM;
+    }
+    engine->params = *defaults;
+    free(defaults);
+    engine->params.pop_size = config->pop_size;
+    engine->params.gen_ct = config->gen_count;
+    engine->params.mutate = config->mutate;
+    engine->params.survive = config->survive;
+    engine->params.num_layers = config->num_layers;
+    for (int l = 0; (l < config->num_layers) && (l < MAX_NUM_LAYERS); l++) {
+        engine->params.shape[RIDX(l, 0, 2)] = config->shape[RIDX(l, 0, 2)];
+        engine->params.shape[RIDX(l, 1, 2)] = config->shape[RIDX(l, 1, 2)];
+        engine->params.activation[l] = sigmoid;
+    }
+    engine->params.num_threads = config->num_threads;
+    engine->params.seed = (config->seed < 0)? NOT_SET: config->seed;
+    engine->params.chunk = config->chunk;
+    engine->params.schedule = config->schedule;
+    engine->params.barrier_spin = config->barrier_spin;
+    engine->params.quiet = !config->verbose;
+    if (file != NULL) {
+        engine->params.resume = CKPT_INIT_POP;
+        strcpy(engine->params.resume_file, file);
+    }
+    if ((config->num_layers < 1) || (config->num_layers > MAX_NUM_LAYERS)) {
+        if (size > 0) { snprintf(err, size, "Invalid number of layers (needs to be 1 to %d)", MAX_NUM_LAYERS); }
+        free(engine);
+        return GS_ERR_PARAMS;
+    }
+    if ((config->schedule != SCHEDULE_INDEX) && (config->schedule != SCHEDULE_LONGEST)) {
+        if (size > 0) { snprintf(err, size, "Invalid schedule %d (use GS_SCHEDULE_INDEX or GS_SCHEDULE_LONGEST)", config->schedule); }
+        free(engine);
+        return GS_ERR_PARAMS;
+    }
+    if (check_parameters(&engine->params, (size > 0)? err: NULL, size) != GS_OK) {
+        free(engine);
+        return GS_ERR_PARAMS;
+    }
+
+    // the engine draws its seeds from its own random numbers and leaves the caller's alone
+    rand_state = get_rand_state();
+    seed_rand((engine->params.seed != NOT_SET)? (unsigned long long) engine->params.seed: (unsigned long long) time(NULL) ^ (unsigned long long) (size_t) engine);
+    code = create_thread_data_struct(&engine->t_data, &engine->params);
+    engine->rand_state = get_rand_state();
+    set_rand_state(rand_state);
+    if (code != GS_OK) {
+        if (size > 0) { snprintf(err, size, "could not allocate thread data for %d snakes", engine->params.pop_size); }
+        free(engine);
+        return code;
+    }
+
+    // map the checkpoint the first run copies its genomes from (its pages are read in as the shards start)
+    code = open_checkpoint(&engine->t_data, (size > 0)? err: NULL, size);
+    if (code != GS_OK) {
+        free_thread_data_struct(&engine->t_data);
+        free(engine);
+        return code;
+    }
+
+    // setup the barrier and the thread contexts every run reuses
+    num_threads = engine->params.num_threads;
+    if (create_barrier(&engine->t_data.barrier, num_threads, (num_threads > 1)? engine->params.barrier_spin: 0) != GS_OK) {
+        if (size > 0) { snprintf(err, size, "could not allocate the barrier of %d threads", num_threads); }
+        finish_checkpoint(&engine->t_data);
+        free_thread_data_struct(&engine->t_data);
+        free(engine);
+        return GS_ERR_NOMEM;
+    }
+    for (int i = 0; i < num_threads; i++) {
+        engine->ctx[i].t_data = &engine->t_data;
+        engine->ctx[i].tid = i;
+        engine->ctx[i].sense = 0;
+        engine->workers[i].engine = engine;
+        engine->workers[i].tid = i;
+    }
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->go, NULL);
+    pthread_cond_init(&engine->idle, NULL);
+    engine->round = 0;
+    engine->num_idle = 0;
+    engine->quit = 0;
+    engine->run_t = 0;
+
+    // park a worker on every thread but the calling one
+    for (int i = 1; i < num_threads; i++) {
+        if (pthread_create(&engine->tid[i], NULL, engine_worker_thread, &engine->workers[i]) != 0) {
+            if (size > 0) { snprintf(err, size, "pthread_create error for engine worker thread (%d)", i); }
+            stop_workers(engine, i - 1);
+            finish_checkpoint(&engine->t_data);
+            free_thread_data_struct(&engine->t_data);
+            pthread_cond_destroy(&engine->idle);
+            pthread_cond_destroy(&engine->go);
+            pthread_mutex_destroy(&engine->lock);
+            free(engine);
+            return GS_ERR_THREAD;
+        }
+    }
+
+    *out = engine;
+    return GS_OK;
+}
+
+
+/*
+ * gs_engine_create - Checks a config and builds an engine from it with a random first population, writing the reason of a failure to err
+ */
+int gs_engine_create(const gs_config *config, gs_engine **out, char *err, size_t size)
+{
+    return create_engine(config, NULL, out, err, size);
+}
+
+
+/*
+ * gs_engine_create_from_checkpoint - Checks a config and builds an engine whose first population is copied from a checkpoint (as INIT_POP does), writing the reason of a failure to err
+ */
+int gs_engine_create_from_checkpoint(const gs_config *config, const char *file, gs_engine **out, char *err, size_t size)
+{
+    if (file == NULL) { return GS_ERR_ARG; }
+    return create_engine(config, file, out, err, size);
+}
+
+
+/*
+ * gs_engine_run - Runs the next n generations of an engine on every engine thread (the calling thread is thread 0), stopping early at the last generation or when a thread runs out of memory (the engine can then only be destroyed)
+ */
+int gs_engine_run(gs_engine *engine, int n)
+{
+    thread_data *t_data;
+    unsigned long long rand_state;
+    double start_t;
+#ifdef __linux__
+    cpu_set_t caller_mask;
+    int pinned = 0;
+#endif
+
+    if ((engine == NULL) || (n < 1)) { return GS_ERR_ARG; }
+    t_data = &engine->t_data;
+    if (t_data->finished) { return GS_ERR_FINISHED; }
+    if (atomic_load(&t_data->fail) != GS_OK) { return atomic_load(&t_data->fail); }
+
+    // a paused run's first phase starts now (not when the last run paused)
+    start_t = get_time();
+    t_data->stop_gen = t_data->ann_s->gen + n;
+    if (t_data->started) { t_data->run_start_t = start_t; }
+
+    // wake the workers and run with them on the caller's own thread
+    pthread_mutex_lock(&engine->lock);
+    engine->num_idle = 0;
+    engine->round++;
+    pthread_cond_broadcast(&engine->go);
+    pthread_mutex_unlock(&engine->lock);
+    rand_state = get_rand_state();
+    set_rand_state(engine->rand_state);
+#ifdef __linux__
+    // thread 0 is pinned like any other engine thread, so the caller gets back the cpus it came with
+    if (t_data->num_cpus > 0) { pinned = (pthread_getaffinity_np(pthread_self(), sizeof(caller_mask), &caller_mask) == 0); }
+#endif
+    snake_controller_thread(&engine->ctx[0]);
+#ifdef __linux__
+    if (pinned) { pthread_setaffinity_np(pthread_self(), sizeof(caller_mask), &caller_mask); }
+#endif
+    engine->rand_state = get_rand_state();
+    set_rand_state(rand_state);
+
+    // wait for every worker to park again
+    pthread_mutex_lock(&engine->lock);
+    while (engine->num_idle < engine->params.num_threads - 1) { pthread_cond_wait(&engine->idle, &engine->lock); }
+    pthread_mutex_unlock(&engine->lock);
+    engine->run_t += get_time() - start_t;
+    return atomic_load(&t_data->fail);
+}
+
+
+/*
+ * gs_engine_get_stats - Copies the generations run so far and the stats of the last generation
+ */
+int gs_engine_get_stats(gs_engine *engine, gs_engine_stats *stats)
+{
+    gen_stats *last;
+
+    if ((engine == NULL) || (stats == NULL)) { return GS_ERR_ARG; }
+    last = &engine->t_data.last_stats;
+    stats->gens = (engine->t_data.finished)? engine->params.gen_ct: (engine->t_data.started)? engine->t_data.ann_s->gen: 0;
+    stats->gen_count = engine->params.gen_ct;
+    stats->finished = engine->t_data.finished;
+    stats->highscore = engine->t_data.highscore;
+    stats->games = last->ct;
+    stats->fitness_min = (last->ct > 0)? last->min_fitness: 0;
+    stats->fitness_mean = (last->ct > 0)? last->sum_fitness / last->ct: 0;
+    stats->fitness_max = (last->ct > 0)? last->max_fitness: 0;
+    stats->moves_mean = (last->ct > 0)? (double) last->sum_moves / last->ct: 0;
+    stats->apples_mean = (last->ct > 0)? (double) last->sum_apples / last->ct: 0;
+    stats->apples_max = last->max_apples;
+    stats->seconds = engine->run_t;
+    return GS_OK;
+}
+
+
+/*
+ * gs_engine_best_genome - Copies the weights then the biases of the fittest snake of the last generation, returning the needed doubles in needed
+ */
+int gs_engine_best_genome(gs_engine *engine, double *genome, int size, int *needed)
+{
+    thread_data *t_data;
+    ann *best;
+
+    if (engine == NULL) { return GS_ERR_ARG; }
+    t_data = &engine->t_data;
+    if ((!t_data->started) || (t_data->last_stats.ct == 0)) { return GS_ERR_STATE; }
+    best = &t_data->ann_s->data[champion_index(t_data, NULL)];
+    if (needed != NULL) { *needed = best->num_w + best->num_n; }
+    if ((genome == NULL) || (size < best->num_w + best->num_n)) { return GS_ERR_SIZE; }
+    memcpy(genome, best->w, best->num_w * sizeof(double));
+    memcpy(genome + best->num_w, best->b, best->num_n * sizeof(double));
+    return GS_OK;
+}
+
+
+/*
+ * gs_engine_export_champion - Writes the fittest snake of the last generation as a frozen champion in a given weight format, pruning weights below prune
+ */
+int gs_engine_export_champion(gs_engine *engine, const char *file, int format, double prune)
+{
+    thread_data *t_data;
+    double fitness;
+    int best_i;
+
+    if ((engine == NULL) || (file == NULL) || (format < GS_CHAMP_DOUBLE) || (format > GS_CHAMP_INT8) || (prune < 0)) { return GS_ERR_ARG; }
+    t_data = &engine->t_data;
+    if ((!t_data->started) || (t_data->last_stats.ct == 0)) { return GS_ERR_STATE; }
+    best_i = champion_index(t_data, &fitness);
+    if (export_champion(&t_data->ann_s->data[best_i], format, prune, t_data->ann_s->gen + t_data->finished, t_data->env_s->data[best_i].n, fitness, file) != 0) { return GS_ERR_IO; }
+    return GS_OK;
+}
+
+
+/*
+ * gs_engine_checkpoint - Writes an engine's population as a checkpoint that INIT_POP can seed a command line run from
+ */
+int gs_engine_checkpoint(gs_engine *engine, const char *file)
+{
+    if ((engine == NULL) || (file == NULL)) { return GS_ERR_ARG; }
+    if (!engine->t_data.started) { return GS_ERR_STATE; }
+    if (save_population(&engine->params, engine->t_data.ann_s, engine->t_data.ann_s->gen, file) != 0) { return GS_ERR_IO; }
+    return GS_OK;
+}
+
+
+/*
+ * gs_engine_destroy - Stops an engine's worker threads and frees everything it holds
+ */
+void gs_engine_destroy(gs_engine *engine)
+{
+    if (engine == NULL) { return; }
+    stop_workers(engine, engine->params.num_threads - 1);
+    finish_checkpoint(&engine->t_data);
+    free_thread_data_struct(&engine->t_data);
+    pthread_cond_destroy(&engine->idle);
+    pthread_cond_destroy(&engine->go);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine);
+    return;
+}
+
+
+/*
+ * gs_strerror - Returns the description of an engine result code
+ */
+const char * gs_strerror(int code)
+{
+    switch (code) {
+        case GS_OK: return "success";
+        case GS_ERR_ARG: return "invalid argument";
+        case GS_ERR_PARAMS: return "invalid configuration";
+        case GS_ERR_NOMEM: return "out of memory";
+        case GS_ERR_THREAD: return "could not start the engine threads";
+        case GS_ERR_STATE: return "no generation has run yet";
+        case GS_ERR_FINISHED: return "every generation has already run";
+        case GS_ERR_SIZE: return "buffer too small";
+        case GS_ERR_IO: return "could not read or write the file";
+        default: return "unknown error";
+    }
+}
@@ -0,0 +1,744 @@
+//
+//  gsfarm.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "gsdefs.h"
+
+// every message starts with a header of three 32 bit words: magic, type and payload length
+#define MSG_HEADER_SIZE 12
+
+// a result record is: index, seed, fitness, moves, apples
+#define RESULT_SIZE (4 + 8 + 8 + 4 + 4)
+
+
+/*
+ * put_bytes - Appends raw bytes to a message buffer
+ */
+static void put_bytes(unsigned char *buf, size_t *off, const void *src, size_t len)
+{
+    memcpy(buf + *off, src, len);
+    *off += len;
+    return;
+}
+
+
+/*
+ * get_bytes - Reads raw bytes from a message buffer
+ */
+static void get_bytes(const unsigned char *buf, size_t *off, void *dst, size_t len)
+{
+    memcpy(dst, buf + *off, len);
+    *off += len;
+    return;
+}
+
+
+/*
+ * put_i32 - Appends a 32 bit integer to a message buffer
+ */
+static void put_i32(unsigned char *buf, size_t *off, int value)
+{
+    int32_t v = (int32_t) value;
+    put_bytes(buf, off, &v, sizeof(v));
+    return;
+}
+
+
+/*
+ * get_i32 - Reads a 32 bit integer from a message buffer
+ */
+static int get_i32(const unsigned char *buf, size_t *off)
+{
+    int32_t v;
+    get_bytes(buf, off, &v, sizeof(v));
+    return (int) v;
+}
+
+
+/*
+ * send_all - Sends a whole buffer to a socket and returns -1 if the peer is gone
+ */
+static int send_all(int fd, const unsigned char *buf, size_t len)
+{
+    ssize_t n;
+    while (len > 0) {
+        n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { return -1; }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+/*
+ * recv_all - Receives a whole buffer from a socket and returns -1 if the peer is gone or timed out
+ */
+static int recv_all(int fd, unsigned char *buf, size_t len)
+{
+    ssize_t n;
+    while (len > 0) {
+        n = recv(fd, buf, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { return -1; }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+
+/*
+ * reserve_buf - Grows a message buffer to hold at least a given number of bytes, returns -1 (leaving the buffer as it was) if it cannot
+ */
+static int reserve_buf(unsigned char **buf, size_t *size, size_t len)
+{
+    unsigned char *grown;
+
+    if (len <= *size) { return 0; }
+    grown = (unsigned char *) realloc(*buf, len);
+    if (grown == NULL) { return -1; }
+    *buf = grown;
+    *size = len;
+    return 0;
+}
+
+
+/*
+ * send_msg - Fills in the header of a message whose payload follows it in the buffer and sends it, returning the bytes sent or -1
+ */
+static long send_msg(int fd, int type, unsigned char *buf, size_t payload_len)
+{
+    size_t off = 0;
+    put_i32(buf, &off, FARM_MAGIC);
+    put_i32(buf, &off, type);
+    put_i32(buf, &off, (int) payload_len);
+    if (send_all(fd, buf, MSG_HEADER_SIZE + payload_len) != 0) { return -1; }
+    return (long) (MSG_HEADER_SIZE + payload_len);
+}
+
+
+/*
+ * recv_msg - Receives a message into a growable buffer (payload at the start) and returns its type, or -1 on a lost peer or bad message
+ */
+static int recv_msg(int fd, unsigned char **buf, size_t *size, size_t *payload_len)
+{
+    unsigned char header[MSG_HEADER_SIZE];
+    size_t off = 0;
+    int magic, type;
+
+    if (recv_all(fd, header, MSG_HEADER_SIZE) != 0) { return -1; }
+    magic = get_i32(header, &off);
+    type = get_i32(header, &off);
+    *payload_len = (size_t) (unsigned int) get_i32(header, &off);
+    if (magic != FARM_MAGIC) { return -1; }
+
+    if (reserve_buf(buf, size, *payload_len + MSG_HEADER_SIZE) != 0) { return -1; }
+    if (recv_all(fd, *buf, *payload_len) != 0) { return -1; }
+    return type;
+}
+
+
+/*
+ * open_socket - Opens a listening or connected stream socket for a 'unix:/path' or 'tcp:host:port' address and returns -1 on failure
+ */
+static int open_socket(const char *addr, int listening)
+{
+    int fd, one = 1;
+
+    if (strncmp(addr, "unix:", 5) == 0) {
+        struct sockaddr_un sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        strncpy(sa.sun_path, addr + 5, sizeof(sa.sun_path) - 1);
+        if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) { return -1; }
+        if (listening) {
+            unlink(sa.sun_path);
+            if ((bind(fd, (struct sockaddr *) &sa, sizeof(sa)) != 0) || (listen(fd, SOMAXCONN) != 0)) { close(fd); return -1; }
+        } else if (connect(fd, (struct sockaddr *) &sa, sizeof(sa)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // tcp:host:port (an empty host listens on every interface)
+    char host[MAX_LINE_SIZE];
+    const char *port = strrchr(addr + 4, ':');
+    struct addrinfo hints, *res, *ai;
+    if (port == NULL) { return -1; }
+    snprintf(host, sizeof(host), "%.*s", (int) (port - (addr + 4)), addr + 4);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = (listening)? AI_PASSIVE: 0;
+    if (getaddrinfo((host[0] != '\0')? host: NULL, port + 1, &hints, &res) != 0) { return -1; }
+
+    fd = -1;
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        if ((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0) continue;
+        if (listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if ((bind(fd, ai->ai_addr, ai->ai_addrlen) == 0) && (listen(fd, SOMAXCONN) == 0)) break;
+        } else if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+
+/*
+ * genome_size - Returns the encoded size of a genome of a given length for a quantization level (0 sends doubles)
+ */
+static size_t genome_size(int len, int quantize)
+{
+    if (quantize == 8) { return sizeof(float) + len * sizeof(int8_t); }
+    if (quantize == 16) { return sizeof(float) + len * sizeof(int16_t); }
+    return len * sizeof(double);
+}
+
+
+/*
+ * encode_param - Encodes one weight or bias with a per genome scale, returning the value the receiver will decode
+ */
+static double encode_param(unsigned char *buf, size_t *off, double x, float scale, int quantize)
+{
+    if (quantize == 8) {
+        int8_t q = (int8_t) lrint(x / scale);
+        put_bytes(buf, off, &q, sizeof(q));
+        return q * (double) scale;
+    } else if (quantize == 16) {
+        int16_t q = (int16_t) lrint(x / scale);
+        put_bytes(buf, off, &q, sizeof(q));
+        return q * (double) scale;
+    }
+    put_bytes(buf, off, &x, sizeof(x));
+    return x;
+}
+
+
+/*
+ * encode_genome - Appends the weights and biases of an ann to a message and snaps the ann to the decoded values so both ends play the same genome
+ */
+static void encode_genome(unsigned char *buf, size_t *off, ann *net, int quantize)
+{
+    double max = 0;
+    float scale = 1;
+
+    if (quantize) {
+        for (int k = 0; k < net->num_w; k++) { if (fabs(net->w[k]) > max) { max = fabs(net->w[k]); } }
+        for (int k = 0; k < net->num_n; k++) { if (fabs(net->b[k]) > max) { max = fabs(net->b[k]); } }
+        if (max > 0) { scale = (float) (max / ((quantize == 8)? 127.0: 32767.0)); }
+        put_bytes(buf, off, &scale, sizeof(scale));
+    }
+    for (int k = 0; k < net->num_w; k++) { net->w[k] = encode_param(buf, off, net->w[k], scale, quantize); }
+    for (int k = 0; k < net->num_n; k++) { net->b[k] = encode_param(buf, off, net->b[k], scale, quantize); }
+    return;
+}
+
+
+/*
+ * decode_param - Decodes one weight or bias of a genome
+ */
+static double decode_param(const unsigned char *buf, size_t *off, float scale, int quantize)
+{
+    if (quantize == 8) {
+        int8_t q;
+        get_bytes(buf, off, &q, sizeof(q));
+        return q * (double) scale;
+    } else if (quantize == 16) {
+        int16_t q;
+        get_bytes(buf, off, &q, sizeof(q));
+        return q * (double) scale;
+    }
+    double x;
+    get_bytes(buf, off, &x, sizeof(x));
+    return x;
+}
+
+
+/*
+ * decode_genome - Reads the weights and biases of an ann from a message
+ */
+static void decode_genome(const unsigned char *buf, size_t *off, ann *net, int quantize)
+{
+    float scale = 1;
+    if (quantize) { get_bytes(buf, off, &scale, sizeof(scale)); }
+    for (int k = 0; k < net->num_w; k++) { net->w[k] = decode_param(buf, off, scale, quantize); }
+    for (int k = 0; k < net->num_n; k++) { net->b[k] = decode_param(buf, off, scale, quantize); }
+    return;
+}
+
+
+/*
+ * play_game - Plays one game of an ann in the first env of a set, with the apples placed from a given seed
+ */
+static void play_game(ann *net, env_set *eval_s, unsigned long long seed)
+{
+    env *e = &eval_s->data[0];
+    int action;
+
+    // a game is fully determined by the genome and the seed, so any process can replay it
+    seed_rand(seed);
+    reset_env(e);
+    update_dist_data(eval_s, 0);
+    while (e->alive) {
+        action = run_ann(net, &eval_s->dist_d[0]);
+        run_env_action(action, e);
+        update_dist_data(eval_s, 0);
+    }
+    return;
+}
+
+
+/*
+ * add_worker - Accepts a pending worker connection and sends it the model shape
+ */
+static void add_worker(farm *f)
+{
+    gs_params *params = f->params;
+    struct timeval tv = { params->farm_timeout, 0 };
+    size_t off = MSG_HEADER_SIZE;
+    int one = 1;
+    int fd = accept(f->listen_fd, NULL, NULL);
+    if (fd < 0) { return; }
+
+    // a worker that stops answering mid-message is dropped after the timeout
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // hello: env width, quantization, layers and shape
+    put_i32(f->buf, &off, params->env_width);
+    put_i32(f->buf, &off, params->quantize);
+    put_i32(f->buf, &off, params->num_layers);
+    for (int k = 0; k < 2 * params->num_layers; k++) { put_i32(f->buf, &off, params->shape[k]); }
+    if (send_msg(fd, FARM_HELLO, f->buf, off - MSG_HEADER_SIZE) < 0) { close(fd); return; }
+
+    if (f->num_workers == f->max_workers) {
+        f->max_workers = (f->max_workers)? 2 * f->max_workers: 8;
+        f->workers = (farm_worker *) realloc(f->workers, f->max_workers * sizeof(farm_worker));
+    }
+    f->workers[f->num_workers].fd = fd;
+    f->workers[f->num_workers].inflight = 0;
+    f->workers[f->num_workers].progress_t = get_time();
+    f->workers[f->num_workers].games = 0;
+    f->num_workers++;
+    f->joined++;
+    return;
+}
+
+
+/*
+ * drop_worker - Closes a lost worker and requeues every batch it had in flight
+ */
+static void drop_worker(farm *f, int w, const char *reason)
+{
+    farm_worker *worker = &f->workers[w];
+
+    printf("\nWARN: lost farm worker (%s), requeueing %d batch(es)\n", reason, worker->inflight);
+    for (int i = 0; i < worker->inflight; i++) { f->batch_state[worker->batch[i]] = BATCH_PENDING; }
+    f->requeued += worker->inflight;
+    f->lost++;
+    close(worker->fd);
+    f->workers[w] = f->workers[--f->num_workers];
+    return;
+}
+
+
+/*
+ * send_batch - Sends a batch of snakes with their game seeds to a worker and returns -1 if the worker is gone
+ */
+static int send_batch(farm *f, int w, int b)
+{
+    gs_params *params = f->params;
+    int start = b * params->farm_batch;
+    int end = (start + params->farm_batch < params->pop_size)? start + params->farm_batch: params->pop_size;
+    size_t off = MSG_HEADER_SIZE;
+    long sent;
+
+    if (reserve_buf(&f->buf, &f->buf_size, MSG_HEADER_SIZE + 4 + (end - start) * (12 + genome_size(f->ann_s->data[0].num_w + f->ann_s->data[0].num_n, params->quantize))) != 0) { return -1; }
+    put_i32(f->buf, &off, end - start);
+    for (int i = start; i < end; i++) {
+        put_i32(f->buf, &off, i);
+        put_bytes(f->buf, &off, &f->seed[i], sizeof(f->seed[i]));
+        encode_genome(f->buf, &off, &f->ann_s->data[i], params->quantize);
+    }
+    if ((sent = send_msg(f->workers[w].fd, FARM_GAMES, f->buf, off - MSG_HEADER_SIZE)) < 0) { return -1; }
+
+    f->bytes_sent += sent;
+    f->batch_state[b] = BATCH_SENT;
+    if (f->workers[w].inflight == 0) { f->workers[w].progress_t = get_time(); }
+    f->workers[w].batch[f->workers[w].inflight++] = b;
+    return 0;
+}
+
+
+/*
+ * recv_results - Receives a worker's answer to its oldest batch and returns -1 if the worker is gone or answered garbage
+ */
+static int recv_results(farm *f, int w)
+{
+    farm_worker *worker = &f->workers[w];
+    size_t len, off = 0;
+    int ct, idx, b;
+    unsigned long long seed;
+    double fitness;
+
+    if (recv_msg(worker->fd, &f->buf, &f->buf_size, &len) != FARM_RESULT) { return -1; }
+    if (worker->inflight == 0) { return -1; }
+    b = worker->batch[0];
+    if (len < 4) { return -1; }
+    ct = get_i32(f->buf, &off);
+    if ((ct < 0) || (ct > f->params->farm_batch) || (len != 4 + (size_t) ct * RESULT_SIZE)) { return -1; }
+
+    // results have to match the batch's snakes and seeds (an index is checked before it indexes anything)
+    for (int i = 0; i < ct; i++) {
+        idx = get_i32(f->buf, &off);
+        get_bytes(f->buf, &off, &seed, sizeof(seed));
+        get_bytes(f->buf, &off, &fitness, sizeof(fitness));
+        if ((idx < 0) || (idx >= f->params->pop_size) || (idx / f->params->farm_batch != b) || (seed != f->seed[idx])) { return -1; }
+        f->ann_s->fitness[idx] = fitness;
+        f->moves[idx] = get_i32(f->buf, &off);
+        f->apples[idx] = get_i32(f->buf, &off);
+        add_game_stats(&f->stats, idx, fitness, f->moves[idx], f->apples[idx], DEATH_NONE);
+    }
+
+    f->bytes_recv += MSG_HEADER_SIZE + len;
+    f->batch_state[b] = BATCH_DONE;
+    worker->games += ct;
+    worker->inflight--;
+    for (int i = 0; i < worker->inflight; i++) { worker->batch[i] = worker->batch[i + 1]; }
+    worker->progress_t = get_time();
+    return 0;
+}
+
+
+/*
+ * run_local_batch - Plays a batch on the coordinator when no worker is connected
+ */
+static void run_local_batch(farm *f, int b)
+{
+    int start = b * f->params->farm_batch;
+    int end = (start + f->params->farm_batch < f->params->pop_size)? start + f->params->farm_batch: f->params->pop_size;
+    unsigned long long state = get_rand_state();
+
+    for (int i = start; i < end; i++) {
+        play_game(&f->ann_s->data[i], f->eval_s, f->seed[i]);
+        f->moves[i] = f->eval_s->data[0].m;
+        f->apples[i] = f->eval_s->data[0].n;
+        f->ann_s->fitness[i] = game_fitness(f->moves[i], f->apples[i]);
+        add_game_stats(&f->stats, i, f->ann_s->fitness[i], f->moves[i], f->apples[i], DEATH_NONE);
+    }
+
+    // game seeds must not disturb the coordinator's own random stream
+    set_rand_state(state);
+    f->batch_state[b] = BATCH_DONE;
+    f->local_games += end - start;
+    return;
+}
+
+
+/*
+ * next_pending - Returns the next batch that is not in flight or done, or NOT_FOUND
+ */
+static int next_pending(farm *f)
+{
+    for (int b = 0; b < f->num_batches; b++) { if (f->batch_state[b] == BATCH_PENDING) { return b; } }
+    return NOT_FOUND;
+}
+
+
+/*
+ * farm_generation - Plays every snake of a generation on the workers, tolerating lost workers and taking in new ones
+ */
+static void farm_generation(farm *f)
+{
+    struct pollfd *fds = (struct pollfd *) malloc((f->max_workers + 1) * sizeof(struct pollfd));
+    int max_fds = f->max_workers + 1;
+    int done = 0;
+    int b, w, num_fds;
+    double now;
+
+    for (b = 0; b < f->num_batches; b++) { f->batch_state[b] = BATCH_PENDING; }
+    reset_gen_stats(&f->stats);
+    for (int i = 0; i < f->params->pop_size; i++) { f->seed[i] = rand_u64(); }
+
+    while (done < f->num_batches) {
+        // keep every worker's pipeline full
+        for (w = 0; w < f->num_workers; w++) {
+            while ((f->workers[w].inflight < FARM_INFLIGHT) && ((b = next_pending(f)) != NOT_FOUND)) {
+                if (send_batch(f, w, b) != 0) { drop_worker(f, w--, "send failed"); break; }
+            }
+        }
+
+        // with every worker gone the coordinator plays the pending batches itself
+        if ((f->num_workers == 0) && ((b = next_pending(f)) != NOT_FOUND)) { run_local_batch(f, b); }
+
+        // wait for answers and new workers
+        if (max_fds < f->max_workers + 1) {
+            max_fds = f->max_workers + 1;
+            fds = (struct pollfd *) realloc(fds, max_fds * sizeof(struct pollfd));
+        }
+        fds[0].fd = f->listen_fd;
+        fds[0].events = POLLIN;
+        for (w = 0; w < f->num_workers; w++) { fds[w + 1].fd = f->workers[w].fd; fds[w + 1].events = POLLIN; }
+        num_fds = f->num_workers + 1;
+        if (poll(fds, num_fds, (f->num_workers == 0)? 0: 1000) < 0) { continue; }
+
+        // answers (backwards so dropping a worker does not skip one)
+        for (w = num_fds - 2; w >= 0; w--) {
+            if (fds[w + 1].revents == 0) continue;
+            if (recv_results(f, w) != 0) { drop_worker(f, w, "connection lost"); }
+        }
+
+        // workers that stopped answering
+        now = get_time();
+        for (w = f->num_workers - 1; w >= 0; w--) {
+            if ((f->workers[w].inflight > 0) && (now - f->workers[w].progress_t > f->params->farm_timeout)) { drop_worker(f, w, "timed out"); }
+        }
+        if (fds[0].revents & POLLIN) { add_worker(f); }
+
+        // local batches count as done too
+        done = 0;
+        for (b = 0; b < f->num_batches; b++) { done += (f->batch_state[b] == BATCH_DONE); }
+    }
+    free(fds);
+    return;
+}
+
+
+/*
+ * farm_highscore - Prints a new highscore and replays it on the coordinator from its genome and seed for the replay viewer
+ */
+static void farm_highscore(farm *f, int gen_n)
+{
+    int best = f->stats.best_idx;
+    unsigned long long state;
+
+    if (f->apples[best] <= f->highscore) { return; }
+    f->highscore = f->apples[best];
+    printf("\033[0;32m--  [GEN %d] New Highscore:  %d  --\033[0m\n", gen_n + 1, f->highscore);
+
+    if ((f->viewer != NULL) && (f->highscore >= f->params->print_replay)) {
+        state = get_rand_state();
+        play_game(&f->ann_s->data[best], f->eval_s, f->seed[best]);
+        set_rand_state(state);
+        submit_replay(f->viewer, gen_n, NOT_FOUND, &f->ann_s->data[best], &f->eval_s->data[0]);
+    }
+    return;
+}
+
+
+/*
+ * farm_genetic_snake - Runs the generational model as a coordinator that farms every game out to worker processes
+ */
+void farm_genetic_snake(gs_params *params, replay_viewer *viewer)
+{
+    int ct = params->pop_size;
+    int ct_surv = ct * params->survive;
+    int ct_die = ct - ct_surv;
+    int *surv_idx = (int *) malloc(ct * sizeof(int));
+    double *fitness_prob = (double *) malloc(ct * sizeof(double));
+    ann *parent_a, *parent_b;
+    farm f;
+
+    // setup the coordinator's population and listening socket
+    memset(&f, 0, sizeof(f));
+    f.params = params;
+    f.viewer = viewer;
+    f.ann_s = (ann_set *) malloc(sizeof(ann_set));
+    f.eval_s = (env_set *) malloc(sizeof(env_set));
+    init_ann_set(f.ann_s, ct, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
+    init_env_set(f.eval_s, 1, params->env_width);
+    f.num_batches = (ct + params->farm_batch - 1) / params->farm_batch;
+    f.batch_state = (int *) malloc(f.num_batches * sizeof(int));
+    f.seed = (unsigned long long *) malloc(ct * sizeof(unsigned long long));
+    f.moves = (int *) malloc(ct * sizeof(int));
+    f.apples = (int *) malloc(ct * sizeof(int));
+    if (reserve_buf(&f.buf, &f.buf_size, MAX_LINE_SIZE) != 0) {
+        printf("\n\nERR: could not allocate the farm message buffer\n");
+        exit(127);
+    }
+    if ((f.listen_fd = open_socket(params->farm_addr, 1)) < 0) {
+        perror(params->farm_addr);
+        exit(127);
+    }
+
+    // wait for the requested workers (more can join at any time)
+    while (f.num_workers < params->farm_workers) {
+        printf("waiting for farm workers on %s (%d/%d)\n", params->farm_addr, f.num_workers, params->farm_workers);
+        add_worker(&f);
+    }
+
+    for (int gen_i = 0; gen_i < params->gen_ct; gen_i++) {
+        // play every game on the workers
+        farm_generation(&f);
+
+        // prints gen stats and any highscoring replay
+        print_farm_stats(gen_i, &f);
+        if ((gen_i + 1) % PRINT_BATCH == 0) { print_mem_stats(mem_bound()); }
+        farm_highscore(&f, gen_i);
+        if ((gen_i + 1) == params->gen_ct) break;
+
+        // select the parents and spawn two children over every pair of culled snakes
+        determine_most_fit_parents(ct, params->survive, surv_idx, fitness_prob, f.ann_s);
+        for (int i = 0; i < ct_die; i += 2) {
+            parent_a = &f.ann_s->data[surv_idx[(ct - 1) - rand_roulette(ct_surv, fitness_prob)]];
+            parent_b = &f.ann_s->data[surv_idx[(ct - 1) - rand_roulette(ct_surv, fitness_prob)]];
+            spawn_ann(params->mutate, parent_a, parent_b, &f.ann_s->data[surv_idx[i]]);
+            if (i + 1 < ct_die) { spawn_ann(params->mutate, parent_a, parent_b, &f.ann_s->data[surv_idx[i + 1]]); }
+        }
+        f.ann_s->gen += 1;
+    }
+
+    // release the workers
+    print_farm_summary(&f);
+    for (int w = 0; w < f.num_workers; w++) {
+        send_msg(f.workers[w].fd, FARM_BYE, f.buf, 0);
+        close(f.workers[w].fd);
+    }
+    close(f.listen_fd);
+    if (strncmp(params->farm_addr, "unix:", 5) == 0) { unlink(params->farm_addr + 5); }
+
+    // final cleanup
+    free_ann_set(f.ann_s);
+    free_env_set(f.eval_s);
+    free(f.workers);
+    free(f.batch_state);
+    free(f.seed);
+    free(f.moves);
+    free(f.apples);
+    free(f.buf);
+    free(surv_idx);
+    free(fitness_prob);
+    return;
+}
+
+
+/*
+ * check_hello - Checks a coordinator's hello (its length, board width, quantization and shape) and returns 0 if a worker can play its snakes
+ */
+static int check_hello(const unsigned char *buf, size_t len, int *env_width, int *quantize, int *num_layers, int *shape)
+{
+    size_t off = 0;
+
+    if (len < 12) { return -1; }
+    *env_width = get_i32(buf, &off);
+    *quantize = get_i32(buf, &off);
+    *num_layers = get_i32(buf, &off);
+    if ((*num_layers < 1) || (*num_layers > MAX_NUM_LAYERS) || (len != 12 + 2 * (size_t) *num_layers * 4)) { return -1; }
+    if ((*env_width < FARM_MIN_WIDTH) || (*env_width > FARM_MAX_WIDTH) || ((*quantize != 0) && (*quantize != 8) && (*quantize != 16))) { return -1; }
+
+    // 24 inputs, 4 outputs and layers that feed each other
+    for (int k = 0; k < 2 * *num_layers; k++) {
+        shape[k] = get_i32(buf, &off);
+        if ((shape[k] < 1) || (shape[k] > FARM_MAX_NEURONS)) { return -1; }
+    }
+    for (int l = 1; l < *num_layers; l++) {
+        if (shape[RIDX(l, 0, 2)] != shape[RIDX((l - 1), 1, 2)]) { return -1; }
+    }
+    if ((shape[0] != 24) || (shape[2 * *num_layers - 1] != 4)) { return -1; }
+    return 0;
+}
+
+
+/*
+ * farm_worker_main - Connects to a coordinator and plays every batch of snakes it sends until it says goodbye
+ */
+void farm_worker_main(const char *addr)
+{
+    unsigned char *buf = NULL;
+    size_t size = 0, len, off, out;
+    int fd, type, ct, idx, quantize, num_layers, env_width;
+    int malformed = 0;
+    size_t rec_size;
+    int shape[2 * MAX_NUM_LAYERS];
+    funct activation[MAX_NUM_LAYERS];
+    unsigned long long seed;
+    long games = 0;
+    double fitness;
+    ann_set *ann_s = (ann_set *) malloc(sizeof(ann_set));
+    env_set *eval_s = (env_set *) malloc(sizeof(env_set));
+    unsigned char *res = NULL;
+    size_t res_size = 0;
+
+    // the coordinator may still be starting up
+    for (int tries = 0; (fd = open_socket(addr, 0)) < 0; tries++) {
+        if (tries == 50) { perror(addr); exit(127); }
+        usleep(100000);
+    }
+
+    // hello: env width, quantization, layers and shape
+    if (recv_msg(fd, &buf, &size, &len) != FARM_HELLO) { printf("\n\nERR: farm coordinator did not say hello\n"); exit(127); }
+    if (check_hello(buf, len, &env_width, &quantize, &num_layers, shape) != 0) { printf("\n\nERR: farm coordinator sent a malformed hello\n"); exit(127); }
+    for (int l = 0; l < num_layers; l++) { activation[l] = sigmoid; }
+    init_ann_set(ann_s, 1, num_layers, shape, activation);
+    init_env_set(eval_s, 1, env_width);
+    rec_size = 12 + genome_size(ann_s->data[0].num_w + ann_s->data[0].num_n, quantize);
+    printf("farm worker connected to %s\n", addr);
+
+    while ((type = recv_msg(fd, &buf, &size, &len)) == FARM_GAMES) {
+        // a batch is its count and exactly that many index, seed and genome records
+        off = 0;
+        ct = (len >= 4)? get_i32(buf, &off): NOT_FOUND;
+        if ((ct < 0) || (len != 4 + (size_t) ct * rec_size)) {
+            malformed = 1;
+            break;
+        }
+        if (reserve_buf(&res, &res_size, MSG_HEADER_SIZE + 4 + ct * RESULT_SIZE) != 0) {
+            printf("\nWARN: could not allocate the results of a %d snake batch\n", ct);
+            break;
+        }
+        out = MSG_HEADER_SIZE;
+        put_i32(res, &out, ct);
+
+        // play every snake of the batch with its seed
+        for (int i = 0; i < ct; i++) {
+            idx = get_i32(buf, &off);
+            get_bytes(buf, &off, &seed, sizeof(seed));
+            decode_genome(buf, &off, &ann_s->data[0], quantize);
+            play_game(&ann_s->data[0], eval_s, seed);
+            fitness = game_fitness(eval_s->data[0].m, eval_s->data[0].n);
+
+            put_i32(res, &out, idx);
+            put_bytes(res, &out, &seed, sizeof(seed));
+            put_bytes(res, &out, &fitness, sizeof(fitness));
+            put_i32(res, &out, eval_s->data[0].m);
+            put_i32(res, &out, eval_s->data[0].n);
+        }
+        if (send_msg(fd, FARM_RESULT, res, out - MSG_HEADER_SIZE) < 0) break;
+        games += ct;
+    }
+    if (malformed) { printf("\nWARN: farm coordinator sent a malformed batch\n"); }
+    else if (type != FARM_BYE) { printf("\nWARN: lost the farm coordinator\n"); }
+    printf("farm worker played %ld games\n", games);
+
+    // final cleanup
+    close(fd);
+    free_ann_set(ann_s);
+    free_env_set(eval_s);
+    free(buf);
+    free(res);
+    return;
+}
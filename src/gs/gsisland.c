@@ -0,0 +1,203 @@
+//
+//  gsisland.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gsdefs.h"
+
+
+/*
+ * init_mailbox - Initializes an island inbox with preallocated genome buffers for a given capacity (rounded up to a power of two)
+ */
+static void init_mailbox(mailbox *box, int capacity, int genome_len)
+{
+    int cap = 2;
+    while (cap < capacity) { cap <<= 1; }
+
+    box->capacity = cap;
+    box->cells = (mailbox_cell *) malloc(cap * sizeof(mailbox_cell));
+    for (int i = 0; i < cap; i++) {
+        atomic_init(&box->cells[i].seq, i);
+        box->cells[i].genome = (double *) malloc(genome_len * sizeof(double));
+    }
+    box->genome_len = genome_len;
+    mem_add(MEM_BUFFERS, mem_chunk(cap * sizeof(mailbox_cell)) + cap * mem_chunk(genome_len * sizeof(double)));
+    atomic_init(&box->head, 0);
+    box->tail = 0;
+    return;
+}
+
+
+/*
+ * free_mailbox - Frees the cells of an island inbox
+ */
+static void free_mailbox(mailbox *box)
+{
+    for (int i = 0; i < box->capacity; i++) { free(box->cells[i].genome); }
+    free(box->cells);
+    mem_add(MEM_BUFFERS, -(mem_chunk(box->capacity * sizeof(mailbox_cell)) + box->capacity * mem_chunk(box->genome_len * sizeof(double))));
+    return;
+}
+
+
+/*
+ * mailbox_send - Copies a migrant into an island inbox without locking and returns 0 if the inbox is full (the migrant is dropped)
+ */
+static int mailbox_send(mailbox *box, ann *net, double fitness, int moves)
+{
+    long pos = atomic_load_explicit(&box->head, memory_order_relaxed);
+    mailbox_cell *cell;
+    long diff;
+
+    // reserve a cell (any island may send to this inbox)
+    while (1) {
+        cell = &box->cells[pos & (box->capacity - 1)];
+        diff = atomic_load_explicit(&cell->seq, memory_order_acquire) - pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&box->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&box->head, memory_order_relaxed);
+        }
+    }
+
+    // copy the migrant and publish the cell to the owner island
+    memcpy(cell->genome, net->w, net->num_w * sizeof(double));
+    memcpy(cell->genome + net->num_w, net->b, net->num_n * sizeof(double));
+    cell->fitness = fitness;
+    cell->moves = moves;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 1;
+}
+
+
+/*
+ * mailbox_receive - Copies the oldest migrant of an island inbox into an ann and returns 0 if the inbox is empty (owner island only)
+ */
+static int mailbox_receive(mailbox *box, ann *net, int *moves)
+{
+    mailbox_cell *cell = &box->cells[box->tail & (box->capacity - 1)];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != box->tail + 1) { return 0; }
+
+    // copy the migrant out and hand the cell back to the senders
+    memcpy(net->w, cell->genome, net->num_w * sizeof(double));
+    memcpy(net->b, cell->genome + net->num_w, net->num_n * sizeof(double));
+    *moves = cell->moves;
+    atomic_store_explicit(&cell->seq, box->tail + box->capacity, memory_order_release);
+    box->tail++;
+    return 1;
+}
+
+
+/*
+ * init_island_set - Splits the model's population and threads into islands with their own thread data and inbox
+ */
+void init_island_set(island_set *isl, gs_params *params)
+{
+    int num_islands = params->num_islands;
+    int genome_len = 0;
+
+    // every island runs the generational model on its share of the population and threads
+    isl->num_islands = num_islands;
+    isl->params = *params;
+    isl->params.pop_size = params->pop_size / num_islands;
+    isl->params.num_threads = params->num_threads / num_islands;
+    isl->islands = (thread_data *) malloc(num_islands * sizeof(thread_data));
+    isl->boxes = (mailbox *) malloc(num_islands * sizeof(mailbox));
+    atomic_init(&isl->sent, 0);
+    atomic_init(&isl->received, 0);
+    atomic_init(&isl->dropped, 0);
+
+    // genome length is the number of weights and biases of the ann shape
+    for (int l = 0; l < params->num_layers; l++) {
+        genome_len += params->shape[RIDX(l, 0, 2)] * params->shape[RIDX(l, 1, 2)] + params->shape[RIDX(l, 1, 2)];
+    }
+
+    for (int i = 0; i < num_islands; i++) {
+        init_thread_data_struct(&isl->islands[i], &isl->params);
+        isl->islands[i].isl = isl;
+        isl->islands[i].island = i;
+        isl->islands[i].cpu_base = i * isl->params.num_threads;
+
+        // an inbox holds a few migrations worth of migrants so a slow island only drops when it falls far behind
+        init_mailbox(&isl->boxes[i], 4 * (params->migrate_k + 1), genome_len);
+    }
+    return;
+}
+
+
+/*
+ * free_island_set - Frees every island's thread data and inbox
+ */
+void free_island_set(island_set *isl)
+{
+    for (int i = 0; i < isl->num_islands; i++) {
+        free_thread_data_struct(&isl->islands[i]);
+        free_mailbox(&isl->boxes[i]);
+    }
+    free(isl->islands);
+    free(isl->boxes);
+    return;
+}
+
+
+/*
+ * emigrate - Sends copies of an island's most fit snakes to its neighbour every migration interval (serial step after parent selection)
+ */
+void emigrate(thread_data *t_data)
+{
+    island_set *isl = t_data->isl;
+    gs_params *params = t_data->params;
+    int ct = params->pop_size;
+    int dst, idx;
+
+    if ((isl == NULL) || (isl->num_islands < 2) || ((t_data->ann_s->gen + 1) % params->migrate_every != 0)) { return; }
+
+    // ring sends to the next island, random to any other island
+    if (params->topology == TOPOLOGY_RING) {
+        dst = (t_data->island + 1) % isl->num_islands;
+    } else {
+        dst = rand_int(0, isl->num_islands - 1);
+        if (dst >= t_data->island) { dst++; }
+    }
+
+    // surv_idx and fitness are sorted least fit first, so the migrants are the last k
+    for (int k = 0; k < params->migrate_k; k++) {
+        idx = t_data->surv_idx[(ct - 1) - k];
+        if (mailbox_send(&isl->boxes[dst], &t_data->ann_s->data[idx], t_data->ann_s->fitness[(ct - 1) - k], t_data->env_s->data[idx].m)) {
+            atomic_fetch_add_explicit(&isl->sent, 1, memory_order_relaxed);
+        } else {
+            atomic_fetch_add_explicit(&isl->dropped, 1, memory_order_relaxed);
+        }
+    }
+    return;
+}
+
+
+/*
+ * immigrate - Overwrites freshly spawned children of an island with the migrants waiting in its inbox (serial step after spawning, so the children have not played yet)
+ */
+void immigrate(thread_data *t_data)
+{
+    island_set *isl = t_data->isl;
+    int ct = t_data->params->pop_size;
+    int ct_die = ct - (int) (ct * t_data->params->survive);
+    int idx, moves, k;
+
+    if (isl == NULL) { return; }
+
+    // culled slots hold the children just spawned into them (none has played a game), so migrants replace unevaluated children rather than survivors
+    for (k = 0; k < ct_die; k++) {
+        idx = t_data->surv_idx[k];
+        if (!mailbox_receive(&isl->boxes[t_data->island], &t_data->ann_s->data[idx], &moves)) break;
+        t_data->pred_moves[idx] = moves;
+    }
+    if (k > 0) { atomic_fetch_add_explicit(&isl->received, k, memory_order_relaxed); }
+    return;
+}
@@ -0,0 +1,571 @@
+//
+//  gslineage.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "gsdefs.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define LINEAGE_MUT_BYTES (sizeof(uint32_t) + sizeof(double))
+
+
+/*
+ * gene - Returns a gene of an ann (weights first, then biases)
+ */
+static inline double * gene(ann *a, int g)
+{
+    return (g < a->num_w)? &a->w[g]: &a->b[g - a->num_w];
+}
+
+
+/*
+ * wait_seq - Parks a side of the lineage log until the push and write counter is no longer the given value
+ */
+static void wait_seq(lineage *lin, int old_seq)
+{
+#ifdef __linux__
+    syscall(SYS_futex, &lin->seq, FUTEX_WAIT_PRIVATE, old_seq, NULL, NULL, 0);
+#else
+    if (atomic_load(&lin->seq) == old_seq) { usleep(1000); }
+#endif
+    return;
+}
+
+
+/*
+ * wake_seq - Bumps the push and write counter and wakes the side parked on it (the writer waits on an empty ring, the serial step on a full one, never both)
+ */
+static void wake_seq(lineage *lin)
+{
+    atomic_fetch_add(&lin->seq, 1);
+#ifdef __linux__
+    syscall(SYS_futex, &lin->seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+    return;
+}
+
+
+/*
+ * lineage_writer_thread - Background thread that writes and flushes pushed records (a killed run keeps every written generation) until the log is stopped and drained
+ */
+static void * lineage_writer_thread(void *void_lin)
+{
+    lineage *lin = (lineage *) void_lin;
+    lineage_block *blk;
+    long tail;
+    int seq, stop;
+
+    while (1) {
+        // stop is read first, so an empty ring after it has seen every push
+        seq = atomic_load(&lin->seq);
+        stop = atomic_load(&lin->stop);
+        tail = atomic_load_explicit(&lin->tail, memory_order_relaxed);
+        if (tail < atomic_load_explicit(&lin->head, memory_order_acquire)) {
+            blk = &lin->ring[tail % LINEAGE_RING];
+            if ((fwrite(blk->data, 1, blk->len, lin->file) != blk->len) || (fflush(lin->file) != 0)) { perror(lin->file_name); }
+
+            // hand the written slot back to the serial step
+            atomic_store_explicit(&lin->tail, tail + 1, memory_order_release);
+            wake_seq(lin);
+            continue;
+        }
+        if (stop) break;
+        if (atomic_load(&lin->seq) == seq) { wait_seq(lin, seq); }
+    }
+    return NULL;
+}
+
+
+/*
+ * trim_lineage - Checks the log a resumed run appends to against the run's header and cuts it after the last record before the resumed generation, returns GS_OK or the reason it could not in err
+ */
+static int trim_lineage(lineage *lin, const lineage_header *hdr, int gen, int quiet, char *err, size_t size)
+{
+    lineage_header old;
+    lineage_record rec;
+    long file_size, end = sizeof(lineage_header);
+
+    if ((fread(&old, sizeof(lineage_header), 1, lin->file) != 1) || (old.magic != LINEAGE_MAGIC) || (old.version != LINEAGE_VERSION)) {
+        snprintf(err, size, "%s is not a version %d lineage log to resume (move it away to start a new one)", lin->file_name, (int) LINEAGE_VERSION);
+        return GS_ERR_PARAMS;
+    } else if ((old.pop_size != hdr->pop_size) || (old.num_layers != hdr->num_layers) || (memcmp(old.shape, hdr->shape, sizeof(old.shape)) != 0)) {
+        snprintf(err, size, "the POP_WIDTH or LAYER shape of lineage log %s does not match the resumed run", lin->file_name);
+        return GS_ERR_PARAMS;
+    }
+
+    // keep every whole record before the resumed generation (records after the checkpoint or cut short by a kill go)
+    fseek(lin->file, 0, SEEK_END);
+    file_size = ftell(lin->file);
+    fseek(lin->file, end, SEEK_SET);
+    while ((fread(&rec, sizeof(lineage_record), 1, lin->file) == 1) && (rec.gen < gen) && (end + (long) sizeof(lineage_record) + (long) rec.size <= file_size)) {
+        end += sizeof(lineage_record) + rec.size;
+        fseek(lin->file, end, SEEK_SET);
+    }
+    fflush(lin->file);
+    if (ftruncate(fileno(lin->file), end) != 0) {
+        snprintf(err, size, "%s: %s", lin->file_name, strerror(errno));
+        return GS_ERR_IO;
+    }
+    fseek(lin->file, end, SEEK_SET);
+    if (!quiet) { printf("--  appending to lineage log %s at GEN %d  --\n", lin->file_name, gen + 1); }
+    return GS_OK;
+}
+
+
+/*
+ * free_lineage - Frees a lineage log's buffers and ring and the log itself (its writer thread has stopped or never started)
+ */
+static void free_lineage(lineage *lin)
+{
+    for (int t = 0; t < lin->num_bufs; t++) {
+        mem_add(MEM_BUFFERS, -mem_chunk(lin->bufs[t].cap));
+        free(lin->bufs[t].data);
+    }
+    for (int r = 0; r < LINEAGE_RING; r++) {
+        mem_add(MEM_BUFFERS, -mem_chunk(lin->ring[r].cap));
+        free(lin->ring[r].data);
+    }
+    mem_add(MEM_BUFFERS, -(mem_chunk(lin->num_bufs * sizeof(lineage_buf)) + mem_chunk(LINEAGE_RING * sizeof(lineage_block))));
+    free(lin->bufs);
+    free(lin->ring);
+    free(lin);
+    return;
+}
+
+
+/*
+ * create_lineage - Opens the lineage log of a generational run as t_data->lin (appending to it when the run resumes, NULL if the run keeps no lineage) and starts its writer thread, returns GS_OK or the reason it could not in err
+ */
+int create_lineage(thread_data *t_data, char *err, size_t size)
+{
+    gs_params *params = t_data->params;
+    lineage_header hdr;
+    lineage *lin;
+    int num_w = 0, num_n = 0, code;
+
+    t_data->lin = NULL;
+    if (params->lineage_every == 0) { return GS_OK; }
+    if (posix_memalign((void **) &lin, CACHE_LINE, sizeof(lineage)) != 0) {
+        snprintf(err, size, "could not allocate lineage log");
+        return GS_ERR_NOMEM;
+    }
+    memset(lin, 0, sizeof(lineage));
+    strcpy(lin->file_name, params->lineage_file);
+
+    // gene counts from the shape (the shards are not initialized yet)
+    for (int l = 0; l < params->num_layers; l++) {
+        num_w += params->shape[RIDX(l, 0, 2)] * params->shape[RIDX(l, 1, 2)];
+        num_n += params->shape[RIDX(l, 1, 2)];
+    }
+    lin->keyframe_every = params->lineage_every;
+    lin->num_genes = num_w + num_n;
+    lin->mask_bytes = (lin->num_genes + 7) / 8;
+    if (posix_memalign((void **) &lin->bufs, CACHE_LINE, params->num_threads * sizeof(lineage_buf)) != 0) { lin->bufs = NULL; }
+    lin->ring = (lineage_block *) calloc(LINEAGE_RING, sizeof(lineage_block));
+    if ((lin->bufs == NULL) || (lin->ring == NULL)) {
+        free(lin->bufs);
+        free(lin->ring);
+        free(lin);
+        snprintf(err, size, "could not allocate lineage buffers");
+        return GS_ERR_NOMEM;
+    }
+    lin->num_bufs = params->num_threads;
+    memset(lin->bufs, 0, lin->num_bufs * sizeof(lineage_buf));
+    mem_add(MEM_BUFFERS, mem_chunk(lin->num_bufs * sizeof(lineage_buf)) + mem_chunk(LINEAGE_RING * sizeof(lineage_block)));
+
+    memset(&hdr, 0, sizeof(lineage_header));
+    hdr.magic = LINEAGE_MAGIC;
+    hdr.version = LINEAGE_VERSION;
+    hdr.pop_size = params->pop_size;
+    hdr.num_layers = params->num_layers;
+    for (int l = 0; l < 2 * params->num_layers; l++) { hdr.shape[l] = params->shape[l]; }
+    hdr.num_w = num_w;
+    hdr.num_n = num_n;
+    hdr.keyframe_every = lin->keyframe_every;
+    hdr.mask_bytes = lin->mask_bytes;
+    hdr.params_seed = params->seed;
+
+    // a resumed run continues its log (its first record is a keyframe of the resumed generation), any other run starts a new one
+    if (params->resume == CKPT_RESUME) { lin->file = fopen(lin->file_name, "r+b"); }
+    if (lin->file != NULL) {
+        code = trim_lineage(lin, &hdr, t_data->ann_s->gen, params->quiet, err, size);
+        if (code != GS_OK) {
+            fclose(lin->file);
+            free_lineage(lin);
+            return code;
+        }
+    } else {
+        lin->file = fopen(lin->file_name, "wb");
+        if ((lin->file == NULL) || (fwrite(&hdr, sizeof(lineage_header), 1, lin->file) != 1)) {
+            snprintf(err, size, "%s: %s", lin->file_name, strerror(errno));
+            if (lin->file != NULL) { fclose(lin->file); }
+            free_lineage(lin);
+            return GS_ERR_IO;
+        }
+    }
+
+    atomic_init(&lin->head, 0);
+    atomic_init(&lin->tail, 0);
+    atomic_init(&lin->seq, 0);
+    atomic_init(&lin->stop, 0);
+    if (pthread_create(&lin->thread, NULL, lineage_writer_thread, lin) != 0) {
+        snprintf(err, size, "pthread_create error for lineage writer thread");
+        fclose(lin->file);
+        free_lineage(lin);
+        return GS_ERR_THREAD;
+    }
+    t_data->lin = lin;
+    return GS_OK;
+}
+
+
+/*
+ * init_lineage - Opens the lineage log of a command line run, stopping it if the log cannot be used, returns NULL if the run keeps no lineage
+ */
+lineage * init_lineage(thread_data *t_data)
+{
+    char err[2 * MAX_LINE_SIZE];
+
+    if (create_lineage(t_data, err, sizeof(err)) != GS_OK) {
+        printf("\n\nERR: %s\n\n\n", err);
+        exit(127);
+    }
+    return t_data->lin;
+}
+
+
+/*
+ * log_child - Encodes a spawned child on its spawning thread as its parents, a crossover mask and its mutated genes (a gene equal to parent a is taken from a, then one equal to parent b from b, so the encoding is lossless)
+ */
+void log_child(thread_data *t_data, int tid, int child, int idx_a, int idx_b)
+{
+    lineage *lin = t_data->lin;
+    lineage_buf *buf;
+    lineage_child rec;
+    ann *c, *a, *b;
+    unsigned char *mask, *mut;
+    size_t worst, cap;
+    uint32_t g32;
+
+    if (lin == NULL) { return; }
+    buf = &lin->bufs[tid];
+    c = &t_data->ann_s->data[child];
+    a = &t_data->ann_s->data[idx_a];
+    b = &t_data->ann_s->data[idx_b];
+
+    // make room for a child whose every gene mutated
+    worst = sizeof(lineage_child) + lin->mask_bytes + lin->num_genes * LINEAGE_MUT_BYTES;
+    if (buf->len + worst > buf->cap) {
+        cap = (buf->cap)? 2 * buf->cap: 64 * worst;
+        while (buf->len + worst > cap) { cap *= 2; }
+        buf->data = (unsigned char *) realloc(buf->data, cap);
+        mem_add(MEM_BUFFERS, mem_chunk(cap) - mem_chunk(buf->cap));
+        buf->cap = cap;
+    }
+
+    mask = buf->data + buf->len + sizeof(lineage_child);
+    mut = mask + lin->mask_bytes;
+    memset(mask, 0, lin->mask_bytes);
+    rec.child = child;
+    rec.parent_a = idx_a;
+    rec.parent_b = idx_b;
+    rec.num_mut = 0;
+    for (int g = 0; g < lin->num_genes; g++) {
+        if (*gene(c, g) == *gene(a, g)) continue;
+        if (*gene(c, g) == *gene(b, g)) {
+            mask[g >> 3] |= (unsigned char) (1 << (g & 7));
+            continue;
+        }
+        g32 = g;
+        memcpy(mut, &g32, sizeof(uint32_t));
+        memcpy(mut + sizeof(uint32_t), gene(c, g), sizeof(double));
+        mut += LINEAGE_MUT_BYTES;
+        rec.num_mut++;
+    }
+    memcpy(buf->data + buf->len, &rec, sizeof(lineage_child));
+    buf->len = mut - buf->data;
+    buf->ct++;
+    return;
+}
+
+
+/*
+ * next_block - Waits for the writer thread to free a ring slot (the log is lossless, so a record is never dropped) and sizes it for a record of a given payload
+ */
+static lineage_block * next_block(lineage *lin, lineage_record *rec)
+{
+    long head = atomic_load_explicit(&lin->head, memory_order_relaxed);
+    lineage_block *blk = &lin->ring[head % LINEAGE_RING];
+    size_t len = sizeof(lineage_record) + rec->size;
+    int seq;
+
+    while (1) {
+        seq = atomic_load(&lin->seq);
+        if (head - atomic_load_explicit(&lin->tail, memory_order_acquire) < LINEAGE_RING) break;
+        wait_seq(lin, seq);
+    }
+    if (len > blk->cap) {
+        blk->data = (unsigned char *) realloc(blk->data, len);
+        mem_add(MEM_BUFFERS, mem_chunk(len) - mem_chunk(blk->cap));
+        blk->cap = len;
+    }
+    memcpy(blk->data, rec, sizeof(lineage_record));
+    blk->len = len;
+    return blk;
+}
+
+
+/*
+ * push_block - Hands the filled ring slot to the writer thread
+ */
+static void push_block(lineage *lin)
+{
+    long head = atomic_load_explicit(&lin->head, memory_order_relaxed);
+    atomic_store_explicit(&lin->head, head + 1, memory_order_release);
+    wake_seq(lin);
+    return;
+}
+
+
+/*
+ * push_keyframe - Copies every snake's genes into a keyframe record for the writer thread
+ */
+static void push_keyframe(lineage *lin, ann_set *ann_s)
+{
+    lineage_record rec;
+    unsigned char *curr;
+
+    rec.type = LINEAGE_KEY;
+    rec.gen = ann_s->gen;
+    rec.size = (uint64_t) ann_s->num_net * lin->num_genes * sizeof(double);
+    curr = next_block(lin, &rec)->data + sizeof(lineage_record);
+    for (int i = 0; i < ann_s->num_net; i++) {
+        memcpy(curr, ann_s->data[i].w, ann_s->data[i].num_w * sizeof(double));
+        curr += ann_s->data[i].num_w * sizeof(double);
+        memcpy(curr, ann_s->data[i].b, ann_s->data[i].num_n * sizeof(double));
+        curr += ann_s->data[i].num_n * sizeof(double);
+    }
+    push_block(lin);
+    lin->keyframes++;
+    lin->key_bytes += sizeof(lineage_record) + rec.size;
+    return;
+}
+
+
+/*
+ * push_delta - Copies the children every thread encoded in the last spawn phase into a delta record for the writer thread
+ */
+static void push_delta(lineage *lin, int gen)
+{
+    lineage_record rec;
+    unsigned char *curr;
+    int32_t ct = 0;
+
+    rec.type = LINEAGE_DELTA;
+    rec.gen = gen;
+    rec.size = sizeof(int32_t);
+    for (int t = 0; t < lin->num_bufs; t++) {
+        ct += lin->bufs[t].ct;
+        rec.size += lin->bufs[t].len;
+    }
+    curr = next_block(lin, &rec)->data + sizeof(lineage_record);
+    memcpy(curr, &ct, sizeof(int32_t));
+    curr += sizeof(int32_t);
+    for (int t = 0; t < lin->num_bufs; t++) {
+        memcpy(curr, lin->bufs[t].data, lin->bufs[t].len);
+        curr += lin->bufs[t].len;
+    }
+    push_block(lin);
+    lin->deltas++;
+    lin->delta_bytes += sizeof(lineage_record) + rec.size;
+    return;
+}
+
+
+/*
+ * log_lineage - Serial step hook once a generation's population is ready: pushes a keyframe every LINEAGE generations (and first) or the generation's delta to the writer thread
+ */
+void log_lineage(thread_data *t_data)
+{
+    lineage *lin = t_data->lin;
+    if (lin == NULL) { return; }
+
+    if ((!lin->started) || (t_data->ann_s->gen % lin->keyframe_every == 0)) { push_keyframe(lin, t_data->ann_s); }
+    else { push_delta(lin, t_data->ann_s->gen); }
+    for (int t = 0; t < lin->num_bufs; t++) {
+        lin->bufs[t].len = 0;
+        lin->bufs[t].ct = 0;
+    }
+    lin->started = 1;
+    return;
+}
+
+
+/*
+ * finish_lineage - Stops the writer thread once it has written every pushed record, closes the lineage log, prints its size against a keyframe every generation and frees it
+ */
+void finish_lineage(thread_data *t_data)
+{
+    lineage *lin = t_data->lin;
+    double full;
+    if (lin == NULL) { return; }
+
+    atomic_store(&lin->stop, 1);
+    wake_seq(lin);
+    if (pthread_join(lin->thread, NULL) != 0) {
+        printf("\n\nERR: pthread_join error for lineage writer thread\n");
+        exit(127);
+    }
+    if (fclose(lin->file) != 0) { perror(lin->file_name); }
+    full = (lin->keyframes)? (lin->keyframes + lin->deltas) * lin->key_bytes / lin->keyframes: 0;
+    printf("\n  LINEAGE     %s (%ld keyframes %0.2f MB, %ld deltas %0.2f MB, %0.1f%% of a keyframe every generation)\n", lin->file_name,
+        lin->keyframes, lin->key_bytes / 1048576.0, lin->deltas, lin->delta_bytes / 1048576.0, (full > 0)? 100.0 * (lin->key_bytes + lin->delta_bytes) / full: 0.0);
+
+    free_lineage(lin);
+    t_data->lin = NULL;
+    return;
+}
+
+
+/*
+ * read_keyframe - Reads a keyframe record's genes into every snake, returns 0 if the log is cut short
+ */
+static int read_keyframe(FILE *file, ann_set *ann_s)
+{
+    for (int i = 0; i < ann_s->num_net; i++) {
+        if (fread(ann_s->data[i].w, sizeof(double), ann_s->data[i].num_w, file) != (size_t) ann_s->data[i].num_w) { return 0; }
+        if (fread(ann_s->data[i].b, sizeof(double), ann_s->data[i].num_n, file) != (size_t) ann_s->data[i].num_n) { return 0; }
+    }
+    return 1;
+}
+
+
+/*
+ * apply_delta - Rebuilds a delta record's children from their parents (parents survive their children's generation, so it is applied in place), returns 0 if the record is corrupt
+ */
+static int apply_delta(const lineage_header *hdr, unsigned char *data, uint64_t size, ann_set *ann_s)
+{
+    int num_genes = hdr->num_w + hdr->num_n;
+    unsigned char *curr = data + sizeof(int32_t), *end = data + size, *mask;
+    lineage_child rec;
+    int32_t ct;
+    uint32_t g;
+    ann *c, *a, *b;
+
+    memcpy(&ct, data, sizeof(int32_t));
+    for (int i = 0; i < ct; i++) {
+        if (curr + sizeof(lineage_child) + hdr->mask_bytes > end) { return 0; }
+        memcpy(&rec, curr, sizeof(lineage_child));
+        mask = curr + sizeof(lineage_child);
+        curr = mask + hdr->mask_bytes;
+        if ((rec.child < 0) || (rec.child >= hdr->pop_size) || (rec.parent_a < 0) || (rec.parent_a >= hdr->pop_size) ||
+            (rec.parent_b < 0) || (rec.parent_b >= hdr->pop_size) || (rec.num_mut < 0) || (curr + rec.num_mut * LINEAGE_MUT_BYTES > end)) { return 0; }
+
+        c = &ann_s->data[rec.child];
+        a = &ann_s->data[rec.parent_a];
+        b = &ann_s->data[rec.parent_b];
+        for (int k = 0; k < num_genes; k++) { *gene(c, k) = (mask[k >> 3] & (1 << (k & 7)))? *gene(b, k): *gene(a, k); }
+        for (int m = 0; m < rec.num_mut; m++, curr += LINEAGE_MUT_BYTES) {
+            memcpy(&g, curr, sizeof(uint32_t));
+            if (g >= (uint32_t) num_genes) { return 0; }
+            memcpy(gene(c, g), curr + sizeof(uint32_t), sizeof(double));
+        }
+    }
+    return 1;
+}
+
+
+/*
+ * rebuild_lineage - Rebuilds the population of a generation (1 based) from the lineage log of a parameters file, starting at the last keyframe before it, and saves it as a checkpoint for INIT_POP
+ */
+void rebuild_lineage(const char *params_file, int gen_n, const char *out_file)
+{
+    gs_params *params = read_parameters_from_file(params_file);
+    lineage_header hdr;
+    lineage_record rec;
+    ann_set *ann_s;
+    unsigned char *data = NULL;
+    size_t cap = 0;
+    long key_off = NOT_FOUND, off;
+    int key_gen = NOT_FOUND, last_gen = NOT_FOUND, deltas = 0, same_shape;
+    int gen = gen_n - 1;
+    double start_t = get_time();
+    FILE *file;
+
+    if (params->lineage_every == 0) {
+        printf("\n\nERR: %s has no LINEAGE log to rebuild from\n\n\n", params_file);
+        exit(127);
+    }
+    file = fopen(params->lineage_file, "rb");
+    if ((file == NULL) || (fread(&hdr, sizeof(lineage_header), 1, file) != 1)) {
+        printf("\n\nERR: could not read lineage log %s\n\n\n", params->lineage_file);
+        exit(127);
+    }
+    same_shape = (hdr.num_layers == params->num_layers);
+    for (int l = 0; (l < 2 * params->num_layers) && (same_shape); l++) { same_shape = (hdr.shape[l] == params->shape[l]); }
+    if ((hdr.magic != LINEAGE_MAGIC) || (hdr.version != LINEAGE_VERSION)) {
+        printf("\n\nERR: %s is not a version %d lineage log\n\n\n", params->lineage_file, (int) LINEAGE_VERSION);
+        exit(127);
+    } else if ((!same_shape) || (hdr.pop_size != params->pop_size) || (hdr.mask_bytes != (hdr.num_w + hdr.num_n + 7) / 8)) {
+        printf("\n\nERR: the POP_WIDTH or LAYER shape of lineage log %s does not match %s\n\n\n", params->lineage_file, params_file);
+        exit(127);
+    }
+
+    // find the last keyframe at or before the generation by skipping over record payloads
+    off = ftell(file);
+    while ((fread(&rec, sizeof(lineage_record), 1, file) == 1) && (rec.gen <= gen)) {
+        if (rec.type == LINEAGE_KEY) {
+            key_off = off;
+            key_gen = rec.gen;
+        }
+        last_gen = rec.gen;
+        if (fseek(file, rec.size, SEEK_CUR) != 0) break;
+        off = ftell(file);
+    }
+    if ((key_off == NOT_FOUND) || (last_gen != gen)) {
+        printf("\n\nERR: lineage log %s has no GEN %d (it has to be played and follow a keyframe)\n\n\n", params->lineage_file, gen_n);
+        exit(127);
+    }
+
+    // replay the deltas after the keyframe
+    ann_s = (ann_set *) malloc(sizeof(ann_set));
+    init_ann_set(ann_s, params->pop_size, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
+    ann_s->gen = gen;
+    fseek(file, key_off + sizeof(lineage_record), SEEK_SET);
+    if (!read_keyframe(file, ann_s)) {
+        printf("\n\nERR: lineage log %s is cut short in the GEN %d keyframe\n\n\n", params->lineage_file, key_gen + 1);
+        exit(127);
+    }
+    while ((fread(&rec, sizeof(lineage_record), 1, file) == 1) && (rec.gen <= gen)) {
+        if (rec.size > cap) {
+            cap = rec.size;
+            data = (unsigned char *) realloc(data, cap);
+        }
+        if ((rec.type != LINEAGE_DELTA) || (rec.size < sizeof(int32_t)) || (fread(data, 1, rec.size, file) != rec.size) || (!apply_delta(&hdr, data, rec.size, ann_s))) {
+            printf("\n\nERR: lineage log %s is corrupt at GEN %d\n\n\n", params->lineage_file, rec.gen + 1);
+            exit(127);
+        }
+        deltas++;
+    }
+    fclose(file);
+
+    if (save_population(params, ann_s, gen, out_file) != 0) { perror(out_file); exit(127); }
+    printf("\n  rebuilt GEN %d of %s from the GEN %d keyframe and %d deltas in %0.2f ms -> %s\n\n", gen_n, params->lineage_file,
+        key_gen + 1, deltas, 1000 * (get_time() - start_t), out_file);
+
+    free_ann_set(ann_s);
+    free(data);
+    free(params);
+    return;
+}
@@ -0,0 +1,233 @@
+//
+//  gsmem.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "gsdefs.h"
+
+// account this thread counts into (NULL counts nothing, so a plain run, an autotune trial or a library engine pays only this check)
+__thread mem_account *mem_acct = NULL;
+
+// bytes this thread counted since its last merge (NULL adds straight to its account)
+static __thread long *mem_local = NULL;
+
+
+/*
+ * mem_chunk - Returns the heap bytes a malloc of a given size takes (size header, 16 byte alignment and the 32 byte minimum chunk)
+ */
+long mem_chunk(long size)
+{
+    long chunk = (size + (long) sizeof(size_t) + 15) & ~15L;
+    return ((chunk < 32)? 32: chunk);
+}
+
+
+/*
+ * raise_peak - Raises a peak counter to a live value if it is higher
+ */
+static void raise_peak(atomic_long *peak, long live)
+{
+    long curr = atomic_load_explicit(peak, memory_order_relaxed);
+    while ((live > curr) && (!atomic_compare_exchange_weak_explicit(peak, &curr, live, memory_order_relaxed, memory_order_relaxed))) {}
+    return;
+}
+
+
+/*
+ * mem_count - Adds bytes to an account's live counters of a subsystem and the total, raising their peaks
+ */
+static void mem_count(mem_account *acct, int subsys, long bytes)
+{
+    long live = atomic_fetch_add_explicit(&acct->live[subsys], bytes, memory_order_relaxed) + bytes;
+    if (bytes > 0) { raise_peak(&acct->peak[subsys], live); }
+    live = atomic_fetch_add_explicit(&acct->live[NUM_MEM], bytes, memory_order_relaxed) + bytes;
+    if (bytes > 0) { raise_peak(&acct->peak[NUM_MEM], live); }
+    return;
+}
+
+
+/*
+ * init_mem_account - Zeroes the live and peak counters of an account
+ */
+void init_mem_account(mem_account *acct)
+{
+    for (int s = 0; s <= NUM_MEM; s++) {
+        atomic_init(&acct->live[s], 0);
+        atomic_init(&acct->peak[s], 0);
+    }
+    return;
+}
+
+
+/*
+ * mem_add - Adds allocated (or, when negative, freed) bytes to a subsystem, in this thread's counters if it has bound any
+ */
+void mem_add(int subsys, long bytes)
+{
+    if ((mem_acct == NULL) || (bytes == 0)) { return; }
+    if (mem_local != NULL) {
+        mem_local[subsys] += bytes;
+        return;
+    }
+    mem_count(mem_acct, subsys, bytes);
+    return;
+}
+
+
+/*
+ * mem_bind - Points this thread's accounting at an account (NULL counts nothing) and its own counters (NULL counts straight into the account)
+ */
+void mem_bind(mem_account *acct, long *local)
+{
+    mem_acct = acct;
+    mem_local = local;
+    return;
+}
+
+
+/*
+ * mem_bound - Returns the account this thread counts into (a thread data struct made on this thread counts into it too)
+ */
+mem_account * mem_bound(void)
+{
+    return mem_acct;
+}
+
+
+/*
+ * mem_merge - Moves a thread's counted bytes into an account (peaks are sampled here, at the end of a run phase when every game has finished)
+ */
+void mem_merge(mem_account *acct, long *local)
+{
+    for (int s = 0; s < NUM_MEM; s++) {
+        if ((local[s] != 0) && (acct != NULL)) { mem_count(acct, s, local[s]); }
+        local[s] = 0;
+    }
+    return;
+}
+
+
+/*
+ * mem_live - Returns the live bytes of a subsystem in an account (NUM_MEM for the total)
+ */
+long mem_live(mem_account *acct, int subsys)
+{
+    return atomic_load_explicit(&acct->live[subsys], memory_order_relaxed);
+}
+
+
+/*
+ * mem_peak - Returns the peak bytes of a subsystem in an account (NUM_MEM for the total)
+ */
+long mem_peak(mem_account *acct, int subsys)
+{
+    return atomic_load_explicit(&acct->peak[subsys], memory_order_relaxed);
+}
+
+
+/*
+ * env_body_bytes - Returns the bytes of an env's snake body nodes (one per segment, a segment per apple eaten)
+ */
+long env_body_bytes(env *e)
+{
+    return (MIN_SNAKE_LEN + e->n) * mem_chunk(sizeof(snake_node));
+}
+
+
+/*
+ * env_log_bytes - Returns the bytes of an env's apple and move records (the killing move of a starved or reversed snake is counted too)
+ */
+long env_log_bytes(env *e)
+{
+    return (e->n + 1) * mem_chunk(sizeof(apple_data)) + e->m * mem_chunk(sizeof(move_data));
+}
+
+
+/*
+ * estimate_parts - Estimates the bytes every subsystem needs regardless of population size and per snake
+ */
+static void estimate_parts(gs_params *params, long *fixed, long *per_snake)
+{
+    long num_n = 0, num_w = 0, genome;
+    long moves = (MEM_EST_APPLES + 1) * MAX_MOVES_PER_APPLE;
+
+    for (int l = 0; l < params->num_layers; l++) {
+        num_n += params->shape[RIDX(l, 1, 2)];
+        num_w += params->shape[RIDX(l, 0, 2)] * params->shape[RIDX(l, 1, 2)];
+    }
+    genome = mem_chunk(SHAPE_DIM * params->num_layers * sizeof(int)) + mem_chunk(num_w * sizeof(double)) +
+        mem_chunk(num_n * sizeof(double)) + mem_chunk(params->num_layers * sizeof(funct));
+    for (int s = 0; s < NUM_MEM; s++) { fixed[s] = per_snake[s] = 0; }
+
+    // every snake: its genome, input and activations, env and a game of MEM_EST_APPLES apples at the move limit of every apple
+    per_snake[MEM_GENOMES] = sizeof(ann) + sizeof(double) + genome;
+    per_snake[MEM_ACTIVATIONS] = sizeof(dist_data) + mem_chunk(num_n * sizeof(double));
+    per_snake[MEM_ENV] = sizeof(env) + mem_chunk(sizeof(apple)) + (MIN_SNAKE_LEN + MEM_EST_APPLES) * mem_chunk(sizeof(snake_node));
+    per_snake[MEM_TRAJECTORY] = (MEM_EST_APPLES + 1) * mem_chunk(sizeof(apple_data)) + moves * mem_chunk(sizeof(move_data));
+    per_snake[MEM_THREADS] = 4 * sizeof(int) + (long) (params->survive * sizeof(double));
+
+    // per run: thread states, replay snapshot genomes and profiler trace buffers
+    fixed[MEM_THREADS] = params->num_threads * (long) sizeof(thread_state);
+    if (params->print_replay) { fixed[MEM_GENOMES] = REPLAY_QUEUE * genome; }
+    if (params->trace_file[0] != '\0') { fixed[MEM_BUFFERS] = (params->num_threads + 1) * (long) PROF_MAX_EVENTS * sizeof(prof_event); }
+    return;
+}
+
+
+/*
+ * estimate_footprint - Estimates the peak bytes of a run from its parameters, per subsystem when given an array, and returns the total
+ */
+long estimate_footprint(gs_params *params, long *by_subsys)
+{
+    long fixed[NUM_MEM], per_snake[NUM_MEM];
+    long total = 0, bytes;
+
+    estimate_parts(params, fixed, per_snake);
+    for (int s = 0; s < NUM_MEM; s++) {
+        bytes = fixed[s] + params->pop_size * per_snake[s];
+        if (by_subsys != NULL) { by_subsys[s] = bytes; }
+        total += bytes;
+    }
+    return total;
+}
+
+
+/*
+ * apply_memory_budget - Refuses a run whose estimated footprint exceeds the memory budget, or shrinks its population to fit, and returns GS_OK or GS_ERR_PARAMS with the reason in err
+ */
+int apply_memory_budget(gs_params *params, char *err, size_t size)
+{
+    long fixed[NUM_MEM], per_snake[NUM_MEM];
+    long budget = params->memory_budget << 20;
+    long fixed_t = 0, snake_t = 0;
+    int pop_size, min_pop;
+
+    if ((params->memory_budget <= 0) || (estimate_footprint(params, NULL) <= budget)) { return GS_OK; }
+    if (params->budget_policy == BUDGET_REFUSE) {
+        snprintf(err, size, "Estimated footprint %0.1f MB exceeds MEMORY_BUDGET %ld MB (lower POP_WIDTH or use 'MEMORY_BUDGET %ld downscale')",
+            estimate_footprint(params, NULL) / 1048576.0, params->memory_budget, params->memory_budget);
+        return GS_ERR_PARAMS;
+    }
+
+    // the estimate is linear in the population, so the largest population that fits is direct
+    estimate_parts(params, fixed, per_snake);
+    for (int s = 0; s < NUM_MEM; s++) {
+        fixed_t += fixed[s];
+        snake_t += per_snake[s];
+    }
+    pop_size = (budget > fixed_t)? (int) ((budget - fixed_t) / snake_t): 0;
+    min_pop = (2 * params->num_threads > MIN_POP_SIZE)? 2 * params->num_threads: MIN_POP_SIZE;
+    if (pop_size < min_pop) {
+        snprintf(err, size, "MEMORY_BUDGET %ld MB is too small to downscale into (a population of %d does not fit)", params->memory_budget, min_pop);
+        return GS_ERR_PARAMS;
+    }
+    if (!params->quiet) {
+        printf("\nWARN: POP_WIDTH downscaled from %d to %d to fit MEMORY_BUDGET %ld MB\n", params->pop_size, pop_size, params->memory_budget);
+    }
+    params->pop_size = pop_size;
+    return GS_OK;
+}
@@ -0,0 +1,363 @@
+//
+//  gsmetrics.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include "gsdefs.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+static const char *fitness_keys[7] = { "fitness_min", "fitness_p25", "fitness_median", "fitness_p75", "fitness_p90", "fitness_max", "fitness_mean" };
+static const char *death_keys[NUM_DEATHS] = { "death_unknown", "death_wall", "death_self", "death_timeout", "death_reverse" };
+
+
+/*
+ * wait_seq - Parks the writer thread until the push counter is no longer the given value
+ */
+static void wait_seq(metrics *m, int old_seq)
+{
+#ifdef __linux__
+    syscall(SYS_futex, &m->seq, FUTEX_WAIT_PRIVATE, old_seq, NULL, NULL, 0);
+#else
+    if (atomic_load(&m->seq) == old_seq) { usleep(1000); }
+#endif
+    return;
+}
+
+
+/*
+ * wake_writer - Bumps the push counter and wakes the writer thread if it is parked on it
+ */
+static void wake_writer(metrics *m)
+{
+    atomic_fetch_add(&m->seq, 1);
+#ifdef __linux__
+    syscall(SYS_futex, &m->seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+    return;
+}
+
+
+/*
+ * write_header - Writes the CSV column names or the binary stream header (JSONL needs none)
+ */
+static void write_header(metrics *m)
+{
+    uint32_t bin_hdr[3] = { METRICS_MAGIC, METRICS_VERSION, sizeof(metrics_rec) };
+
+    if (m->format == METRICS_BIN) {
+        fwrite(bin_hdr, sizeof(bin_hdr), 1, m->file);
+        return;
+    } else if (m->format != METRICS_CSV) { return; }
+
+    fprintf(m->file, "gen,%s,elapsed_s,games", m->group_key);
+    for (int k = 0; k < 7; k++) { fprintf(m->file, ",%s", fitness_keys[k]); }
+    fprintf(m->file, ",fitness_std,moves_min,moves_mean,moves_max,apples_min,apples_mean,apples_max,highscore");
+    for (int d = 0; d < NUM_DEATHS; d++) { fprintf(m->file, ",%s", death_keys[d]); }
+    fprintf(m->file, ",run_ms,select_ms,spawn_ms,gen_ms,straggler_idle_pct,steals,games_per_s,steps_per_s\n");
+    return;
+}
+
+
+/*
+ * write_rec - Writes one generation's metrics in the stream's format
+ */
+static void write_rec(metrics *m, const metrics_rec *rec)
+{
+    FILE *file = m->file;
+
+    if (m->format == METRICS_BIN) {
+        fwrite(rec, sizeof(metrics_rec), 1, file);
+    } else if (m->format == METRICS_CSV) {
+        fprintf(file, "%d,%d,%0.6f,%lld", rec->gen + 1, rec->island, rec->elapsed_s, (long long) rec->games);
+        for (int k = 0; k < 7; k++) { fprintf(file, ",%0.4f", rec->fitness[k]); }
+        fprintf(file, ",%0.4f,%0.0f,%0.4f,%0.0f,%0.0f,%0.4f,%0.0f,%d", rec->fitness_std, rec->moves[0], rec->moves[1], rec->moves[2],
+            rec->apples[0], rec->apples[1], rec->apples[2], rec->highscore);
+        for (int d = 0; d < NUM_DEATHS; d++) { fprintf(file, ",%lld", (long long) rec->deaths[d]); }
+        fprintf(file, ",%0.4f,%0.4f,%0.4f,%0.4f,%0.2f,%lld,%0.2f,%0.1f\n", rec->run_ms, rec->select_ms, rec->spawn_ms, rec->gen_ms,
+            rec->idle_pct, (long long) rec->steals, rec->games_per_s, rec->steps_per_s);
+    } else {
+        fprintf(file, "{\"gen\": %d, \"%s\": %d, \"elapsed_s\": %0.6f, \"games\": %lld", rec->gen + 1, m->group_key, rec->island, rec->elapsed_s, (long long) rec->games);
+        for (int k = 0; k < 7; k++) { fprintf(file, ", \"%s\": %0.4f", fitness_keys[k], rec->fitness[k]); }
+        fprintf(file, ", \"fitness_std\": %0.4f, \"moves_min\": %0.0f, \"moves_mean\": %0.4f, \"moves_max\": %0.0f, \"apples_min\": %0.0f, \"apples_mean\": %0.4f, \"apples_max\": %0.0f, \"highscore\": %d",
+            rec->fitness_std, rec->moves[0], rec->moves[1], rec->moves[2], rec->apples[0], rec->apples[1], rec->apples[2], rec->highscore);
+        for (int d = 0; d < NUM_DEATHS; d++) { fprintf(file, ", \"%s\": %lld", death_keys[d], (long long) rec->deaths[d]); }
+        fprintf(file, ", \"run_ms\": %0.4f, \"select_ms\": %0.4f, \"spawn_ms\": %0.4f, \"gen_ms\": %0.4f, \"straggler_idle_pct\": %0.2f, \"steals\": %lld, \"games_per_s\": %0.2f, \"steps_per_s\": %0.1f}\n",
+            rec->run_ms, rec->select_ms, rec->spawn_ms, rec->gen_ms, rec->idle_pct, (long long) rec->steals, rec->games_per_s, rec->steps_per_s);
+    }
+    m->written++;
+    return;
+}
+
+
+/*
+ * drain_rings - Writes every pushed record of every ring and returns how many it wrote
+ */
+static long drain_rings(metrics *m)
+{
+    metrics_ring *ring;
+    long head, tail, ct = 0;
+
+    for (int r = 0; r < m->num_rings; r++) {
+        ring = &m->rings[r];
+        head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        for (; tail < head; tail++, ct++) { write_rec(m, &ring->recs[tail % METRICS_RING]); }
+
+        // hand the written slots back to the producer
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    if (ct) { fflush(m->file); }
+    return ct;
+}
+
+
+/*
+ * metrics_writer_thread - Background thread that writes pushed records until the stream is stopped and drained
+ */
+static void * metrics_writer_thread(void *void_m)
+{
+    metrics *m = (metrics *) void_m;
+    int seq, stop;
+
+    while (1) {
+        // stop is read first, so an empty drain after it has seen every push
+        seq = atomic_load(&m->seq);
+        stop = atomic_load(&m->stop);
+        if ((drain_rings(m) == 0) && (stop)) break;
+        if (atomic_load(&m->seq) == seq) { wait_seq(m, seq); }
+    }
+    return NULL;
+}
+
+
+/*
+ * free_metrics - Frees a metrics stream's rings and the stream itself (its writer thread has stopped or never started)
+ */
+static void free_metrics(metrics *m)
+{
+    mem_add(MEM_BUFFERS, -(mem_chunk(m->num_rings * sizeof(metrics_ring)) + m->num_rings * (mem_chunk(METRICS_RING * sizeof(metrics_rec)) + mem_chunk(m->pop_size * sizeof(double)))));
+    for (int r = 0; r < m->num_rings; r++) {
+        free(m->rings[r].recs);
+        free(m->rings[r].sorted);
+    }
+    free(m->rings);
+    free(m);
+    return;
+}
+
+
+/*
+ * create_metrics - Opens the metrics stream of a run with a ring per producer (island or sweep run, named by the group column) as out (NULL if the run streams no metrics) and starts its writer thread, returns GS_OK or the reason it could not in err
+ */
+int create_metrics(gs_params *params, int num_rings, const char *group_key, metrics **out, char *err, size_t size)
+{
+    metrics *m;
+    int ok = 1;
+
+    *out = NULL;
+    if (params->metrics_format == METRICS_OFF) { return GS_OK; }
+    if (posix_memalign((void **) &m, CACHE_LINE, sizeof(metrics)) != 0) {
+        snprintf(err, size, "could not allocate metrics stream");
+        return GS_ERR_NOMEM;
+    }
+    memset(m, 0, sizeof(metrics));
+    strcpy(m->file_name, params->metrics_file);
+    m->format = params->metrics_format;
+    m->group_key = group_key;
+
+    m->num_rings = num_rings;
+    m->pop_size = params->pop_size;
+    if (posix_memalign((void **) &m->rings, CACHE_LINE, num_rings * sizeof(metrics_ring)) != 0) {
+        free(m);
+        snprintf(err, size, "could not allocate metrics rings");
+        return GS_ERR_NOMEM;
+    }
+    for (int r = 0; r < num_rings; r++) {
+        atomic_init(&m->rings[r].head, 0);
+        atomic_init(&m->rings[r].tail, 0);
+        m->rings[r].recs = (metrics_rec *) malloc(METRICS_RING * sizeof(metrics_rec));
+        m->rings[r].sorted = (double *) malloc(m->pop_size * sizeof(double));
+        m->rings[r].dropped = 0;
+        ok = ok && (m->rings[r].recs != NULL) && (m->rings[r].sorted != NULL);
+    }
+    mem_add(MEM_BUFFERS, mem_chunk(num_rings * sizeof(metrics_ring)) + num_rings * (mem_chunk(METRICS_RING * sizeof(metrics_rec)) + mem_chunk(m->pop_size * sizeof(double))));
+    if (!ok) {
+        free_metrics(m);
+        snprintf(err, size, "could not allocate metrics rings");
+        return GS_ERR_NOMEM;
+    }
+
+    m->file = fopen(m->file_name, (m->format == METRICS_BIN)? "wb": "w");
+    if (m->file == NULL) {
+        snprintf(err, size, "%s: %s", m->file_name, strerror(errno));
+        free_metrics(m);
+        return GS_ERR_IO;
+    }
+    write_header(m);
+    atomic_init(&m->seq, 0);
+    atomic_init(&m->stop, 0);
+    m->start_t = get_time();
+
+    if (pthread_create(&m->thread, NULL, metrics_writer_thread, m) != 0) {
+        snprintf(err, size, "pthread_create error for metrics writer thread");
+        fclose(m->file);
+        free_metrics(m);
+        return GS_ERR_THREAD;
+    }
+    *out = m;
+    return GS_OK;
+}
+
+
+/*
+ * start_metrics - Opens the metrics stream of a command line run, stopping it if the stream cannot be opened, returns NULL if the run streams no metrics
+ */
+metrics * start_metrics(gs_params *params, int num_rings, const char *group_key)
+{
+    char err[2 * MAX_LINE_SIZE];
+    metrics *m;
+
+    if (create_metrics(params, num_rings, group_key, &m, err, sizeof(err)) != GS_OK) {
+        printf("\n\nERR: %s\n\n\n", err);
+        exit(127);
+    }
+    return m;
+}
+
+
+/*
+ * compare_double - qsort comparison of two doubles
+ */
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+
+/*
+ * quantile - Returns a quantile of sorted values (nearest rank)
+ */
+static double quantile(const double *sorted, int ct, double q)
+{
+    int idx = (int) ceil(q * ct) - 1;
+    return sorted[(idx < 0)? 0: idx];
+}
+
+
+/*
+ * collect_gen_metrics - Serial step hook after a run phase: fills the generation's metrics from its merged stats, fitness distribution and run phase timings
+ */
+void collect_gen_metrics(thread_data *t_data, gen_stats *stats)
+{
+    metrics_rec *rec = &t_data->gen_metrics;
+    metrics_ring *ring;
+    double mean, var;
+    int ct;
+
+    if ((t_data->metrics == NULL) || (stats->ct == 0)) { return; }
+    ring = &t_data->metrics->rings[(t_data->island == NOT_FOUND)? 0: t_data->island];
+    ct = t_data->ann_s->num_net;
+
+    memset(rec, 0, sizeof(metrics_rec));
+    rec->gen = t_data->ann_s->gen;
+    rec->island = t_data->island;
+    rec->games = stats->ct;
+
+    // every snake's fitness is still in index order before selection sorts it
+    memcpy(ring->sorted, t_data->ann_s->fitness, ct * sizeof(double));
+    qsort(ring->sorted, ct, sizeof(double), compare_double);
+    mean = stats->sum_fitness / stats->ct;
+    var = stats->sum_sq_fitness / stats->ct - mean * mean;
+    rec->fitness[0] = stats->min_fitness;
+    rec->fitness[1] = quantile(ring->sorted, ct, 0.25);
+    rec->fitness[2] = quantile(ring->sorted, ct, 0.5);
+    rec->fitness[3] = quantile(ring->sorted, ct, 0.75);
+    rec->fitness[4] = quantile(ring->sorted, ct, 0.9);
+    rec->fitness[5] = stats->max_fitness;
+    rec->fitness[6] = mean;
+    rec->fitness_std = (var > 0)? sqrt(var): 0;
+    rec->moves[0] = stats->min_moves;
+    rec->moves[1] = (double) stats->sum_moves / stats->ct;
+    rec->moves[2] = stats->max_moves;
+    rec->apples[0] = stats->min_apples;
+    rec->apples[1] = (double) stats->sum_apples / stats->ct;
+    rec->apples[2] = stats->max_apples;
+    rec->highscore = t_data->highscore;
+    for (int d = 0; d < NUM_DEATHS; d++) { rec->deaths[d] = stats->deaths[d]; }
+
+    rec->run_ms = 1000 * t_data->run_t;
+    rec->idle_pct = t_data->idle_pct;
+    rec->steals = t_data->gen_steals;
+    rec->steps_per_s = (t_data->run_t > 0)? stats->sum_moves / t_data->run_t: 0;
+    return;
+}
+
+
+/*
+ * push_gen_metrics - Serial step hook once a generation is over (spawned, or the last one run): pushes its metrics to the ring without ever waiting for the writer
+ */
+void push_gen_metrics(thread_data *t_data)
+{
+    metrics *m = t_data->metrics;
+    metrics_rec *rec = &t_data->gen_metrics;
+    metrics_ring *ring;
+    double now = get_time();
+    long head;
+
+    if ((m == NULL) || (rec->games == 0)) { return; }
+    ring = &m->rings[(t_data->island == NOT_FOUND)? 0: t_data->island];
+    rec->elapsed_s = now - m->start_t;
+    rec->gen_ms = 1000 * (now - t_data->run_start_t);
+    rec->games_per_s = (now > t_data->run_start_t)? rec->games / (now - t_data->run_start_t): 0;
+
+    // a full ring drops the record rather than stalling the generation
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= METRICS_RING) {
+        ring->dropped++;
+    } else {
+        ring->recs[head % METRICS_RING] = *rec;
+        atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+        wake_writer(m);
+    }
+    rec->games = 0;
+    return;
+}
+
+
+/*
+ * stop_metrics - Stops the writer thread once it has written every pushed record, prints the stream summary and frees it
+ */
+void stop_metrics(metrics *m)
+{
+    long dropped = 0;
+    if (m == NULL) { return; }
+
+    atomic_store(&m->stop, 1);
+    wake_writer(m);
+    if (pthread_join(m->thread, NULL) != 0) {
+        printf("\n\nERR: pthread_join error for metrics writer thread\n");
+        exit(127);
+    }
+    if (fclose(m->file) != 0) { perror(m->file_name); }
+
+    for (int r = 0; r < m->num_rings; r++) { dropped += m->rings[r].dropped; }
+    printf("\n  METRICS     %s (%ld generations", m->file_name, m->written);
+    if (dropped) { printf(", %ld dropped while the writer fell behind", dropped); }
+    printf(")\n");
+
+    free_metrics(m);
+    return;
+}
@@ -0,0 +1,207 @@
+//
+//  gsperf.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "gsdefs.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+/*
+ * open_counter - Opens a user space hardware counter of the calling thread and returns -1 (with errno set) if it is unavailable
+ */
+static int open_counter(int counter)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = (counter == PERF_CYCLES)? PERF_COUNT_HW_CPU_CYCLES: (counter == PERF_INSTR)? PERF_COUNT_HW_INSTRUCTIONS:
+        (counter == PERF_LLC_MISS)? PERF_COUNT_HW_CACHE_MISSES: PERF_COUNT_HW_BRANCH_MISSES;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // user space only so the default perf_event_paranoid setting still allows it
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
+/*
+ * read_counter - Returns the value of an open counter, scaled up when the kernel multiplexed it with other counters
+ */
+static double read_counter(int fd)
+{
+    unsigned long long val[3];
+
+    if ((fd < 0) || (read(fd, val, sizeof(val)) != sizeof(val)) || (val[2] == 0)) { return 0; }
+    return (val[1] == val[2])? (double) val[0]: (double) val[0] * val[1] / val[2];
+}
+
+
+/*
+ * create_perf_counters - Allocates the hardware counters of a number of threads as out (NULL if counters are off), returns GS_OK or GS_ERR_NOMEM
+ */
+int create_perf_counters(gs_params *params, int num_threads, int island, perf_counters **out)
+{
+    perf_counters *perf;
+
+    *out = NULL;
+    if (!params->perf_counters) { return GS_OK; }
+    perf = (perf_counters *) calloc(1, sizeof(perf_counters));
+    if (perf == NULL) { return GS_ERR_NOMEM; }
+    perf->num_threads = num_threads;
+    perf->island = island;
+    for (int c = 0; c < NUM_PERF; c++) { atomic_init(&perf->missing[c], 0); }
+    atomic_init(&perf->open_errno, 0);
+    if (posix_memalign((void **) &perf->threads, CACHE_LINE, num_threads * sizeof(perf_thread)) != 0) {
+        free(perf);
+        return GS_ERR_NOMEM;
+    }
+    memset(perf->threads, 0, num_threads * sizeof(perf_thread));
+    for (int t = 0; t < num_threads; t++) {
+        for (int c = 0; c < NUM_PERF; c++) { perf->threads[t].fd[c] = -1; }
+    }
+    *out = perf;
+    return GS_OK;
+}
+
+
+/*
+ * init_perf_counters - Allocates the hardware counters of a command line run's threads, stopping it if they cannot be, and returns NULL if counters are off
+ */
+perf_counters * init_perf_counters(gs_params *params, int num_threads, int island)
+{
+    perf_counters *perf;
+
+    if (create_perf_counters(params, num_threads, island, &perf) != GS_OK) {
+        printf("\n\nERR: could not allocate hardware counter threads\n");
+        exit(127);
+    }
+    return perf;
+}
+
+
+/*
+ * free_perf_counters - Closes every thread's counters and frees them
+ */
+void free_perf_counters(perf_counters *perf)
+{
+    if (perf == NULL) { return; }
+    for (int t = 0; t < perf->num_threads; t++) {
+        for (int c = 0; c < NUM_PERF; c++) { if (perf->threads[t].fd[c] >= 0) { close(perf->threads[t].fd[c]); } }
+    }
+    free(perf->threads);
+    free(perf);
+    return;
+}
+
+
+/*
+ * perf_open_thread - Opens the counters of the calling snake controller thread (counters the host does not support are left out)
+ */
+void perf_open_thread(perf_counters *perf, int tid)
+{
+    perf_thread *pt;
+    if (perf == NULL) { return; }
+
+    pt = &perf->threads[tid];
+    for (int c = 0; c < NUM_PERF; c++) {
+        pt->fd[c] = open_counter(c);
+        if (pt->fd[c] < 0) {
+            if (atomic_fetch_add(&perf->missing[c], 1) == 0) { atomic_store(&perf->open_errno, errno); }
+        }
+    }
+    return;
+}
+
+
+/*
+ * perf_begin - Reads a thread's counters at the start of a phase
+ */
+void perf_begin(perf_counters *perf, int tid)
+{
+    perf_thread *pt;
+    if (perf == NULL) { return; }
+
+    pt = &perf->threads[tid];
+    for (int c = 0; c < NUM_PERF; c++) { pt->start[c] = read_counter(pt->fd[c]); }
+    return;
+}
+
+
+/*
+ * perf_end - Reads a thread's counters at the end of a phase and adds the phase's counts to the thread's generation
+ */
+void perf_end(perf_counters *perf, int tid, int phase)
+{
+    perf_thread *pt;
+    if (perf == NULL) { return; }
+
+    pt = &perf->threads[tid];
+    for (int c = 0; c < NUM_PERF; c++) { pt->gen[phase][c] += read_counter(pt->fd[c]) - pt->start[c]; }
+    return;
+}
+
+
+/*
+ * perf_merge_gen - Sums every thread's counts of the finished generation with its snake steps and children (serial step only)
+ */
+void perf_merge_gen(perf_counters *perf, double steps, double children)
+{
+    if (perf == NULL) { return; }
+
+    for (int p = 0; p < NUM_PERF_PHASES; p++) {
+        for (int c = 0; c < NUM_PERF; c++) {
+            perf->gen[p][c] = 0;
+            for (int t = 0; t < perf->num_threads; t++) {
+                perf->gen[p][c] += perf->threads[t].gen[p][c];
+                perf->threads[t].gen[p][c] = 0;
+            }
+            perf->total[p][c] += perf->gen[p][c];
+        }
+    }
+    perf->gen_units[PERF_PHASE_RUN] = steps;
+    perf->gen_units[PERF_PHASE_SPAWN] = children;
+    perf->total_units[PERF_PHASE_RUN] += steps;
+    perf->total_units[PERF_PHASE_SPAWN] += children;
+    return;
+}
+
+
+/*
+ * perf_report_missing - Warns once about the counters that could not be opened on every thread (serial step after the shards are initialized)
+ */
+void perf_report_missing(perf_counters *perf)
+{
+    const char *names[NUM_PERF] = { "cycles", "instructions", "llc misses", "branch misses" };
+    int missing = 0;
+    if (perf == NULL) { return; }
+
+    for (int c = 0; c < NUM_PERF; c++) { if (atomic_load(&perf->missing[c]) > 0) { missing++; } }
+    if (missing == 0) { return; }
+
+    printf("\nWARN: hardware counters unavailable (%s):", strerror(atomic_load(&perf->open_errno)));
+    for (int c = 0; c < NUM_PERF; c++) { if (atomic_load(&perf->missing[c]) > 0) { printf(" %s", names[c]); } }
+    if (atomic_load(&perf->open_errno) == EACCES) { printf(" -- check /proc/sys/kernel/perf_event_paranoid"); }
+    printf("\n");
+    return;
+}
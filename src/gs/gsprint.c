@@ -32,12 +32,58 @@ void print_model_parameters(gs_params * params)
         printf("  EXECUTION TYPE          SEQUENTIAL\n");
         printf("  THREADS                 %d\n", params->num_threads);
     }
+    if (params->autotune != TUNE_OFF) {
+        printf("  AUTO-TUNED              %d THREADS, %s SCHEDULE, CHUNK %d (%0.2f GENS/S, %s %s)\n", params->num_threads,
+            (params->schedule == SCHEDULE_INDEX)? "INDEX": "LONGEST", params->chunk, params->tune_rate,
+            (params->autotune == TUNE_CACHED)? "CACHED IN": "CALIBRATED INTO", params->tune_file);
+    }
+    if (params->mode == MODE_STEADY) {
+        printf("  ENGINE                  STEADY-STATE\n");
+        printf("  REPORT EVERY            %d EVALS\n", params->report_evals);
+    } else if (params->mode == MODE_ISLAND) {
+        printf("  ENGINE                  ISLAND\n");
+        printf("  ISLANDS                 %d (%d THREADS, %d SNAKES EACH)\n", params->num_islands, 
+            params->num_threads / params->num_islands, params->pop_size / params->num_islands);
+        printf("  MIGRATION               %d SNAKES EVERY %d GENS (%s)\n", params->migrate_k, params->migrate_every, 
+            (params->topology == TOPOLOGY_RING)? "RING": "RANDOM");
+    } else if (params->mode == MODE_FARM) {
+        printf("  ENGINE                  FARM COORDINATOR\n");
+        printf("  FARM ADDRESS            %s\n", params->farm_addr);
+        printf("  FARM WORKERS            %d (MORE MAY JOIN)\n", params->farm_workers);
+        printf("  FARM BATCH              %d SNAKES\n", params->farm_batch);
+        printf("  GENOME TRANSFER         ");
+        if (params->quantize) { printf("%d BIT QUANTIZED\n", params->quantize); } else { printf("DOUBLE\n"); }
+    } else {
+        printf("  ENGINE                  GENERATIONAL\n");
+    }
     printf("  REPLAY                  ");
     if (params->print_replay) {
-        printf(">= %d APPLES\n\n", params->print_replay);
+        printf(">= %d APPLES\n", params->print_replay);
     } else {
-        printf("OFF\n\n");
+        printf("OFF\n");
+    }
+    printf("  PROFILE                 ");
+    if ((params->profile) && (params->mode == MODE_FARM)) { printf("OFF (NOT SUPPORTED BY THE FARM)\n"); }
+    else if (params->trace_file[0] != '\0') { printf("ON (TRACE %s)\n", params->trace_file); }
+    else { printf("%s\n", (params->profile)? "ON": "OFF"); }
+    printf("  HARDWARE COUNTERS       ");
+    if ((params->perf_counters) && ((params->mode == MODE_STEADY) || (params->mode == MODE_FARM))) { printf("OFF (GENERATIONAL AND ISLAND ONLY)\n"); }
+    else { printf("%s\n", (params->perf_counters)? "ON": "OFF"); }
+    if (params->seed != NOT_SET) { printf("  SEED                    %lld\n", params->seed); }
+    if (params->ckpt_every) { printf("  CHECKPOINT              %s EVERY %d GENS\n", params->ckpt_file, params->ckpt_every); }
+    if (params->metrics_format != METRICS_OFF) {
+        printf("  METRICS                 %s (%s)\n", params->metrics_file, (params->metrics_format == METRICS_CSV)? "CSV": (params->metrics_format == METRICS_JSONL)? "JSONL": "BINARY");
+    }
+    if (params->champ_file[0] != '\0') {
+        printf("  CHAMPION                %s (%s", params->champ_file, (params->champ_format == GS_CHAMP_DOUBLE)? "DOUBLE": (params->champ_format == GS_CHAMP_FLOAT)? "FLOAT": (params->champ_format == GS_CHAMP_INT16)? "INT16": "INT8");
+        if (params->champ_prune > 0) { printf(", PRUNED BELOW %g", params->champ_prune); }
+        printf(")\n");
     }
+    if (params->lineage_every) { printf("  LINEAGE                 %s (KEYFRAME EVERY %d GENS)\n", params->lineage_file, params->lineage_every); }
+    if (params->resume != CKPT_OFF) { printf("  %-24s%s\n", (params->resume == CKPT_RESUME)? "RESUME FROM": "POPULATION FROM", params->resume_file); }
+    printf("  MEMORY ESTIMATE         %0.1f MB", estimate_footprint(params, NULL) / 1048576.0);
+    if (params->memory_budget > 0) { printf(" (BUDGET %ld MB)", params->memory_budget); }
+    printf("\n\n");
 
     // print model parameters
     printf("+++++++  MODEL PARAMETERS  +++++++\n\n");
@@ -57,10 +103,12 @@ void print_model_parameters(gs_params * params)
 
 
 /*
- * print_start_prompt - Prints a start prompt and waits for user input before continuing
+ * print_start_prompt - Prints a start prompt and waits for user input before continuing (skipped when stdin is not a terminal)
  */
 void print_start_prompt()
 {
+    // nothing to wait for without a terminal (i.e. make targets and scripts)
+    if (!isatty(STDIN_FILENO)) { return; }
     printf("\n\n\n Press a key to begin...\n  (press control + c at any time to exit)\n\n");
     getchar();
     printf("starting\n\n");
@@ -69,187 +117,100 @@ void print_start_prompt()
 
 
 /*
- * print_pop_stats - Prints the average of the current population's fitness, moves, and apples
+ * print_pop_stats - Prints the average and range of the current population's fitness, moves, and apples
  */
-void print_pop_stats(ann_set *ann_s, env_set *env_s)
+void print_pop_stats(gen_stats *stats)
 {
-    double total_fitness = 0; 
-    double total_apples = 0; 
-    double total_moves = 0;
-
-    // find the sum of the fitness, moves, and apples
-    for (int i = 0; i < ann_s->num_net; i++) {
-        total_fitness += ((double) env_s->data[i].m) * pow(2.0, (double) env_s->data[i].n);
-        total_moves += env_s->data[i].m;
-        total_apples += env_s->data[i].n;
-    }
-
     // calculates and prints the average of the fitness, moves, and apples
-    printf("avg fitness - %f, avg moves - %f, avg apples - %f \n", total_fitness/ann_s->num_net, total_moves/ann_s->num_net, total_apples/ann_s->num_net);
+    printf("avg fitness - %f, avg moves - %f, avg apples - %f \n", stats->sum_fitness / stats->ct, 
+        ((double) stats->sum_moves) / stats->ct, ((double) stats->sum_apples) / stats->ct);
+    printf("               fitness - [%0.1f, %0.1f], moves - [%d, %d], apples - [%d, %d] \n", stats->min_fitness, stats->max_fitness,
+        stats->min_moves, stats->max_moves, stats->min_apples, stats->max_apples);
     return;
 }
 
  
 /*
- * print_env - Prints an env state from an array of ints
- */
-static void print_env(int dim, int *d)
-{
-    // print top bar
-    printf("   ");
-    for (int i = 0; i < dim; i++){ printf("- "); }
-    printf("\n");
-    
-    // print game board
-    for (int i = 0; i < dim; i++){
-        // print left bar
-        printf(" | ");
-
-        // print env board
-        for (int j = 0; j < dim; j++) {
-            switch (d[RIDX(i,j,dim)]) {
-            case 1: // head
-                printf("\033[0;92m# \033[0m");
-                break;
-            case 2: // body
-                printf("\033[0;92m* \033[0m");
-                break;
-            case 3: // apple
-                printf("\033[0;91m@ \033[0m");
-                break;
-            default:
-                printf("  ");
-                break;
-            }
-        }
-
-        // print right bar
-        printf("| \n");
-    }
-    
-    // print bottom bar
-    printf("   ");
-    for (int i = 0; i<dim; i++){
-        printf("- ");
-    }
-    printf("\n\n");
-    return;
-}
-
-
-/*
- * print_env_set - Prints a given number of env in a set
+ * print_ann_run_replay - Runs and renders a snake game replay from a highscore snapshot (genome and game record)
  */
-static void print_env_set(int dim, int n, env_set *src)
-{
-    int image_data[(dim*dim)];
-    snake_node *curr;
-
-    // prints every set member
-    for (int e = 0; e < n; e++){
-        // wipe image data array for every set member
-        for (int i = 0; i < dim; i++){
-            for (int j = 0; j < dim; j++){ image_data[RIDX(i,j,dim)] = 0;}
-        }
-        
-        // record current apple in image data
-        image_data[RIDX(((src->data[e].a->y) - 1), ((src->data[e].a->x) - 1), dim)] = 3;
-        
-        // record snake head if alive in image data
-        curr = src->data[e].h;
-        if (src->data[e].alive) { image_data[RIDX(((curr->y) - 1),((curr->x) - 1),dim)] = 1; }
-        
-        // record snake body nodes in image data
-        while (curr->c != NULL) {
-            curr = curr->c;
-            image_data[RIDX(((curr->y)-1),((curr->x)-1),dim)] = 2;
-        }
-        
-        // pass image data to the print env function to display the game board
-        print_env(dim, (int *) &image_data);
-    }
-    return;
-}
-
-
-/*
- * print_ann_run_replay - Runs and prints a snake game replay with a given ann and env struct
- */
-static void print_ann_run_replay(ann *a_src, env *e_src)
+void print_ann_run_replay(replay_snapshot *snap, renderer *r)
 {
     // set up temp run memory
     int n = 0;
+    int curr_a = 1;
+    int curr_m = 0;
+    char text[MAX_LINE_SIZE];
     env_set *tmp_env_s = (env_set *) malloc(sizeof(env_set));
     ann_set *tmp_ann_s = (ann_set *) malloc(sizeof(ann_set));
     int *tmp_action_set = (int *) malloc(sizeof(int));
-    apple_data *curr_a = e_src->a_data->next_apple;
-    move_data *curr_m = e_src->m_data;
    
     // init and copy set memory
-    init_env_set(tmp_env_s, 1, e_src->env_dim);
-    init_ann_set(tmp_ann_s, 1, a_src->num_l, a_src->shape, a_src->A);
-    copy_parameters(a_src, &tmp_ann_s->data[0]);
+    init_env_set(tmp_env_s, 1, snap->env_dim);
+    init_ann_set(tmp_ann_s, 1, snap->net.num_l, snap->net.shape, snap->net.A);
+    copy_parameters(&snap->net, &tmp_ann_s->data[0]);
    
    // setup first apple
-    tmp_env_s->data[0].a->x = e_src->a_data->x;
-    tmp_env_s->data[0].a->y = e_src->a_data->y;
-    
-    // get first move from the end of the move struct linked list
-    while (curr_m->prev_move != NULL) { curr_m = curr_m->prev_move; }
+    tmp_env_s->data[0].a->x = snap->apple_xy[0];
+    tmp_env_s->data[0].a->y = snap->apple_xy[1];
+
+    if (snap->island != NOT_FOUND) { snprintf(text, sizeof(text), "--  replay of the [ISLAND %d GEN %d] highscore  --", snap->island, snap->gen + 1); }
+    else { snprintf(text, sizeof(text), "--  replay of the [GEN %d] highscore  --", snap->gen + 1); }
+    render_begin(r, text);
 
-    // print ann run in env
+    // render ann run in env
     do {
-        // print the game board
-        printf("apples:  %d   |   moves:  %d\n", tmp_env_s->data[0].n, tmp_env_s->data[0].m);
-        print_env_set(e_src->env_dim, 1, tmp_env_s);
+        // render the game board
+        snprintf(text, sizeof(text), "apples:  %d   |   moves:  %d", tmp_env_s->data[0].n, tmp_env_s->data[0].m);
+        render_frame(r, &tmp_env_s->data[0], text);
 
         // run coupled ann/env struct once
         run_ann_set(tmp_ann_s, tmp_action_set, tmp_env_s->dist_d);
-        run_env_set(tmp_env_s, &curr_m->action);
+        run_env_set(tmp_env_s, &snap->actions[curr_m]);
         
         // set next replay apple if current apple was eaten
-        if (n != tmp_env_s->data[0].n) {
+        if ((n != tmp_env_s->data[0].n) && (curr_a < snap->num_apples)) {
             n = tmp_env_s->data[0].n;
-            tmp_env_s->data[0].a->x = curr_a->x;
-            tmp_env_s->data[0].a->y = curr_a->y;
-            curr_a = curr_a->next_apple;
+            tmp_env_s->data[0].a->x = snap->apple_xy[2 * curr_a];
+            tmp_env_s->data[0].a->y = snap->apple_xy[2 * curr_a + 1];
+            curr_a++;
         }
 
         // increment move
-        curr_m = curr_m->next_move;
+        curr_m++;
 
-        // sleep between env frames
-        if (e_src->m < 200) {
+        // sleep between env frames (headless replays render as fast as they can)
+        if (r->headless) {
+            continue;
+        } else if (snap->num_moves < 200) {
             usleep(REPLAY_TIME_5);
-        } else if (e_src->m < 800) {
+        } else if (snap->num_moves < 800) {
             usleep(REPLAY_TIME_4);
-        } else if (e_src->m < 1400) {
+        } else if (snap->num_moves < 1400) {
             usleep(REPLAY_TIME_3);
-        } else if (e_src->m < 2000) {
+        } else if (snap->num_moves < 2000) {
             usleep(REPLAY_TIME_2);
         } else {
             usleep(REPLAY_TIME_1);
         }
-    } while ((tmp_env_s->is_active) && (curr_m != NULL)); // exit if it is the last move or if the snake died
+    } while ((tmp_env_s->is_active) && (curr_m < snap->num_moves)); // exit if it is the last move or if the snake died
    
-    // print the final game board
-    printf("apples:  %d   |   moves:  %d        :( \n", tmp_env_s->data[0].n, tmp_env_s->data[0].m);
-    print_env_set(e_src->env_dim, 1, tmp_env_s);
-    
-    // print cause of death
+    // render the final game board
+    snprintf(text, sizeof(text), "apples:  %d   |   moves:  %d        :( ", tmp_env_s->data[0].n, tmp_env_s->data[0].m);
+    render_frame(r, &tmp_env_s->data[0], text);
+    render_end(r);
+
+    // cause of death and final stats
     if (tmp_env_s->data[0].m_n > MAX_MOVES_PER_APPLE) {
-        printf("\n Snake ran out of moves (%d without next apple)\n", (int) MAX_MOVES_PER_APPLE);
+        n = snprintf(text, sizeof(text), "\n Snake ran out of moves (%d without next apple)\n", (int) MAX_MOVES_PER_APPLE);
     } else {
-        printf("\n Snake made a bad move\n\n");
+        n = snprintf(text, sizeof(text), "\n Snake made a bad move\n\n");
     }
-
-    // print final stats
-    printf("    moves: %d\n", tmp_env_s->data[0].m);
-    printf("    apples eaten: %d\n\n\n", tmp_env_s->data[0].n);
-    printf("    moves this apple: %d\n", tmp_env_s->data[0].m_n);
+    snprintf(text + n, sizeof(text) - n, "    moves: %d\n    apples eaten: %d\n\n\n    moves this apple: %d\n", 
+        tmp_env_s->data[0].m, tmp_env_s->data[0].n, tmp_env_s->data[0].m_n);
+    render_text(r, text);
 
     // check if there is an inconsistency error in the reply and exit if so
-    if (tmp_env_s->data[0].n != e_src->n) {
+    if (tmp_env_s->data[0].n != snap->apples) {
         printf("\n\nERR: inconsistent number of replay apples eaten\n\n\n");
         exit(127);
     }
@@ -263,31 +224,340 @@ static void print_ann_run_replay(ann *a_src, env *e_src)
 
 
 /*
- * print_gen_stats - Prints the metrics and replays for a generation
+ * print_gen_stats - Prints the metrics and replays for a generation from its merged game stats
  */ 
-void print_gen_stats(int gen_n, int *highscore, ann_set *ann_s, env_set *env_s, int print_replay) 
+void print_gen_stats(int gen_n, int island, int *highscore, gen_stats *stats, ann_set *ann_s, env_set *env_s, replay_viewer *viewer) 
 {
-    // find highscoring snake
-    int highscore_idx = 0;
-    for (int i = 0; i < env_s->num_env; i++) {
-        highscore_idx = (env_s->data[i].n > env_s->data[highscore_idx].n)? i: highscore_idx;
-    }
+    int highscore_idx = stats->best_idx;
 
     // print pop stats every print batch generation
     if ((gen_n + 1) % PRINT_BATCH == 0) {
-        printf(":: GEN %d ::  ", gen_n + 1);
-        print_pop_stats(ann_s, env_s);
+        if (island != NOT_FOUND) { printf(":: ISLAND %d GEN %d ::  ", island, gen_n + 1); }
+        else { printf(":: GEN %d ::  ", gen_n + 1); }
+        print_pop_stats(stats);
     }
 
     // print highscoring stats if there is a new highscore
-    if (env_s->data[highscore_idx].n > *highscore) {
-        *highscore = env_s->data[highscore_idx].n;
-        printf("\033[0;32m--  [GEN %d] New Highscore:  %d  --\033[0m\n", gen_n + 1, *highscore);
+    if (stats->max_apples > *highscore) {
+        *highscore = stats->max_apples;
+        if (island != NOT_FOUND) { printf("\033[0;32m--  [ISLAND %d GEN %d] New Highscore:  %d  --\033[0m\n", island, gen_n + 1, *highscore); }
+        else { printf("\033[0;32m--  [GEN %d] New Highscore:  %d  --\033[0m\n", gen_n + 1, *highscore); }
 
-        // print highscore replay
-        if ((print_replay) && (*highscore >= print_replay)) {
-            print_ann_run_replay(&ann_s->data[highscore_idx], &env_s->data[highscore_idx]);
-        }
+        // hand the highscore replay to the viewer thread
+        submit_replay(viewer, gen_n, island, &ann_s->data[highscore_idx], &env_s->data[highscore_idx]);
+    }
+    return;
+}
+
+
+/*
+ * print_phase_claim - Prints the claim and contention counters of a single snake controller phase summed over every thread
+ */
+static void print_phase_claim(const char *phase, int id, thread_data *t_data)
+{
+    long claims = 0;
+    long targets = 0;
+    long contention = 0;
+
+    for (int t = 0; t < t_data->params->num_threads; t++) {
+        claims += t_data->threads[t].claims[id];
+        targets += t_data->threads[t].targets[id];
+        contention += t_data->threads[t].contention[id];
+    }
+
+    printf("  %-8s  claims - %ld, avg chunk - %0.2f, contended - %ld (%0.2f%%)\n", phase, claims, 
+        (claims)? (double) targets / claims: 0.0, contention, (claims)? 100.0 * contention / claims: 0.0);
+    return;
+}
+
+
+/*
+ * print_claim_stats - Prints the target claim counters of every snake controller phase
+ */
+void print_claim_stats(thread_data *t_data)
+{
+    printf("\n+++++++  TARGET CLAIMS  +++++++\n\n");
+    if (t_data->params->schedule == SCHEDULE_INDEX) { print_phase_claim("RUN", CLAIM_RUN, t_data); }
+    print_phase_claim("SPAWN", CLAIM_SPAWN, t_data);
+
+    // print run schedule totals
+    printf("\n+++++++  RUN SCHEDULE  +++++++\n\n");
+    printf("  SCHEDULE  %s\n", (t_data->params->schedule == SCHEDULE_LONGEST)? "LONGEST FIRST": "INDEX ORDER");
+    printf("  AFFINITY  %s\n", (t_data->params->affinity == AFFINITY_COMPACT)? "COMPACT": (t_data->params->affinity == AFFINITY_SCATTER)? "SCATTER": "NONE");
+    printf("  STEALS    %ld\n", t_data->total_steals);
+    printf("  AVG STRAGGLER IDLE  %0.2f%%\n", t_data->total_idle_pct / (t_data->ann_s->gen + 1));
+    return;
+}
+
+
+/*
+ * print_sched_stats - Prints the run phase time and straggler idle time of a generation every print batch generation
+ */
+void print_sched_stats(int gen_n, thread_data *t_data)
+{
+    if ((gen_n + 1) % PRINT_BATCH != 0) { return; }
+    printf("               run phase - %0.2f ms, straggler idle - %0.2f%% (%0.2f thread ms), steals - %ld \n", 
+        1000.0 * t_data->run_t, t_data->idle_pct, 1000.0 * t_data->idle_t, t_data->gen_steals);
+    return;
+}
+
+
+/*
+ * print_island_stats - Prints the schedule totals of every island and the migration counters of an island model
+ */
+void print_island_stats(island_set *isl)
+{
+    thread_data *t_data;
+
+    printf("\n+++++++  ISLANDS  +++++++\n\n");
+    for (int i = 0; i < isl->num_islands; i++) {
+        t_data = &isl->islands[i];
+        printf("  ISLAND %-3d  highscore - %d, steals - %ld, avg straggler idle - %0.2f%%\n", i, t_data->highscore, 
+            t_data->total_steals, t_data->total_idle_pct / (t_data->ann_s->gen + 1));
+    }
+    printf("\n  MIGRANTS  sent - %ld, received - %ld, dropped - %ld\n", atomic_load(&isl->sent), 
+        atomic_load(&isl->received), atomic_load(&isl->dropped));
+    return;
+}
+
+
+/*
+ * print_profile - Prints the time of every profiled phase summed over threads and the busy, barrier and mutex time of every thread
+ */
+void print_profile(profiler *prof)
+{
+    const char *names[NUM_PROF] = { "RUN", "RESET", "INFERENCE", "ENV STEP", "FITNESS", "SPAWN", "BARRIER", "MUTEX", "SELECT", "STATS", "SCHEDULE" };
+    prof_totals totals = { { 0 }, 0, 0 };
+    double *total = totals.t;
+    double budget = (get_time() - prof->start_t) * prof->num_threads;
+    long gens = prof->threads[prof->num_threads].ct[PROF_STATS];
+    long games;
+    prof_thread *pt;
+
+    // sum every thread's phases
+    sum_profile(prof, &totals);
+    games = totals.games;
+
+    if (prof->island != NOT_FOUND) { printf("\n+++++++  ISLAND %d PROFILE  +++++++\n\n", prof->island); }
+    else { printf("\n+++++++  PROFILE  +++++++\n\n"); }
+    printf("  %-10s  %12s  %10s  %7s\n", "PHASE", "THREAD MS", (gens)? "MS / GEN": "US / GAME", "SHARE");
+    for (int p = 0; p < NUM_PROF; p++) {
+        if (total[p] == 0) continue;
+        printf("  %-10s  %12.2f  %10.3f  %6.2f%%%s\n", names[p], 1e3 * total[p], (gens)? 1e3 * total[p] / gens: (games)? 1e6 * total[p] / games: 0.0,
+            (budget > 0)? 100.0 * total[p] / budget: 0.0, ((p == PROF_INFER) || (p == PROF_ENV))? "  (sampled)": "");
+    }
+
+    // busy is time spent running and spawning, so a straggler shows as busy while the others wait on the barrier
+    printf("\n  %-10s  %12s  %12s  %12s  %10s\n", "THREAD", "BUSY MS", "BARRIER MS", "MUTEX MS", (gens)? "GAMES/GEN": "GAMES");
+    for (int t = 0; t < prof->num_threads; t++) {
+        pt = &prof->threads[t];
+        printf("  %-10d  %12.2f  %12.2f  %12.2f  %10.1f\n", t, 1e3 * (pt->t[PROF_RUN] + pt->t[PROF_SPAWN]), 1e3 * pt->t[PROF_BARRIER], 
+            1e3 * pt->t[PROF_MUTEX], (gens)? (double) pt->games / gens: (double) pt->games);
+    }
+    return;
+}
+
+
+/*
+ * print_perf_phase - Prints the derived hardware counter metrics of a phase's counts per unit of work (n/a for unavailable counters)
+ */
+static void print_perf_phase(perf_counters *perf, const char *phase, const char *unit, double *ct, double units)
+{
+    int has[NUM_PERF];
+    for (int c = 0; c < NUM_PERF; c++) { has[c] = (atomic_load(&perf->missing[c]) == 0); }
+    if (units <= 0) { return; }
+
+    printf("%s", phase);
+    if (has[PERF_CYCLES] && has[PERF_INSTR] && (ct[PERF_CYCLES] > 0)) { printf("IPC %0.2f, ", ct[PERF_INSTR] / ct[PERF_CYCLES]); } else { printf("IPC n/a, "); }
+    if (has[PERF_CYCLES]) { printf("cycles/%s %0.0f, ", unit, ct[PERF_CYCLES] / units); } else { printf("cycles/%s n/a, ", unit); }
+    if (has[PERF_LLC_MISS]) { printf("llc misses/%s %0.3f, ", unit, ct[PERF_LLC_MISS] / units); } else { printf("llc misses/%s n/a, ", unit); }
+    if (has[PERF_BRANCH_MISS]) { printf("branch misses/%s %0.3f\n", unit, ct[PERF_BRANCH_MISS] / units); } else { printf("branch misses/%s n/a\n", unit); }
+    return;
+}
+
+
+/*
+ * print_perf_stats - Prints the hardware counter metrics of a generation's run and spawn phases every print batch generation
+ */
+void print_perf_stats(int gen_n, perf_counters *perf)
+{
+    int missing = 0;
+    if ((perf == NULL) || ((gen_n + 1) % PRINT_BATCH != 0)) { return; }
+
+    // the missing counters were reported once at the start
+    for (int c = 0; c < NUM_PERF; c++) { if (atomic_load(&perf->missing[c]) > 0) { missing++; } }
+    if (missing == NUM_PERF) { return; }
+    print_perf_phase(perf, "               run counters - ", "step", perf->gen[PERF_PHASE_RUN], perf->gen_units[PERF_PHASE_RUN]);
+    print_perf_phase(perf, "               spawn counters - ", "child", perf->gen[PERF_PHASE_SPAWN], perf->gen_units[PERF_PHASE_SPAWN]);
+    return;
+}
+
+
+/*
+ * print_perf_summary - Prints the hardware counter metrics of the whole run
+ */
+void print_perf_summary(perf_counters *perf)
+{
+    double *run;
+    int missing = 0;
+
+    if (perf == NULL) { return; }
+    run = perf->total[PERF_PHASE_RUN];
+    for (int c = 0; c < NUM_PERF; c++) { if (atomic_load(&perf->missing[c]) > 0) { missing++; } }
+
+    if (perf->island != NOT_FOUND) { printf("\n+++++++  ISLAND %d HARDWARE COUNTERS  +++++++\n\n", perf->island); }
+    else { printf("\n+++++++  HARDWARE COUNTERS  +++++++\n\n"); }
+    if (missing == NUM_PERF) {
+        printf("  UNAVAILABLE (%s)\n", strerror(atomic_load(&perf->open_errno)));
+        return;
+    }
+    print_perf_phase(perf, "  RUN     ", "step", run, perf->total_units[PERF_PHASE_RUN]);
+    print_perf_phase(perf, "  SPAWN   ", "child", perf->total[PERF_PHASE_SPAWN], perf->total_units[PERF_PHASE_SPAWN]);
+
+    // misses per thousand instructions compare across population sizes and game lengths
+    if ((atomic_load(&perf->missing[PERF_INSTR]) == 0) && (run[PERF_INSTR] > 0)) {
+        printf("  RUN     instructions/step %0.0f", run[PERF_INSTR] / perf->total_units[PERF_PHASE_RUN]);
+        if (atomic_load(&perf->missing[PERF_LLC_MISS]) == 0) { printf(", llc mpki %0.3f", 1e3 * run[PERF_LLC_MISS] / run[PERF_INSTR]); }
+        if (atomic_load(&perf->missing[PERF_BRANCH_MISS]) == 0) { printf(", branch mpki %0.3f", 1e3 * run[PERF_BRANCH_MISS] / run[PERF_INSTR]); }
+        printf("\n");
+    }
+    return;
+}
+
+
+/*
+ * print_mem_stats - Prints the live and peak heap bytes of every subsystem in a run's account (a run without one prints nothing)
+ */
+void print_mem_stats(mem_account *acct)
+{
+    if (acct == NULL) { return; }
+    printf("               memory - live %0.1f MB, peak %0.1f MB (genomes %0.1f, activations %0.1f, env %0.1f, trajectories %0.1f, threads %0.1f, buffers %0.1f MB) \n",
+        mem_live(acct, NUM_MEM) / 1048576.0, mem_peak(acct, NUM_MEM) / 1048576.0, mem_live(acct, MEM_GENOMES) / 1048576.0, mem_live(acct, MEM_ACTIVATIONS) / 1048576.0,
+        mem_live(acct, MEM_ENV) / 1048576.0, mem_live(acct, MEM_TRAJECTORY) / 1048576.0, mem_live(acct, MEM_THREADS) / 1048576.0, mem_live(acct, MEM_BUFFERS) / 1048576.0);
+    return;
+}
+
+
+/*
+ * print_mem_summary - Prints the estimated and peak heap bytes of every subsystem in a run's account after the run
+ */
+void print_mem_summary(gs_params *params, mem_account *acct)
+{
+    const char *names[NUM_MEM] = { "GENOMES", "ACTIVATIONS", "ENV", "TRAJECTORIES", "THREADS", "BUFFERS" };
+    long est[NUM_MEM];
+    long est_total;
+
+    if (acct == NULL) { return; }
+    est_total = estimate_footprint(params, est);
+    printf("\n+++++++  MEMORY  +++++++\n\n");
+    printf("  %-12s  %12s  %12s\n", "SUBSYSTEM", "ESTIMATE MB", "PEAK MB");
+    for (int s = 0; s < NUM_MEM; s++) { printf("  %-12s  %12.2f  %12.2f\n", names[s], est[s] / 1048576.0, mem_peak(acct, s) / 1048576.0); }
+    printf("  %-12s  %12.2f  %12.2f\n", "TOTAL", est_total / 1048576.0, mem_peak(acct, NUM_MEM) / 1048576.0);
+    if ((params->memory_budget > 0) && (mem_peak(acct, NUM_MEM) > (params->memory_budget << 20))) {
+        printf("\nWARN: peak %0.1f MB went over MEMORY_BUDGET %ld MB (games ran longer than the estimate assumes)\n", mem_peak(acct, NUM_MEM) / 1048576.0, params->memory_budget);
+    }
+    return;
+}
+
+
+/*
+ * print_farm_stats - Prints the stats and worker traffic of a farmed generation every print batch generation
+ */
+void print_farm_stats(int gen_n, farm *f)
+{
+    if ((gen_n + 1) % PRINT_BATCH != 0) { return; }
+    printf(":: GEN %d ::  ", gen_n + 1);
+    print_pop_stats(&f->stats);
+    printf("               workers - %d, sent - %0.1f KB, received - %0.1f KB, requeued - %ld, local games - %ld \n", f->num_workers, 
+        f->bytes_sent / 1024.0, f->bytes_recv / 1024.0, f->requeued, f->local_games);
+    return;
+}
+
+
+/*
+ * print_farm_summary - Prints the worker and traffic totals of a farm coordinator
+ */
+void print_farm_summary(farm *f)
+{
+    printf("\n+++++++  FARM  +++++++\n\n");
+    printf("  WORKERS   joined - %ld, lost - %ld, connected - %d\n", f->joined, f->lost, f->num_workers);
+    printf("  BATCHES   requeued - %ld, local games - %ld\n", f->requeued, f->local_games);
+    printf("  TRAFFIC   sent - %0.1f KB, received - %0.1f KB\n", f->bytes_sent / 1024.0, f->bytes_recv / 1024.0);
+    return;
+}
+
+
+/*
+ * print_eval_stats - Prints the averages of a steady-state report window of evaluations
+ */
+void print_eval_stats(eval_stats *report)
+{
+    printf(":: EVAL %ld ::  avg fitness - %f, avg moves - %f, avg apples - %f \n", report->evals, 
+        report->fitness / report->ct, report->moves / report->ct, report->apples / report->ct);
+    printf("               survivor min fitness - %f, evals/sec - %0.1f \n", report->min_surv_fitness, 
+        (report->elapsed_t > 0)? report->ct / report->elapsed_t: 0.0);
+    return;
+}
+
+/*
+ * print_scale_results - Prints the throughput and scaling of every scaling grid cell and where its thread time went
+ */
+void print_scale_results(scale_cell *cells, int num_cells)
+{
+    scale_cell *cell;
+    double budget;
+
+    printf("\n\n+++++++  SCALING  +++++++\n\n");
+    printf("  %-7s  %9s  %9s  %9s  %12s  %7s  %10s  %8s\n", "THREADS", "POP_WIDTH", "SECONDS", "GENS/S", "STEPS/S", "SPEEDUP", "EFFICIENCY", "WEAK EFF");
+    for (int c = 0; c < num_cells; c++) {
+        cell = &cells[c];
+        printf("  %-7d  %9d  %9.2f  %9.2f  %12.0f", cell->threads, cell->pop_size, cell->wall_t, cell->gens / cell->wall_t, cell->totals.moves / cell->wall_t);
+        if (cell->speedup != NOT_SET) { printf("  %7.2f  %9.1f%%", cell->speedup, 100.0 * cell->efficiency); } else { printf("  %7s  %10s", "-", "-"); }
+        if (cell->weak_efficiency != NOT_SET) { printf("  %7.1f%%\n", 100.0 * cell->weak_efficiency); } else { printf("  %8s\n", "-"); }
+    }
+
+    // share of every cell's thread time (wall time x threads) by phase, serial steps together
+    printf("\n  %-7s  %9s  %9s  %9s  %9s  %9s  %9s\n", "THREADS", "POP_WIDTH", "RUN", "SPAWN", "BARRIER", "MUTEX", "SERIAL");
+    for (int c = 0; c < num_cells; c++) {
+        cell = &cells[c];
+        budget = cell->wall_t * cell->threads / 100.0;
+        printf("  %-7d  %9d  %8.2f%%  %8.2f%%  %8.2f%%  %8.2f%%  %8.2f%%\n", cell->threads, cell->pop_size, cell->totals.t[PROF_RUN] / budget,
+            cell->totals.t[PROF_SPAWN] / budget, cell->totals.t[PROF_BARRIER] / budget, cell->totals.t[PROF_MUTEX] / budget,
+            (cell->totals.t[PROF_SELECT] + cell->totals.t[PROF_STATS] + cell->totals.t[PROF_SCHED]) / budget);
+    }
+    return;
+}
+
+
+/*
+ * print_sweep_results - Prints the sweep runs in rank order with their share of the pool's thread time (and the generations early stopping saved)
+ */
+void print_sweep_results(sweep *sw, int *rank)
+{
+    sweep_run *run;
+    char shape[MAX_STR_SIZE];
+    long total_ns = 0, gens = 0;
+    int num_stopped = 0;
+
+    for (int r = 0; r < sw->num_runs; r++) {
+        total_ns += atomic_load(&sw->runs[r].busy_ns);
+        gens += sw->runs[r].gens;
+        num_stopped += (sw->runs[r].stopped != NOT_FOUND);
+    }
+    printf("\n\n+++++++  SWEEP RANKING  +++++++\n\n");
+    printf("  %-4s  %-3s  %9s  %7s  %7s  %-16s  %5s  %9s  %12s  %7s  %9s  %9s  %6s\n", "RANK", "RUN", "POP_WIDTH", "MUTATE", "SURVIVE", "LAYERS",
+        "GENS", "FITNESS", "BEST FIT", "APPLES", "HIGHSCORE", "SECONDS", "SHARE");
+    for (int i = 0; i < sw->num_runs; i++) {
+        run = &sw->runs[rank[i]];
+        sweep_shape_str(&run->params, shape, sizeof(shape));
+        printf("  %-4d  %-3d  %9d  %7.3f  %7.3f  %-16s  %5d  %9.2f  %12.2f  %7.2f  %9d  %9.2f  %5.1f%%\n", i + 1, rank[i], run->params.pop_size, run->params.mutate,
+            run->params.survive, shape, run->gens, run->final_fitness, run->best_fitness, run->final_apples, run->t_data.highscore, run->end_t - run->start_t,
+            (total_ns)? 100.0 * atomic_load(&run->busy_ns) / total_ns: 0);
+    }
+    printf("\n  %d runs in %0.2f s on %d threads\n", sw->num_runs, sw->wall_t, sw->num_threads);
+    if (sw->num_rungs) {
+        printf("  ASHA stopped %d runs early, running %ld of %ld generations (%0.1f%%)\n", num_stopped, gens, (long) sw->num_runs * sw->params->gen_ct,
+            100.0 * gens / ((long) sw->num_runs * sw->params->gen_ct));
     }
     return;
-}
\ No newline at end of file
+}
@@ -0,0 +1,185 @@
+//
+//  gsprof.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "gsdefs.h"
+
+static const char *phase_names[NUM_PROF] = { "run", "reset", "inference", "env step", "fitness", "spawn", "barrier wait", "mutex wait", "select", "stats", "schedule" };
+
+
+/*
+ * init_profiler - Allocates a profiler for a number of threads (plus a serial step track) and returns NULL if profiling is off
+ */
+profiler * init_profiler(gs_params *params, int num_threads, int island)
+{
+    profiler *prof;
+    if (!params->profile) { return NULL; }
+
+    prof = (profiler *) malloc(sizeof(profiler));
+    prof->num_threads = num_threads;
+    prof->island = island;
+    prof->trace_file = NULL;
+    prof->start_t = get_time();
+    prof->last_serial_t = 0;
+    if (posix_memalign((void **) &prof->threads, CACHE_LINE, (num_threads + 1) * sizeof(prof_thread)) != 0) {
+        printf("\n\nERR: could not allocate profiler threads\n");
+        exit(127);
+    }
+    memset(prof->threads, 0, (num_threads + 1) * sizeof(prof_thread));
+
+    // trace events are only kept when a trace file is requested
+    if (params->trace_file[0] != '\0') {
+        prof->trace_file = params->trace_file;
+        for (int t = 0; t <= num_threads; t++) { prof->threads[t].events = (prof_event *) malloc(PROF_MAX_EVENTS * sizeof(prof_event)); }
+        mem_add(MEM_BUFFERS, (num_threads + 1) * mem_chunk(PROF_MAX_EVENTS * sizeof(prof_event)));
+    }
+    return prof;
+}
+
+
+/*
+ * free_profiler - Frees a profiler and its trace events
+ */
+void free_profiler(profiler *prof)
+{
+    if (prof == NULL) { return; }
+    if (prof->trace_file != NULL) { mem_add(MEM_BUFFERS, -(prof->num_threads + 1) * mem_chunk(PROF_MAX_EVENTS * sizeof(prof_event))); }
+    for (int t = 0; t <= prof->num_threads; t++) { free(prof->threads[t].events); }
+    free(prof->threads);
+    free(prof);
+    return;
+}
+
+
+/*
+ * prof_add - Adds a timed phase to a thread (num_threads for serial steps) and records a trace event for it unless the gen is NOT_FOUND
+ */
+void prof_add(profiler *prof, int tid, int phase, double start_t, double end_t, int gen, long ct)
+{
+    prof_thread *pt = &prof->threads[tid];
+    prof_event *ev;
+
+    pt->t[phase] += end_t - start_t;
+    pt->ct[phase]++;
+    if ((pt->events == NULL) || (gen == NOT_FOUND)) { return; }
+    if (pt->num_events == PROF_MAX_EVENTS) {
+        pt->dropped_events++;
+        return;
+    }
+    ev = &pt->events[pt->num_events++];
+    ev->start_t = start_t;
+    ev->end_t = end_t;
+    ev->phase = phase;
+    ev->gen = gen;
+    ev->ct = ct;
+    return;
+}
+
+
+/*
+ * prof_lock - Locks a mutex, timing the wait only when it is contended
+ */
+void prof_lock(profiler *prof, int tid, pthread_mutex_t *lock)
+{
+    double start_t;
+    if ((prof == NULL) || (pthread_mutex_trylock(lock) == 0)) {
+        if (prof == NULL) { pthread_mutex_lock(lock); }
+        return;
+    }
+    start_t = get_time();
+    pthread_mutex_lock(lock);
+    prof_add(prof, tid, PROF_MUTEX, start_t, get_time(), NOT_FOUND, 0);
+    return;
+}
+
+
+/*
+ * write_trace - Writes the trace events of every profiler as Chrome/Perfetto trace JSON (one process per island, one track per thread)
+ */
+static void write_trace(profiler **profs, int num_profs, const char *file_name)
+{
+    FILE *file = fopen(file_name, "w");
+    double start_t = profs[0]->start_t;
+    prof_thread *pt;
+    prof_event *ev;
+    int first = 1;
+    long dropped = 0;
+
+    if (file == NULL) {
+        perror(file_name);
+        return;
+    }
+    for (int p = 0; p < num_profs; p++) { if (profs[p]->start_t < start_t) { start_t = profs[p]->start_t; } }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (int p = 0; p < num_profs; p++) {
+        for (int t = 0; t <= profs[p]->num_threads; t++) {
+            pt = &profs[p]->threads[t];
+            dropped += pt->dropped_events;
+
+            // track names
+            fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": ",
+                (first)? "": ",\n", p, t);
+            if (t == profs[p]->num_threads) { fprintf(file, "\"serial steps\"}}"); }
+            else { fprintf(file, "\"thread %d\"}}", t); }
+            first = 0;
+
+            for (int i = 0; i < pt->num_events; i++) {
+                ev = &pt->events[i];
+                fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %0.3f, \"dur\": %0.3f, \"args\": {\"gen\": %d, \"ct\": %ld}}",
+                    phase_names[ev->phase], p, t, 1e6 * (ev->start_t - start_t), 1e6 * (ev->end_t - ev->start_t), ev->gen + 1, ev->ct);
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("\n  TRACE     %s", file_name);
+    if (dropped) { printf(" (%ld events dropped past %d per thread)", dropped, (int) PROF_MAX_EVENTS); }
+    printf("\n");
+    return;
+}
+
+
+/*
+ * sum_profile - Adds the phase times, games and moves of every thread of a profiler to a totals struct
+ */
+void sum_profile(profiler *prof, prof_totals *totals)
+{
+    prof_thread *pt;
+
+    // move loops are split into inference and env steps by the ratio of the sampled games
+    for (int t = 0; t <= prof->num_threads; t++) {
+        pt = &prof->threads[t];
+        totals->games += pt->games;
+        totals->moves += pt->moves;
+        for (int p = 0; p < NUM_PROF; p++) { totals->t[p] += pt->t[p]; }
+        if (pt->infer_t + pt->env_t > 0) {
+            totals->t[PROF_INFER] += pt->loop_t * pt->infer_t / (pt->infer_t + pt->env_t);
+            totals->t[PROF_ENV] += pt->loop_t * pt->env_t / (pt->infer_t + pt->env_t);
+        }
+    }
+    return;
+}
+
+
+/*
+ * finish_profile - Prints the profile summary of every profiler, sums them into the run's totals (if given) and writes the trace file if one was requested
+ */
+void finish_profile(profiler **profs, int num_profs, prof_totals *totals)
+{
+    if ((num_profs == 0) || (profs[0] == NULL)) { return; }
+    for (int p = 0; p < num_profs; p++) {
+        print_profile(profs[p]);
+        if (totals != NULL) { sum_profile(profs[p], totals); }
+    }
+    if (profs[0]->trace_file != NULL) { write_trace(profs, num_profs, profs[0]->trace_file); }
+    return;
+}
@@ -0,0 +1,260 @@
+//
+//  gsrender.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "gsdefs.h"
+
+// board cells
+#define CELL_EMPTY 0
+#define CELL_HEAD 1
+#define CELL_BODY 2
+#define CELL_APPLE 3
+
+// terminal layout: status line, top bar, board rows, bottom bar, then the scrolling region for other output
+#define ROW_STATUS 1
+#define ROW_BOARD 3
+#define COL_BOARD 4
+
+
+/*
+ * put_str - Appends a string to the frame buffer
+ */
+static void put_str(renderer *r, const char *str)
+{
+    size_t len = strlen(str);
+    memcpy(r->buf + r->len, str, len);
+    r->len += len;
+    return;
+}
+
+
+/*
+ * put_cell - Appends the glyph of a board cell to the frame buffer (colored on terminals)
+ */
+static void put_cell(renderer *r, unsigned char cell)
+{
+    if (r->headless) {
+        put_str(r, (cell == CELL_HEAD)? "# ": (cell == CELL_BODY)? "* ": (cell == CELL_APPLE)? "@ ": "  ");
+    } else {
+        put_str(r, (cell == CELL_HEAD)? "\033[0;92m# \033[0m": (cell == CELL_BODY)? "\033[0;92m* \033[0m": (cell == CELL_APPLE)? "\033[0;91m@ \033[0m": "  ");
+    }
+    return;
+}
+
+
+/*
+ * put_bar - Appends a top or bottom board bar to the frame buffer
+ */
+static void put_bar(renderer *r)
+{
+    put_str(r, "   ");
+    for (int i = 0; i < r->dim; i++) { put_str(r, "- "); }
+    return;
+}
+
+
+/*
+ * flush_frame - Sends the frame buffer in a single write (looping only on a short write)
+ */
+static void flush_frame(renderer *r)
+{
+    ssize_t n;
+    size_t off = 0;
+
+    // anything the trainer printed has to land before the frame
+    if (r->fd == STDOUT_FILENO) { fflush(stdout); }
+    while (off < r->len) {
+        n = write(r->fd, r->buf + off, r->len - off);
+        if (n <= 0) break;
+        off += n;
+    }
+    r->len = 0;
+    return;
+}
+
+
+/*
+ * draw_grid - Draws the snake and apple of an env into the current board cells
+ */
+static void draw_grid(renderer *r, env *e)
+{
+    snake_node *curr = e->h;
+    int dim = r->dim;
+
+    memset(r->cur, CELL_EMPTY, dim * dim);
+    r->cur[RIDX((e->a->y - 1), (e->a->x - 1), dim)] = CELL_APPLE;
+    if (e->alive) { r->cur[RIDX((curr->y - 1), (curr->x - 1), dim)] = CELL_HEAD; }
+    while (curr->c != NULL) {
+        curr = curr->c;
+        r->cur[RIDX((curr->y - 1), (curr->x - 1), dim)] = CELL_BODY;
+    }
+    return;
+}
+
+
+/*
+ * create_renderer - Preallocates a replay renderer for a board size, drawing to the terminal or headless to a file (NULL file means stdout), returns GS_OK or the reason it could not in err
+ */
+int create_renderer(renderer *r, int dim, const char *file, char *err, size_t size)
+{
+    r->dim = dim;
+    r->fd = STDOUT_FILENO;
+    r->headless = !isatty(STDOUT_FILENO);
+    if ((file != NULL) && (file[0] != '\0')) {
+        r->fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (r->fd < 0) {
+            snprintf(err, size, "%s: %s", file, strerror(errno));
+            return GS_ERR_IO;
+        }
+        r->headless = 1;
+    }
+
+    // worst case frame: every cell with its cursor address and colors, plus bars and the status line
+    r->buf_size = (size_t) dim * dim * 32 + (size_t) dim * 16 + MAX_LINE_SIZE;
+    r->buf = (char *) malloc(r->buf_size);
+    r->prev = (unsigned char *) malloc(dim * dim);
+    r->cur = (unsigned char *) malloc(dim * dim);
+    if ((r->buf == NULL) || (r->prev == NULL) || (r->cur == NULL)) {
+        free_renderer(r);
+        snprintf(err, size, "could not allocate a %d x %d replay renderer", dim, dim);
+        return GS_ERR_NOMEM;
+    }
+    r->len = 0;
+    r->frames = 0;
+    r->scroll_top = ROW_BOARD + dim + 2;
+    return GS_OK;
+}
+
+
+/*
+ * free_renderer - Frees a renderer's buffers and closes its file
+ */
+void free_renderer(renderer *r)
+{
+    if (r->fd != STDOUT_FILENO) { close(r->fd); }
+    free(r->buf);
+    free(r->prev);
+    free(r->cur);
+    return;
+}
+
+
+/*
+ * render_begin - Starts a replay: terminals get a cleared screen with the board on top and every other line scrolling below it
+ */
+void render_begin(renderer *r, const char *title)
+{
+    struct winsize ws;
+    int rows = 0;
+    char line[MAX_LINE_SIZE];
+
+    if (r->headless) {
+        snprintf(line, sizeof(line), "%s\n", title);
+        put_str(r, line);
+        flush_frame(r);
+        return;
+    }
+
+    if ((ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) && (ws.ws_row > 0)) { rows = ws.ws_row; }
+    if (rows <= r->scroll_top) { rows = r->scroll_top + 1; }
+
+    // clear, draw the bars and confine other output to the rows below the board (the cleared board is all empty cells)
+    memset(r->prev, CELL_EMPTY, r->dim * r->dim);
+    put_str(r, "\033[2J\033[H\033[K");
+    put_str(r, title);
+    snprintf(line, sizeof(line), "\033[%d;1H", ROW_BOARD - 1);
+    put_str(r, line);
+    put_bar(r);
+    for (int i = 0; i < r->dim; i++) {
+        snprintf(line, sizeof(line), "\033[%d;1H | \033[%d;%dH| ", ROW_BOARD + i, ROW_BOARD + i, COL_BOARD + 2 * r->dim);
+        put_str(r, line);
+    }
+    snprintf(line, sizeof(line), "\033[%d;1H", ROW_BOARD + r->dim);
+    put_str(r, line);
+    put_bar(r);
+    snprintf(line, sizeof(line), "\033[%d;%dr\033[%d;1H", r->scroll_top, rows, r->scroll_top);
+    put_str(r, line);
+    flush_frame(r);
+    return;
+}
+
+
+/*
+ * render_frame - Renders an env's board: only the cells that changed since the last frame on terminals, the whole board headless
+ */
+void render_frame(renderer *r, env *e, const char *status)
+{
+    char line[MAX_LINE_SIZE];
+    int dim = r->dim;
+    int idx;
+
+    draw_grid(r, e);
+    if (r->headless) {
+        // plain text frame
+        snprintf(line, sizeof(line), "%s\n", status);
+        put_str(r, line);
+        put_bar(r);
+        put_str(r, "\n");
+        for (int i = 0; i < dim; i++) {
+            put_str(r, " | ");
+            for (int j = 0; j < dim; j++) { put_cell(r, r->cur[RIDX(i, j, dim)]); }
+            put_str(r, "| \n");
+        }
+        put_bar(r);
+        put_str(r, "\n\n");
+    } else {
+        // save the cursor of the scrolling output, rewrite the status line and changed cells, restore the cursor
+        snprintf(line, sizeof(line), "\0337\033[%d;1H\033[K%s", ROW_STATUS, status);
+        put_str(r, line);
+        for (int i = 0; i < dim; i++) {
+            for (int j = 0; j < dim; j++) {
+                idx = RIDX(i, j, dim);
+                if (r->cur[idx] == r->prev[idx]) continue;
+                snprintf(line, sizeof(line), "\033[%d;%dH", ROW_BOARD + i, COL_BOARD + 2 * j);
+                put_str(r, line);
+                put_cell(r, r->cur[idx]);
+            }
+        }
+        put_str(r, "\0338");
+    }
+    flush_frame(r);
+    memcpy(r->prev, r->cur, dim * dim);
+    r->frames++;
+    return;
+}
+
+
+/*
+ * render_end - Ends a replay and gives the whole terminal back to the scrolling output
+ */
+void render_end(renderer *r)
+{
+    if (r->headless) { return; }
+    put_str(r, "\033[r\033[999;1H\n");
+    flush_frame(r);
+    return;
+}
+
+
+/*
+ * render_text - Sends a block of text (i.e. end of replay stats) to the renderer's output
+ */
+void render_text(renderer *r, const char *text)
+{
+    size_t len = strlen(text);
+    if (len > r->buf_size) { len = r->buf_size; }
+    memcpy(r->buf, text, len);
+    r->len = len;
+    flush_frame(r);
+    return;
+}
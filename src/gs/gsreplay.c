@@ -0,0 +1,245 @@
+//
+//  gsreplay.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "gsdefs.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+
+/*
+ * copy_game_record - Copies the apple positions and actions of a finished game into new buffers of a snapshot, returns -1 if they cannot be allocated
+ */
+static int copy_game_record(replay_snapshot *snap, env *e)
+{
+    apple_data *curr_a;
+    move_data *curr_m = e->m_data;
+    int num_apples, num_moves = 0, ct;
+
+    // apples are linked from the first apple, moves from the last move
+    for (num_apples = 0, curr_a = e->a_data; curr_a != NULL; curr_a = curr_a->next_apple) { num_apples++; }
+    if (curr_m != NULL) {
+        for (num_moves = 1; curr_m->prev_move != NULL; curr_m = curr_m->prev_move) { num_moves++; }
+    }
+    snap->apple_xy = (int *) malloc((2 * num_apples + 1) * sizeof(int));
+    snap->actions = (int *) malloc((num_moves + 1) * sizeof(int));
+    if ((snap->apple_xy == NULL) || (snap->actions == NULL)) {
+        free(snap->apple_xy);
+        free(snap->actions);
+        return -1;
+    }
+
+    for (ct = 0, curr_a = e->a_data; curr_a != NULL; curr_a = curr_a->next_apple, ct++) {
+        snap->apple_xy[2 * ct] = curr_a->x;
+        snap->apple_xy[2 * ct + 1] = curr_a->y;
+    }
+    snap->num_apples = ct;
+    for (ct = 0; curr_m != NULL; curr_m = curr_m->next_move, ct++) { snap->actions[ct] = curr_m->action; }
+    snap->num_moves = ct;
+    return 0;
+}
+
+
+/*
+ * free_viewer - Frees the snapshots and the viewer itself (the viewer thread is not running)
+ */
+static void free_viewer(replay_viewer *viewer, int num_nets)
+{
+    for (int i = 0; i < num_nets; i++) { destroy_ann(&viewer->slots[i].net); }
+    for (int i = 0; i < REPLAY_QUEUE; i++) {
+        free(viewer->slots[i].apple_xy);
+        free(viewer->slots[i].actions);
+    }
+    pthread_mutex_destroy(&viewer->lock);
+    pthread_cond_destroy(&viewer->ready);
+    free(viewer);
+    return;
+}
+
+
+/*
+ * replay_viewer_thread - Plays the best pending snapshot at a time and drops the pending snapshots it supersedes
+ */
+static void * replay_viewer_thread(void *void_viewer)
+{
+    replay_viewer *viewer = (replay_viewer *) void_viewer;
+    double start_t;
+    int best;
+
+    // replays only get the cpu time training leaves over
+#ifdef __linux__
+    setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), REPLAY_NICE);
+#endif
+
+    while (1) {
+        pthread_mutex_lock(&viewer->lock);
+        while (1) {
+            best = NOT_FOUND;
+            for (int i = 0; i < REPLAY_QUEUE; i++) {
+                if ((viewer->slots[i].state == SNAPSHOT_PENDING) && ((best == NOT_FOUND) || (viewer->slots[i].apples > viewer->slots[best].apples))) { best = i; }
+            }
+            if ((best != NOT_FOUND) || (viewer->stop)) break;
+            pthread_cond_wait(&viewer->ready, &viewer->lock);
+        }
+        if (best == NOT_FOUND) {
+            pthread_mutex_unlock(&viewer->lock);
+            break;
+        }
+
+        // coalesce: older pending replays are superseded by the best one
+        for (int i = 0; i < REPLAY_QUEUE; i++) {
+            if ((i != best) && (viewer->slots[i].state == SNAPSHOT_PENDING)) {
+                viewer->slots[i].state = SNAPSHOT_EMPTY;
+                viewer->dropped++;
+            }
+        }
+        viewer->slots[best].state = SNAPSHOT_PLAYING;
+        pthread_mutex_unlock(&viewer->lock);
+
+        // play outside the lock so training can keep submitting
+        start_t = get_time();
+        print_ann_run_replay(&viewer->slots[best], &viewer->render);
+        viewer->play_t += get_time() - start_t;
+
+        pthread_mutex_lock(&viewer->lock);
+        viewer->slots[best].state = SNAPSHOT_EMPTY;
+        viewer->played++;
+        pthread_mutex_unlock(&viewer->lock);
+    }
+    return NULL;
+}
+
+
+/*
+ * start_replay_viewer - Starts the replay viewer thread and returns NULL if replays are off (or, with a warning, if the viewer cannot be started)
+ */
+replay_viewer * start_replay_viewer(gs_params *params)
+{
+    char err[2 * MAX_LINE_SIZE];
+    replay_viewer *viewer;
+    if (params->print_replay == 0) { return NULL; }
+
+    // training goes on without replays when the viewer cannot start
+    viewer = (replay_viewer *) calloc(1, sizeof(replay_viewer));
+    if (viewer == NULL) {
+        printf("\nWARN: could not allocate the replay viewer (replays are off)\n");
+        return NULL;
+    }
+    pthread_mutex_init(&viewer->lock, NULL);
+    pthread_cond_init(&viewer->ready, NULL);
+    viewer->min_apples = params->print_replay;
+    viewer->profile = params->profile;
+    for (int i = 0; i < REPLAY_QUEUE; i++) {
+        if (create_ann(&viewer->slots[i].net, params->num_layers, (int *) &params->shape, (funct *) &params->activation) != GS_OK) {
+            printf("\nWARN: could not allocate the replay viewer nets (replays are off)\n");
+            free_viewer(viewer, i);
+            return NULL;
+        }
+    }
+    if (create_renderer(&viewer->render, params->env_width, params->replay_file, err, sizeof(err)) != GS_OK) {
+        printf("\nWARN: %s (replays are off)\n", err);
+        free_viewer(viewer, REPLAY_QUEUE);
+        return NULL;
+    }
+
+    if (pthread_create(&viewer->thread, NULL, replay_viewer_thread, viewer) != 0) {
+        printf("\nWARN: pthread_create error for replay viewer thread (replays are off)\n");
+        free_renderer(&viewer->render);
+        free_viewer(viewer, REPLAY_QUEUE);
+        return NULL;
+    }
+    return viewer;
+}
+
+
+/*
+ * stop_replay_viewer - Waits for the viewer to play its best pending replay and frees it
+ */
+void stop_replay_viewer(replay_viewer *viewer)
+{
+    if (viewer == NULL) { return; }
+
+    pthread_mutex_lock(&viewer->lock);
+    viewer->stop = 1;
+    pthread_cond_signal(&viewer->ready);
+    pthread_mutex_unlock(&viewer->lock);
+    if (pthread_join(viewer->thread, NULL) != 0) {
+        printf("\n\nERR: pthread_join error for replay viewer thread\n");
+        exit(127);
+    }
+    printf("\n  REPLAYS   played - %ld, dropped - %ld, frames - %ld\n", viewer->played, viewer->dropped, viewer->render.frames);
+    if (viewer->profile) { printf("  REPLAYS   submit - %0.2f ms (training threads), play - %0.2f ms (viewer thread)\n", 1e3 * viewer->submit_t, 1e3 * viewer->play_t); }
+    free_renderer(&viewer->render);
+    free_viewer(viewer, REPLAY_QUEUE);
+    return;
+}
+
+
+/*
+ * submit_replay - Snapshots a finished highscoring game for the viewer without waiting for playback (full queues replace their least scoring replay)
+ *
+ * The game record is copied before the viewer lock is taken and swapped into the chosen snapshot under it, so no allocation holds back other training threads
+ */
+void submit_replay(replay_viewer *viewer, int gen, int island, ann *net, env *e)
+{
+    replay_snapshot *snap = NULL;
+    replay_snapshot rec;
+    int *prev_xy, *prev_actions;
+    double start_t;
+    if ((viewer == NULL) || (e->n < viewer->min_apples)) { return; }
+
+    start_t = get_time();
+    if (copy_game_record(&rec, e) != 0) {
+        pthread_mutex_lock(&viewer->lock);
+        viewer->dropped++;
+        pthread_mutex_unlock(&viewer->lock);
+        return;
+    }
+    pthread_mutex_lock(&viewer->lock);
+    for (int i = 0; i < REPLAY_QUEUE; i++) {
+        if (viewer->slots[i].state == SNAPSHOT_EMPTY) { snap = &viewer->slots[i]; break; }
+        if ((viewer->slots[i].state == SNAPSHOT_PENDING) && ((snap == NULL) || (viewer->slots[i].apples < snap->apples))) { snap = &viewer->slots[i]; }
+    }
+
+    // the viewer is behind and every pending replay scored higher
+    if ((snap == NULL) || ((snap->state == SNAPSHOT_PENDING) && (snap->apples > e->n))) {
+        viewer->dropped++;
+        viewer->submit_t += get_time() - start_t;
+        pthread_mutex_unlock(&viewer->lock);
+        free(rec.apple_xy);
+        free(rec.actions);
+        return;
+    }
+    if (snap->state == SNAPSHOT_PENDING) { viewer->dropped++; }
+
+    // genome and game record (the playing snapshot is never overwritten, and its replaced record is freed after the unlock)
+    snap->gen = gen;
+    snap->island = island;
+    snap->env_dim = e->env_dim;
+    snap->apples = e->n;
+    copy_parameters(net, &snap->net);
+    prev_xy = snap->apple_xy;
+    prev_actions = snap->actions;
+    snap->apple_xy = rec.apple_xy;
+    snap->actions = rec.actions;
+    snap->num_apples = rec.num_apples;
+    snap->num_moves = rec.num_moves;
+    snap->state = SNAPSHOT_PENDING;
+    viewer->submit_t += get_time() - start_t;
+    pthread_cond_signal(&viewer->ready);
+    pthread_mutex_unlock(&viewer->lock);
+    free(prev_xy);
+    free(prev_actions);
+    return;
+}
@@ -0,0 +1,224 @@
+//
+//  gsscale.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gsdefs.h"
+
+static const char *phase_keys[NUM_PROF] = { "run", "reset", "inference", "env_step", "fitness", "spawn", "barrier_wait", "mutex_wait", "select", "stats", "schedule" };
+
+
+/*
+ * run_quiet - Runs the model of a parameters struct from its seed with the run's own output dropped and returns its wall time
+ */
+double run_quiet(gs_params *params)
+{
+    int out_fd, null_fd;
+    double start_t, wall_t;
+
+    fflush(stdout);
+    out_fd = dup(STDOUT_FILENO);
+    null_fd = open("/dev/null", O_WRONLY);
+    if ((out_fd < 0) || (null_fd < 0) || (dup2(null_fd, STDOUT_FILENO) < 0)) {
+        perror("/dev/null");
+        exit(127);
+    }
+    seed_rand(params->seed);
+    start_t = get_time();
+    run_genetic_snake(params, NULL);
+    wall_t = get_time() - start_t;
+    fflush(stdout);
+    dup2(out_fd, STDOUT_FILENO);
+    close(out_fd);
+    close(null_fd);
+    return wall_t;
+}
+
+
+/*
+ * run_cell - Runs a scaling grid cell from its parameters and records its wall time and profile totals
+ */
+static void run_cell(gs_params *params, scale_cell *cell)
+{
+    memset(cell, 0, sizeof(scale_cell));
+    cell->threads = params->num_threads;
+    cell->pop_size = params->pop_size;
+    params->totals = &cell->totals;
+    printf("  running   THREADS %-3d  POP_WIDTH %-6d", cell->threads, cell->pop_size);
+
+    // every cell starts from the same seed, so every thread count plays the same generational games
+    cell->wall_t = run_quiet(params);
+    cell->gens = (params->mode == MODE_STEADY)? (double) cell->totals.games / params->pop_size: params->gen_ct;
+    printf("  %0.2f s\n", cell->wall_t);
+    return;
+}
+
+
+/*
+ * find_cell - Returns the index of the grid cell with a thread count and population size, NOT_FOUND if it was not run
+ */
+static int find_cell(scale_cell *cells, int num_cells, int threads, int pop_size)
+{
+    for (int c = 0; c < num_cells; c++) { if ((cells[c].threads == threads) && (cells[c].pop_size == pop_size)) { return c; } }
+    return NOT_FOUND;
+}
+
+
+/*
+ * compute_scaling - Computes every cell's strong scaling speedup and efficiency at its population and weak scaling efficiency at its population per thread
+ */
+static void compute_scaling(scale_cell *cells, int num_cells, int base_threads)
+{
+    scale_cell *cell;
+    int base;
+
+    for (int c = 0; c < num_cells; c++) {
+        cell = &cells[c];
+        cell->speedup = cell->efficiency = cell->weak_efficiency = NOT_SET;
+
+        // strong: the same work on more threads should take proportionally less time
+        base = find_cell(cells, num_cells, base_threads, cell->pop_size);
+        if (base != NOT_FOUND) {
+            cell->speedup = cells[base].wall_t / cell->wall_t;
+            cell->efficiency = cell->speedup * base_threads / cell->threads;
+        }
+
+        // weak: proportionally more work on more threads should take the same time
+        if ((long) cell->pop_size * base_threads % cell->threads != 0) continue;
+        base = find_cell(cells, num_cells, base_threads, (int) ((long) cell->pop_size * base_threads / cell->threads));
+        if (base != NOT_FOUND) { cell->weak_efficiency = cells[base].wall_t / cell->wall_t; }
+    }
+    return;
+}
+
+
+/*
+ * write_scale_csv - Writes one CSV row per grid cell (empty fields where a scaling baseline was not run)
+ */
+static void write_scale_csv(scale_cell *cells, int num_cells, const char *file_name)
+{
+    FILE *file = fopen(file_name, "w");
+    scale_cell *cell;
+
+    if (file == NULL) {
+        perror(file_name);
+        return;
+    }
+    fprintf(file, "threads,pop_size,seconds,gens_per_s,games_per_s,steps_per_s,speedup,efficiency,weak_efficiency");
+    for (int p = 0; p < NUM_PROF; p++) { fprintf(file, ",%s_s", phase_keys[p]); }
+    fprintf(file, "\n");
+
+    for (int c = 0; c < num_cells; c++) {
+        cell = &cells[c];
+        fprintf(file, "%d,%d,%0.6f,%0.4f,%0.2f,%0.1f", cell->threads, cell->pop_size, cell->wall_t, cell->gens / cell->wall_t,
+            cell->totals.games / cell->wall_t, cell->totals.moves / cell->wall_t);
+        if (cell->speedup != NOT_SET) { fprintf(file, ",%0.4f,%0.4f", cell->speedup, cell->efficiency); } else { fprintf(file, ",,"); }
+        if (cell->weak_efficiency != NOT_SET) { fprintf(file, ",%0.4f", cell->weak_efficiency); } else { fprintf(file, ","); }
+        for (int p = 0; p < NUM_PROF; p++) { fprintf(file, ",%0.6f", cell->totals.t[p]); }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    printf("\n  CSV       %s", file_name);
+    return;
+}
+
+
+/*
+ * write_scale_json - Writes the grid cells as JSON (null where a scaling baseline was not run)
+ */
+static void write_scale_json(gs_params *params, scale_cell *cells, int num_cells, const char *file_name)
+{
+    FILE *file = fopen(file_name, "w");
+    scale_cell *cell;
+
+    if (file == NULL) {
+        perror(file_name);
+        return;
+    }
+    fprintf(file, "{\"seed\": %lld, \"gen_count\": %d, \"mode\": \"%s\", \"cells\": [\n", params->seed, params->gen_ct,
+        (params->mode == MODE_STEADY)? "steady": (params->mode == MODE_ISLAND)? "island": "generational");
+    for (int c = 0; c < num_cells; c++) {
+        cell = &cells[c];
+        fprintf(file, "  {\"threads\": %d, \"pop_size\": %d, \"seconds\": %0.6f, \"gens_per_s\": %0.4f, \"games_per_s\": %0.2f, \"steps_per_s\": %0.1f",
+            cell->threads, cell->pop_size, cell->wall_t, cell->gens / cell->wall_t, cell->totals.games / cell->wall_t, cell->totals.moves / cell->wall_t);
+        if (cell->speedup != NOT_SET) { fprintf(file, ", \"speedup\": %0.4f, \"efficiency\": %0.4f", cell->speedup, cell->efficiency); }
+        else { fprintf(file, ", \"speedup\": null, \"efficiency\": null"); }
+        if (cell->weak_efficiency != NOT_SET) { fprintf(file, ", \"weak_efficiency\": %0.4f", cell->weak_efficiency); }
+        else { fprintf(file, ", \"weak_efficiency\": null"); }
+        fprintf(file, ", \"phases_s\": {");
+        for (int p = 0; p < NUM_PROF; p++) { fprintf(file, "%s\"%s\": %0.6f", (p)? ", ": "", phase_keys[p], cell->totals.t[p]); }
+        fprintf(file, "}}%s\n", (c + 1 < num_cells)? ",": "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+    printf("\n  JSON      %s\n", file_name);
+    return;
+}
+
+
+/*
+ * scale_genetic_snake - Runs the model of a parameters file over a grid of thread counts and population sizes from a fixed seed and writes its scaling as CSV and JSON
+ */
+void scale_genetic_snake(const char *file_name)
+{
+    gs_params *base = read_parameters_from_file(file_name);
+    gs_params *params;
+    scale_cell *cells;
+    char out_file[MAX_LINE_SIZE + 8];
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int num_cells = 0;
+
+    if (base->mode == MODE_FARM) {
+        printf("\n\nERR: The scaling harness does not run farms (use generational, steady or island mode)\n\n\n");
+        exit(127);
+    }
+
+    // default grid: powers of two up to the online cpus at the file's POP_WIDTH
+    if (base->num_scale_threads == 0) {
+        for (int t = 1; (t <= num_cpus) && (t <= MAX_NUM_THREADS) && (base->num_scale_threads < MAX_SCALE); t *= 2) { base->scale_threads[base->num_scale_threads++] = t; }
+        if (base->num_scale_threads == 0) { base->scale_threads[base->num_scale_threads++] = 1; }
+    }
+    if (base->num_scale_pop == 0) { base->scale_pop[base->num_scale_pop++] = base->pop_size; }
+    if (base->seed == NOT_SET) { base->seed = SCALE_SEED; }
+
+    print_model_parameters(base);
+    printf("\n\n+++++++  SCALING GRID  +++++++\n\n");
+    cells = (scale_cell *) malloc(base->num_scale_threads * base->num_scale_pop * sizeof(scale_cell));
+
+    // every cell is a fresh run of the file with its thread count and population (replays, traces and the prompt are off)
+    for (int p = 0; p < base->num_scale_pop; p++) {
+        for (int t = 0; t < base->num_scale_threads; t++) {
+            params = read_parameters_override(file_name, base->scale_threads[t], base->scale_pop[p]);
+            params->seed = base->seed;
+            params->print_replay = 0;
+            params->profile = 1;
+            params->trace_file[0] = '\0';
+            params->ckpt_every = 0;
+            params->resume = CKPT_OFF;
+            params->lineage_every = 0;
+            params->metrics_format = METRICS_OFF;
+            params->champ_file[0] = '\0';
+            run_cell(params, &cells[num_cells++]);
+            free(params);
+        }
+    }
+
+    // scaling is relative to the first SCALE_THREADS value
+    compute_scaling(cells, num_cells, base->scale_threads[0]);
+    print_scale_results(cells, num_cells);
+    snprintf(out_file, sizeof(out_file), "%s.csv", base->scale_out);
+    write_scale_csv(cells, num_cells, out_file);
+    snprintf(out_file, sizeof(out_file), "%s.json", base->scale_out);
+    write_scale_json(base, cells, num_cells, out_file);
+
+    free(cells);
+    free(base);
+    return;
+}
@@ -0,0 +1,301 @@
+//
+//  gssched.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+#include "gsdefs.h"
+
+#define PACK_BOUNDS(h,t) ((((long long) (t)) << 32) | ((long long) (h)))
+#define BOUNDS_HEAD(b) ((int) ((b) & 0xffffffffLL))
+#define BOUNDS_TAIL(b) ((int) ((b) >> 32))
+
+
+/*
+ * get_time - Returns the monotonic clock time in seconds
+ */
+double get_time()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec + t.tv_nsec / 1000000000.0);
+}
+
+
+/*
+ * moves_bucket - Returns the longest-first bucket of a predicted game length (bucket 0 holds the longest games)
+ */
+int moves_bucket(int moves)
+{
+    int log_m = 0;
+    while ((moves >> log_m) > 1) { log_m++; }
+    return ((log_m >= LPT_BUCKETS)? 0: (LPT_BUCKETS - 1) - log_m);
+}
+
+
+/*
+ * deal_thread - Returns the thread that the k-th longest target is dealt to (boustrophedon order keeps every slice balanced)
+ */
+static int deal_thread(int k, int num_threads)
+{
+    int pos = k % num_threads;
+    return (((k / num_threads) % 2) == 0)? pos: (num_threads - 1) - pos;
+}
+
+
+/*
+ * shard_start - Returns the first snake of a thread's shard of the population
+ */
+int shard_start(int ct, int num_threads, int tid)
+{
+    return ((int) (((long long) ct * tid) / num_threads));
+}
+
+
+/*
+ * build_shard_order - Orders every thread's own shard by predicted game length so pinned threads run the snakes they first-touched
+ */
+static void build_shard_order(thread_data *t_data)
+{
+    int ct = t_data->params->pop_size;
+    int num_threads = t_data->params->num_threads;
+    int start, end, k;
+
+    for (int t = 0; t < num_threads; t++) {
+        int bucket_ct[LPT_BUCKETS] = {0};
+        start = shard_start(ct, num_threads, t);
+        end = shard_start(ct, num_threads, t + 1);
+
+        // counting sort of the shard by predicted length bucket, longest bucket first
+        for (int i = start; i < end; i++) { bucket_ct[moves_bucket(t_data->pred_moves[i])]++; }
+        for (int b = 0, sum = start; b < LPT_BUCKETS; b++) { k = bucket_ct[b]; bucket_ct[b] = sum; sum += k; }
+        for (int i = start; i < end; i++) { t_data->run_order[bucket_ct[moves_bucket(t_data->pred_moves[i])]++] = i; }
+        atomic_store_explicit(&t_data->threads[t].bounds, PACK_BOUNDS(start, end), memory_order_relaxed);
+    }
+    return;
+}
+
+
+/*
+ * build_run_order - Orders every snake by its predicted game length and deals the order into per-thread run queues
+ */
+void build_run_order(thread_data *t_data)
+{
+    int ct = t_data->params->pop_size;
+    int num_threads = t_data->params->num_threads;
+    int bucket_ct[LPT_BUCKETS] = {0};
+    int thread_ct[MAX_NUM_THREADS] = {0};
+    int thread_pos[MAX_NUM_THREADS];
+    int *sorted = t_data->run_sorted;
+    int k, t;
+
+    // pinned threads keep to their own shard (stealing still balances the load)
+    if (t_data->params->affinity != AFFINITY_NONE) {
+        build_shard_order(t_data);
+        return;
+    }
+
+    // counting sort of the snakes by predicted length bucket, longest bucket first
+    for (int i = 0; i < ct; i++) { bucket_ct[moves_bucket(t_data->pred_moves[i])]++; }
+    for (int b = 0, sum = 0; b < LPT_BUCKETS; b++) { k = bucket_ct[b]; bucket_ct[b] = sum; sum += k; }
+    for (int i = 0; i < ct; i++) { sorted[bucket_ct[moves_bucket(t_data->pred_moves[i])]++] = i; }
+
+    // determine the slice of the run order each thread owns
+    for (k = 0; k < ct; k++) { thread_ct[deal_thread(k, num_threads)]++; }
+    for (t = 0, k = 0; t < num_threads; t++) { thread_pos[t] = k; k += thread_ct[t]; }
+
+    // deal the sorted snakes into the thread slices (each slice stays longest first)
+    for (k = 0; k < ct; k++) {
+        t = deal_thread(k, num_threads);
+        t_data->run_order[thread_pos[t]++] = sorted[k];
+    }
+
+    // arm every run queue with its slice
+    for (t = 0; t < num_threads; t++) {
+        atomic_store_explicit(&t_data->threads[t].bounds, PACK_BOUNDS(thread_pos[t] - thread_ct[t], thread_pos[t]), memory_order_relaxed);
+    }
+    return;
+}
+
+
+/*
+ * pop_front - Takes the longest remaining target from the front of a run queue and returns NOT_FOUND if it is empty
+ */
+static int pop_front(thread_state *q, int *run_order)
+{
+    long long b = atomic_load_explicit(&q->bounds, memory_order_relaxed);
+    while (BOUNDS_HEAD(b) < BOUNDS_TAIL(b)) {
+        if (atomic_compare_exchange_weak_explicit(&q->bounds, &b, PACK_BOUNDS(BOUNDS_HEAD(b) + 1, BOUNDS_TAIL(b)), memory_order_relaxed, memory_order_relaxed)) {
+            return run_order[BOUNDS_HEAD(b)];
+        }
+    }
+    return NOT_FOUND;
+}
+
+
+/*
+ * steal_back - Takes the shortest remaining target from the back of another thread's run queue and returns NOT_FOUND if it is empty
+ */
+static int steal_back(thread_state *q, int *run_order)
+{
+    long long b = atomic_load_explicit(&q->bounds, memory_order_relaxed);
+    while (BOUNDS_HEAD(b) < BOUNDS_TAIL(b)) {
+        if (atomic_compare_exchange_weak_explicit(&q->bounds, &b, PACK_BOUNDS(BOUNDS_HEAD(b), BOUNDS_TAIL(b) - 1), memory_order_relaxed, memory_order_relaxed)) {
+            return run_order[BOUNDS_TAIL(b) - 1];
+        }
+    }
+    return NOT_FOUND;
+}
+
+
+/*
+ * pop_run_target - Returns the next run target of a thread, stealing from other threads when its own queue is empty
+ */
+int pop_run_target(thread_data *t_data, int tid)
+{
+    int num_threads = t_data->params->num_threads;
+    int target = pop_front(&t_data->threads[tid], t_data->run_order);
+    if (target != NOT_FOUND) { return target; }
+
+    // steal from the other threads' queues (no targets are added during a run phase, so one empty pass ends it)
+    for (int i = 1; i < num_threads; i++) {
+        target = steal_back(&t_data->threads[(tid + i) % num_threads], t_data->run_order);
+        if (target != NOT_FOUND) {
+            t_data->threads[tid].steals++;
+            return target;
+        }
+    }
+
+    return NOT_FOUND;
+}
+
+
+/*
+ * compute_straggler_idle - Computes the thread time spent idle at the end of the run phase while stragglers finished
+ */
+void compute_straggler_idle(thread_data *t_data)
+{
+    int num_threads = t_data->params->num_threads;
+    double run_end_t = t_data->threads[0].finish_t;
+    double idle_t = 0;
+    t_data->gen_steals = 0;
+
+    // the run phase ends when the last straggler finishes its last game
+    for (int t = 1; t < num_threads; t++) {
+        if (t_data->threads[t].finish_t > run_end_t) { run_end_t = t_data->threads[t].finish_t; }
+    }
+    for (int t = 0; t < num_threads; t++) {
+        idle_t += run_end_t - t_data->threads[t].finish_t;
+        t_data->gen_steals += t_data->threads[t].steals;
+        t_data->threads[t].steals = 0;
+    }
+
+    // idle share of the thread time available in the run phase
+    t_data->run_t = run_end_t - t_data->run_start_t;
+    t_data->idle_t = idle_t;
+    t_data->idle_pct = (run_end_t > t_data->run_start_t)? 100.0 * idle_t / (num_threads * (run_end_t - t_data->run_start_t)): 0.0;
+    t_data->total_idle_pct += t_data->idle_pct;
+    t_data->total_steals += t_data->gen_steals;
+    return;
+}
+
+
+
+/*
+ * package_id - Returns the physical package (socket) of a cpu, or 0 if it is unknown
+ */
+static int package_id(int cpu)
+{
+    char path[MAX_LINE_SIZE];
+    int id = 0;
+    FILE *file;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    file = fopen(path, "r");
+    if (file == NULL) { return 0; }
+    if (fscanf(file, "%d", &id) != 1) { id = 0; }
+    fclose(file);
+    return id;
+}
+
+
+/*
+ * build_cpu_order - Orders the cpus the process may run on for the affinity mode (compact fills a socket first, scatter alternates sockets)
+ */
+void build_cpu_order(thread_data *t_data)
+{
+    t_data->cpu_order = NULL;
+    t_data->num_cpus = 0;
+    if (t_data->params->affinity == AFFINITY_NONE) { return; }
+
+#ifdef __linux__
+    cpu_set_t allowed;
+    int num_pkg = 0;
+    int *cpus, *pkg;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) { return; }
+    cpus = (int *) malloc(CPU_COUNT(&allowed) * sizeof(int));
+    pkg = (int *) malloc(CPU_COUNT(&allowed) * sizeof(int));
+    t_data->cpu_order = (int *) malloc(CPU_COUNT(&allowed) * sizeof(int));
+    if ((cpus == NULL) || (pkg == NULL) || (t_data->cpu_order == NULL)) {
+        // no affinity order (threads run unpinned) rather than no run
+        free(cpus);
+        free(pkg);
+        free(t_data->cpu_order);
+        t_data->cpu_order = NULL;
+        return;
+    }
+
+    // list allowed cpus with their package
+    for (int c = 0, n = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &allowed)) continue;
+        cpus[n] = c;
+        pkg[n] = package_id(c);
+        if (pkg[n] + 1 > num_pkg) { num_pkg = pkg[n] + 1; }
+        n++;
+    }
+    int ct = CPU_COUNT(&allowed);
+
+    if (t_data->params->affinity == AFFINITY_COMPACT) {
+        // every cpu of package 0, then package 1, ...
+        for (int p = 0; p < num_pkg; p++) {
+            for (int i = 0; i < ct; i++) { if (pkg[i] == p) { t_data->cpu_order[t_data->num_cpus++] = cpus[i]; } }
+        }
+    } else {
+        // the i-th cpu of every package in turn
+        for (int i = 0; t_data->num_cpus < ct; i++) {
+            for (int p = 0; p < num_pkg; p++) {
+                for (int j = 0, k = 0; j < ct; j++) {
+                    if (pkg[j] != p) continue;
+                    if (k++ == i) { t_data->cpu_order[t_data->num_cpus++] = cpus[j]; break; }
+                }
+            }
+        }
+    }
+    free(cpus);
+    free(pkg);
+#endif
+    return;
+}
+
+
+/*
+ * pin_thread - Pins the calling snake controller thread to its cpu in the affinity order and returns 0 on success
+ */
+int pin_thread(thread_data *t_data, int tid)
+{
+    if (t_data->num_cpus == 0) { return (t_data->params->affinity == AFFINITY_NONE)? 0: -1; }
+
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(t_data->cpu_order[(t_data->cpu_base + tid) % t_data->num_cpus], &mask);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) != 0) { return -1; }
+#endif
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+//
+//  gssteady.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
+#include "gsdefs.h"
+
+
+/*
+ * tree_add - Adds a fitness delta to a pool position of the fenwick tree
+ */
+static void tree_add(ranked_pool *pool, int pos, double delta)
+{
+    for (int i = pos + 1; i <= pool->capacity; i += i & (-i)) { pool->tree[i] += delta; }
+    return;
+}
+
+
+/*
+ * tree_rebuild - Rebuilds the fenwick tree from the pool fitness to drop accumulated rounding error
+ */
+static void tree_rebuild(ranked_pool *pool)
+{
+    pool->sum_fitness = 0;
+    for (int i = 0; i <= pool->capacity; i++) { pool->tree[i] = 0; }
+    for (int i = 0; i < pool->size; i++) {
+        tree_add(pool, i, pool->fitness[i]);
+        pool->sum_fitness += pool->fitness[i];
+    }
+    pool->tree_updates = 0;
+    return;
+}
+
+
+/*
+ * tree_find - Returns the pool position whose fitness prefix sum range contains a given value (roulette selection)
+ */
+static int tree_find(ranked_pool *pool, double r)
+{
+    int pos = 0;
+    int mask = 1;
+    while ((mask << 1) <= pool->capacity) { mask <<= 1; }
+
+    for (; mask > 0; mask >>= 1) {
+        if ((pos + mask <= pool->capacity) && (pool->tree[pos + mask] <= r)) {
+            pos += mask;
+            r -= pool->tree[pos];
+        }
+    }
+    return ((pos < pool->size)? pos: pool->size - 1);
+}
+
+
+/*
+ * heap_swap - Swaps two entries of the pool's min-heap
+ */
+static void heap_swap(ranked_pool *pool, int i, int j)
+{
+    int tmp = pool->heap[i];
+    pool->heap[i] = pool->heap[j];
+    pool->heap[j] = tmp;
+    return;
+}
+
+
+/*
+ * heap_sift_up - Moves a heap entry up until its parent is less fit
+ */
+static void heap_sift_up(ranked_pool *pool, int i)
+{
+    while ((i > 0) && (pool->fitness[pool->heap[i]] < pool->fitness[pool->heap[(i - 1) / 2]])) {
+        heap_swap(pool, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    return;
+}
+
+
+/*
+ * heap_sift_down - Moves a heap entry down until both children are more fit
+ */
+static void heap_sift_down(ranked_pool *pool, int i)
+{
+    int min;
+    while (1) {
+        min = i;
+        if ((2 * i + 1 < pool->size) && (pool->fitness[pool->heap[2 * i + 1]] < pool->fitness[pool->heap[min]])) { min = 2 * i + 1; }
+        if ((2 * i + 2 < pool->size) && (pool->fitness[pool->heap[2 * i + 2]] < pool->fitness[pool->heap[min]])) { min = 2 * i + 2; }
+        if (min == i) break;
+        heap_swap(pool, i, min);
+        i = min;
+    }
+    return;
+}
+
+
+/*
+ * release_slot - Returns a culled population slot to the free list, or defers it until its last parent pin is dropped
+ */
+static void release_slot(ranked_pool *pool, int slot)
+{
+    if (pool->pins[slot] > 0) {
+        pool->culled[slot] = 1;
+    } else {
+        pool->free_slots[pool->num_free++] = slot;
+    }
+    return;
+}
+
+
+/*
+ * init_ranked_pool - Initializes a ranked pool of survivors for a population of a given size
+ */
+void init_ranked_pool(ranked_pool *pool, int capacity, int pop_size)
+{
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->capacity = capacity;
+    pool->size = 0;
+    pool->slot = (int *) malloc(capacity * sizeof(int));
+    pool->fitness = (double *) malloc(capacity * sizeof(double));
+    pool->tree = (double *) calloc(capacity + 1, sizeof(double));
+    pool->heap = (int *) malloc(capacity * sizeof(int));
+    pool->sum_fitness = 0;
+    pool->tree_updates = 0;
+
+    // no slot is pinned or free until the initial population has been evaluated
+    pool->pins = (int *) calloc(pop_size, sizeof(int));
+    pool->culled = (char *) calloc(pop_size, sizeof(char));
+    pool->free_slots = (int *) malloc(pop_size * sizeof(int));
+    pool->num_free = 0;
+
+    atomic_init(&pool->evals, 0);
+    pool->done = 0;
+    pool->win_ct = 0;
+    pool->win_fitness = 0;
+    pool->win_moves = 0;
+    pool->win_apples = 0;
+    pool->win_start_t = get_time();
+    return;
+}
+
+
+/*
+ * free_ranked_pool - Frees the members of a ranked pool
+ */
+void free_ranked_pool(ranked_pool *pool)
+{
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->slot);
+    free(pool->fitness);
+    free(pool->tree);
+    free(pool->heap);
+    free(pool->pins);
+    free(pool->culled);
+    free(pool->free_slots);
+    return;
+}
+
+
+/*
+ * pool_insert - Ranks a finished game's slot into the pool, culling the least fit survivor when the pool is full (pool lock held)
+ */
+static void pool_insert(ranked_pool *pool, int slot, double fitness)
+{
+    int pos;
+
+    if (pool->size < pool->capacity) {
+        // pool is still filling up
+        pos = pool->size++;
+        pool->slot[pos] = slot;
+        pool->fitness[pos] = fitness;
+        pool->heap[pos] = pos;
+        heap_sift_up(pool, pos);
+    } else if (fitness > pool->fitness[pool->heap[0]]) {
+        // replace the least fit survivor
+        pos = pool->heap[0];
+        release_slot(pool, pool->slot[pos]);
+        tree_add(pool, pos, -pool->fitness[pos]);
+        pool->sum_fitness -= pool->fitness[pos];
+        pool->slot[pos] = slot;
+        pool->fitness[pos] = fitness;
+        heap_sift_down(pool, 0);
+    } else {
+        // not fit enough to survive
+        release_slot(pool, slot);
+        return;
+    }
+    tree_add(pool, pos, fitness);
+    pool->sum_fitness += fitness;
+
+    // periodically rebuild the fenwick tree to bound rounding drift
+    if (++pool->tree_updates >= pool->capacity) { tree_rebuild(pool); }
+    return;
+}
+
+
+/*
+ * pool_sample - Returns a survivor slot by roulette selection over the pool's fitness (pool lock held)
+ */
+static int pool_sample(ranked_pool *pool)
+{
+    return pool->slot[tree_find(pool, rand_unit() * pool->sum_fitness)];
+}
+
+
+/*
+ * spawn_child - Takes a free slot and spawns a child into it from two pinned survivors
+ */
+static int spawn_child(thread_data *t_data, int tid)
+{
+    ranked_pool *pool = t_data->pool;
+    int slot, idx_a, idx_b;
+
+    // take a free slot and pin two parents (retry while every free slot is waiting on a parent pin)
+    while (1) {
+        prof_lock(t_data->prof, tid, &pool->lock);
+        if (pool->num_free > 0) break;
+        pthread_mutex_unlock(&pool->lock);
+        sched_yield();
+    }
+    slot = pool->free_slots[--pool->num_free];
+    idx_a = pool_sample(pool);
+    idx_b = pool_sample(pool);
+    pool->pins[idx_a]++;
+    pool->pins[idx_b]++;
+    pthread_mutex_unlock(&pool->lock);
+
+    // spawn outside the lock (pinned parents cannot be reused as child slots)
+    spawn_ann(t_data->params->mutate, &t_data->ann_s->data[idx_a], &t_data->ann_s->data[idx_b], &t_data->ann_s->data[slot]);
+
+    // unpin the parents and release any parent that was culled while it was pinned
+    prof_lock(t_data->prof, tid, &pool->lock);
+    if ((--pool->pins[idx_a] == 0) && (pool->culled[idx_a])) { pool->culled[idx_a] = 0; release_slot(pool, idx_a); }
+    if ((--pool->pins[idx_b] == 0) && (pool->culled[idx_b])) { pool->culled[idx_b] = 0; release_slot(pool, idx_b); }
+    pthread_mutex_unlock(&pool->lock);
+    return slot;
+}
+
+
+/*
+ * mark_started - Marks a steady run as started once every shard is initialized, so its population is freed with it
+ */
+static void mark_started(void *void_t_data)
+{
+    ((thread_data *) void_t_data)->started = 1;
+    return;
+}
+
+
+/*
+ * steady_controller_thread - Function that runs the steady-state genetic algorithm: evaluate, rank, spawn and repeat without generation barriers
+ */
+void * steady_controller_thread(void *void_ctx)
+{
+    thread_ctx *ctx = (thread_ctx *) void_ctx;
+    thread_data *t_data = ctx->t_data;
+    ranked_pool *pool = t_data->pool;
+    gs_params *params = t_data->params;
+    long total_evals = (long) params->gen_ct * params->pop_size;
+    long report_every = (long) params->report_evals;
+    long eval, done;
+    int slot, action, new_highscore;
+    double fitness, win_t, start_t = 0;
+    eval_stats report;
+    mem_account *prev = mem_bound();
+    env *e;
+
+    // count heap bytes of the run straight into its account (steady threads never merge)
+    mem_bind(t_data->acct, NULL);
+
+    // initialize this thread's shard and wait for every other shard (the only barrier of the run)
+    if (init_shard_thread(t_data, ctx->tid) != GS_OK) {
+        printf("\n\nERR: could not allocate the population shard of thread %d\n\n\n", ctx->tid);
+        exit(127);
+    }
+    barrier_wait(&t_data->barrier, ctx->tid, &ctx->sense, mark_started, t_data);
+
+    while ((eval = atomic_fetch_add_explicit(&pool->evals, 1, memory_order_relaxed)) < total_evals) {
+        // evaluate the initial population first, then a new child per evaluation (steady phases have no generation, so no trace events)
+        if (t_data->prof != NULL) { start_t = get_time(); }
+        slot = (eval < params->pop_size)? (int) eval: spawn_child(t_data, ctx->tid);
+        if (t_data->prof != NULL) {
+            win_t = get_time();
+            if (eval >= params->pop_size) { prof_add(t_data->prof, ctx->tid, PROF_SPAWN, start_t, win_t, NOT_FOUND, 1); }
+            start_t = win_t;
+        }
+        e = &t_data->env_s->data[slot];
+
+        // lazily reset the env if it still holds the slot's previous game
+        if (!e->alive) {
+            reset_env(e);
+            update_dist_data(t_data->env_s, slot);
+        }
+
+        // run ann/env until the snake is dead
+        while (e->alive) {
+            action = run_ann(&t_data->ann_s->data[slot], &t_data->env_s->dist_d[slot]);
+            run_env_action(action, e);
+            update_dist_data(t_data->env_s, slot);
+        }
+        compute_ann_fitness(t_data->ann_s, t_data->env_s, slot);
+        fitness = t_data->ann_s->fitness[slot];
+        if (t_data->prof != NULL) {
+            prof_add(t_data->prof, ctx->tid, PROF_RUN, start_t, get_time(), NOT_FOUND, 1);
+            t_data->prof->threads[ctx->tid].games++;
+            t_data->prof->threads[ctx->tid].moves += e->m;
+        }
+
+        // snapshot a new highscore for the replay viewer while this thread still owns the slot
+        prof_lock(t_data->prof, ctx->tid, &pool->lock);
+        new_highscore = (e->n > t_data->highscore);
+        if (new_highscore) { t_data->highscore = e->n; }
+        pthread_mutex_unlock(&pool->lock);
+        if (new_highscore) {
+            printf("\033[0;32m--  [EVAL %ld] New Highscore:  %d  --\033[0m\n", eval + 1, e->n);
+            submit_replay(t_data->viewer, (int) (eval / params->pop_size), NOT_FOUND, &t_data->ann_s->data[slot], e);
+        }
+
+        // rank the game into the pool and update the report window
+        prof_lock(t_data->prof, ctx->tid, &pool->lock);
+        pool_insert(pool, slot, fitness);
+        done = ++pool->done;
+        pool->win_ct++;
+        pool->win_fitness += fitness;
+        pool->win_moves += e->m;
+        pool->win_apples += e->n;
+        if ((done % report_every == 0) || (done == total_evals)) {
+            win_t = get_time();
+            report.evals = done;
+            report.ct = pool->win_ct;
+            report.fitness = pool->win_fitness;
+            report.moves = pool->win_moves;
+            report.apples = pool->win_apples;
+            report.elapsed_t = win_t - pool->win_start_t;
+            report.min_surv_fitness = pool->fitness[pool->heap[0]];
+            pool->win_ct = 0;
+            pool->win_fitness = 0;
+            pool->win_moves = 0;
+            pool->win_apples = 0;
+            pool->win_start_t = win_t;
+            pthread_mutex_unlock(&pool->lock);
+            print_eval_stats(&report);
+            print_mem_stats(t_data->acct);
+        } else {
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+    mem_bind(prev, NULL);
+    return NULL;
+}
@@ -0,0 +1,626 @@
+//
+//  gssweep.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "gsdefs.h"
+
+
+/*
+ * sweep_shape_str - Writes the ANN shape of a parameters struct as neuron counts joined by '-' (i.e. 24-16-4)
+ */
+void sweep_shape_str(gs_params *params, char *str, size_t size)
+{
+    size_t len = snprintf(str, size, "%d", params->shape[0]);
+    for (int l = 0; (l < params->num_layers) && (len < size); l++) { len += snprintf(str + len, size - len, "-%d", params->shape[RIDX(l, 1, 2)]); }
+    return;
+}
+
+
+/*
+ * count_runs - Returns how many runs a parameters file's SWEEP lists make (every combination, or the i-th value of every list) and the length of every list (1 when it is empty)
+ */
+static int count_runs(gs_params *base, int *lens)
+{
+    int num_runs = 1;
+
+    lens[0] = base->num_sweep_pop;
+    lens[1] = base->num_sweep_mutate;
+    lens[2] = base->num_sweep_survive;
+    lens[3] = base->num_sweep_shape;
+    for (int l = 0; l < 4; l++) {
+        if (lens[l] == 0) { lens[l] = 1; }
+        if (base->sweep_mode == SWEEP_GRID) { num_runs *= lens[l]; }
+        else if (lens[l] > num_runs) { num_runs = lens[l]; }
+    }
+    return num_runs;
+}
+
+
+/*
+ * build_runs - Fills the parameters of every sweep run from the base file (a list without values keeps the base file's value)
+ */
+static void build_runs(gs_params *base, sweep_run *runs, int num_runs)
+{
+    int lens[4], idx[4];
+    int rest;
+    gs_params *params;
+
+    count_runs(base, lens);
+    for (int r = 0; r < num_runs; r++) {
+        // grid runs count through the shapes first and the population sizes last
+        rest = r;
+        for (int l = 3; l >= 0; l--) {
+            idx[l] = (base->sweep_mode == SWEEP_GRID)? rest % lens[l]: (lens[l] > 1)? r: 0;
+            rest /= lens[l];
+        }
+
+        params = &runs[r].params;
+        *params = *base;
+        if (base->num_sweep_pop) { params->pop_size = base->sweep_pop[idx[0]]; }
+        if (base->num_sweep_mutate) { params->mutate = base->sweep_mutate[idx[1]]; }
+        if (base->num_sweep_survive) { params->survive = base->sweep_survive[idx[2]]; }
+        if (base->num_sweep_shape) {
+            params->num_layers = base->sweep_layers[idx[3]];
+            memcpy(params->shape, base->sweep_shape[idx[3]], sizeof(params->shape));
+            for (int l = 0; l < params->num_layers; l++) { params->activation[l] = sigmoid; }
+        }
+
+        // every run shares the pool's threads, so its claims are sized for all of them (replays, profiles and run files are off)
+        params->schedule = SCHEDULE_INDEX;
+        params->affinity = AFFINITY_NONE;
+        params->print_replay = 0;
+        params->profile = 0;
+        params->trace_file[0] = '\0';
+        params->perf_counters = 0;
+        params->totals = NULL;
+        params->autotune = TUNE_OFF;
+        params->ckpt_every = 0;
+        params->resume = CKPT_OFF;
+        params->lineage_every = 0;
+        params->champ_file[0] = '\0';
+    }
+    return;
+}
+
+
+/*
+ * arm_phase - Arms a run's next phase for the pool (or marks the run done) and wakes any waiting worker
+ */
+static void arm_phase(sweep *sw, sweep_run *run, int phase)
+{
+    pthread_mutex_lock(&sw->lock);
+    run->phase = phase;
+    atomic_store(&run->done, 0);
+    if (phase == SWEEP_RUN) {
+        run->limit = run->t_data.run_claim.limit;
+        atomic_store_explicit(&run->t_data.run_claim.next, 0, memory_order_relaxed);
+    } else if (phase == SWEEP_SPAWN) {
+        run->limit = run->t_data.spawn_claim.limit;
+        atomic_store_explicit(&run->t_data.spawn_claim.next, 0, memory_order_relaxed);
+    } else {
+        sw->active--;
+    }
+    pthread_cond_broadcast(&sw->cond);
+    pthread_mutex_unlock(&sw->lock);
+    return;
+}
+
+
+/*
+ * sweep_next_gen - Serial step after a run's last child has spawned: pushes its generation's metrics and arms the next run phase
+ */
+static void sweep_next_gen(sweep *sw, sweep_run *run)
+{
+    thread_data *t_data = &run->t_data;
+
+    t_data->gen_metrics.spawn_ms = 1000 * (get_time() - t_data->spawn_start_t);
+    push_gen_metrics(t_data);
+
+    // every pool thread may run this run's snakes, so the serial step empties all of their stats
+    t_data->ann_s->gen += 1;
+    for (int t = 0; t < sw->num_threads; t++) { reset_gen_stats(&t_data->threads[t].stats); }
+    t_data->run_start_t = get_time();
+    arm_phase(sw, run, SWEEP_RUN);
+    return;
+}
+
+
+/*
+ * sweep_go_on - Selects the parents of a run's next generation and arms its spawn phase (a run that keeps every snake goes straight to its next generation)
+ */
+static void sweep_go_on(sweep *sw, sweep_run *run, double start_t)
+{
+    thread_data *t_data = &run->t_data;
+    gs_params *params = &run->params;
+
+    determine_most_fit_parents(params->pop_size, params->survive, t_data->surv_idx, t_data->fitness_prob, t_data->ann_s);
+    t_data->spawn_start_t = get_time();
+    t_data->gen_metrics.select_ms = 1000 * (t_data->spawn_start_t - start_t);
+
+    // a run that keeps every snake has no children to spawn
+    if (t_data->spawn_claim.limit == 0) {
+        sweep_next_gen(sw, run);
+        return;
+    }
+    arm_phase(sw, run, SWEEP_SPAWN);
+    return;
+}
+
+
+/*
+ * sweep_finish - Pushes the last generation's metrics of a run that ran every generation or was stopped early and marks it done (its share of the pool goes to the other runs at their next claim)
+ */
+static void sweep_finish(sweep *sw, sweep_run *run)
+{
+    thread_data *t_data = &run->t_data;
+    gs_params *params = &run->params;
+    char shape[MAX_STR_SIZE];
+
+    push_gen_metrics(t_data);
+    run->end_t = get_time();
+    sweep_shape_str(params, shape, sizeof(shape));
+    printf("  %-8s  RUN %-3d  POP_WIDTH %-6d  MUTATE %-6.3f  SURVIVE %-6.3f  LAYERS %-16s  GEN %-5d  %0.2f s  (fitness %0.2f, highscore %d)\n",
+        (run->stopped != NOT_FOUND)? "stopped": "done", t_data->island, params->pop_size, params->mutate, params->survive, shape, run->gens,
+        run->end_t - run->start_t, run->final_fitness, t_data->highscore);
+    arm_phase(sw, run, SWEEP_DONE);
+    return;
+}
+
+
+/*
+ * waits_at - Returns 1 if a run is waiting at a given rung (a run that reached the rung may since be waiting at a later one)
+ */
+static int waits_at(sweep *sw, sweep_run *run, int k)
+{
+    return ((run->phase == SWEEP_WAIT) && (run->gens == sw->rung_gens[k]));
+}
+
+
+/*
+ * promote_rung - Moves the runs waiting at a rung that rank in its top floor(n/eta) onto a list of runs that go on (ties go to the earlier arrival)
+ */
+static void promote_rung(sweep *sw, int k, int *go, int *num_go)
+{
+    double *vals = sw->rung_vals[k];
+    int keep = sw->rung_ct[k] / sw->params->asha_eta;
+    sweep_run *run;
+    int ahead;
+
+    for (int i = 0; i < sw->rung_ct[k]; i++) {
+        run = &sw->runs[sw->rung_runs[k][i]];
+        if (!waits_at(sw, run, k)) continue;
+        ahead = 0;
+        for (int j = 0; j < sw->rung_ct[k]; j++) {
+            if ((vals[j] > vals[i]) || ((vals[j] == vals[i]) && (j < i))) { ahead++; }
+        }
+        if (ahead < keep) {
+            run->phase = SWEEP_RUN;
+            go[(*num_go)++] = sw->rung_runs[k][i];
+        }
+    }
+    return;
+}
+
+
+/*
+ * close_rungs - Stops the runs still waiting at every rung that each run still going has reached (a run stopped at a rung never reaches a later one, so one pass from the first rung is enough)
+ */
+static void close_rungs(sweep *sw, int *go, int *num_go, int *stop, int *num_stop)
+{
+    sweep_run *run;
+    int expected, waiting, best;
+
+    for (int k = 0; k < sw->num_rungs; k++) {
+        expected = sw->num_runs;
+        for (int r = 0; r < sw->num_runs; r++) {
+            if ((sw->runs[r].stopped != NOT_FOUND) && (sw->runs[r].stopped < k)) { expected--; }
+        }
+        if (sw->rung_ct[k] < expected) continue;
+
+        // a rung of fewer than eta runs still passes on its best one
+        waiting = 0;
+        best = NOT_FOUND;
+        for (int i = 0; i < sw->rung_ct[k]; i++) {
+            if (!waits_at(sw, &sw->runs[sw->rung_runs[k][i]], k)) continue;
+            waiting++;
+            if ((best == NOT_FOUND) || (sw->rung_vals[k][i] > sw->rung_vals[k][best])) { best = i; }
+        }
+        if ((best != NOT_FOUND) && (waiting == sw->rung_ct[k])) {
+            sw->runs[sw->rung_runs[k][best]].phase = SWEEP_RUN;
+            go[(*num_go)++] = sw->rung_runs[k][best];
+        }
+
+        for (int i = 0; i < sw->rung_ct[k]; i++) {
+            run = &sw->runs[sw->rung_runs[k][i]];
+            if (!waits_at(sw, run, k)) continue;
+            run->phase = SWEEP_RUN;
+            run->stopped = k;
+            stop[(*num_stop)++] = sw->rung_runs[k][i];
+        }
+    }
+    return;
+}
+
+
+/*
+ * asha_rung - Records a run's metric at the early-stopping rung it just reached and lets every run the arrival decides go on or stop, returns 0 if the run is not at a rung
+ *
+ * A run goes on once it ranks in the top floor(n/eta) of the n runs that reached its rung (a promotion is never taken back), so the first eta - 1 arrivals wait for
+ * later ones instead of passing on their own. Once every run still going has reached a rung, the runs still waiting there stop (a rung that passed on no run
+ * keeps its best). Waiting runs hold no claims, and the lowest rung with waiting runs only waits for running runs, so the pool always moves on.
+ */
+static int asha_rung(sweep *sw, sweep_run *run, gen_stats *stats, double start_t)
+{
+    gs_params *params = sw->params;
+    double val = (params->asha_metric == ASHA_HIGHSCORE)? run->t_data.highscore: stats->sum_fitness / stats->ct;
+    int go[MAX_SWEEP_RUNS], stop[MAX_SWEEP_RUNS];
+    int num_go = 0, num_stop = 0;
+    int k, i;
+
+    for (k = 0; (k < sw->num_rungs) && (sw->rung_gens[k] != run->gens); k++);
+    if (k == sw->num_rungs) { return 0; }
+
+    // decisions are taken under the lock, and their serial steps run after it (every decided run has no claims left, so only this thread touches it)
+    pthread_mutex_lock(&sw->lock);
+    i = sw->rung_ct[k]++;
+    sw->rung_vals[k][i] = val;
+    sw->rung_runs[k][i] = (int) (run - sw->runs);
+    run->phase = SWEEP_WAIT;
+    promote_rung(sw, k, go, &num_go);
+    close_rungs(sw, go, &num_go, stop, &num_stop);
+    pthread_mutex_unlock(&sw->lock);
+
+    for (i = 0; i < num_stop; i++) { sweep_finish(sw, &sw->runs[stop[i]]); }
+    for (i = 0; i < num_go; i++) { sweep_go_on(sw, &sw->runs[go[i]], (&sw->runs[go[i]] == run)? start_t: get_time()); }
+    return 1;
+}
+
+
+/*
+ * sweep_select - Serial step after a run's last snake has run: records its gen stats and selects its next generation's parents (or finishes the run)
+ */
+static void sweep_select(sweep *sw, sweep_run *run)
+{
+    thread_data *t_data = &run->t_data;
+    gs_params *params = &run->params;
+    int gen_i = t_data->ann_s->gen;
+    double start_t = get_time();
+    gen_stats stats;
+
+    // a run whose snakes could not play stops the sweep
+    if (atomic_load(&t_data->fail) != GS_OK) {
+        printf("\n\nERR: sweep run %d stopped (%s)\n\n\n", (int) (run - sw->runs), gs_strerror(atomic_load(&t_data->fail)));
+        exit(127);
+    }
+
+    // merge every pool thread's game stats of this run
+    reset_gen_stats(&stats);
+    for (int t = 0; t < sw->num_threads; t++) { merge_gen_stats(&stats, &t_data->threads[t].stats); }
+    t_data->run_t = start_t - t_data->run_start_t;
+    if (stats.max_apples > t_data->highscore) { t_data->highscore = stats.max_apples; }
+    if ((gen_i == 0) || (stats.max_fitness > run->best_fitness)) { run->best_fitness = stats.max_fitness; }
+    run->final_fitness = stats.sum_fitness / stats.ct;
+    run->final_apples = (double) stats.sum_apples / stats.ct;
+    run->gens = gen_i + 1;
+    collect_gen_metrics(t_data, &stats);
+
+    // skips spawning last gen, and a run at an early-stopping rung goes on or stops when its rung decides
+    if (run->gens == params->gen_ct) {
+        sweep_finish(sw, run);
+        return;
+    }
+    if ((sw->num_rungs) && (asha_rung(sw, run, &stats, start_t))) { return; }
+    sweep_go_on(sw, run, start_t);
+    return;
+}
+
+
+/*
+ * claim_sweep_chunk - Claims a chunk of the armed phase of the run with the least pool time among runs with unclaimed targets (waiting while there are none) and returns NULL once every run is done
+ */
+static sweep_run * claim_sweep_chunk(sweep *sw, int tid, int *phase, int *start, int *end)
+{
+    sweep_run *run, *best;
+    phase_claim *claim;
+
+    pthread_mutex_lock(&sw->lock);
+    while (sw->active > 0) {
+        // fair share: the run that has had the least thread time goes first
+        best = NULL;
+        for (int r = 0; r < sw->num_runs; r++) {
+            run = &sw->runs[r];
+            if ((run->phase == SWEEP_DONE) || (run->phase == SWEEP_WAIT)) continue;
+            claim = (run->phase == SWEEP_RUN)? &run->t_data.run_claim: &run->t_data.spawn_claim;
+            if (atomic_load_explicit(&claim->next, memory_order_relaxed) >= claim->limit) continue;
+            if ((best == NULL) || (atomic_load(&run->busy_ns) < atomic_load(&best->busy_ns))) { best = run; }
+        }
+
+        // claims are only taken and rearmed under the lock, so a claimed chunk always belongs to the phase it was armed for
+        if (best != NULL) {
+            *phase = best->phase;
+            claim = (best->phase == SWEEP_RUN)? &best->t_data.run_claim: &best->t_data.spawn_claim;
+            claim_targets(claim, sw->num_threads, &best->t_data.threads[tid], start, end);
+            pthread_mutex_unlock(&sw->lock);
+            return best;
+        }
+        pthread_cond_wait(&sw->cond, &sw->lock);
+    }
+    pthread_mutex_unlock(&sw->lock);
+    return NULL;
+}
+
+
+/*
+ * sweep_worker_thread - Pool thread function to run and spawn claimed chunks of every sweep run (the thread that finishes a phase runs its serial step)
+ */
+static void * sweep_worker_thread(void *void_w)
+{
+    sweep_worker *w = (sweep_worker *) void_w;
+    sweep *sw = w->sw;
+    sweep_run *run;
+    int phase, start, end;
+    double start_t;
+
+    seed_rand(sw->seed + w->tid);
+    while ((run = claim_sweep_chunk(sw, w->tid, &phase, &start, &end)) != NULL) {
+        start_t = get_time();
+        if (phase == SWEEP_RUN) {
+            for (int target = start; target < end; target++) { run_target(&run->t_data, w->tid, target); }
+        } else {
+            spawn_targets(&run->t_data, w->tid, start, end);
+        }
+        atomic_fetch_add(&run->busy_ns, (long) (1e9 * (get_time() - start_t)));
+
+        // the thread that finishes a phase's last targets has seen every other thread's targets of it
+        if (atomic_fetch_add(&run->done, end - start) + (end - start) == run->limit) {
+            if (phase == SWEEP_RUN) { sweep_select(sw, run); }
+            else { sweep_next_gen(sw, run); }
+        }
+    }
+    return NULL;
+}
+
+
+/*
+ * rank_runs - Ranks the sweep runs by how far they ran, then by the early-stopping metric of their last generation (mean fitness, or highscore then mean fitness)
+ */
+static void rank_runs(sweep *sw, int *rank)
+{
+    sweep_run *a, *b;
+    int by_score = (sw->params->asha_metric == ASHA_HIGHSCORE);
+    int tmp, ahead;
+
+    for (int r = 0; r < sw->num_runs; r++) { rank[r] = r; }
+    for (int i = 1; i < sw->num_runs; i++) {
+        for (int j = i; j > 0; j--) {
+            a = &sw->runs[rank[j - 1]];
+            b = &sw->runs[rank[j]];
+            if (a->gens != b->gens) { ahead = (a->gens > b->gens); }
+            else if ((by_score) && (a->t_data.highscore != b->t_data.highscore)) { ahead = (a->t_data.highscore > b->t_data.highscore); }
+            else if (a->final_fitness != b->final_fitness) { ahead = (a->final_fitness > b->final_fitness); }
+            else { ahead = (a->t_data.highscore >= b->t_data.highscore); }
+            if (ahead) break;
+            tmp = rank[j - 1];
+            rank[j - 1] = rank[j];
+            rank[j] = tmp;
+        }
+    }
+    return;
+}
+
+
+/*
+ * write_sweep_csv - Writes one CSV row per sweep run in rank order
+ */
+static void write_sweep_csv(sweep *sw, int *rank, const char *file_name)
+{
+    FILE *file = fopen(file_name, "w");
+    long total_ns = 0;
+    char shape[MAX_STR_SIZE];
+    sweep_run *run;
+
+    if (file == NULL) {
+        perror(file_name);
+        return;
+    }
+    for (int r = 0; r < sw->num_runs; r++) { total_ns += atomic_load(&sw->runs[r].busy_ns); }
+    fprintf(file, "rank,run,pop_size,mutate,survive,layers,final_fitness,best_fitness,final_apples,highscore,gens,stopped_rung,seconds,gens_per_s,thread_s,pool_share\n");
+    for (int i = 0; i < sw->num_runs; i++) {
+        run = &sw->runs[rank[i]];
+        sweep_shape_str(&run->params, shape, sizeof(shape));
+        fprintf(file, "%d,%d,%d,%0.4f,%0.4f,%s,%0.4f,%0.4f,%0.4f,%d,%d,", i + 1, rank[i], run->params.pop_size, run->params.mutate,
+            run->params.survive, shape, run->final_fitness, run->best_fitness, run->final_apples, run->t_data.highscore, run->gens);
+        if (run->stopped != NOT_FOUND) { fprintf(file, "%d", run->stopped); }
+        fprintf(file, ",%0.6f,%0.4f,%0.6f,%0.4f\n", run->end_t - run->start_t, run->gens / (run->end_t - run->start_t), atomic_load(&run->busy_ns) / 1e9, (total_ns)? (double) atomic_load(&run->busy_ns) / total_ns: 0);
+    }
+    fclose(file);
+    printf("\n  CSV       %s", file_name);
+    return;
+}
+
+
+/*
+ * write_sweep_json - Writes the sweep runs as JSON in rank order
+ */
+static void write_sweep_json(sweep *sw, int *rank, const char *file_name)
+{
+    FILE *file = fopen(file_name, "w");
+    long total_ns = 0;
+    char shape[MAX_STR_SIZE];
+    sweep_run *run;
+
+    if (file == NULL) {
+        perror(file_name);
+        return;
+    }
+    for (int r = 0; r < sw->num_runs; r++) { total_ns += atomic_load(&sw->runs[r].busy_ns); }
+    fprintf(file, "{\"seed\": %lld, \"gen_count\": %d, \"threads\": %d, \"mode\": \"%s\", \"seconds\": %0.6f, \"asha_gens\": %d, \"asha_eta\": %d, \"runs\": [\n", sw->params->seed,
+        sw->params->gen_ct, sw->num_threads, (sw->params->sweep_mode == SWEEP_LIST)? "list": "grid", sw->wall_t, sw->params->asha_gens, sw->params->asha_eta);
+    for (int i = 0; i < sw->num_runs; i++) {
+        run = &sw->runs[rank[i]];
+        sweep_shape_str(&run->params, shape, sizeof(shape));
+        fprintf(file, "  {\"rank\": %d, \"run\": %d, \"pop_size\": %d, \"mutate\": %0.4f, \"survive\": %0.4f, \"layers\": \"%s\", \"final_fitness\": %0.4f, \"best_fitness\": %0.4f",
+            i + 1, rank[i], run->params.pop_size, run->params.mutate, run->params.survive, shape, run->final_fitness, run->best_fitness);
+        fprintf(file, ", \"final_apples\": %0.4f, \"highscore\": %d, \"gens\": %d", run->final_apples, run->t_data.highscore, run->gens);
+        if (run->stopped != NOT_FOUND) { fprintf(file, ", \"stopped_rung\": %d", run->stopped); } else { fprintf(file, ", \"stopped_rung\": null"); }
+        fprintf(file, ", \"seconds\": %0.6f, \"gens_per_s\": %0.4f, \"thread_s\": %0.6f, \"pool_share\": %0.4f}%s\n",
+            run->end_t - run->start_t, run->gens / (run->end_t - run->start_t), atomic_load(&run->busy_ns) / 1e9,
+            (total_ns)? (double) atomic_load(&run->busy_ns) / total_ns: 0, (i + 1 < sw->num_runs)? ",": "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+    printf("\n  JSON      %s\n", file_name);
+    return;
+}
+
+
+/*
+ * init_sweep - Sets up every sweep run's population (all resident at once) and the metrics stream with a ring per run
+ */
+static void init_sweep(sweep *sw, gs_params *base)
+{
+    gs_params metrics_params = *base;
+    sweep_run *run;
+    int lens[4];
+
+    sw->params = base;
+    sw->num_threads = base->num_threads;
+    sw->num_runs = count_runs(base, lens);
+    if (posix_memalign((void **) &sw->runs, CACHE_LINE, sw->num_runs * sizeof(sweep_run)) != 0) {
+        printf("\n\nERR: could not allocate sweep runs\n");
+        exit(127);
+    }
+    build_runs(base, sw->runs, sw->num_runs);
+    sw->active = sw->num_runs;
+    pthread_mutex_init(&sw->lock, NULL);
+    pthread_cond_init(&sw->cond, NULL);
+
+    // every run's seed is drawn before any shard reseeds the calling thread, so a SEED sweep plays the same games on any pool size
+    for (int r = 0; r < sw->num_runs; r++) { init_thread_data_struct(&sw->runs[r].t_data, &sw->runs[r].params); }
+    sw->seed = rand_u64();
+
+    // the metrics rings' quantile scratch has to hold the largest population
+    for (int r = 0; r < sw->num_runs; r++) { if (sw->runs[r].params.pop_size > metrics_params.pop_size) { metrics_params.pop_size = sw->runs[r].params.pop_size; } }
+    sw->metrics = start_metrics(&metrics_params, sw->num_runs, "run");
+
+    for (int r = 0; r < sw->num_runs; r++) {
+        run = &sw->runs[r];
+        run->t_data.island = r;
+        run->t_data.metrics = sw->metrics;
+        run->t_data.barrier.nodes = NULL;   // the pool never waits on a run's barrier
+        for (int t = 0; t < sw->num_threads; t++) {
+            if (init_shard_thread(&run->t_data, t) != GS_OK) {
+                printf("\n\nERR: could not allocate the population of sweep run %d\n\n\n", r);
+                exit(127);
+            }
+            reset_gen_stats(&run->t_data.threads[t].stats);
+        }
+        run->t_data.started = 1;
+        run->phase = SWEEP_RUN;
+        run->limit = run->t_data.run_claim.limit;
+        atomic_init(&run->done, 0);
+        atomic_init(&run->busy_ns, 0);
+        run->best_fitness = 0;
+        run->final_fitness = 0;
+        run->final_apples = 0;
+        run->gens = 0;
+        run->stopped = NOT_FOUND;
+    }
+
+    // early-stopping rungs every eta times more generations, from the first rung up to (not including) GEN_COUNT
+    sw->num_rungs = 0;
+    for (long g = base->asha_gens; (base->asha_gens) && (g < base->gen_ct) && (sw->num_rungs < MAX_RUNGS); g *= base->asha_eta) {
+        sw->rung_gens[sw->num_rungs] = (int) g;
+        sw->rung_vals[sw->num_rungs] = (double *) malloc(sw->num_runs * sizeof(double));
+        sw->rung_runs[sw->num_rungs] = (int *) malloc(sw->num_runs * sizeof(int));
+        sw->rung_ct[sw->num_rungs++] = 0;
+    }
+    return;
+}
+
+
+/*
+ * sweep_genetic_snake - Runs every parameter set of a parameters file's SWEEP lists concurrently on one pool of THREADS threads (stopping the ones that fall behind at ASHA rungs) and ranks them
+ */
+void sweep_genetic_snake(const char *file_name)
+{
+    gs_params *base = read_parameters_from_file(file_name);
+    sweep_worker workers[MAX_NUM_THREADS];
+    pthread_t tid[MAX_NUM_THREADS];
+    int rank[MAX_SWEEP_RUNS];
+    char out_file[MAX_LINE_SIZE + 8];
+    sweep sw;
+
+    if (base->mode != MODE_GENERATIONAL) {
+        printf("\n\nERR: The sweep runner only runs the generational engine\n\n\n");
+        exit(127);
+    }
+    if (base->seed != NOT_SET) { seed_rand(base->seed); }
+
+    // every run's generations go to the file's METRICS stream, or a CSV next to the results
+    if (base->metrics_format == METRICS_OFF) {
+        snprintf(base->metrics_file, sizeof(base->metrics_file), "%.500s_gens.csv", base->sweep_out);
+        base->metrics_format = METRICS_CSV;
+    }
+    print_model_parameters(base);
+    init_sweep(&sw, base);
+    printf("\n\n+++++++  SWEEP  (%d runs on %d threads)  +++++++\n\n", sw.num_runs, sw.num_threads);
+    if (sw.num_rungs) {
+        printf("  ASHA rungs at GEN");
+        for (int k = 0; k < sw.num_rungs; k++) { printf(" %d", sw.rung_gens[k]); }
+        printf(", keeping the top 1/%d by %s\n\n", base->asha_eta, (base->asha_metric == ASHA_HIGHSCORE)? "highscore": "mean fitness");
+    }
+
+    // the calling thread is pool thread 0
+    sw.start_t = get_time();
+    for (int r = 0; r < sw.num_runs; r++) {
+        sw.runs[r].start_t = sw.start_t;
+        sw.runs[r].t_data.run_start_t = sw.start_t;
+    }
+    for (int i = 0; i < sw.num_threads; i++) {
+        workers[i].sw = &sw;
+        workers[i].tid = i;
+    }
+    for (int i = 1; i < sw.num_threads; i++) {
+        if (pthread_create(&tid[i], NULL, sweep_worker_thread, &workers[i]) != 0) {
+            printf("\n\nERR: pthread_create error for sweep pool thread (%d)\n", i);
+            exit(127);
+        }
+    }
+    sweep_worker_thread(&workers[0]);
+    for (int i = 1; i < sw.num_threads; i++) {
+        if (pthread_join(tid[i], NULL) != 0) {
+            printf("\n\nERR: pthread_join error for sweep pool thread (%d)\n", i);
+            exit(127);
+        }
+    }
+    sw.wall_t = get_time() - sw.start_t;
+    stop_metrics(sw.metrics);
+
+    // rank the runs and write the results
+    rank_runs(&sw, rank);
+    print_sweep_results(&sw, rank);
+    snprintf(out_file, sizeof(out_file), "%s.csv", base->sweep_out);
+    write_sweep_csv(&sw, rank, out_file);
+    snprintf(out_file, sizeof(out_file), "%s.json", base->sweep_out);
+    write_sweep_json(&sw, rank, out_file);
+
+    // final cleanup
+    for (int r = 0; r < sw.num_runs; r++) { free_thread_data_struct(&sw.runs[r].t_data); }
+    for (int k = 0; k < sw.num_rungs; k++) {
+        free(sw.rung_vals[k]);
+        free(sw.rung_runs[k]);
+    }
+    pthread_mutex_destroy(&sw.lock);
+    pthread_cond_destroy(&sw.cond);
+    free(sw.runs);
+    free(base);
+    return;
+}
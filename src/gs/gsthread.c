@@ -10,93 +10,193 @@
 #include <pthread.h>
 #include "gsdefs.h"
 
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; 
-pthread_cond_t snake_cond = PTHREAD_COND_INITIALIZER;
-pthread_cond_t model_cond = PTHREAD_COND_INITIALIZER;
+
+/*
+ * claim_targets - Claims a guided chunk of phase targets with a single atomic fetch-add and returns 0 if no targets remain
+ */
+int claim_targets(phase_claim *claim, int num_threads, thread_state *state, int *start, int *end)
+{
+    int chunk;
+    int curr = atomic_load_explicit(&claim->next, memory_order_relaxed);
+
+    // return if every target has already been claimed
+    if (curr >= claim->limit) { return 0; }
+
+    // guided chunk size: large chunks while many targets remain, shrinking towards the minimum chunk
+    chunk = (claim->limit - curr) / (CLAIM_GUIDED_DIV * num_threads);
+    if (chunk < claim->min_chunk) { chunk = claim->min_chunk; }
+    chunk = ((chunk + claim->step - 1) / claim->step) * claim->step;
+
+    // claim the chunk (a stale snapshot only changes the chunk size, never the range's exclusivity)
+    *start = atomic_fetch_add_explicit(&claim->next, chunk, memory_order_relaxed);
+    if (*start != curr) { state->contention[claim->id]++; }
+    if (*start >= claim->limit) { return 0; }
+    *end = (*start + chunk < claim->limit)? *start + chunk: claim->limit;
+
+    // update this thread's claim counters
+    state->claims[claim->id]++;
+    state->targets[claim->id] += *end - *start;
+    return 1;
+}
 
 
 /*
- * sync_snake_thread - Barrier synchronization for the snake controller thread with a given flag
+ * seed_target - Seeds the calling thread's random numbers from the run seed, a generation and a target when SEED is set (the same games and children on any number of threads)
  */
-static void sync_snake_thread(int* snake_flag)
+static void seed_target(thread_data *t_data, int gen, int target)
 {
-    // return if the model controller thread signaled it has finished
-    if (finished_flag) { return; }
-    
-    // signal to the model controller that a snake controller thread is at the sync barrier
-    pthread_mutex_lock(&mutex);
-    model_flag++;
-    pthread_cond_signal(&model_cond);
-
-    // wait for model controller thread to signal release
-    while(!*snake_flag) {
-        pthread_cond_wait(&snake_cond, &mutex);
-    }
-    pthread_mutex_unlock(&mutex);
+    if (t_data->params->seed == NOT_SET) { return; }
+    seed_rand(t_data->seed + ((unsigned long long) (gen + 1) << 32) + target);
     return;
 }
 
 
 /*
- * sync_model_thread - Barrier synchronization for the model controller thread with given snake wait and sync flags
+ * fail_run - Records the first failure of a run (every thread stops at the run's next barrier)
  */
-static void sync_model_thread(int num_threads, int *curr_wait_flag, int *next_wait_flag, int *sync_flag)
+static void fail_run(thread_data *t_data, int code)
 {
-    // wait for all snake threads to reach the sync barrier
-    pthread_mutex_lock(&mutex);
-    while (model_flag < num_threads) {
-        pthread_cond_wait(&model_cond, &mutex);
+    int ok = GS_OK;
+    atomic_compare_exchange_strong(&t_data->fail, &ok, code);
+    return;
+}
+
+
+/*
+ * run_snake - Resets, runs and scores a single target snake (timing its reset and fitness phases when profiling, and its inference and env steps every PROF_SAMPLE games)
+ */
+static void run_snake(thread_data *t_data, int tid, int target)
+{
+    prof_thread *pt = (t_data->prof != NULL)? &t_data->prof->threads[tid]: NULL;
+    env *e = &t_data->env_s->data[target];
+    int sampled = (pt != NULL) && (pt->games % PROF_SAMPLE == 0);
+    double start_t = 0, mid_t = 0, end_t, loop_t = 0;
+    int action, moves = 0;
+
+    // lazily reset the env if it still holds last generation's finished game
+    if (pt != NULL) { start_t = get_time(); }
+    if (!e->alive) {
+        reset_env(e);
+        update_dist_data(t_data->env_s, target);
+    }
+    if (pt != NULL) {
+        loop_t = get_time();
+        pt->t[PROF_RESET] += loop_t - start_t;
     }
 
-    // adjust flags and target for the snake controller threads' next operation before releasing them
-    model_flag = 0;
-    curr_target = 0;
-    *curr_wait_flag = 1;
-    *next_wait_flag = 0;
-    *sync_flag = 1;
+    // run ann/env until target snake is dead concurrently with other snake controller threads (timing every move would cost about as much as a move)
+    while (e->alive) {
+        if (sampled) { start_t = get_time(); }
+        action = run_ann(&t_data->ann_s->data[target], &t_data->env_s->dist_d[target]);
+        if (action == NOT_SET) {
+            fail_run(t_data, GS_ERR_NOMEM);
+            break;
+        }
+        if (sampled) { mid_t = get_time(); }
+        run_env_action(action, e);
+
+        // update the distance data for target ann/env
+        update_dist_data(t_data->env_s, target);
+        if (sampled) {
+            end_t = get_time();
+            pt->infer_t += mid_t - start_t;
+            pt->env_t += end_t - mid_t;
+        }
+        moves++;
+    }
+    if (pt != NULL) {
+        start_t = get_time();
+        pt->loop_t += start_t - loop_t;
+    }
 
-    // release all snake controller threads
-    pthread_cond_broadcast(&snake_cond);
-    pthread_mutex_unlock(&mutex);
+    // score the finished game, add it to this thread's stats and remember its length for the next schedule
+    compute_ann_fitness(t_data->ann_s, t_data->env_s, target);
+    add_game_stats(&t_data->threads[tid].stats, target, t_data->ann_s->fitness[target], e->m, e->n, e->death);
+    t_data->pred_moves[target] = e->m;
+    if (pt != NULL) {
+        pt->t[PROF_FITNESS] += get_time() - start_t;
+        pt->games++;
+        pt->moves += moves;
+        if (sampled) { pt->sampled_moves += moves; }
+    }
     return;
 }
 
 
 /*
- * run_snake_thread - Snake controller thread function to run snakes with a barrier synchronization
+ * run_target - Runs and scores a target snake from its own seed (for engines that claim their own targets)
  */
-static void run_snake_thread(thread_data *t_data)
+void run_target(thread_data *t_data, int tid, int target)
 {
-    int target;
+    seed_target(t_data, t_data->ann_s->gen, target);
+    run_snake(t_data, tid, target);
+    return;
+}
 
-    // return if the model controller thread signaled it has finished
-    if (finished_flag) { return; }
 
-    // wait for all other snake controller threads to reach the sync barrier
-    sync_snake_thread(&wait_run_flag);
+/*
+ * run_snake_thread - Snake controller thread function to reset, run and score every claimed snake
+ */
+static void run_snake_thread(thread_data *t_data, int tid)
+{
+    double start_t = get_time();
+    long games = 0;
+    int start, end, target;
+    reset_gen_stats(&t_data->threads[tid].stats);
+    perf_begin(t_data->perf, tid);
+
+    if (t_data->params->schedule == SCHEDULE_LONGEST) {
+        // run the longest predicted games first, stealing from other threads once this thread's queue is empty
+        while ((target = pop_run_target(t_data, tid)) != NOT_FOUND) {
+            seed_target(t_data, t_data->ann_s->gen, target);
+            run_snake(t_data, tid, target);
+            games++;
+        }
+    } else {
+        // acquire and run chunks of targets in index order until no targets remain
+        while (claim_targets(&t_data->run_claim, t_data->params->num_threads, &t_data->threads[tid], &start, &end)) {
+            for (target = start; target < end; target++) {
+                seed_target(t_data, t_data->ann_s->gen, target);
+                run_snake(t_data, tid, target);
+            }
+            games += end - start;
+        }
+    }
 
-    while (run_flag) {
-        pthread_mutex_lock(&mutex);
+    // record when this thread ran out of work
+    t_data->threads[tid].finish_t = get_time();
+    perf_end(t_data->perf, tid, PERF_PHASE_RUN);
+    if (t_data->prof != NULL) { prof_add(t_data->prof, tid, PROF_RUN, start_t, t_data->threads[tid].finish_t, t_data->ann_s->gen, games); }
+    return;
+}
 
-        // acquire and run a target if there are targets remaining
-        if (curr_target < t_data->params->pop_size) {
-            // get target and increment the shared current target
-            target = curr_target;
-            curr_target++;
-            pthread_mutex_unlock(&mutex);
 
-            // run ann/env until target snake is dead concurrently with other snake controller threads
-            while (t_data->env_s->data[target].alive) {
-                t_data->action_set[target] = run_ann(&t_data->ann_s->data[target], &t_data->env_s->dist_d[target]);
-                run_env_action(t_data->action_set[target], &t_data->env_s->data[target]);
+/*
+ * spawn_targets - Spawns the children of a range of culled target pairs from roulette-picked survivors
+ */
+void spawn_targets(thread_data *t_data, int tid, int start, int end)
+{
+    int idx_a, idx_b;
+    int ct = t_data->params->pop_size;
+    int ct_surv = ct * t_data->params->survive;
+    int ct_die = ct - ct_surv;
 
-                // update the distance data for target ann/env
-                update_dist_data(t_data->env_s, target);
-            }
-        } else {
-            // singal to other snake controller threads that no target snakes remain 
-            run_flag = 0;
-            pthread_mutex_unlock(&mutex);
+    for (int target = start; target < end; target += 2) {
+        // children draw from their own seeds, apart from the run targets' seeds
+        seed_target(t_data, t_data->ann_s->gen, ct + target);
+
+        // determine two parents for the children snakes
+        idx_a = t_data->surv_idx[(ct - 1 ) - rand_roulette(ct_surv, t_data->fitness_prob)];
+        idx_b = t_data->surv_idx[(ct - 1 ) - rand_roulette(ct_surv, t_data->fitness_prob)];
+
+        // spawn one/two snakes depending on the current target number (children are predicted to play as long as their parents)
+        spawn_ann(t_data->params->mutate, &t_data->ann_s->data[idx_a], &t_data->ann_s->data[idx_b], &t_data->ann_s->data[t_data->surv_idx[target]]);
+        log_child(t_data, tid, t_data->surv_idx[target], idx_a, idx_b);
+        t_data->pred_moves[t_data->surv_idx[target]] = (t_data->pred_moves[idx_a] + t_data->pred_moves[idx_b]) / 2;
+        if ((target) + 1 < ct_die) { // prevents an extra snake from being spawned in the last snake controller thread to spawn children
+            spawn_ann(t_data->params->mutate, &t_data->ann_s->data[idx_a], &t_data->ann_s->data[idx_b], &t_data->ann_s->data[t_data->surv_idx[target + 1]]);
+            log_child(t_data, tid, t_data->surv_idx[target + 1], idx_a, idx_b);
+            t_data->pred_moves[t_data->surv_idx[target + 1]] = t_data->pred_moves[t_data->surv_idx[target]];
         }
     }
     return;
@@ -104,211 +204,274 @@ static void run_snake_thread(thread_data *t_data)
 
 
 /*
- * compute_fitness_thread - Snake controller thread function to compute snake fitness with a barrier synchronization
+ * spawn_ann_gen_thread - Snake controller thread function to spawn children into every claimed pair of culled snakes
  */
-static void compute_fitness_thread(ann_set *ann_s, env_set *env_s)
+static void spawn_ann_gen_thread(thread_data *t_data, int tid)
 {
-    int target;
-
-    // return if the model controller thread signaled it has finished
-    if (finished_flag) { return; }
-
-    // wait for all other snake controller threads to reach the sync barrier
-    sync_snake_thread(&wait_compute_flag);
-
-    while (compute_flag) {
-        pthread_mutex_lock(&mutex);
-
-        // acquire and run a target if there are targets remaining
-        if (curr_target < ann_s->num_net) {
-            // get target and increment the shared current target
-            target = curr_target;
-            curr_target++;            
-            pthread_mutex_unlock(&mutex);
-
-            // compute fitness of the target concurrently with other snake controller threads
-            compute_ann_fitness(ann_s, env_s, target);
-        } else {
-            // singal to other snake controller threads that no target snakes remain
-            compute_flag = 0;
-            pthread_mutex_unlock(&mutex);
-        }
+    int start, end;
+    double start_t = get_time();
+    long children = 0;
+    perf_begin(t_data->perf, tid);
+
+    // acquire chunks of target pairs and spawn their children concurrently with other snake controller threads
+    while (claim_targets(&t_data->spawn_claim, t_data->params->num_threads, &t_data->threads[tid], &start, &end)) {
+        spawn_targets(t_data, tid, start, end);
+        children += end - start;
     }
+    perf_end(t_data->perf, tid, PERF_PHASE_SPAWN);
+    if (t_data->prof != NULL) { prof_add(t_data->prof, tid, PROF_SPAWN, start_t, get_time(), t_data->ann_s->gen, children); }
     return;
 }
 
 
 /*
- * spawn_ann_gen_thread - Snake controller thread function to spawn new snakes with a barrier synchronization
+ * drop_shard - Frees the envs and anns of the snakes in [start, end) of a run that stopped before its first game
  */
-static void spawn_ann_gen_thread(thread_data *t_data)
+static void drop_shard(thread_data *t_data, int start, int end)
 {
-    int target;
-    ann *parent_a;
-    ann *parent_b;
-    int ct = t_data->params->pop_size;
-    int ct_surv = ct * t_data->params->survive;
-    int ct_die = ct - ct_surv;
+    for (int i = start; i < end; i++) {
+        destroy_env(&t_data->env_s->data[i]);
+        destroy_ann(&t_data->ann_s->data[i]);
+    }
+    return;
+}
+
 
-    // return if the model controller thread signaled it has finished
-    if (finished_flag) { return; }
-
-    // wait for all other snake controller threads to reach the sync barrier
-    sync_snake_thread(&wait_spawn_flag);
-
-    // select first snake controller thread to setup spawn variables while all other threads wait
-    pthread_mutex_lock(&mutex);
-    if (!spawn_setup_flag) { // first thread computes spawn variables
-        spawn_setup_flag = 1;
-        pthread_mutex_unlock(&mutex);
-
-        // determine the most fit parents
-        determine_most_fit_parents(t_data->params->pop_size, t_data->params->survive, t_data->surv_idx, t_data->fitness_prob, t_data->ann_s);
-        
-        // adjust flag and release all other snake controller threads
-        pthread_mutex_lock(&mutex);
-        spawn_setup_flag = 2;
-        pthread_cond_broadcast(&snake_cond);
-    } else if (spawn_setup_flag == 1) { // all snake controller threads besides the first one wait
-        while (spawn_setup_flag < 2) {
-            pthread_cond_wait(&snake_cond, &mutex);
+/*
+ * init_shard_thread - Snake controller thread function to pin the thread, seed its random numbers and initialize (first-touch) its population shard, returns GS_OK or GS_ERR_NOMEM (leaving none of the shard initialized)
+ */
+int init_shard_thread(thread_data *t_data, int tid)
+{
+    gs_params *params = t_data->params;
+    int start = shard_start(params->pop_size, params->num_threads, tid);
+    int end = shard_start(params->pop_size, params->num_threads, tid + 1);
+    int code = GS_OK;
+
+    // pin before touching the shard so its pages are placed on this thread's node
+    if ((pin_thread(t_data, tid) != 0) && (!params->quiet)) { printf("\nWARN: could not pin snake controller thread (%d)\n", tid); }
+    seed_rand(t_data->seed + tid);
+    perf_open_thread(t_data->perf, tid);
+
+    // init ann and env shard with given params (snake by snake from their own seeds when SEED is set)
+    if (params->seed == NOT_SET) {
+        init_env_range(t_data->env_s, params->env_width, start, end);
+        code = create_ann_range(t_data->ann_s, start, end, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
+        if (code != GS_OK) {
+            for (int i = start; i < end; i++) { destroy_env(&t_data->env_s->data[i]); }
+            return code;
         }
-    }
-    pthread_mutex_unlock(&mutex);
-
-    while (spawn_flag) {
-        pthread_mutex_lock(&mutex);
-
-        // acquire and run a target if there are targets remaining
-        if (curr_target < t_data->params->pop_size) {
-            // get target and increment the shared current target by two
-            target = curr_target;
-            curr_target = curr_target + 2;
-            pthread_mutex_unlock(&mutex);
-
-            // determine two parents for the children snakes
-            parent_a = &t_data->ann_s->data[t_data->surv_idx[(ct - 1 ) - rand_roulette(ct_surv, t_data->fitness_prob)]];
-            parent_b = &t_data->ann_s->data[t_data->surv_idx[(ct - 1 ) - rand_roulette(ct_surv, t_data->fitness_prob)]];
-
-            // spawn one/two snakes depending on the current target number
-            spawn_ann(t_data->params->mutate, parent_a, parent_b, &t_data->ann_s->data[t_data->surv_idx[target]]);
-            if ((target) + 1 < ct_die) { // prevents an extra snake from being spawned in the last snake controller thread to spawn children
-                spawn_ann(t_data->params->mutate, parent_a, parent_b, &t_data->ann_s->data[t_data->surv_idx[target + 1]]);
+    } else {
+        for (int i = start; i < end; i++) {
+            seed_target(t_data, NOT_FOUND, i);
+            init_env_range(t_data->env_s, params->env_width, i, i + 1);
+            code = create_ann_range(t_data->ann_s, i, i + 1, params->num_layers, (int *) &params->shape, (funct *) &params->activation);
+            if (code != GS_OK) {
+                drop_shard(t_data, start, i);
+                destroy_env(&t_data->env_s->data[i]);
+                return code;
             }
-        } else {
-            // singal to other snake controller threads that no target snakes remain
-            spawn_flag = 0;
-            pthread_mutex_unlock(&mutex);
         }
     }
-    return;
+
+    // a resumed (or seeded) population replaces the fresh genomes
+    restore_shard(t_data, start, end);
+    return GS_OK;
 }
 
 
 /*
- * reset_env_thread - Snake controller thread function to reset snake environments with a barrier synchronization
+ * prof_serial - Records a serial step phase on the profiler's serial track (the serial thread's barrier wait excludes it)
  */
-static void reset_env_thread(env_set * env_s)
+static void prof_serial(thread_data *t_data, int phase, double start_t, int gen)
 {
-    int target;
+    double end_t;
+    if (t_data->prof == NULL) { return; }
 
-    // return if the model controller thread signaled it has finished
-    if (finished_flag) { return; }
-
-    // wait for all other snake controller threads to reach the sync barrier
-    sync_snake_thread(&wait_reset_flag);
+    end_t = get_time();
+    prof_add(t_data->prof, t_data->prof->num_threads, phase, start_t, end_t, gen, 0);
+    t_data->prof->last_serial_t += end_t - start_t;
+    return;
+}
 
-    while (reset_flag) {
-        pthread_mutex_lock(&mutex);
 
-        // acquire and run a target if there are targets remaining
-        if (curr_target < env_s->num_env) {
-            // get target and increment the shared current target
-            target = curr_target;
-            curr_target++;
-            pthread_mutex_unlock(&mutex);
+/*
+ * timed_barrier_wait - Waits on the generation barrier and records the wait (minus any serial step this thread ran) when profiling
+ */
+static void timed_barrier_wait(thread_data *t_data, thread_ctx *ctx, serial_funct serial)
+{
+    profiler *prof = t_data->prof;
+    int gen = t_data->ann_s->gen;
+    double start_t, end_t;
 
-            // reset env target concurrently with other snake controller threads for the next generation
-            reset_env(&env_s->data[target]);
-            update_dist_data(env_s, target);
-            env_s->is_active = 1;
-        } else {
-            // singal to other snake controller threads that no target snakes remain
-            reset_flag = 0;
-            pthread_mutex_unlock(&mutex);
+    if (prof == NULL) {
+        barrier_wait(&t_data->barrier, ctx->tid, &ctx->sense, serial, t_data);
+        return;
+    }
 
-        }
+    // only the serial thread touches last_serial_t, and only inside the serial step
+    start_t = get_time();
+    if (barrier_wait(&t_data->barrier, ctx->tid, &ctx->sense, serial, t_data)) {
+        end_t = get_time();
+        prof_add(prof, ctx->tid, PROF_BARRIER, start_t, end_t - prof->last_serial_t, gen, 0);
+        prof->last_serial_t = 0;
+    } else {
+        prof_add(prof, ctx->tid, PROF_BARRIER, start_t, get_time(), gen, 0);
     }
     return;
 }
 
 
 /*
- * snake_controller_thread - Function that allows threads to run the genetic algorithm in a concurrent/parallel manner
+ * start_serial - Serial step after every shard is initialized: logs the first population and starts the first run phase clock
  */
-void * snake_controller_thread(void *void_t_data)
+static void start_serial(void *void_t_data)
 {
     thread_data *t_data = (thread_data *) void_t_data;
 
-    while (!finished_flag) {
-        // concurrently run all snakes
-        run_snake_thread(t_data);
+    // a run whose shards could not all be initialized never starts
+    if (atomic_load(&t_data->fail) != GS_OK) { return; }
+    perf_report_missing(t_data->perf);
+    log_lineage(t_data);
+    t_data->started = 1;
+    t_data->run_start_t = get_time();
+    return;
+}
 
-        // concurrently compute every snake's fitness
-        compute_fitness_thread(t_data->ann_s, t_data->env_s);
 
-        // concurrently spawn new snakes
-        spawn_ann_gen_thread(t_data);
+/*
+ * select_serial - Serial step after every snake has run: prints gen stats and selects the next generation's parents
+ */
+static void select_serial(void *void_t_data)
+{
+    thread_data *t_data = (thread_data *) void_t_data;
+    int gen_i = t_data->ann_s->gen;
+    double start_t = get_time();
+    gen_stats stats;
+
+    // merge every thread's game stats and counted heap bytes
+    reset_gen_stats(&stats);
+    for (int t = 0; t < t_data->params->num_threads; t++) {
+        merge_gen_stats(&stats, &t_data->threads[t].stats);
+        mem_merge(t_data->acct, t_data->threads[t].mem);
+    }
 
-        // concurrently reset all env structs
-        reset_env_thread(t_data->env_s);
+    // a generation whose run failed is neither printed nor selected from
+    if (atomic_load(&t_data->fail) != GS_OK) { return; }
+
+    // merge every thread's hardware counts (the spawn counts are the previous generation's children)
+    perf_merge_gen(t_data->perf, stats.sum_moves, (gen_i > 0)? t_data->params->pop_size - (int) (t_data->params->pop_size * t_data->params->survive): 0);
+
+    // prints gen stats, straggler stats and any highscoring run data (islands print their block without interleaving, library engines only keep the highscore)
+    compute_straggler_idle(t_data);
+    t_data->last_stats = stats;
+    if (t_data->params->quiet) {
+        if (stats.max_apples > t_data->highscore) { t_data->highscore = stats.max_apples; }
+    } else {
+        flockfile(stdout);
+        print_gen_stats(gen_i, t_data->island, &t_data->highscore, &stats, t_data->ann_s, t_data->env_s, t_data->viewer);
+        print_sched_stats(gen_i, t_data);
+        print_perf_stats(gen_i, t_data->perf);
+        if ((gen_i + 1) % PRINT_BATCH == 0) { print_mem_stats(t_data->acct); }
+        funlockfile(stdout);
+    }
+    collect_gen_metrics(t_data, &stats);
+    prof_serial(t_data, PROF_STATS, start_t, gen_i);
+
+    // skips spawning last gen
+    if ((gen_i + 1) == t_data->params->gen_ct) {
+        push_gen_metrics(t_data);
+        t_data->finished = 1;
+        return;
     }
-    pthread_exit ((void *) 0);
+
+    // determine the most fit parents and rearm the spawn claim
+    start_t = get_time();
+    determine_most_fit_parents(t_data->params->pop_size, t_data->params->survive, t_data->surv_idx, t_data->fitness_prob, t_data->ann_s);
+    emigrate(t_data);
+    atomic_store_explicit(&t_data->spawn_claim.next, 0, memory_order_relaxed);
+    prof_serial(t_data, PROF_SELECT, start_t, gen_i);
+    t_data->spawn_start_t = get_time();
+    t_data->gen_metrics.select_ms = 1000 * (t_data->spawn_start_t - start_t);
+    return;
 }
 
 
 /*
- * model_controller_thread - Model controller thread function that manages all snake controller threads via barrier syncronization
+ * next_gen_serial - Serial step after every child has spawned: advances the generation and rearms the run schedule
  */
-void * model_controller_thread(void *void_t_data)
+static void next_gen_serial(void *void_t_data)
 {
     thread_data *t_data = (thread_data *) void_t_data;
-    int highscore = 0;
-
-    for (int gen_i = 0; gen_i < t_data->params->gen_ct; gen_i++) {
-        spawn_setup_flag = 0;
-
-        // wait for all snake controller threads to sync before running all snakes
-        sync_model_thread(t_data->params->num_threads, &wait_run_flag, &wait_compute_flag, &run_flag);
-        
-        // wait for all snake controller threads to finish running all snakes
-        pthread_mutex_lock(&mutex);
-        while (model_flag < t_data->params->num_threads) { pthread_cond_wait(&model_cond, &mutex); }
-        print_gen_stats(gen_i, &highscore, t_data->ann_s, t_data->env_s, t_data->params->print_replay);
-        pthread_mutex_unlock(&mutex);
-
-        // check if its time to skip last gen spawn/reset operations
-        if ((gen_i + 1) == t_data->params->gen_ct) { break; }
-
-        //wait for all snake controller threads to sync before computing snake fitness
-        sync_model_thread(t_data->params->num_threads, &wait_compute_flag, &wait_spawn_flag, &compute_flag);
-        
-        // wait for all snake controller threads to sync before spawning new snakes
-        sync_model_thread(t_data->params->num_threads, &wait_spawn_flag, &wait_reset_flag, &spawn_flag);
-
-        // wait for all snake controller threads to sync before reseting snake environments
-        sync_model_thread(t_data->params->num_threads, &wait_reset_flag, &wait_run_flag, &reset_flag);
-
-        // increment ann set generation number
-        t_data->ann_s->gen += 1;
+    double start_t = get_time();
+
+    // the finished generation's metrics go to the writer thread
+    t_data->gen_metrics.spawn_ms = 1000 * (start_t - t_data->spawn_start_t);
+    push_gen_metrics(t_data);
+
+    // increment ann set generation number and take in any migrants from other islands
+    t_data->ann_s->gen += 1;
+    immigrate(t_data);
+
+    // rearm the run claim or rebuild the longest-first run queues
+    if (t_data->params->schedule == SCHEDULE_LONGEST) {
+        build_run_order(t_data);
+    } else {
+        atomic_store_explicit(&t_data->run_claim.next, 0, memory_order_relaxed);
+    }
+    log_lineage(t_data);
+    checkpoint_gen(t_data);
+    t_data->run_start_t = get_time();
+    prof_serial(t_data, PROF_SCHED, start_t, t_data->ann_s->gen - 1);
+    return;
+}
+
+
+/*
+ * snake_controller_thread - Function that allows threads to run the genetic algorithm in a concurrent/parallel manner
+ *
+ * A generation crosses the barrier twice, once per phase boundary (run to spawn, spawn to run), and the serial work of a boundary runs inside its crossing
+ */
+void * snake_controller_thread(void *void_ctx)
+{
+    thread_ctx *ctx = (thread_ctx *) void_ctx;
+    thread_data *t_data = ctx->t_data;
+    gs_params *params = t_data->params;
+    mem_account *prev = mem_bound();
+    int code;
+
+    // count heap bytes of the run in this thread's own counters until select merges them
+    mem_bind(t_data->acct, t_data->threads[ctx->tid].mem);
+
+    // initialize this thread's shard and wait for every other shard (a paused run picks up where it stopped)
+    if (!t_data->started) {
+        code = init_shard_thread(t_data, ctx->tid);
+        if (code != GS_OK) { fail_run(t_data, code); }
+        timed_barrier_wait(t_data, ctx, start_serial);
+
+        // a run with a shard that failed never starts, so the other shards are freed before their first game
+        if ((!t_data->started) && (code == GS_OK)) {
+            drop_shard(t_data, shard_start(params->pop_size, params->num_threads, ctx->tid), shard_start(params->pop_size, params->num_threads, ctx->tid + 1));
+        }
     }
 
-    // signal that all other threads should exit
-    pthread_mutex_lock(&mutex);
-    finished_flag = 1;
-    wait_compute_flag = 1;
-    pthread_cond_broadcast(&snake_cond);
-    pthread_mutex_unlock(&mutex);
+    while (t_data->started) {
+        // concurrently reset, run and score all snakes
+        run_snake_thread(t_data, ctx->tid);
+
+        // the last thread to finish selects the parents of the next generation (a failure can only happen while snakes run, so every thread sees the same one here)
+        timed_barrier_wait(t_data, ctx, select_serial);
+        if ((t_data->finished) || (atomic_load(&t_data->fail) != GS_OK)) break;
+
+        // concurrently spawn new snakes
+        spawn_ann_gen_thread(t_data, ctx->tid);
+
+        // the last thread to finish starts the next generation (every thread sees the same generation until the next serial step)
+        timed_barrier_wait(t_data, ctx, next_gen_serial);
+        if (t_data->ann_s->gen == t_data->stop_gen) break;
+    }
 
-    pthread_exit ((void *) 0);
+    // the calling thread keeps running past this one, so leave nothing counted behind and give it back its own account
+    mem_merge(t_data->acct, t_data->threads[ctx->tid].mem);
+    mem_bind(prev, NULL);
+    return NULL;
 }
\ No newline at end of file
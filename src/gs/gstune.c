@@ -0,0 +1,191 @@
+//
+//  gstune.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "gsdefs.h"
+
+#define NUM_TUNE_CHUNKS 3
+#define MAX_TUNE_LINES 1024
+
+static const int tune_chunks[NUM_TUNE_CHUNKS] = { 1, 4, 16 };
+
+
+/*
+ * tune_key - Builds the cache key of a run: host, online cpus, affinity, population size and ANN shape (everything the fastest configuration depends on)
+ */
+static void tune_key(gs_params *params, char *key, size_t size)
+{
+    char host[MAX_LINE_SIZE / 2];
+    size_t len;
+
+    if (gethostname(host, sizeof(host)) != 0) { strcpy(host, "unknown"); }
+    host[sizeof(host) - 1] = '\0';
+    len = snprintf(key, size, "%s/%ldcpu/%s/pop%d/%d", host, sysconf(_SC_NPROCESSORS_ONLN),
+        (params->affinity == AFFINITY_COMPACT)? "compact": (params->affinity == AFFINITY_SCATTER)? "scatter": "none", params->pop_size, params->shape[0]);
+    for (int l = 0; (l < params->num_layers) && (len < size); l++) { len += snprintf(key + len, size - len, "-%d", params->shape[RIDX(l, 1, 2)]); }
+    return;
+}
+
+
+/*
+ * read_tune_cache - Applies the cached configuration of a key and returns 0 if the cache has none
+ */
+static int read_tune_cache(gs_params *params, const char *key)
+{
+    FILE *file = fopen(params->tune_file, "r");
+    char line[MAX_LINE_SIZE], curr[MAX_LINE_SIZE], schedule[MAX_STR_SIZE];
+    int threads, chunk, found = 0;
+    double rate;
+
+    if (file == NULL) { return 0; }
+    while ((!found) && (fgets(line, sizeof(line), file) != NULL)) {
+        if (sscanf(line, "%511s %d %31s %d %lf", curr, &threads, schedule, &chunk, &rate) != 5) continue;
+        if (strcmp(curr, key) != 0) continue;
+
+        // a cache edited by hand still has to hold a valid configuration
+        if ((threads < 1) || (threads > MAX_NUM_THREADS) || (chunk < 1) || ((strcmp(schedule, "longest") != 0) && (strcmp(schedule, "index") != 0))) {
+            printf("\nWARN: ignoring invalid auto-tune cache entry for %s in %s\n", key, params->tune_file);
+            break;
+        }
+        params->num_threads = threads;
+        params->schedule = (strcmp(schedule, "index") == 0)? SCHEDULE_INDEX: SCHEDULE_LONGEST;
+        params->chunk = chunk;
+        params->tune_rate = rate;
+        found = 1;
+    }
+    fclose(file);
+    return found;
+}
+
+
+/*
+ * write_tune_cache - Replaces (or adds) the cache line of a key with the tuned configuration, writing a temporary file renamed over the cache
+ */
+static void write_tune_cache(gs_params *params, const char *key)
+{
+    char tmp_file[MAX_LINE_SIZE + 8], curr[MAX_LINE_SIZE];
+    char *lines[MAX_TUNE_LINES];
+    char line[MAX_LINE_SIZE];
+    int num_lines = 0;
+    FILE *file = fopen(params->tune_file, "r");
+
+    // keep every other host's (and workload's) line
+    if (file != NULL) {
+        while ((num_lines < MAX_TUNE_LINES - 1) && (fgets(line, sizeof(line), file) != NULL)) {
+            if ((sscanf(line, "%511s", curr) == 1) && (strcmp(curr, key) == 0)) continue;
+            lines[num_lines++] = strdup(line);
+        }
+        fclose(file);
+    }
+
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", params->tune_file);
+    file = fopen(tmp_file, "w");
+    if (file == NULL) {
+        perror(tmp_file);
+        for (int i = 0; i < num_lines; i++) { free(lines[i]); }
+        return;
+    }
+    for (int i = 0; i < num_lines; i++) {
+        fputs(lines[i], file);
+        free(lines[i]);
+    }
+    fprintf(file, "%s %d %s %d %0.4f\n", key, params->num_threads, (params->schedule == SCHEDULE_INDEX)? "index": "longest", params->chunk, params->tune_rate);
+    if ((fclose(file) != 0) || (rename(tmp_file, params->tune_file) != 0)) { perror(params->tune_file); }
+    return;
+}
+
+
+/*
+ * calibrate - Runs a few quiet generations of every thread count (powers of two and every online cpu), schedule and chunk, and keeps the fastest (best of TUNE_REPEATS runs each)
+ */
+static void calibrate(gs_params *params)
+{
+    gs_params trial = *params;
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    double rate, wall_t;
+    int num_threads[MAX_SCALE + 1];
+    int num_counts = 0;
+
+    // every configuration plays the same games from the same seed, so only the configuration changes the time
+    trial.gen_ct = TUNE_GENS;
+    trial.seed = (params->seed != NOT_SET)? params->seed: SCALE_SEED;
+    trial.print_replay = 0;
+    trial.profile = 0;
+    trial.trace_file[0] = '\0';
+    trial.perf_counters = 0;
+    trial.totals = NULL;
+    trial.ckpt_every = 0;
+    trial.resume = CKPT_OFF;
+    trial.lineage_every = 0;
+    trial.metrics_format = METRICS_OFF;
+    trial.champ_file[0] = '\0';
+    if (num_cpus > MAX_NUM_THREADS) { num_cpus = MAX_NUM_THREADS; }
+    for (int t = 1; (t < num_cpus) && (num_counts < MAX_SCALE); t *= 2) { num_threads[num_counts++] = t; }
+    num_threads[num_counts++] = (num_cpus > 0)? (int) num_cpus: 1;
+
+    printf("\n\n+++++++  AUTO-TUNE  +++++++\n\n");
+    params->tune_rate = 0;
+
+    // the first run pays for cold caches and page faults, so it is not timed
+    trial.num_threads = 1;
+    run_quiet(&trial);
+    for (int t = 0; t < num_counts; t++) {
+        for (int s = SCHEDULE_INDEX; s <= SCHEDULE_LONGEST; s++) {
+            for (int c = 0; c < NUM_TUNE_CHUNKS; c++) {
+                trial.num_threads = num_threads[t];
+                trial.schedule = s;
+                trial.chunk = tune_chunks[c];
+                printf("  THREADS %-3d  SCHEDULE %-7s  CHUNK %-3d", trial.num_threads, (s == SCHEDULE_INDEX)? "index": "longest", trial.chunk);
+                wall_t = run_quiet(&trial);
+                for (int r = 1; r < TUNE_REPEATS; r++) { wall_t = fmin(wall_t, run_quiet(&trial)); }
+                rate = TUNE_GENS / wall_t;
+                printf("  %0.2f gens/s\n", rate);
+                if (rate > params->tune_rate) {
+                    params->num_threads = trial.num_threads;
+                    params->schedule = trial.schedule;
+                    params->chunk = trial.chunk;
+                    params->tune_rate = rate;
+                }
+            }
+        }
+    }
+    return;
+}
+
+
+/*
+ * autotune - Picks the fastest threads, schedule and chunk of a generational run, from the host-keyed cache or by calibrating (and caching) them
+ */
+void autotune(gs_params *params)
+{
+    unsigned long long rand_state = get_rand_state();
+    char key[MAX_LINE_SIZE];
+
+    if (params->autotune == TUNE_OFF) { return; }
+    if (params->mode != MODE_GENERATIONAL) {
+        printf("\nWARN: AUTOTUNE only tunes the generational engine (keeping THREADS %d)\n", params->num_threads);
+        params->autotune = TUNE_OFF;
+        return;
+    }
+
+    tune_key(params, key, sizeof(key));
+    if (read_tune_cache(params, key)) {
+        params->autotune = TUNE_CACHED;
+    } else {
+        calibrate(params);
+        write_tune_cache(params, key);
+        params->autotune = TUNE_CALIBRATED;
+    }
+
+    // calibration runs reseed the calling thread, and the run itself must not start from their seed
+    set_rand_state(rand_state);
+    return;
+}
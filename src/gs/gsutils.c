@@ -7,15 +7,74 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include "gsdefs.h"
 
 
+// per-thread random number generator state (xorshift64*), so threads never share the libc rand() lock and state
+static __thread unsigned long long rng_state = 0x9E3779B97F4A7C15ULL;
+
+
+/*
+ * seed_rand - Seeds the calling thread's random number generator
+ */
+void seed_rand(unsigned long long seed)
+{
+    // splitmix64 scramble so nearby seeds (i.e. seed + thread id) start far apart
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    rng_state = (z ^ (z >> 31)) | 1;
+    return;
+}
+
+
+/*
+ * get_rand_state - Returns the calling thread's random number generator state
+ */
+unsigned long long get_rand_state()
+{
+    return rng_state;
+}
+
+
+/*
+ * set_rand_state - Restores the calling thread's random number generator state
+ */
+void set_rand_state(unsigned long long state)
+{
+    rng_state = state;
+    return;
+}
+
+
+/*
+ * rand_u64 - Returns the next random 64 bit value of the calling thread
+ */
+unsigned long long rand_u64()
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (rng_state * 0x2545F4914F6CDD1DULL);
+}
+
+
+/*
+ * rand_unit - Returns a random double in [0, 1)
+ */
+double rand_unit()
+{
+    return ((rand_u64() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+
 /*
  * rand_int - Returns a random int between two specified values
  */
 int rand_int(int low, int high)
 {
-    return (rand()% (high - low)) + low;
+    return ((int) ((rand_u64() >> 33) % (high - low))) + low;
 }
 
 
@@ -24,7 +83,7 @@ int rand_int(int low, int high)
  */
 double rand_double(int low, int high)
 {
-    return ((double) ((rand()% (high - low)) + (double) low));
+    return ((double) rand_int(low, high));
 }
 
 
@@ -35,8 +94,8 @@ double rand_norm()
 {
     double U1, U2, W;
     do {
-        U1 = -1 + ((double) rand () / RAND_MAX) * 2;
-        U2 = -1 + ((double) rand () / RAND_MAX) * 2;
+        U1 = -1 + rand_unit() * 2;
+        U2 = -1 + rand_unit() * 2;
         W = pow (U1, 2) + pow (U2, 2);
     } while (W >= 1 || W == 0);
     return ((sqrt ((-2 * log (W)) / W)) * U1);
@@ -50,7 +109,7 @@ int rand_roulette(int ct_prob, double *prob)
 {
     int i;
     double offset = 0;
-    double r = rand() / (RAND_MAX + 1.0);
+    double r = rand_unit();
     for (i = 0; i < ct_prob; i++) {
         offset += prob[i];
         if (r < offset) break;
@@ -59,13 +118,22 @@ int rand_roulette(int ct_prob, double *prob)
 }
 
 
+/*
+ * game_fitness - Returns the fitness of a finished game with a given number of moves and apples
+ */
+double game_fitness(int moves, int apples)
+{
+    // Fitness(m,n) = num_moves * 2 ^ (num_apples)
+    return (((double) moves) * pow(2.0, (double) apples));
+}
+
+
 /*
  * compute_ann_fitness - Computes and updates the fitness of a specified ann with its respective env struct
  */
 void compute_ann_fitness(ann_set *ann_s, env_set *env_s, int i)
 {
-    // Fitness(m,n) = num_moves * 2 ^ (num_apples)
-    ann_s->fitness[i] = ((double) env_s->data[i].m) * pow(2.0, (double) env_s->data[i].n);
+    ann_s->fitness[i] = game_fitness(env_s->data[i].m, env_s->data[i].n);
     return;
 }
 
@@ -83,40 +151,202 @@ void compute_set_fitness(ann_set *ann_s, env_set *env_s)
 
 
 /*
- * init_thread_data_struct - Initializes a thread data struct with a given parameter struct
- */ 
-void init_thread_data_struct(thread_data *t_data, gs_params *params)
+ * reset_gen_stats - Empties a generation statistics accumulator
+ */
+void reset_gen_stats(gen_stats *stats)
+{
+    stats->ct = 0;
+    stats->sum_fitness = 0;
+    stats->sum_moves = 0;
+    stats->sum_apples = 0;
+    stats->best_idx = NOT_FOUND;
+    stats->sum_sq_fitness = 0;
+    for (int d = 0; d < NUM_DEATHS; d++) { stats->deaths[d] = 0; }
+    return;
+}
+
+
+/*
+ * add_game_stats - Adds a finished game (and how it ended) to a generation statistics accumulator
+ */
+void add_game_stats(gen_stats *stats, int idx, double fitness, int moves, int apples, int death)
+{
+    if ((stats->ct == 0) || (fitness < stats->min_fitness)) { stats->min_fitness = fitness; }
+    if ((stats->ct == 0) || (fitness > stats->max_fitness)) { stats->max_fitness = fitness; }
+    if ((stats->ct == 0) || (moves < stats->min_moves)) { stats->min_moves = moves; }
+    if ((stats->ct == 0) || (moves > stats->max_moves)) { stats->max_moves = moves; }
+    if ((stats->ct == 0) || (apples < stats->min_apples)) { stats->min_apples = apples; }
+    if ((stats->ct == 0) || (apples > stats->max_apples) || ((apples == stats->max_apples) && (idx < stats->best_idx))) {
+        stats->max_apples = apples;
+        stats->best_idx = idx;
+    }
+    stats->ct++;
+    stats->sum_fitness += fitness;
+    stats->sum_moves += moves;
+    stats->sum_apples += apples;
+    stats->sum_sq_fitness += fitness * fitness;
+    stats->deaths[death]++;
+    return;
+}
+
+
+/*
+ * merge_gen_stats - Merges a generation statistics accumulator into another
+ */
+void merge_gen_stats(gen_stats *dst, gen_stats *src)
+{
+    if (src->ct == 0) { return; }
+    if (dst->ct == 0) {
+        *dst = *src;
+        return;
+    }
+    if (src->min_fitness < dst->min_fitness) { dst->min_fitness = src->min_fitness; }
+    if (src->max_fitness > dst->max_fitness) { dst->max_fitness = src->max_fitness; }
+    if (src->min_moves < dst->min_moves) { dst->min_moves = src->min_moves; }
+    if (src->max_moves > dst->max_moves) { dst->max_moves = src->max_moves; }
+    if (src->min_apples < dst->min_apples) { dst->min_apples = src->min_apples; }
+    if ((src->max_apples > dst->max_apples) || ((src->max_apples == dst->max_apples) && (src->best_idx < dst->best_idx))) {
+        dst->max_apples = src->max_apples;
+        dst->best_idx = src->best_idx;
+    }
+    dst->ct += src->ct;
+    dst->sum_fitness += src->sum_fitness;
+    dst->sum_moves += src->sum_moves;
+    dst->sum_apples += src->sum_apples;
+    dst->sum_sq_fitness += src->sum_sq_fitness;
+    for (int d = 0; d < NUM_DEATHS; d++) { dst->deaths[d] += src->deaths[d]; }
+    return;
+}
+
+
+/*
+ * create_thread_data_struct - Initializes a thread data struct with a given parameter struct, returns GS_OK or GS_ERR_NOMEM with nothing left allocated
+ */
+int create_thread_data_struct(thread_data *t_data, gs_params *params)
 {
     int ct_surv = params->pop_size * params->survive;
-    t_data->action_set = (int *) malloc(params->pop_size * sizeof(int));
     t_data->env_s = (env_set *) malloc(sizeof(env_set));
     t_data->ann_s = (ann_set *) malloc(sizeof(ann_set));
+    if ((t_data->env_s == NULL) || (t_data->ann_s == NULL)) {
+        free(t_data->env_s);
+        free(t_data->ann_s);
+        return GS_ERR_NOMEM;
+    }
     t_data->params = params;
     t_data->surv_idx = (int *) malloc(params->pop_size * sizeof(int));
     t_data->fitness_prob = (double *) malloc(ct_surv * sizeof(double));
+    t_data->highscore = 0;
+    t_data->finished = 0;
+    t_data->started = 0;
+    t_data->stop_gen = NOT_SET;
+    atomic_init(&t_data->fail, GS_OK);
+    reset_gen_stats(&t_data->last_stats);
+    t_data->seed = rand_u64();
+    t_data->pool = NULL;
+    t_data->isl = NULL;
+    t_data->viewer = NULL;
+    t_data->prof = NULL;
+    t_data->perf = NULL;
+    t_data->ckpt = NULL;
+    t_data->lin = NULL;
+    t_data->metrics = NULL;
+    t_data->barrier.nodes = NULL;
+    memset(&t_data->gen_metrics, 0, sizeof(metrics_rec));
+    t_data->spawn_start_t = 0;
+    t_data->island = NOT_FOUND;
+    t_data->cpu_base = 0;
+
+    // allocate the ann and env sets (each snake controller thread initializes and first-touches its own shard)
+    alloc_env_set(t_data->env_s, params->pop_size);
+    alloc_ann_set(t_data->ann_s, params->pop_size);
+
+    // setup the longest-first run queues (every snake is predicted equal until its first game)
+    t_data->pred_moves = (int *) calloc(params->pop_size, sizeof(int));
+    t_data->run_order = (int *) malloc(params->pop_size * sizeof(int));
+    t_data->run_sorted = (int *) malloc(params->pop_size * sizeof(int));
+    if (posix_memalign((void **) &t_data->threads, CACHE_LINE, params->num_threads * sizeof(thread_state)) != 0) { t_data->threads = NULL; }
+    t_data->cpu_order = NULL;
+    t_data->mem_bytes = 0;
+    t_data->acct = mem_bound();
+    if ((t_data->surv_idx == NULL) || ((t_data->fitness_prob == NULL) && (ct_surv > 0)) || (t_data->env_s->data == NULL) || (t_data->env_s->dist_d == NULL) ||
+        (t_data->ann_s->data == NULL) || (t_data->ann_s->fitness == NULL) || (t_data->pred_moves == NULL) || (t_data->run_order == NULL) ||
+        (t_data->run_sorted == NULL) || (t_data->threads == NULL)) {
+        free_thread_data_struct(t_data);
+        return GS_ERR_NOMEM;
+    }
+    memset(t_data->threads, 0, params->num_threads * sizeof(thread_state));
+    for (int t = 0; t < params->num_threads; t++) { atomic_init(&t_data->threads[t].bounds, 0); }
+    build_cpu_order(t_data);
+    t_data->run_start_t = get_time();
+    t_data->run_t = 0;
+    t_data->idle_t = 0;
+    t_data->idle_pct = 0;
+    t_data->total_idle_pct = 0;
+    t_data->gen_steals = 0;
+    t_data->total_steals = 0;
+    build_run_order(t_data);
+
+    // account the population-sized arrays and thread states (the sets account themselves)
+    t_data->mem_bytes = 2 * mem_chunk(sizeof(env_set)) + mem_chunk(params->pop_size * sizeof(int)) * 4 + mem_chunk(ct_surv * sizeof(double)) +
+        mem_chunk(params->num_threads * sizeof(thread_state)) + mem_chunk(t_data->num_cpus * sizeof(int));
+    mem_add(MEM_THREADS, t_data->mem_bytes);
+
+    // setup the target claims of every snake controller phase
+    init_phase_claim(&t_data->run_claim, CLAIM_RUN, params->pop_size, 1, params->chunk);
+    init_phase_claim(&t_data->spawn_claim, CLAIM_SPAWN, params->pop_size - ct_surv, 2, (params->chunk > SPAWN_MIN_CHUNK)? params->chunk: SPAWN_MIN_CHUNK);
+    return GS_OK;
+}
+
+
+/*
+ * init_thread_data_struct - Initializes a thread data struct with a given parameter struct, stopping the run if it cannot be allocated
+ */
+void init_thread_data_struct(thread_data *t_data, gs_params *params)
+{
+    if (create_thread_data_struct(t_data, params) != GS_OK) {
+        printf("\n\nERR: could not allocate thread data for %d snakes\n\n\n", params->pop_size);
+        exit(127);
+    }
+    return;
+}
+
+
+/*
+ * free_thread_data_struct - Frees the members of a thread data struct
+ */
+void free_thread_data_struct(thread_data *t_data)
+{
+    // an engine torn down before its first run never initialized its shards
+    if (t_data->started) {
+        free_env_set(t_data->env_s);
+        free_ann_set(t_data->ann_s);
+    } else {
+        release_env_set(t_data->env_s);
+        release_ann_set(t_data->ann_s);
+    }
+    free(t_data->surv_idx);
+    free(t_data->fitness_prob);
+    free(t_data->pred_moves);
+    free(t_data->run_order);
+    free(t_data->run_sorted);
+    free(t_data->threads);
+    free(t_data->cpu_order);
+    free_barrier(&t_data->barrier);
+    mem_add(MEM_THREADS, -t_data->mem_bytes);
     return;
 }
 
 
 /*
- * define_thread_variables - Defines the initial values for the used thread variables
+ * init_phase_claim - Initializes a phase claim with a given counter index, target count, chunk step, and minimum chunk size
  */
-void init_thread_variables()
+void init_phase_claim(phase_claim *claim, int id, int limit, int step, int min_chunk)
 {
-    finished_flag = 0;
-    model_flag = 0;
-    curr_target = 0;
-    spawn_setup_flag = 0;
-
-    wait_run_flag = 0;
-    wait_compute_flag = 0;
-    wait_spawn_flag = 0;
-    wait_reset_flag = 0;
-
-    run_flag = 0;
-    compute_flag = 0;
-    spawn_flag = 0;
-    reset_flag = 0;
+    atomic_init(&claim->next, 0);
+    claim->id = id;
+    claim->limit = limit;
+    claim->step = step;
+    claim->min_chunk = min_chunk;
     return;
 }
 
@@ -124,15 +354,67 @@ void init_thread_variables()
 /*
  * init_parameters_struct - Constructor for gs_params struct with flag/default values
  */
-static gs_params * init_parameters_struct()
+gs_params * init_parameters_struct()
 {
     gs_params *params = (gs_params *) malloc(sizeof(gs_params));
+    if (params == NULL) { return NULL; }
     params->pop_size = NOT_SET;
     params->gen_ct = NOT_SET;
     params->env_width = ENV_WIDTH;
     params->num_layers = 0;
     params->num_threads = 1;
     params->print_replay = 0;
+    params->replay_file[0] = '\0';
+    params->profile = 0;
+    params->trace_file[0] = '\0';
+    params->perf_counters = 0;
+    params->memory_budget = 0;
+    params->mem_stats = 0;
+    params->budget_policy = BUDGET_REFUSE;
+    params->seed = NOT_SET;
+    params->chunk = RUN_MIN_CHUNK;
+    params->autotune = TUNE_OFF;
+    params->tune_file[0] = '\0';
+    params->tune_rate = 0;
+    params->ckpt_file[0] = '\0';
+    params->ckpt_every = 0;
+    params->resume_file[0] = '\0';
+    params->resume = CKPT_OFF;
+    params->lineage_file[0] = '\0';
+    params->lineage_every = 0;
+    params->metrics_file[0] = '\0';
+    params->metrics_format = METRICS_OFF;
+    params->champ_file[0] = '\0';
+    params->champ_format = GS_CHAMP_DOUBLE;
+    params->champ_prune = 0;
+    params->num_scale_threads = 0;
+    params->num_scale_pop = 0;
+    strcpy(params->scale_out, SCALE_OUT);
+    params->num_sweep_pop = 0;
+    params->num_sweep_mutate = 0;
+    params->num_sweep_survive = 0;
+    params->num_sweep_shape = 0;
+    params->sweep_mode = SWEEP_GRID;
+    strcpy(params->sweep_out, SWEEP_OUT);
+    params->asha_gens = 0;
+    params->asha_eta = ASHA_ETA;
+    params->asha_metric = ASHA_FITNESS;
+    params->quiet = 0;
+    params->totals = NULL;
+    params->barrier_spin = BARRIER_SPIN;
+    params->schedule = SCHEDULE_LONGEST;
+    params->affinity = AFFINITY_NONE;
+    params->mode = MODE_GENERATIONAL;
+    params->report_evals = NOT_SET;
+    params->num_islands = NOT_SET;
+    params->migrate_every = MIGRATE_EVERY;
+    params->migrate_k = MIGRATE_K;
+    params->topology = TOPOLOGY_RING;
+    strcpy(params->farm_addr, FARM_ADDR);
+    params->farm_workers = 1;
+    params->farm_batch = FARM_BATCH;
+    params->farm_timeout = FARM_TIMEOUT;
+    params->quantize = 0;
     params->mutate = (float) NOT_SET;
     params->survive = (float) NOT_SET;
     return params;
@@ -140,67 +422,196 @@ static gs_params * init_parameters_struct()
 
 
 /*
- * verify_parameters - Verify that all parameters have been properly set
+ * param_err - Writes a parameter error message and returns GS_ERR_PARAMS
  */
-static void verify_parameters(gs_params *params)
+static int param_err(char *err, size_t size, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(err, size, fmt, args);
+    va_end(args);
+    return GS_ERR_PARAMS;
+}
+
+
+/*
+ * check_parameters - Checks that all parameters have been properly set (filling in the derived ones) and returns GS_OK, or GS_ERR_PARAMS with the reason in err
+ */
+int check_parameters(gs_params *params, char *err, size_t size)
 {
+    int sweep_lens[4] = { params->num_sweep_pop, params->num_sweep_mutate, params->num_sweep_survive, params->num_sweep_shape };
+    int sweep_len;
+
     // check that all parameters have been set
-    if (params->pop_size == NOT_SET) { printf("\n\nERR: Did not set POP_WIDTH parameter\n"); exit(127); }
-    if (params->gen_ct == NOT_SET) { printf("\n\nERR: Did not set GEN_COUNT parameter\n"); exit(127); }
-    if (params->mutate == (float) NOT_SET) { printf("\n\nERR: Did not set MUTATE parameter\n"); exit(127); }
-    if (params->survive == (float) NOT_SET) { printf("\n\nERR: Did not set SURVIVE parameter\n"); exit(127); }
-    if (params->num_layers == 0) { printf("\n\nERR: Did not set LAYER parameter(s)\n"); exit(127); }
+    if (params->pop_size == NOT_SET) { return param_err(err, size, "Did not set POP_WIDTH parameter"); }
+    if (params->gen_ct == NOT_SET) { return param_err(err, size, "Did not set GEN_COUNT parameter"); }
+    if (params->mutate == (float) NOT_SET) { return param_err(err, size, "Did not set MUTATE parameter"); }
+    if (params->survive == (float) NOT_SET) { return param_err(err, size, "Did not set SURVIVE parameter"); }
+    if (params->num_layers == 0) { return param_err(err, size, "Did not set LAYER parameter(s)"); }
     
     // verify that all parameter values are within specified limits
     if (params->pop_size < MIN_POP_SIZE) {
-        printf("\n\nERR: Invalid population width (needs to be >= %d)\n", (int) MIN_POP_SIZE); 
-        exit(127);
+        return param_err(err, size, "Invalid population width (needs to be >= %d)", (int) MIN_POP_SIZE);
     }
 
     if (params->gen_ct < MIN_GEN_CT) {
-        printf("\n\nERR: Invalid generation count (needs to be >= %d)\n", (int) MIN_GEN_CT);
-        exit(127);
+        return param_err(err, size, "Invalid generation count (needs to be >= %d)", (int) MIN_GEN_CT);
     }
 
     if (params->mutate < MIN_MUTATE) {
-        printf("\n\nERR: Invalid mutate percentage (needs to be >= %3f)\n", (float) MIN_MUTATE);
-        exit(127);
+        return param_err(err, size, "Invalid mutate percentage (needs to be >= %3f)", (float) MIN_MUTATE);
     } else if (params->mutate > MAX_MUTATE) {
-        printf("\n\nERR: Invalid mutate percentage (needs to be <= %3f)\n", (float) MAX_MUTATE);
-        exit(127);
+        return param_err(err, size, "Invalid mutate percentage (needs to be <= %3f)", (float) MAX_MUTATE);
     }
 
     if (params->survive < MIN_SURVIVE) {
-        printf("\n\nERR: Invalid survive percentage (needs to be >= %3f)\n\n\n", (float) MIN_SURVIVE);
-        exit(127);
+        return param_err(err, size, "Invalid survive percentage (needs to be >= %3f)", (float) MIN_SURVIVE);
     } else if (params->survive > MAX_SURVIVE) {
-        printf("\n\nERR: Invalid survive percentage (needs to be <= %3f)\n\n\n", (float) MAX_SURVIVE);
-        exit(127);
+        return param_err(err, size, "Invalid survive percentage (needs to be <= %3f)", (float) MAX_SURVIVE);
     }
 
     if (params->num_layers > MAX_NUM_LAYERS) {
-        printf("\n\nERR: Too many layers  (max number of layers is %d)\n\n\n", (int) MAX_NUM_LAYERS);
-        exit(127);
+        return param_err(err, size, "Too many layers  (max number of layers is %d)", (int) MAX_NUM_LAYERS);
     }
 
     if (params->num_threads > MAX_NUM_THREADS) {
-        printf("\n\nERR: Too many threads (max number of threads is %d)\n\n\n", (int) MAX_NUM_THREADS);
-        exit(127);
+        return param_err(err, size, "Too many threads (max number of threads is %d)", (int) MAX_NUM_THREADS);
     } else if (params->num_threads < 1) {
-        printf("\n\nERR: Too few threads (min number of threads is 1)\n\n\n");
-        exit(127);
+        return param_err(err, size, "Too few threads (min number of threads is 1)");
+    }
+
+    if (params->chunk < 1) {
+        return param_err(err, size, "CHUNK must be 1 or greater (currently set to %d)", params->chunk);
+    }
+
+    if (params->barrier_spin < 0) {
+        return param_err(err, size, "Barrier spin parameter must be 0 or greater (currently set to %d)", params->barrier_spin);
     }
 
     if (params->print_replay < 0) {
-        printf("\n\nERR: Replay parameter must be 0 or greater (currently set to %d)\n\n\n", params->print_replay);
-        exit(127);
+        return param_err(err, size, "Replay parameter must be 0 or greater (currently set to %d)", params->print_replay);
+    }
+
+    // a run that would not fit the memory budget is refused or shrunk before the population checks
+    if (params->memory_budget < 0) {
+        return param_err(err, size, "MEMORY_BUDGET must be 0 (unlimited) or greater (currently set to %ld)", params->memory_budget);
+    }
+    if (apply_memory_budget(params, err, size) != GS_OK) { return GS_ERR_PARAMS; }
+
+    if ((params->seed != NOT_SET) && (params->seed < 0)) {
+        return param_err(err, size, "SEED must be 0 or greater (currently set to %lld)", params->seed);
+    }
+
+    // checkpoints hold one generational population
+    if (params->ckpt_every < 0) {
+        return param_err(err, size, "CHECKPOINT must save every 1 or more generations (currently set to %d)", params->ckpt_every);
+    } else if (((params->ckpt_every) || (params->resume != CKPT_OFF)) && (params->mode != MODE_GENERATIONAL)) {
+        return param_err(err, size, "CHECKPOINT, RESUME and INIT_POP only support the generational engine");
+    } else if (params->lineage_every < 0) {
+        return param_err(err, size, "LINEAGE must write a keyframe every 1 or more generations (currently set to %d)", params->lineage_every);
+    } else if ((params->lineage_every) && (params->mode != MODE_GENERATIONAL)) {
+        return param_err(err, size, "LINEAGE only supports the generational engine");
+    } else if ((params->metrics_format != METRICS_OFF) && (params->mode != MODE_GENERATIONAL) && (params->mode != MODE_ISLAND)) {
+        return param_err(err, size, "METRICS only supports the generational and island engines");
+    } else if ((params->champ_file[0] != '\0') && (params->mode != MODE_GENERATIONAL) && (params->mode != MODE_ISLAND)) {
+        return param_err(err, size, "CHAMPION only supports the generational and island engines");
+    } else if (params->champ_prune < 0) {
+        return param_err(err, size, "CHAMPION prune threshold must be 0 or greater (currently set to %f)", params->champ_prune);
+    }
+
+    // scaling grid values are checked here so a bad grid fails before the first run
+    for (int i = 0; i < params->num_scale_threads; i++) {
+        if ((params->scale_threads[i] < 1) || (params->scale_threads[i] > MAX_NUM_THREADS)) {
+            return param_err(err, size, "SCALE_THREADS values must be between 1 and %d (currently %d)", (int) MAX_NUM_THREADS, params->scale_threads[i]);
+        }
+    }
+    for (int i = 0; i < params->num_scale_pop; i++) {
+        if (params->scale_pop[i] < MIN_POP_SIZE) {
+            return param_err(err, size, "SCALE_POP values need to be >= %d (currently %d)", (int) MIN_POP_SIZE, params->scale_pop[i]);
+        }
+    }
+
+    // sweep values are checked the same way, and a list sweep pairs up lists of one length (or a single value)
+    for (int i = 0; i < params->num_sweep_pop; i++) {
+        if (params->sweep_pop[i] < MIN_POP_SIZE) {
+            return param_err(err, size, "SWEEP_POP values need to be >= %d (currently %d)", (int) MIN_POP_SIZE, params->sweep_pop[i]);
+        }
+    }
+    for (int i = 0; i < params->num_sweep_mutate; i++) {
+        if ((params->sweep_mutate[i] < MIN_MUTATE) || (params->sweep_mutate[i] > MAX_MUTATE)) {
+            return param_err(err, size, "SWEEP_MUTATE values must be between %3f and %3f (currently %3f)", (float) MIN_MUTATE, (float) MAX_MUTATE, params->sweep_mutate[i]);
+        }
+    }
+    for (int i = 0; i < params->num_sweep_survive; i++) {
+        if ((params->sweep_survive[i] < MIN_SURVIVE) || (params->sweep_survive[i] > MAX_SURVIVE)) {
+            return param_err(err, size, "SWEEP_SURVIVE values must be between %3f and %3f (currently %3f)", (float) MIN_SURVIVE, (float) MAX_SURVIVE, params->sweep_survive[i]);
+        }
+    }
+    if (params->sweep_mode == SWEEP_LIST) {
+        sweep_len = 1;
+        for (int l = 0; l < 4; l++) {
+            if (sweep_lens[l] <= 1) continue;
+            if ((sweep_len > 1) && (sweep_lens[l] != sweep_len)) {
+                return param_err(err, size, "SWEEP_MODE list needs every SWEEP list to hold the same number of values (or one)");
+            }
+            sweep_len = sweep_lens[l];
+        }
+    } else {
+        sweep_len = 1;
+        for (int l = 0; l < 4; l++) { if (sweep_lens[l] > 1) { sweep_len *= sweep_lens[l]; } }
+    }
+    if (sweep_len > MAX_SWEEP_RUNS) {
+        return param_err(err, size, "Too many sweep runs (%d, max number of runs is %d)", sweep_len, (int) MAX_SWEEP_RUNS);
+    }
+
+    // early stopping needs a first rung before the last generation and a rung to rung growth
+    if ((params->asha_gens < 0) || ((params->asha_gens) && (params->asha_gens >= params->gen_ct))) {
+        return param_err(err, size, "ASHA needs a first rung of 1 or more generations before GEN_COUNT (currently %d)", params->asha_gens);
+    } else if (params->asha_eta < 2) {
+        return param_err(err, size, "ASHA reduction factor must be 2 or greater (currently %d)", params->asha_eta);
+    }
+
+    // steady-state mode needs at least two survivors to sample parents and enough free slots for every thread's child
+    if (params->mode == MODE_STEADY) {
+        if ((int) (params->pop_size * params->survive) < 2) {
+            return param_err(err, size, "Steady-state mode needs at least 2 survivors (raise SURVIVE or POP_WIDTH)");
+        } else if (params->pop_size - (int) (params->pop_size * params->survive) < 2 * params->num_threads) {
+            return param_err(err, size, "Steady-state mode needs at least %d culled slots (lower SURVIVE or THREADS)", 2 * params->num_threads);
+        }
+    }
+    // island mode splits the threads and the population evenly between islands
+    if (params->num_islands == NOT_SET) { params->num_islands = params->num_threads; }
+    if (params->mode == MODE_ISLAND) {
+        if ((params->num_islands < 1) || (params->num_threads % params->num_islands != 0)) {
+            return param_err(err, size, "ISLANDS must be 1 or greater and divide THREADS (currently %d islands, %d threads)", params->num_islands, params->num_threads);
+        } else if (params->pop_size / params->num_islands < MIN_ISLAND_SIZE) {
+            return param_err(err, size, "Island population too small (POP_WIDTH / ISLANDS needs to be >= %d)", (int) MIN_ISLAND_SIZE);
+        } else if ((params->migrate_every < 1) || (params->migrate_k < 0)) {
+            return param_err(err, size, "MIGRATE_EVERY must be 1 or greater and MIGRATE_K 0 or greater");
+        } else if (params->migrate_k > (int) ((params->pop_size / params->num_islands) * params->survive)) {
+            return param_err(err, size, "MIGRATE_K can not exceed the survivors per island (%d)", (int) ((params->pop_size / params->num_islands) * params->survive));
+        }
+    }
+    // farm mode transfer settings
+    if (params->mode == MODE_FARM) {
+        if ((strncmp(params->farm_addr, "unix:", 5) != 0) && (strncmp(params->farm_addr, "tcp:", 4) != 0)) {
+            return param_err(err, size, "FARM_ADDR has to start with 'unix:' or 'tcp:' (currently %s)", params->farm_addr);
+        } else if ((params->farm_workers < 0) || (params->farm_batch < 1) || (params->farm_timeout < 1)) {
+            return param_err(err, size, "FARM_WORKERS must be 0 or greater, FARM_BATCH and FARM_TIMEOUT 1 or greater");
+        } else if ((params->quantize != 0) && (params->quantize != 8) && (params->quantize != 16)) {
+            return param_err(err, size, "QUANTIZE must be 0 (off), 8 or 16 (currently %d)", params->quantize);
+        }
+    }
+    if (params->report_evals == NOT_SET) { params->report_evals = params->pop_size * PRINT_BATCH; }
+    if (params->report_evals < 1) {
+        return param_err(err, size, "Report interval must be 1 or greater (currently set to %d)", params->report_evals);
     }
 
     // check that ANN shape is valid between layers
     for (int i = 1; i < params->num_layers; i++) {
         if (params->shape[RIDX(i, 0, 2)] != params->shape[RIDX((i - 1), 1, 2)]) {
-            printf("\n\nERR: Invalid ANN shape -- incompatable number of neurons/inputs between LAYER %d and LAYER %d \n", i, i + 1);
-            exit(127);
+            return param_err(err, size, "Invalid ANN shape -- incompatable number of neurons/inputs between LAYER %d and LAYER %d", i, i + 1);
         }
     }
 
@@ -212,18 +623,127 @@ static void verify_parameters(gs_params *params)
         params->shape[RIDX(0, 1, 2)] = 4;
     }
 
+    return GS_OK;
+}
+
+
+/*
+ * verify_parameters - Verify that all parameters have been properly set
+ */
+static void verify_parameters(gs_params *params)
+{
+    char err[MAX_LINE_SIZE];
+
+    if (check_parameters(params, err, sizeof(err)) != GS_OK) {
+        printf("\n\nERR: %s\n\n\n", err);
+        exit(127);
+    }
     return;
 }
 
 
+/*
+ * read_int_list - Reads the integers following a parameter flag on a line into a list and returns how many were read
+ */
+static int read_int_list(char *line, int *list, int max_ct, int line_num)
+{
+    char *tok = strtok(line, " \t\r\n");
+    int ct = 0;
+
+    while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+        if (ct == max_ct) {
+            printf("\n\nERR: Too many values on line %d (max number of values is %d)\n\n\n", line_num, max_ct);
+            exit(127);
+        }
+        list[ct++] = atoi(tok);
+    }
+    return ct;
+}
+
+
+/*
+ * read_float_list - Reads the decimals following a parameter flag on a line into a list and returns how many were read
+ */
+static int read_float_list(char *line, float *list, int max_ct, int line_num)
+{
+    char *tok = strtok(line, " \t\r\n");
+    int ct = 0;
+
+    while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+        if (ct == max_ct) {
+            printf("\n\nERR: Too many values on line %d (max number of values is %d)\n\n\n", line_num, max_ct);
+            exit(127);
+        }
+        list[ct++] = (float) atof(tok);
+    }
+    return ct;
+}
+
+
+/*
+ * read_shape_list - Reads the ANN shapes following a parameter flag on a line (neuron counts joined by '-', i.e. 24-16-4) into layer pairs and returns how many were read
+ */
+static int read_shape_list(char *line, int shapes[][2 * MAX_NUM_LAYERS], int *num_layers, int max_ct, int line_num)
+{
+    char *tok = strtok(line, " \t\r\n");
+    char *pos, *end;
+    int ct = 0;
+    int neurons[MAX_NUM_LAYERS + 1];
+    int num_neurons;
+
+    while ((tok = strtok(NULL, " \t\r\n")) != NULL) {
+        if (ct == max_ct) {
+            printf("\n\nERR: Too many values on line %d (max number of values is %d)\n\n\n", line_num, max_ct);
+            exit(127);
+        }
+
+        // every layer takes the last layer's outputs as its inputs
+        num_neurons = 0;
+        for (pos = tok; ; pos = end + 1) {
+            if (num_neurons == MAX_NUM_LAYERS + 1) {
+                printf("\n\nERR: Too many layers in shape '%s' on line %d (max number of layers is %d)\n\n\n", tok, line_num, (int) MAX_NUM_LAYERS);
+                exit(127);
+            }
+            neurons[num_neurons++] = (int) strtol(pos, &end, 10);
+            if ((end == pos) || (neurons[num_neurons - 1] < 1) || ((*end != '-') && (*end != '\0'))) {
+                printf("\n\nERR: Invalid shape '%s' on line %d (use neuron counts joined by '-', i.e. 24-16-4)\n\n\n", tok, line_num);
+                exit(127);
+            }
+            if (*end == '\0') break;
+        }
+        if ((num_neurons < 2) || (neurons[0] != 24) || (neurons[num_neurons - 1] != 4)) {
+            printf("\n\nERR: Invalid shape '%s' on line %d (shapes start with 24 inputs and end with 4 outputs)\n\n\n", tok, line_num);
+            exit(127);
+        }
+        num_layers[ct] = num_neurons - 1;
+        for (int l = 0; l < num_layers[ct]; l++) {
+            shapes[ct][RIDX(l, 0, 2)] = neurons[l];
+            shapes[ct][RIDX(l, 1, 2)] = neurons[l + 1];
+        }
+        ct++;
+    }
+    return ct;
+}
+
+
 /*
  * read_parameters_from_file - Updates given gs_params struct with values found in file from argv[1]
  */ 
 gs_params * read_parameters_from_file(const char *file_name)
+{
+    return read_parameters_override(file_name, NOT_SET, NOT_SET);
+}
+
+
+/*
+ * read_parameters_override - Same as read_parameters_from_file with THREADS and POP_WIDTH replaced before verifying (NOT_SET keeps the file's value)
+ */
+gs_params * read_parameters_override(const char *file_name, int num_threads, int pop_size)
 {
     char line [MAX_LINE_SIZE];
     char param [MAX_STR_SIZE]; 
     char activation [MAX_STR_SIZE];
+    char value [MAX_STR_SIZE];
     int line_num = 1;
 
     // initialize a new parameter struct
@@ -239,37 +759,167 @@ gs_params * read_parameters_from_file(const char *file_name)
     // read through the file by line and populate the parameter struct with values
     while (fgets(line, sizeof(line), file) != NULL ) {
         // read parameter flag
-        sscanf(line, "%s", param);
+        sscanf(line, "%31s", param);
 
         // skip blank or commented lines
         if ((line[0] == '\n') || (strcmp(param, "//") == 0)) { line_num++; continue; }
         
         // identify parameter flag and set parameter variable(s) from line
         if (strcmp(param, "POP_WIDTH") == 0) { // population size flag
-            sscanf(line, "%s %d\n", param, &params->pop_size);
+            sscanf(line, "%31s %d\n", param, &params->pop_size);
         } else if (strcmp(param, "GEN_COUNT") == 0) { // number of generations flag
-            sscanf(line, "%s %d\n", param, &params->gen_ct);
+            sscanf(line, "%31s %d\n", param, &params->gen_ct);
         } else if (strcmp(param, "MUTATE") == 0) { // mutation chance flag
-            sscanf(line, "%s %f\n", param, &params->mutate);
+            sscanf(line, "%31s %f\n", param, &params->mutate);
         } else if (strcmp(param, "SURVIVE") == 0) { // survival chance flag
-            sscanf(line, "%s %f\n", param, &params->survive);
-        } else if (strcmp(param, "THREADS") == 0) { // number of threads flag
-            sscanf(line, "%s %d\n", param, &params->num_threads);
+            sscanf(line, "%31s %f\n", param, &params->survive);
+        } else if (strcmp(param, "THREADS") == 0) { // number of threads flag (auto for every online cpu)
+            sscanf(line, "%31s %31s\n", param, value);
+            params->num_threads = atoi(value);
+            if (strcmp(value, "auto") == 0) {
+                params->num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+                if (params->num_threads > MAX_NUM_THREADS) { params->num_threads = MAX_NUM_THREADS; }
+            }
         } else if (strcmp(param, "REPLAY") == 0) { // highscore replay number flag
-            sscanf(line, "%s %d\n", param, &params->print_replay);
+            sscanf(line, "%31s %d\n", param, &params->print_replay);
+        } else if (strcmp(param, "BARRIER_SPIN") == 0) { // barrier spin budget flag
+            sscanf(line, "%31s %d\n", param, &params->barrier_spin);
+        } else if (strcmp(param, "SCHEDULE") == 0) { // run phase schedule flag
+            sscanf(line, "%31s %31s\n", param, value);
+            if (strcmp(value, "index") == 0) { params->schedule = SCHEDULE_INDEX; }
+            else if (strcmp(value, "longest") == 0) { params->schedule = SCHEDULE_LONGEST; }
+            else { printf("\n\nERR: Unknown schedule '%s' on line %d (use longest or index)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "AFFINITY") == 0) { // thread pinning flag
+            sscanf(line, "%31s %31s\n", param, value);
+            if (strcmp(value, "none") == 0) { params->affinity = AFFINITY_NONE; }
+            else if (strcmp(value, "compact") == 0) { params->affinity = AFFINITY_COMPACT; }
+            else if (strcmp(value, "scatter") == 0) { params->affinity = AFFINITY_SCATTER; }
+            else { printf("\n\nERR: Unknown affinity '%s' on line %d (use none, compact or scatter)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "MODE") == 0) { // genetic algorithm engine flag
+            sscanf(line, "%31s %31s\n", param, value);
+            if (strcmp(value, "generational") == 0) { params->mode = MODE_GENERATIONAL; }
+            else if (strcmp(value, "steady") == 0) { params->mode = MODE_STEADY; }
+            else if (strcmp(value, "island") == 0) { params->mode = MODE_ISLAND; }
+            else if (strcmp(value, "farm") == 0) { params->mode = MODE_FARM; }
+            else { printf("\n\nERR: Unknown mode '%s' on line %d (use generational, steady, island or farm)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "REPORT_EVALS") == 0) { // steady-state report interval flag
+            sscanf(line, "%31s %d\n", param, &params->report_evals);
+        } else if (strcmp(param, "ISLANDS") == 0) { // number of islands flag
+            sscanf(line, "%31s %d\n", param, &params->num_islands);
+        } else if (strcmp(param, "MIGRATE_EVERY") == 0) { // migration interval flag
+            sscanf(line, "%31s %d\n", param, &params->migrate_every);
+        } else if (strcmp(param, "MIGRATE_K") == 0) { // migrants per island flag
+            sscanf(line, "%31s %d\n", param, &params->migrate_k);
+        } else if (strcmp(param, "TOPOLOGY") == 0) { // migration topology flag
+            sscanf(line, "%31s %31s\n", param, value);
+            if (strcmp(value, "ring") == 0) { params->topology = TOPOLOGY_RING; }
+            else if (strcmp(value, "random") == 0) { params->topology = TOPOLOGY_RANDOM; }
+            else { printf("\n\nERR: Unknown topology '%s' on line %d (use ring or random)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "REPLAY_FILE") == 0) { // headless replay file flag
+            sscanf(line, "%31s %511s\n", param, params->replay_file);
+        } else if (strcmp(param, "PROFILE") == 0) { // phase profiler flag
+            sscanf(line, "%31s %d\n", param, &params->profile);
+        } else if (strcmp(param, "PROFILE_TRACE") == 0) { // chrome trace file flag (implies PROFILE)
+            sscanf(line, "%31s %511s\n", param, params->trace_file);
+            params->profile = 1;
+        } else if (strcmp(param, "PERF_COUNTERS") == 0) { // hardware counter flag
+            sscanf(line, "%31s %d\n", param, &params->perf_counters);
+        } else if (strcmp(param, "MEMORY_BUDGET") == 0) { // memory budget flag (MB, then refuse or downscale)
+            value[0] = '\0';
+            sscanf(line, "%31s %ld %31s\n", param, &params->memory_budget, value);
+            if ((value[0] == '\0') || (strcmp(value, "refuse") == 0)) { params->budget_policy = BUDGET_REFUSE; }
+            else if (strcmp(value, "downscale") == 0) { params->budget_policy = BUDGET_DOWNSCALE; }
+            else { printf("\n\nERR: Unknown memory budget policy '%s' on line %d (use refuse or downscale)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "MEMORY_STATS") == 0) { // live heap accounting flag
+            sscanf(line, "%31s %d\n", param, &params->mem_stats);
+        } else if (strcmp(param, "SEED") == 0) { // fixed random seed flag
+            sscanf(line, "%31s %lld\n", param, &params->seed);
+        } else if (strcmp(param, "CHUNK") == 0) { // smallest claim chunk flag
+            sscanf(line, "%31s %d\n", param, &params->chunk);
+        } else if (strcmp(param, "AUTOTUNE") == 0) { // auto-tuner flag (optional cache file)
+            strcpy(params->tune_file, TUNE_FILE);
+            sscanf(line, "%31s %511s\n", param, params->tune_file);
+            params->autotune = TUNE_CALIBRATED;
+        } else if (strcmp(param, "CHECKPOINT") == 0) { // checkpoint file flag (optional interval)
+            params->ckpt_every = CKPT_EVERY;
+            sscanf(line, "%31s %511s %d\n", param, params->ckpt_file, &params->ckpt_every);
+        } else if ((strcmp(param, "RESUME") == 0) || (strcmp(param, "INIT_POP") == 0)) { // checkpoint to resume or seed the population from flag
+            if (params->resume != CKPT_OFF) { printf("\n\nERR: Second RESUME/INIT_POP on line %d (use only one)\n\n\n", line_num); exit(127); }
+            sscanf(line, "%31s %511s\n", param, params->resume_file);
+            params->resume = (strcmp(param, "RESUME") == 0)? CKPT_RESUME: CKPT_INIT_POP;
+        } else if (strcmp(param, "LINEAGE") == 0) { // lineage log file flag (optional keyframe interval)
+            params->lineage_every = LINEAGE_KEYFRAME;
+            sscanf(line, "%31s %511s %d\n", param, params->lineage_file, &params->lineage_every);
+        } else if (strcmp(param, "METRICS") == 0) { // metrics stream file flag (optional format)
+            strcpy(value, "csv");
+            sscanf(line, "%31s %511s %31s\n", param, params->metrics_file, value);
+            if (strcmp(value, "csv") == 0) { params->metrics_format = METRICS_CSV; }
+            else if (strcmp(value, "jsonl") == 0) { params->metrics_format = METRICS_JSONL; }
+            else if (strcmp(value, "bin") == 0) { params->metrics_format = METRICS_BIN; }
+            else { printf("\n\nERR: Unknown metrics format '%s' on line %d (use csv, jsonl or bin)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "CHAMPION") == 0) { // champion export file flag (optional weight format and prune threshold)
+            strcpy(value, "double");
+            sscanf(line, "%31s %511s %31s %lf\n", param, params->champ_file, value, &params->champ_prune);
+            if (strcmp(value, "double") == 0) { params->champ_format = GS_CHAMP_DOUBLE; }
+            else if (strcmp(value, "float") == 0) { params->champ_format = GS_CHAMP_FLOAT; }
+            else if (strcmp(value, "int16") == 0) { params->champ_format = GS_CHAMP_INT16; }
+            else if (strcmp(value, "int8") == 0) { params->champ_format = GS_CHAMP_INT8; }
+            else { printf("\n\nERR: Unknown champion format '%s' on line %d (use double, float, int16 or int8)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "SCALE_THREADS") == 0) { // scaling grid thread counts flag
+            params->num_scale_threads = read_int_list(line, params->scale_threads, MAX_SCALE, line_num);
+        } else if (strcmp(param, "SCALE_POP") == 0) { // scaling grid population sizes flag
+            params->num_scale_pop = read_int_list(line, params->scale_pop, MAX_SCALE, line_num);
+        } else if (strcmp(param, "SCALE_OUT") == 0) { // scaling results file prefix flag
+            sscanf(line, "%31s %511s\n", param, params->scale_out);
+        } else if (strcmp(param, "SWEEP_POP") == 0) { // sweep population sizes flag
+            params->num_sweep_pop = read_int_list(line, params->sweep_pop, MAX_SWEEP, line_num);
+        } else if (strcmp(param, "SWEEP_MUTATE") == 0) { // sweep mutation chances flag
+            params->num_sweep_mutate = read_float_list(line, params->sweep_mutate, MAX_SWEEP, line_num);
+        } else if (strcmp(param, "SWEEP_SURVIVE") == 0) { // sweep survival chances flag
+            params->num_sweep_survive = read_float_list(line, params->sweep_survive, MAX_SWEEP, line_num);
+        } else if (strcmp(param, "SWEEP_LAYERS") == 0) { // sweep ann shapes flag
+            params->num_sweep_shape = read_shape_list(line, params->sweep_shape, params->sweep_layers, MAX_SWEEP, line_num);
+        } else if (strcmp(param, "SWEEP_MODE") == 0) { // sweep combination flag
+            sscanf(line, "%31s %31s\n", param, value);
+            if (strcmp(value, "grid") == 0) { params->sweep_mode = SWEEP_GRID; }
+            else if (strcmp(value, "list") == 0) { params->sweep_mode = SWEEP_LIST; }
+            else { printf("\n\nERR: Unknown sweep mode '%s' on line %d (use grid or list)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "SWEEP_OUT") == 0) { // sweep results file prefix flag
+            sscanf(line, "%31s %511s\n", param, params->sweep_out);
+        } else if (strcmp(param, "ASHA") == 0) { // sweep early stopping flag (first rung, optional reduction factor)
+            sscanf(line, "%31s %d %d\n", param, &params->asha_gens, &params->asha_eta);
+        } else if (strcmp(param, "ASHA_METRIC") == 0) { // sweep early stopping metric flag
+            sscanf(line, "%31s %31s\n", param, value);
+            if (strcmp(value, "fitness") == 0) { params->asha_metric = ASHA_FITNESS; }
+            else if (strcmp(value, "highscore") == 0) { params->asha_metric = ASHA_HIGHSCORE; }
+            else { printf("\n\nERR: Unknown ASHA metric '%s' on line %d (use fitness or highscore)\n\n\n", value, line_num); exit(127); }
+        } else if (strcmp(param, "FARM_ADDR") == 0) { // farm socket address flag
+            sscanf(line, "%31s %511s\n", param, params->farm_addr);
+        } else if (strcmp(param, "FARM_WORKERS") == 0) { // workers to wait for flag
+            sscanf(line, "%31s %d\n", param, &params->farm_workers);
+        } else if (strcmp(param, "FARM_BATCH") == 0) { // snakes per batch flag
+            sscanf(line, "%31s %d\n", param, &params->farm_batch);
+        } else if (strcmp(param, "FARM_TIMEOUT") == 0) { // worker timeout flag
+            sscanf(line, "%31s %d\n", param, &params->farm_timeout);
+        } else if (strcmp(param, "QUANTIZE") == 0) { // genome quantization flag
+            sscanf(line, "%31s %d\n", param, &params->quantize);
         } else if (strcmp(param, "LAYER") == 0) { // ann layer flag
-            sscanf(line, "%s %d %d %s\n", param, &params->shape[RIDX(params->num_layers, 0, 2)], &params->shape[RIDX(params->num_layers, 1, 2)], activation);
+            sscanf(line, "%31s %d %d %31s\n", param, &params->shape[RIDX(params->num_layers, 0, 2)], &params->shape[RIDX(params->num_layers, 1, 2)], activation);
             if (strcmp(activation, "sigmoid") == 0) { params->activation[params->num_layers] = sigmoid; }
             else { params->activation[params->num_layers] = sigmoid; } // everything is forced to be sigmoid -- WIP
             params->num_layers++;
         } else { // unknown symbol
             perror(line);
-            printf("\n\nERR: Unknown symbol on line %d (please fix/remove) -- each line must start with of { MODEL, POP_WIDTH, GEN_COUNT, MUTATE, SURVIVE, LAYER, ACTIVATION, or '//' }\n\n\n", line_num);
+            printf("\n\nERR: Unknown symbol on line %d (please fix/remove) -- each line must start with of { MODEL, POP_WIDTH, GEN_COUNT, MUTATE, SURVIVE, LAYER, ACTIVATION, THREADS, REPLAY, REPLAY_FILE, BARRIER_SPIN, SCHEDULE, AFFINITY, MODE, REPORT_EVALS, ISLANDS, MIGRATE_EVERY, MIGRATE_K, TOPOLOGY, FARM_ADDR, FARM_WORKERS, FARM_BATCH, FARM_TIMEOUT, QUANTIZE, PROFILE, PROFILE_TRACE, PERF_COUNTERS, MEMORY_BUDGET, SEED, CHUNK, AUTOTUNE, CHECKPOINT, RESUME, INIT_POP, LINEAGE, METRICS, CHAMPION, SCALE_THREADS, SCALE_POP, SCALE_OUT, SWEEP_POP, SWEEP_MUTATE, SWEEP_SURVIVE, SWEEP_LAYERS, SWEEP_MODE, SWEEP_OUT, ASHA, ASHA_METRIC, or '//' }\n\n\n", line_num);
             exit(127);
         }
         line_num++;
     }
     fclose(file);
+
+    // thread count and population size of a scaling grid cell
+    if (num_threads != NOT_SET) { params->num_threads = num_threads; }
+    if (pop_size != NOT_SET) { params->pop_size = pop_size; }
     
     // verify the parameters are valid
     verify_parameters(params);
@@ -12,12 +12,32 @@ int main(int argc, const char *argv[])
 {
     struct timespec start, finish;
     double elapsed;
-    srand(time(NULL));
+    seed_rand(time(NULL));
 
     // get start time
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    // start the model -- good luck
+    // play games for a farm coordinator, run a scaling grid or a sweep, play a champion, rebuild a logged generation, or start the model -- good luck
+    if ((argc > 2) && (strcmp(argv[1], "-worker") == 0)) {
+        farm_worker_main(argv[2]);
+        return 0;
+    }
+    if ((argc > 2) && (strcmp(argv[1], "-scale") == 0)) {
+        scale_genetic_snake(argv[2]);
+        return 0;
+    }
+    if ((argc > 2) && (strcmp(argv[1], "-sweep") == 0)) {
+        sweep_genetic_snake(argv[2]);
+        return 0;
+    }
+    if ((argc > 2) && (strcmp(argv[1], "-champion") == 0)) {
+        play_champion(argv[2]);
+        return 0;
+    }
+    if ((argc > 4) && (strcmp(argv[1], "-lineage") == 0)) {
+        rebuild_lineage(argv[2], atoi(argv[3]), argv[4]);
+        return 0;
+    }
     genetic_snake(argv[1]);
     
     // get end time
@@ -0,0 +1,337 @@
+//
+//  nnchamp.c
+//  genetic-snake
+//
+//  Created by Alexander Gonsalves
+//  04/17/2021
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "nndefs.h"
+
+
+/*
+ * DENSE_KERNEL - Defines a sigmoid layer kernel with a fixed number of outputs, so the compiler keeps them in registers and unrolls the output loop
+ *
+ * z adds one input at a time to the bias of every output, the same order forward adds them in, so a double champion makes forward's decisions
+ */
+#define DENSE_KERNEL(N) \
+static void dense_##N(const double *w, const double *b, const double *x, int in, int out, double *y) \
+{ \
+    double z[N]; \
+    for (int j = 0; j < N; j++) { z[j] = b[j]; } \
+    for (int k = 0; k < in; k++) { \
+        for (int j = 0; j < N; j++) { z[j] += w[k * N + j] * x[k]; } \
+    } \
+    for (int j = 0; j < N; j++) { y[j] = (1 / (1 + exp(-z[j]))); } \
+    return; \
+}
+
+DENSE_KERNEL(4)
+DENSE_KERNEL(8)
+DENSE_KERNEL(12)
+DENSE_KERNEL(16)
+DENSE_KERNEL(24)
+DENSE_KERNEL(32)
+
+
+/*
+ * dense_any - Sigmoid layer kernel of any number of outputs (the layer's outputs are its own activations until they are squashed)
+ */
+static void dense_any(const double *w, const double *b, const double *x, int in, int out, double *y)
+{
+    for (int j = 0; j < out; j++) { y[j] = b[j]; }
+    for (int k = 0; k < in; k++) {
+        for (int j = 0; j < out; j++) { y[j] += w[k * out + j] * x[k]; }
+    }
+    for (int j = 0; j < out; j++) { y[j] = (1 / (1 + exp(-y[j]))); }
+    return;
+}
+
+
+/*
+ * pick_kernel - Returns the kernel specialized to a layer's number of outputs, or the generic one
+ */
+static dense_funct pick_kernel(int out)
+{
+    switch (out) {
+        case 4: return dense_4;
+        case 8: return dense_8;
+        case 12: return dense_12;
+        case 16: return dense_16;
+        case 24: return dense_24;
+        case 32: return dense_32;
+        default: return dense_any;
+    }
+}
+
+
+/*
+ * champ_ns - Returns a monotonic time in ns (the runtime does not link the trainer's clock)
+ */
+static long long champ_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/*
+ * check_header - Checks a champion header against its file and returns GS_OK, or GS_ERR_PARAMS with the reason in err
+ */
+static int check_header(gs_champion_header *hdr, long file_size, char *err, size_t size)
+{
+    size_t elem = (hdr->format == GS_CHAMP_DOUBLE)? sizeof(double): (hdr->format == GS_CHAMP_FLOAT)? sizeof(float): (hdr->format == GS_CHAMP_INT16)? sizeof(int16_t): sizeof(int8_t);
+    long num_w = 0, num_n = 0;
+
+    if ((hdr->magic != GS_CHAMP_MAGIC) || (hdr->version != GS_CHAMP_VERSION)) {
+        snprintf(err, size, "not a champion file (or a champion of another version)");
+        return GS_ERR_PARAMS;
+    }
+    if ((hdr->format < GS_CHAMP_DOUBLE) || (hdr->format > GS_CHAMP_INT8) || (hdr->num_layers < 1) || (hdr->num_layers > GS_MAX_LAYERS)) {
+        snprintf(err, size, "champion has an unknown weight format or layer count");
+        return GS_ERR_PARAMS;
+    }
+    for (int l = 0; l < hdr->num_layers; l++) {
+        if ((hdr->shape[RIDX(l, 0, 2)] < 1) || (hdr->shape[RIDX(l, 1, 2)] < 1) || (hdr->activation[l] != GS_CHAMP_SIGMOID) ||
+            ((l > 0) && (hdr->shape[RIDX(l, 0, 2)] != hdr->shape[RIDX((l - 1), 1, 2)]))) {
+            snprintf(err, size, "champion layer %d has an invalid shape or activation", l + 1);
+            return GS_ERR_PARAMS;
+        }
+        num_w += (long) hdr->shape[RIDX(l, 0, 2)] * hdr->shape[RIDX(l, 1, 2)];
+        num_n += hdr->shape[RIDX(l, 1, 2)];
+    }
+    if ((num_w != hdr->num_w) || (num_n != hdr->num_n) || ((long) hdr->file_size != file_size) ||
+        (hdr->weights_off + hdr->num_w * elem > hdr->file_size) || (hdr->biases_off + hdr->num_n * sizeof(double) > hdr->file_size)) {
+        snprintf(err, size, "champion file is truncated or its header does not match its weights");
+        return GS_ERR_PARAMS;
+    }
+    return GS_OK;
+}
+
+
+/*
+ * read_weights - Reads every weight of a champion file as doubles in the kernels' order (integer weights times their layer's scale)
+ */
+static int read_weights(FILE *file, gs_champion_header *hdr, double *w)
+{
+    size_t elem = (hdr->format == GS_CHAMP_DOUBLE)? sizeof(double): (hdr->format == GS_CHAMP_FLOAT)? sizeof(float): (hdr->format == GS_CHAMP_INT16)? sizeof(int16_t): sizeof(int8_t);
+    unsigned char *raw = (unsigned char *) malloc(hdr->num_w * elem);
+    int idx_w = 0, count;
+
+    if ((raw == NULL) || (fseek(file, hdr->weights_off, SEEK_SET) != 0) || (fread(raw, elem, hdr->num_w, file) != (size_t) hdr->num_w)) {
+        free(raw);
+        return -1;
+    }
+    for (int l = 0; l < hdr->num_layers; l++) {
+        count = hdr->shape[RIDX(l, 0, 2)] * hdr->shape[RIDX(l, 1, 2)];
+        for (int k = idx_w; k < idx_w + count; k++) {
+            if (hdr->format == GS_CHAMP_DOUBLE) { memcpy(&w[k], raw + k * elem, sizeof(double)); }
+            else if (hdr->format == GS_CHAMP_FLOAT) { float f; memcpy(&f, raw + k * elem, sizeof(float)); w[k] = f; }
+            else if (hdr->format == GS_CHAMP_INT16) { int16_t q; memcpy(&q, raw + k * elem, sizeof(int16_t)); w[k] = q * (double) hdr->scale[l]; }
+            else { w[k] = ((int8_t) raw[k]) * (double) hdr->scale[l]; }
+        }
+        idx_w += count;
+    }
+    free(raw);
+    return 0;
+}
+
+
+/*
+ * gs_champion_load - Loads a frozen champion into one allocation (weights, biases and activations) and picks every layer's kernel, writing the reason of a failure to err
+ */
+int gs_champion_load(const char *file_name, gs_champion **out, char *err, size_t size)
+{
+    gs_champion_header hdr;
+    gs_champion *champ;
+    FILE *file;
+    long file_size;
+    int width = 0, idx_w = 0, idx_n = 0, rc;
+    char scratch[1];
+
+    if ((file_name == NULL) || (out == NULL)) { return GS_ERR_ARG; }
+    *out = NULL;
+    if (err == NULL) {
+        err = scratch;
+        size = sizeof(scratch);
+    }
+    file = fopen(file_name, "rb");
+    if (file == NULL) {
+        snprintf(err, size, "could not open champion file %s", file_name);
+        return GS_ERR_IO;
+    }
+    if ((fseek(file, 0, SEEK_END) != 0) || ((file_size = ftell(file)) < 0) || (fseek(file, 0, SEEK_SET) != 0) || (fread(&hdr, sizeof(hdr), 1, file) != 1)) {
+        snprintf(err, size, "could not read champion file %s", file_name);
+        fclose(file);
+        return GS_ERR_IO;
+    }
+    if ((rc = check_header(&hdr, file_size, err, size)) != GS_OK) {
+        fclose(file);
+        return rc;
+    }
+
+    // the widest layer sizes both activation buffers
+    for (int l = 0; l < hdr.num_layers; l++) {
+        if (hdr.shape[RIDX(l, 0, 2)] > width) { width = hdr.shape[RIDX(l, 0, 2)]; }
+        if (hdr.shape[RIDX(l, 1, 2)] > width) { width = hdr.shape[RIDX(l, 1, 2)]; }
+    }
+    champ = (gs_champion *) calloc(1, sizeof(gs_champion));
+    if ((champ == NULL) || (posix_memalign((void **) &champ->mem, 64, (hdr.num_w + hdr.num_n + 2 * width) * sizeof(double)) != 0)) {
+        free(champ);
+        fclose(file);
+        return GS_ERR_NOMEM;
+    }
+    if ((read_weights(file, &hdr, champ->mem) != 0) || (fseek(file, hdr.biases_off, SEEK_SET) != 0) ||
+        (fread(champ->mem + hdr.num_w, sizeof(double), hdr.num_n, file) != (size_t) hdr.num_n)) {
+        snprintf(err, size, "could not read champion file %s", file_name);
+        gs_champion_free(champ);
+        fclose(file);
+        return GS_ERR_IO;
+    }
+    fclose(file);
+
+    // every layer points into the one allocation
+    champ->num_l = hdr.num_layers;
+    for (int l = 0; l < hdr.num_layers; l++) {
+        champ->in[l] = hdr.shape[RIDX(l, 0, 2)];
+        champ->out[l] = hdr.shape[RIDX(l, 1, 2)];
+        champ->w[l] = champ->mem + idx_w;
+        champ->b[l] = champ->mem + hdr.num_w + idx_n;
+        champ->kernel[l] = pick_kernel(champ->out[l]);
+        idx_w += champ->in[l] * champ->out[l];
+        idx_n += champ->out[l];
+    }
+    champ->a = champ->mem + hdr.num_w + hdr.num_n;
+    champ->a_next = champ->a + width;
+
+    champ->info.num_layers = hdr.num_layers;
+    memcpy(champ->info.shape, hdr.shape, sizeof(champ->info.shape));
+    champ->info.format = hdr.format;
+    champ->info.num_w = hdr.num_w;
+    champ->info.num_n = hdr.num_n;
+    champ->info.pruned_w = hdr.pruned_w;
+    champ->info.pruned_n = hdr.pruned_n;
+    champ->info.gen = hdr.gen;
+    champ->info.apples = hdr.apples;
+    champ->info.fitness = hdr.fitness;
+    champ->info.file_size = hdr.file_size;
+    champ->info.bytes = sizeof(gs_champion) + (hdr.num_w + hdr.num_n + 2 * width) * sizeof(double);
+    *out = champ;
+    return GS_OK;
+}
+
+
+/*
+ * gs_champion_decide - Returns the move (GS_ENV_UP to GS_ENV_RIGHT for a snake champion) of the most active output for an observation
+ */
+int gs_champion_decide(gs_champion *champ, const double *x)
+{
+    const double *in = x;
+    double *act = NULL;
+    int best = 0;
+
+    if ((champ == NULL) || (x == NULL)) { return GS_ERR_ARG; }
+    for (int l = 0; l < champ->num_l; l++) {
+        act = (l & 1)? champ->a_next: champ->a;
+        champ->kernel[l](champ->w[l], champ->b[l], in, champ->in[l], champ->out[l], act);
+        in = act;
+    }
+
+    // the first of equally active outputs wins (like run_ann)
+    for (int j = 1; j < champ->out[champ->num_l - 1]; j++) {
+        if (act[j] > act[best]) { best = j; }
+    }
+    return best + 1;
+}
+
+
+/*
+ * gs_champion_decide_batch - Decides the moves of a number of observations laid out one after the other
+ */
+int gs_champion_decide_batch(gs_champion *champ, const double *x, int num_obs, int *actions)
+{
+    if ((champ == NULL) || (x == NULL) || (actions == NULL) || (num_obs < 0)) { return GS_ERR_ARG; }
+    for (int o = 0; o < num_obs; o++) { actions[o] = gs_champion_decide(champ, x + (size_t) o * champ->in[0]); }
+    return GS_OK;
+}
+
+
+/*
+ * gs_champion_get_info - Copies a champion's topology, weight format, pruning and the game it was exported from
+ */
+int gs_champion_get_info(gs_champion *champ, gs_champion_info *info)
+{
+    if ((champ == NULL) || (info == NULL)) { return GS_ERR_ARG; }
+    *info = champ->info;
+    return GS_OK;
+}
+
+
+/*
+ * compare_ns - qsort comparison of two latencies
+ */
+static int compare_ns(const void *a, const void *b)
+{
+    double x = *((const double *) a), y = *((const double *) b);
+    return (x > y) - (x < y);
+}
+
+
+/*
+ * gs_champion_measure - Times every one of a number of decisions over a set of observations on its own and reports the mean, median, p99 and best ns per decision, less the median cost of reading the clock
+ */
+int gs_champion_measure(gs_champion *champ, const double *x, int num_obs, int decisions, gs_champion_latency *lat)
+{
+    volatile int sink = 0;
+    double *samples, clock_ns, sum = 0;
+    long long start_ns;
+    int o = 0;
+
+    if ((champ == NULL) || (x == NULL) || (lat == NULL) || (num_obs < 1) || (decisions < 1)) { return GS_ERR_ARG; }
+    samples = (double *) malloc(((decisions > CHAMP_CLOCK_READS)? decisions: CHAMP_CLOCK_READS) * sizeof(double));
+    if (samples == NULL) { return GS_ERR_NOMEM; }
+
+    // calibrate the cost of the clock read that ends every timed decision (back to back reads, median)
+    for (int i = 0; i < CHAMP_CLOCK_READS; i++) {
+        start_ns = champ_ns();
+        samples[i] = (double) (champ_ns() - start_ns);
+    }
+    qsort(samples, CHAMP_CLOCK_READS, sizeof(double), compare_ns);
+    clock_ns = samples[CHAMP_CLOCK_READS / 2];
+
+    // a decision takes as long as a few clock reads, so every one is timed on its own and the tail is the decision's
+    for (int i = 0; i < decisions; i++) {
+        start_ns = champ_ns();
+        sink += gs_champion_decide(champ, x + (size_t) o * champ->in[0]);
+        samples[i] = (double) (champ_ns() - start_ns) - clock_ns;
+        if (samples[i] < 0) { samples[i] = 0; }
+        sum += samples[i];
+        if (++o == num_obs) { o = 0; }
+    }
+    qsort(samples, decisions, sizeof(double), compare_ns);
+    lat->decisions = decisions;
+    lat->mean_ns = sum / decisions;
+    lat->p50_ns = samples[decisions / 2];
+    lat->p99_ns = samples[(int) (decisions * 0.99)];
+    lat->min_ns = samples[0];
+    lat->clock_ns = clock_ns;
+    free(samples);
+    return GS_OK;
+}
+
+
+/*
+ * gs_champion_free - Frees a loaded champion
+ */
+void gs_champion_free(gs_champion *champ)
+{
+    if (champ == NULL) { return; }
+    free(champ->mem);
+    free(champ);
+    return;
+}
@@ -9,9 +9,9 @@
 
 
 /*
- * init_ann_set - Initializes a set of ann of a given size and shape
+ * alloc_ann_set - Allocates a set of ann of a given size without initializing its members
  */
-void init_ann_set(ann_set *ann_s, int ct, int num_l, int *shape, funct *A)
+void alloc_ann_set(ann_set *ann_s, int ct)
 {
     ann_s->gen = 0;
     ann_s->num_net = ct;
@@ -19,9 +19,37 @@ void init_ann_set(ann_set *ann_s, int ct, int num_l, int *shape, funct *A)
     // malloc fitness and ann data array
     ann_s->fitness = (double *) malloc(ct * sizeof(double));
     ann_s->data = (ann *) malloc(ct * sizeof(ann));
-    
-    // init each ann set member
-    for (int i = 0; i < ct; i++) { 
+    mem_add(MEM_GENOMES, mem_chunk(ct * sizeof(double)) + mem_chunk(ct * sizeof(ann)));
+    return;
+}
+
+
+/*
+ * create_ann_range - Initializes the ann set members in [start, end) with a given shape and returns GS_OK or the create_ann code of the first that failed (leaving none of the range allocated)
+ */
+int create_ann_range(ann_set *ann_s, int start, int end, int num_l, int *shape, funct *A)
+{
+    int code;
+
+    for (int i = start; i < end; i++) { 
+        ann_s->fitness[i] = NOT_SET;
+        code = create_ann(&(ann_s->data[i]), num_l, shape, A);
+        if (code != GS_OK) {
+            for (int j = start; j < i; j++) { destroy_ann(&(ann_s->data[j])); }
+            return code;
+        }
+    }
+    return GS_OK;
+}
+
+
+/*
+ * init_ann_set - Initializes a set of ann of a given size and shape
+ */
+void init_ann_set(ann_set *ann_s, int ct, int num_l, int *shape, funct *A)
+{
+    alloc_ann_set(ann_s, ct);
+    for (int i = 0; i < ct; i++) {
         ann_s->fitness[i] = NOT_SET;
         init_ann(&(ann_s->data[i]), num_l, shape, A);
     }
@@ -126,7 +154,7 @@ void spawn_ann_gen(ann_set *ann_s, double survive, double mutate, int ct, int nu
 
 
 /*
- * run_ann - Runs a given ann with env out data and returns the best predicted move
+ * run_ann - Runs a given ann with env out data and returns the best predicted move (NOT_SET if the env is dead or the ann cannot predict)
  */
 int run_ann(ann *net, dist_data *o_data)
 {
@@ -135,11 +163,16 @@ int run_ann(ann *net, dist_data *o_data)
 
     // cast out data struct to array of doubles
     double *o = (double *) malloc(sizeof(dist_data));
+    if (o == NULL) { return NOT_SET; }
     memcpy(o, o_data, sizeof(dist_data));
     
-    // forward prop with given ann
+    // forward prop with given ann (a net that cannot predict has no move)
     int max_idx = 0;
     double *y = forward(net, 1, 24, o);
+    if (y == NULL) {
+        free(o);
+        return NOT_SET;
+    }
 
     // determine max probability idx
     for (int i = 0; i < 4; i++) {
@@ -170,8 +203,19 @@ void free_ann_set(ann_set *src)
     for (int i = 0; i < (src->num_net); i++) {
         destroy_ann(&(src->data[i]));
     }
+    release_ann_set(src);
+    return;
+}
+
+
+/*
+ * release_ann_set - Frees a set and its arrays without touching anns that were never initialized
+ */
+void release_ann_set(ann_set *src)
+{
     free(src->data);
     free(src->fitness);
+    mem_add(MEM_GENOMES, -(mem_chunk(src->num_net * sizeof(double)) + mem_chunk(src->num_net * sizeof(ann))));
     free(src);
     return;
 }
\ No newline at end of file
@@ -22,9 +22,9 @@ double sigmoid(double x)
 
 
 /*
- * ann_init - Initializes a network with a given set of parameters
+ * create_ann - Initializes a network with a given set of parameters and returns GS_OK, GS_ERR_PARAMS if its size is invalid or GS_ERR_NOMEM (leaving nothing allocated)
  */
-void init_ann(ann *net, int num_l, int *shape, funct *A)
+int create_ann(ann *net, int num_l, int *shape, funct *A)
 {
     int idx_n = 0;
     int idx_w = 0;
@@ -37,11 +37,8 @@ void init_ann(ann *net, int num_l, int *shape, funct *A)
         num_w += shape[RIDX(l,0,SHAPE_DIM)] * shape[RIDX(l,1,SHAPE_DIM)];
     }
 
-    // exit if net size is invalid
-    if ((num_n == 0) || (num_w == 0)) {
-        printf("\n\nERR: net size is invalid\n");
-        exit(127);
-    } 
+    // return if net size is invalid
+    if ((num_n == 0) || (num_w == 0)) { return GS_ERR_PARAMS; }
     
     // set ann numeric values
     net->num_l = num_l;
@@ -55,6 +52,18 @@ void init_ann(ann *net, int num_l, int *shape, funct *A)
     net->b = (double *) malloc(num_n * sizeof(double));
     net->a_obs = (double *) malloc(num_n * sizeof(double));
     net->A = (funct *) malloc(num_l * sizeof(funct));
+    if ((net->shape == NULL) || (net->w == NULL) || (net->b == NULL) || (net->a_obs == NULL) || (net->A == NULL)) {
+        free(net->shape);
+        free(net->w);
+        free(net->b);
+        free(net->a_obs);
+        free(net->A);
+        return GS_ERR_NOMEM;
+    }
+    if (mem_acct != NULL) {
+        mem_add(MEM_GENOMES, mem_chunk(SHAPE_DIM * num_l * sizeof(int)) + mem_chunk(num_w * sizeof(double)) + mem_chunk(num_n * sizeof(double)) + mem_chunk(num_l * sizeof(funct)));
+        mem_add(MEM_ACTIVATIONS, mem_chunk(num_n * sizeof(double)));
+    }
     
     // idx_n: node idx of current layer
     // idx_w: weight idx of current layer
@@ -79,6 +88,24 @@ void init_ann(ann *net, int num_l, int *shape, funct *A)
         idx_n += shape[RIDX(l,1,SHAPE_DIM)];
         idx_w += shape[RIDX(l,0,SHAPE_DIM)] * shape[RIDX(l,1,SHAPE_DIM)];
     }
+    return GS_OK;
+}
+
+
+/*
+ * init_ann - Initializes a network with a given set of parameters, stopping the run if it cannot
+ */
+void init_ann(ann *net, int num_l, int *shape, funct *A)
+{
+    int code = create_ann(net, num_l, shape, A);
+
+    if (code == GS_ERR_PARAMS) {
+        printf("\n\nERR: net size is invalid\n");
+        exit(127);
+    } else if (code != GS_OK) {
+        printf("\n\nERR: could not allocate a net of %d layers\n", num_l);
+        exit(127);
+    }
     return;
 }
 
@@ -109,22 +136,22 @@ static void rebuild_obs_sets(ann *net)
 
 
 /*
- * forward - Forward propagation with a given ann and observation set
+ * forward - Forward propagation with a given ann and observation set, returns NULL if the features do not fit the input layer or the output cannot be allocated
  */
 double * forward(ann *net, int num_obs, int num_feat, double *x)
 {
     int idx_w, idx_n, idx_n_prev;
     double z;
-    double *y = (double *) malloc(num_obs * net->shape[RIDX((net->num_l) - 1, 1, SHAPE_DIM)] * sizeof(double));
+    double *y;
     
     // check if num features is compatible with input layer
-    if (num_feat != net->shape[RIDX(0,0,SHAPE_DIM)]) {
-        printf("\n\nERR: forward prop input features incompatible with net input layer\n");
-        exit(127);
-    }
+    if (num_feat != net->shape[RIDX(0,0,SHAPE_DIM)]) { return NULL; }
+    y = (double *) malloc(num_obs * net->shape[RIDX((net->num_l) - 1, 1, SHAPE_DIM)] * sizeof(double));
+    if (y == NULL) { return NULL; }
 
     // restructure net activation if num obs is different
     if (net->num_obs != num_obs) {
+        if (mem_acct != NULL) { mem_add(MEM_ACTIVATIONS, mem_chunk(net->num_n * num_obs * sizeof(double)) - mem_chunk(net->num_n * net->num_obs * sizeof(double))); }
         net->num_obs = num_obs;
         rebuild_obs_sets(net);
     }
@@ -220,6 +247,10 @@ void copy_parameters(ann *src, ann *dst)
  */
 void destroy_ann(ann *net)
 {
+    if (mem_acct != NULL) {
+        mem_add(MEM_GENOMES, -(mem_chunk(SHAPE_DIM * net->num_l * sizeof(int)) + mem_chunk(net->num_w * sizeof(double)) + mem_chunk(net->num_n * sizeof(double)) + mem_chunk(net->num_l * sizeof(funct))));
+        mem_add(MEM_ACTIVATIONS, -mem_chunk(net->num_n * net->num_obs * sizeof(double)));
+    }
     free(net->shape);
     free(net->w);
     free(net->b);